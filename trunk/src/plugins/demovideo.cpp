@@ -65,6 +65,7 @@ DemoVideo1::~DemoVideo1() {
 }
 
 void DemoVideo1::LoadCurrentFrame() {
+    m_Bitmap->Unshare(false); // We paint the whole frame, so the previous one doesn't need to be copied.
 //    PaintMathPattern();
     PaintMovingLine();
 }
@@ -43,6 +43,16 @@ class syAtomic {
 
         static void MemoryBarrier();
 
+        /** @brief Reads a value published by another thread with StoreRelease().
+         *  Reads and writes done after this call can't be moved before it.
+         */
+        static unsigned int LoadAcquire(const volatile unsigned int* ptr);
+
+        /** @brief Publishes a value to another thread, which reads it with LoadAcquire().
+         *  Reads and writes done before this call can't be moved after it.
+         */
+        static void StoreRelease(volatile unsigned int* ptr, unsigned int val);
+
         /** @brief Returns true on success. Curval obtains the current value of *ptr.
          *  We add an additional parameter to hold the old value because both the value and the return are boolean.
          */
@@ -85,6 +95,27 @@ inline void syAtomic::MemoryBarrier() {
     AO_nop_full();
 }
 
+inline unsigned int syAtomic::LoadAcquire(const volatile unsigned int* ptr) {
+    unsigned int result = *ptr;
+    #if defined(__i386__) || defined(__x86_64__)
+    // x86 loads are never reordered with later loads or stores, so we only need to stop the compiler.
+    __asm__ __volatile__("" : : : "memory");
+    #else
+    MemoryBarrier();
+    #endif
+    return result;
+}
+
+inline void syAtomic::StoreRelease(volatile unsigned int* ptr, unsigned int val) {
+    #if defined(__i386__) || defined(__x86_64__)
+    // x86 stores are never reordered with earlier loads or stores, so we only need to stop the compiler.
+    __asm__ __volatile__("" : : : "memory");
+    #else
+    MemoryBarrier();
+    #endif
+    *ptr = val;
+}
+
 inline bool syAtomic::bool_CAS(bool* ptr, bool oldval, bool newval) {
     bool result;
     #ifdef AO_USE_GCC
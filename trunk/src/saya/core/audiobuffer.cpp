@@ -11,20 +11,34 @@
 
 // Programmer notes:
 
-// In this implementation, the tail grows with each new write, while the head shrinks with each new read.
+// In this implementation, the tail grows with each new write, while the head grows with each new read.
 // To make this class thread-safe, we must ABSOLUTELY make sure that the writer does not write to m_Head,
 // and that the reader does not write to m_Tail.
 
-// Writing to the buffer will increase m_Tail, while reading from the buffer will increase m_Head
-// (think of it as a snake moving backwards).
+// Head and tail are free-running counters: They're never wrapped, and the position of a sample in the buffer
+// is its counter masked with m_Mask (the buffer size is a power of two). The length of the buffer is simply
+// tail - head, which stays right even when the counters overflow; so a full buffer has all its slots in use.
 
-// Clearing will first set the m_Clear flag to true, and then set the tail equal to the head.
-// if(m_Clear) is true, setting the m_Clear to false will be the last operation done by the writer.
-// This is to avoid race conditions where the buffer is cleared by the writer but then the head is disminished by
-// the reader, resulting in a garbage buffer of size m_Size.
+// Each side publishes its counter with syAtomic::StoreRelease() after copying the samples, and reads the
+// other side's counter with syAtomic::LoadAcquire() before copying them. To avoid reading the other side's
+// counter (and stealing its cache line) on every call, each side keeps a cached copy of it, and only reloads
+// it when the cached copy says there isn't enough data (or room) for the request.
+
+// The variables used by the reader and the writer live on separate cache lines, so that the audio thread
+// reading the buffer doesn't stall every time the decoder thread writes to it, and vice versa.
+
+// Clearing only saves the current tail in m_ClearTail and increments m_ClearRequests. The reader discards
+// everything up to the saved tail the next time it reads, and the writer restarts the resampling the next time
+// it writes. That way, the samples written after the Clear() (i.e. by a source that refills the buffer after
+// a seek) are kept, and neither the head nor the tail are written by both threads.
 
 #include "audiobuffer.h"
+#include "syaudioblock.h"
+#include "syaudioresampler.h"
+#include "syrowconverter.h"
+#include "sysimd.h"
 #include "atomic.h"
+#include <cstring>
 
 const unsigned int syAudioBuffer::maxbitspersample = 32;
 const unsigned int syAudioBuffer::maxsamplefreq = 96000;
@@ -32,20 +46,164 @@ const unsigned int syAudioBuffer::maxaudiochannels = 256;
 const unsigned int syAudioBuffer::minsamplesperbuffer = 256;
 const unsigned int syAudioBuffer::maxsamplesperbuffer = 1048576;
 
+/** Size of the padding between the reader's and the writer's variables. At least one cache line. */
+static const unsigned int sy_cachelinesize = 64;
+
+// --------------------------
+// Begin precision conversion
+// --------------------------
+
+// A sample of precision p has a full scale of 2^(p-1), so converting to a higher precision shifts left, and
+// converting to a lower one shifts right (an arithmetic shift, which truncates towards minus infinity).
+// The vector kernels give exactly the same results as the plain C ones.
+
+/** Converts count integers. shift is the distance between the precisions. */
+typedef void (*sy_precisionkernel)(const int* src, int* dst, unsigned int count, unsigned int shift);
+
+static void sy_copy_samples(const int* src, int* dst, unsigned int count, unsigned int shift) {
+    memcpy(dst, src, count * sizeof(int));
+}
+
+static void sy_shift_left(const int* src, int* dst, unsigned int count, unsigned int shift) {
+    for(unsigned int i = 0; i < count; ++i) {
+        dst[i] = (int)((unsigned int)src[i] << shift);
+    }
+}
+
+static void sy_shift_right(const int* src, int* dst, unsigned int count, unsigned int shift) {
+    for(unsigned int i = 0; i < count; ++i) {
+        dst[i] = src[i] >> shift;
+    }
+}
+
+#ifdef SY_X86_SIMD
+
+SY_TARGET_SSE2 static void sy_shift_left_sse2(const int* src, int* dst, unsigned int count, unsigned int shift) {
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    unsigned int i = 0;
+    for(; i + 8 <= count; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i + 4));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_sll_epi32(a, vshift));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_sll_epi32(b, vshift));
+    }
+    sy_shift_left(src + i, dst + i, count - i, shift);
+}
+
+SY_TARGET_SSE2 static void sy_shift_right_sse2(const int* src, int* dst, unsigned int count, unsigned int shift) {
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    unsigned int i = 0;
+    for(; i + 8 <= count; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + i + 4));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_sra_epi32(a, vshift));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_sra_epi32(b, vshift));
+    }
+    sy_shift_right(src + i, dst + i, count - i, shift);
+}
+
+SY_TARGET_AVX2 static void sy_shift_left_avx2(const int* src, int* dst, unsigned int count, unsigned int shift) {
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    unsigned int i = 0;
+    for(; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i + 8));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_sll_epi32(a, vshift));
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), _mm256_sll_epi32(b, vshift));
+    }
+    _mm256_zeroupper();
+    sy_shift_left(src + i, dst + i, count - i, shift);
+}
+
+SY_TARGET_AVX2 static void sy_shift_right_avx2(const int* src, int* dst, unsigned int count, unsigned int shift) {
+    __m128i vshift = _mm_cvtsi32_si128(shift);
+    unsigned int i = 0;
+    for(; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i + 8));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_sra_epi32(a, vshift));
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), _mm256_sra_epi32(b, vshift));
+    }
+    _mm256_zeroupper();
+    sy_shift_right(src + i, dst + i, count - i, shift);
+}
+
+#endif
+
+/** @brief Converts samples from one precision to another.
+ *
+ *  The kernel for a pair of precisions is picked when the pair changes, so the precisions and the CPU's
+ *  features aren't checked again on every block.
+ */
+class sySampleConverter {
+    public:
+        sySampleConverter() : m_SrcPrecision(0), m_DstPrecision(0), m_Shift(0), m_Kernel(sy_copy_samples) {}
+
+        /** Converts count integers (i.e. samples times channels) from srcprecision to dstprecision bits. */
+        inline void Convert(const int* src, int* dst, unsigned int count, unsigned int srcprecision, unsigned int dstprecision) {
+            if(srcprecision != m_SrcPrecision || dstprecision != m_DstPrecision) {
+                Setup(srcprecision, dstprecision);
+            }
+            m_Kernel(src, dst, count, m_Shift);
+        }
+
+    private:
+        void Setup(unsigned int srcprecision, unsigned int dstprecision);
+
+        unsigned int m_SrcPrecision;
+        unsigned int m_DstPrecision;
+        unsigned int m_Shift;
+        sy_precisionkernel m_Kernel;
+};
+
+void sySampleConverter::Setup(unsigned int srcprecision, unsigned int dstprecision) {
+    m_SrcPrecision = srcprecision;
+    m_DstPrecision = dstprecision;
+    if(srcprecision > syAudioBuffer::maxbitspersample) { srcprecision = syAudioBuffer::maxbitspersample; }
+    if(dstprecision > syAudioBuffer::maxbitspersample) { dstprecision = syAudioBuffer::maxbitspersample; }
+    if(srcprecision == dstprecision) {
+        m_Shift = 0;
+        m_Kernel = sy_copy_samples;
+    } else if(srcprecision < dstprecision) {
+        m_Shift = dstprecision - srcprecision;
+        m_Kernel = sy_shift_left;
+        #ifdef SY_X86_SIMD
+        if(syRowConverter::HasAVX2()) {
+            m_Kernel = sy_shift_left_avx2;
+        } else if(syRowConverter::HasSSE2()) {
+            m_Kernel = sy_shift_left_sse2;
+        }
+        #endif
+    } else {
+        m_Shift = srcprecision - dstprecision;
+        m_Kernel = sy_shift_right;
+        #ifdef SY_X86_SIMD
+        if(syRowConverter::HasAVX2()) {
+            m_Kernel = sy_shift_right_avx2;
+        } else if(syRowConverter::HasSSE2()) {
+            m_Kernel = sy_shift_right_sse2;
+        }
+        #endif
+    }
+}
+
+// ------------------------
+// End precision conversion
+// ------------------------
+
 class syAudioBuffer::Data {
     public:
 
+        // Settings. Both threads read them, but they only change when the buffer is set up.
+
         /** The number of channels allocated for the frame */
         unsigned int m_NumChannels;
 
-        /** The number of samples allocated for each channel buffer */
+        /** The number of samples allocated for each channel buffer. Always a power of two. */
         unsigned int m_Size;
 
-        /** The buffer's head. Points to the sample to be read by the output. */
-        mutable volatile unsigned int m_Head;
-
-        /** The buffer's tail. Points to the sample to be written by the input. */
-        volatile unsigned int m_Tail;
+        /** m_Size - 1. Converts the head and tail counters into buffer positions. */
+        unsigned int m_Mask;
 
         /** Sample precision */
         unsigned int m_Precision;
@@ -56,46 +214,169 @@ class syAudioBuffer::Data {
         /** The buffer holding the data */
         int* m_Data;
 
-        /** Indicates whether the buffer has been cleared. */
-        mutable volatile bool m_Clear;
+        /** Number of times that Clear() has been called. */
+        volatile unsigned int m_ClearRequests;
 
-        /** Quotient for samplerate conversion */
-        unsigned long m_Quotient;
+        /** The tail at the last call to Clear(): The reader discards the samples before it. */
+        volatile unsigned int m_ClearTail;
+
+        char m_ReaderPad[sy_cachelinesize];
+
+        // Reader's variables.
+
+        /** The buffer's head. Counts the samples read by the output. */
+        mutable volatile unsigned int m_Head;
 
-        /** Remainder for samplerate conversion */
-        unsigned long m_Remainder;
+        /** The reader's copy of m_Tail. */
+        mutable unsigned int m_CachedTail;
 
-        /** Remainder Counter for samplerate conversion */
-        unsigned long m_RCounter;
+        /** The value of m_ClearRequests the last time the reader cleared the buffer. */
+        mutable unsigned int m_ReaderClears;
 
-        /** The last input frequency that was given. */
+        /** Converts the samples read to the reader's precision. */
+        mutable sySampleConverter m_ReadConverter;
+
+        char m_WriterPad[sy_cachelinesize];
+
+        // Writer's variables.
+
+        /** The buffer's tail. Counts the samples written by the input. */
+        volatile unsigned int m_Tail;
+
+        /** The writer's copy of m_Head. */
+        unsigned int m_CachedHead;
+
+        /** The value of m_ClearRequests the last time the writer saw the buffer cleared. */
+        unsigned int m_WriterClears;
+
+        /** The last input frequency that was given; 0 to restart the resampling. */
         unsigned long m_LastInputFreq;
 
-        /** Copies a sample between two buffers. Does the precision conversion on-the-fly. */
-        static void CopySample(const int* src, int* dst,unsigned int numchannels, unsigned int srcprecision, unsigned int dstprecision);
+        /** Converts the input samples when the input frequency isn't the buffer's frequency. */
+        syAudioResampler m_Resampler;
+
+        /** The resampler's output, before it's copied into the buffer */
+        int* m_Resampled;
+
+        /** The number of samples that fit in m_Resampled */
+        unsigned int m_ResampledSize;
+
+        /** Converts the samples written to the buffer's precision. */
+        sySampleConverter m_WriteConverter;
+
+        char m_EndPad[sy_cachelinesize];
+
+        /** Sets up the resampler if the input frequency changed. */
+        void SetInputFrequency(unsigned int freq);
+
+        /** @brief Copies samples into the buffer and publishes the new tail. Called by the writer only.
+         *  The caller must make sure that there's room for them.
+         */
+        void Push(const int* src, unsigned int count, unsigned int srcprecision);
+
+        /** @brief Resamples and writes as many input samples as there's room for. Called by the writer only.
+         *  @return The number of input samples consumed.
+         */
+        unsigned int WriteResampled(const int* src, unsigned int count, unsigned int freq, unsigned int srcprecision);
+
+        /** @brief Gets the number of samples that the reader can read. Called by the reader only.
+         *  Discards the buffered samples if Clear() was called. The tail is only reloaded if the cached copy
+         *  has less than the wanted samples.
+         */
+        unsigned int GetReadable(unsigned int wanted) const;
+
+        /** @brief Gets the number of samples that the writer can write. Called by the writer only.
+         *  Restarts the resampling if Clear() was called. The head is only reloaded if the cached copy
+         *  has less than the wanted room.
+         */
+        unsigned int GetWritable(unsigned int wanted);
 };
 
-inline void syAudioBuffer::Data::CopySample(const int* src,int* dst, unsigned int numchannels, unsigned int srcprecision, unsigned int dstprecision) {
-    if(srcprecision > syAudioBuffer::maxbitspersample) { srcprecision = syAudioBuffer::maxbitspersample; }
-    if(dstprecision > syAudioBuffer::maxbitspersample) { dstprecision = syAudioBuffer::maxbitspersample; }
-    if(srcprecision == dstprecision) {
-        // Is it the same precision that we're handling?
-        for(unsigned int i = numchannels; i; --i, ++dst, ++src) {
-            *dst = *src;
+void syAudioBuffer::Data::SetInputFrequency(unsigned int freq) {
+    if(freq != m_LastInputFreq) {
+        // A different input frequency (or a cleared buffer) starts a new stream.
+        if(freq != m_Freq) {
+            m_Resampler.Init(freq, m_Freq, m_NumChannels);
+            // Make room for at least everything that one input sample can produce.
+            unsigned int size = m_Freq / freq + 2;
+            if(size < 1024) { size = 1024; }
+            if(size != m_ResampledSize) {
+                delete[] m_Resampled;
+                m_Resampled = new int[size*m_NumChannels];
+                m_ResampledSize = size;
+            }
         }
-    } else if(srcprecision < dstprecision) {
-        // Source has more precision than the destination; shift right.
-        unsigned int shifts = dstprecision - srcprecision;
-        for(unsigned int i = numchannels; i; --i, ++dst, ++src) {
-            *dst = *src >> shifts;
+        m_LastInputFreq = freq;
+    }
+}
+
+void syAudioBuffer::Data::Push(const int* src, unsigned int count, unsigned int srcprecision) {
+    // Copy the samples up to the end of the buffer, and then the ones that wrap around to the beginning.
+    unsigned int curtail = m_Tail;
+    unsigned int pos = curtail & m_Mask;
+    unsigned int first = m_Size - pos;
+    if(first > count) { first = count; }
+    m_WriteConverter.Convert(src, &m_Data[m_NumChannels*pos], m_NumChannels*first, srcprecision, m_Precision);
+    if(count > first) {
+        m_WriteConverter.Convert(src + m_NumChannels*first, m_Data, m_NumChannels*(count - first), srcprecision, m_Precision);
+    }
+    syAtomic::StoreRelease(&m_Tail, curtail + count);
+}
+
+unsigned int syAudioBuffer::Data::WriteResampled(const int* src, unsigned int count, unsigned int freq, unsigned int srcprecision) {
+    // We don't know beforehand how much room we'll need, so reload the head.
+    unsigned int room = GetWritable(m_Size);
+    SetInputFrequency(freq);
+    unsigned int written = 0;
+    while(written < count) {
+        // Feed the resampler as many samples as the room in the buffer (and in m_Resampled) allows.
+        unsigned int limit = (room < m_ResampledSize) ? room : m_ResampledSize;
+        unsigned int n = m_Resampler.GetInputCount(limit);
+        if(n > count - written) { n = count - written; }
+        if(!n) {
+            break; // Buffer full
         }
-    } else {
-        // Source has less precision than the destination; shift left.
-        unsigned int shifts = srcprecision - dstprecision;
-        for(unsigned int i = numchannels; i; --i, ++dst, ++src) {
-            *dst = *src << shifts;
+        unsigned int produced = m_Resampler.Process(src, n, m_Resampled, srcprecision);
+        Push(m_Resampled, produced, srcprecision);
+        room -= produced;
+        written += n;
+        src += n*m_NumChannels;
+    }
+    return written;
+}
+
+unsigned int syAudioBuffer::Data::GetReadable(unsigned int wanted) const {
+    unsigned int requests = syAtomic::LoadAcquire(&m_ClearRequests);
+    if(requests != m_ReaderClears) {
+        m_ReaderClears = requests;
+        unsigned int cleartail = syAtomic::LoadAcquire(&m_ClearTail);
+        m_CachedTail = syAtomic::LoadAcquire(&m_Tail);
+        // Never move the head backwards, nor past the tail.
+        unsigned int curhead = m_Head;
+        if(cleartail - curhead <= m_CachedTail - curhead) {
+            syAtomic::StoreRelease(&m_Head, cleartail);
         }
     }
+    unsigned int available = m_CachedTail - m_Head;
+    if(available < wanted) {
+        m_CachedTail = syAtomic::LoadAcquire(&m_Tail);
+        available = m_CachedTail - m_Head;
+    }
+    return available;
+}
+
+unsigned int syAudioBuffer::Data::GetWritable(unsigned int wanted) {
+    unsigned int requests = syAtomic::LoadAcquire(&m_ClearRequests);
+    if(requests != m_WriterClears) {
+        m_WriterClears = requests;
+        m_LastInputFreq = 0;
+    }
+    unsigned int room = m_Size - (m_Tail - m_CachedHead);
+    if(room < wanted) {
+        m_CachedHead = syAtomic::LoadAcquire(&m_Head);
+        room = m_Size - (m_Tail - m_CachedHead);
+    }
+    return room;
 }
 
 syAudioBuffer::syAudioBuffer(unsigned int numsamples, unsigned int numchannels, unsigned int precision, unsigned int freq) {
@@ -110,28 +391,36 @@ syAudioBuffer::syAudioBuffer(unsigned int numsamples, unsigned int numchannels,
     }
     m_Data->m_NumChannels = numchannels;
 
-    if(numsamples < minsamplesperbuffer) {
-        numsamples = minsamplesperbuffer;
-    }
     if(numsamples > maxsamplesperbuffer) {
         numsamples = maxsamplesperbuffer;
     }
-    m_Data->m_Size = numsamples + 1;
+    // Round up to a power of two (both limits are powers of two).
+    unsigned int size = minsamplesperbuffer;
+    while(size < numsamples) {
+        size <<= 1;
+    }
+    m_Data->m_Size = size;
+    m_Data->m_Mask = size - 1;
     m_Data->m_Data = new int[m_Data->m_NumChannels*m_Data->m_Size];
-    m_Data->m_Clear = true;
+    m_Data->m_ClearRequests = 0;
+    m_Data->m_ClearTail = 0;
     m_Data->m_Head = 0;
+    m_Data->m_CachedTail = 0;
+    m_Data->m_ReaderClears = 0;
     m_Data->m_Tail = 0;
+    m_Data->m_CachedHead = 0;
+    m_Data->m_WriterClears = 0;
 
     SetSamplePrecision(precision);
     SetSampleFrequency(freq);
 
-    m_Data->m_Quotient = 0;
-    m_Data->m_Remainder = 0;
-    m_Data->m_RCounter = 0;
     m_Data->m_LastInputFreq = 0;
+    m_Data->m_Resampled = 0;
+    m_Data->m_ResampledSize = 0;
 }
 
 syAudioBuffer::~syAudioBuffer() {
+    delete[] m_Data->m_Resampled;
     delete[] m_Data->m_Data;
     delete m_Data;
 }
@@ -141,11 +430,19 @@ unsigned int syAudioBuffer::GetSize() const {
 }
 
 unsigned int syAudioBuffer::GetLength() const {
-    unsigned int curhead = m_Data->m_Head;
-    unsigned int curtail = m_Data->m_Tail;
-    // We must obtain the values first because the calculation result could be altered by the other thread.
-    // This way we make sure the result is consistent, even if a bit late.
-    return (curtail >= curhead) ? (curtail - curhead) : ((m_Data->m_Size + curtail) - curhead);
+    // Read the head first: It can only grow up to the tail, so the tail read afterwards can't be behind it.
+    unsigned int curhead = syAtomic::LoadAcquire(&m_Data->m_Head);
+    unsigned int curtail = syAtomic::LoadAcquire(&m_Data->m_Tail);
+    if(syAtomic::LoadAcquire(&m_Data->m_ClearRequests) != m_Data->m_ReaderClears) {
+        // A Clear() is pending; the reader will discard the samples before the saved tail.
+        unsigned int cleartail = syAtomic::LoadAcquire(&m_Data->m_ClearTail);
+        if(cleartail - curhead <= curtail - curhead) {
+            curhead = cleartail;
+        }
+    }
+    unsigned int length = curtail - curhead;
+    // If both threads moved between the two reads, the result could be a bit off; keep it in range.
+    return (length > m_Data->m_Size) ? m_Data->m_Size : length;
 }
 
 unsigned int syAudioBuffer::GetNumChannels() const {
@@ -171,151 +468,194 @@ unsigned int syAudioBuffer::SetSampleFrequency(unsigned int freq) {
     if(freq < 1) { freq = 1; }
     if(freq > maxsamplefreq) { freq = maxsamplefreq; }
     m_Data->m_Freq = freq;
+    m_Data->m_LastInputFreq = 0; // Set up the resampler again on the next write
     return m_Data->m_Freq;
 }
 
 bool syAudioBuffer::Read(int* dest,unsigned int precision) const {
-    if(m_Data->m_Head == m_Data->m_Tail) { m_Data->m_Clear = true; return false; }
-    if(m_Data->m_Clear) { return false; } // Buffer empty
-    const int* ptr = &m_Data->m_Data[m_Data->m_NumChannels*m_Data->m_Head];
+    if(!m_Data->GetReadable(1)) {
+        return false; // Buffer empty
+    }
+    unsigned int curhead = m_Data->m_Head;
+    const int* ptr = &m_Data->m_Data[m_Data->m_NumChannels*(curhead & m_Data->m_Mask)];
     if(!precision) { precision = m_Data->m_Precision; } // Default
     // Copy the sample
-    syAudioBuffer::Data::CopySample(ptr,dest, m_Data->m_NumChannels, m_Data->m_Precision, precision);
-
-    syAtomic::MemoryBarrier(); // Make sure the data has been written before updating head
+    m_Data->m_ReadConverter.Convert(ptr, dest, m_Data->m_NumChannels, m_Data->m_Precision, precision);
 
-    // First calculate the new value of head, and then set the variable. Can't be set in 2 steps because
-    // the writer may read m_Data->m_Head.
-    m_Data->m_Head = (m_Data->m_Head + 1) % m_Data->m_Size;
+    // Publish the new head only after the sample has been copied.
+    syAtomic::StoreRelease(&m_Data->m_Head, curhead + 1);
     return true;
 }
 
 bool syAudioBuffer::Write(const int* src, unsigned int freq, unsigned int precision) {
-    if(GetLength() == m_Data->m_Size) {
+    // Set default values in case of 0
+    if(!freq) { freq = m_Data->m_Freq; }
+    if(!precision) { precision = m_Data->m_Precision; }
+
+    if(freq != m_Data->m_Freq) {
+        // Input sample frequency != buffer's sample frequency. We have to resample.
+        return (m_Data->WriteResampled(src, 1, freq, precision) == 1);
+    }
+    if(!m_Data->GetWritable(1)) {
         return false; // Buffer full
     }
-    if(m_Data->m_Clear) {
-        // Note that m_Clear could be set in the middle of this function call; there's
-        // nothing we can do about it, but the times that we can catch it, let's reset m_LastInputFreq.
-        m_Data->m_LastInputFreq = 0;
+    m_Data->SetInputFrequency(freq);
+    m_Data->Push(src, 1, precision);
+    return true;
+}
+
+unsigned int syAudioBuffer::ReadBlock(int* dest, unsigned int count, unsigned int precision) const {
+    if(!count) { return 0; }
+    unsigned int available = m_Data->GetReadable(count);
+    if(!available) {
+        return 0; // Buffer empty
+    }
+    if(count > available) { count = available; }
+    if(!precision) { precision = m_Data->m_Precision; } // Default
+
+    unsigned int numchannels = m_Data->m_NumChannels;
+    unsigned int curhead = m_Data->m_Head;
+    unsigned int pos = curhead & m_Data->m_Mask;
+
+    // Copy the samples up to the end of the buffer, and then the ones that wrapped around to the beginning.
+    unsigned int first = m_Data->m_Size - pos;
+    if(first > count) { first = count; }
+    m_Data->m_ReadConverter.Convert(&m_Data->m_Data[numchannels*pos], dest, numchannels*first, m_Data->m_Precision, precision);
+    if(count > first) {
+        m_Data->m_ReadConverter.Convert(m_Data->m_Data, dest + numchannels*first, numchannels*(count - first), m_Data->m_Precision, precision);
     }
+
+    syAtomic::StoreRelease(&m_Data->m_Head, curhead + count);
+    return count;
+}
+
+unsigned int syAudioBuffer::WriteBlock(const int* src, unsigned int count, unsigned int freq, unsigned int precision) {
+    if(!count) { return 0; }
     // Set default values in case of 0
     if(!freq) { freq = m_Data->m_Freq; }
     if(!precision) { precision = m_Data->m_Precision; }
 
-    syAtomic::MemoryBarrier();
-
-    // Calculate Quotient, remainder and set the counters to 0 for resampling.
-    if(freq != m_Data->m_LastInputFreq) {
-
-        // Explanation for the resampling:
-        //
-        // We divide the current frequency by the input frequency.
-        // If our sample freq. is 22050 Hz and the input freq. is 44100 Hz, we have a 0.5 coefficient;
-        // So for every input sample (at 44100 samples/sec), we have 0.5 output samples (at 22050 samples/sec).
-        // What we do is accumulate this coefficient with time (actually just the remainder), and when the
-        // sum is greater than one, we add it to the quotient.
-        // This quotient gives us the actual number of samples that we must copy into our destination buffer.
-        // For a coefficient of 0.5, every 2 input samples we get a quotient of 1, so that's what we actually
-        // put in the buffer.
-
-        // Let's do the opposite case. If our sample frequency is 44100 and the input frequency is 22050,
-        // Our quotient is 2. It means that we must copy the sample received 2 times.
-
-        // Now, for a mixed integer / fractional result. If our sample frequency is 48000 and the input
-        // frequency is 44100, we get a coefficient of 1.08843... which means a quotient of 1 and a
-        // remainder of 3900.
-        // So everytime we add 1 copy of the input sample to the buffer, and add 3900 to the counter.
-        // After the 12th time we're given a sample, we've added 3900 times 12 to the counter, which
-        // makes it equal to 46800. That is greater than 44100 (the input sample frequency), meaning that
-        // the remainder has reached an overflow. So we add 1 to the quotient and get the modulus.
-        // This makes the quotient = 1 (the original quotient) + 1 (the overflow) = 2,
-        // and the remainder counter is left at 2700 for the next input.
-        // Since the quotient is 2, we copy the input sample twice.
-
-        // The next overflow will come the 11th time, when the counter = 2700 + 3900*11 = 45600 = 44100 + 1500.
-        // So we copy the sample twice and leave the counter at 1500.
-        // And so on.
-
-        // A final example: Input frequency = 32000 Hz. Our frequency = 48000.
-        // coefficient = 48000 / 32000 = 1.5. Quotient = 1, remainder = 16000.
-        // The second time we'll have an overflow at 16000 + 16000 = 32000, leaving the counter at 0.
-
-        // Note that our sampling is rudimentary and we don't do anything to avoid aliasing artifacts.
-        // That belongs to the signal processing part of the application. The resampling provided here is
-        // implemented to simplify the data transfer routines.
-
-        m_Data->m_Quotient = m_Data->m_Freq / freq;
-        m_Data->m_Remainder = m_Data->m_Freq % freq;
-        m_Data->m_RCounter = 0;
-        syAtomic::MemoryBarrier();
-        m_Data->m_LastInputFreq = freq;
-    }
-
-    syAtomic::MemoryBarrier();
-
-    if(freq == m_Data->m_Freq) {
-
-        // Input sample frequency == buffer's sample frequency. Copy.
-        int* ptr = &m_Data->m_Data[m_Data->m_NumChannels*m_Data->m_Tail];
-        syAudioBuffer::Data::CopySample(src, ptr, m_Data->m_NumChannels, precision, m_Data->m_Precision);
-        syAtomic::MemoryBarrier();
-        m_Data->m_Tail = (m_Data->m_Tail + 1) % m_Data->m_Size;
-    } else {
-
+    if(freq != m_Data->m_Freq) {
         // Input sample frequency != buffer's sample frequency. We have to resample.
+        return m_Data->WriteResampled(src, count, freq, precision);
+    }
+    unsigned int written = m_Data->GetWritable(count);
+    m_Data->SetInputFrequency(freq);
+    if(written > count) { written = count; }
+    m_Data->Push(src, written, precision);
+    return written;
+}
 
-        // Calculate the amount in samples that we need to advance.
-        // See the above explanation for the logic behind the resampling.
-        unsigned int quotient = m_Data->m_Quotient;
-        unsigned int newr = m_Data->m_Remainder + m_Data->m_RCounter;
-        if(newr >= m_Data->m_LastInputFreq) {
-            quotient += newr / m_Data->m_LastInputFreq;
-            newr %= m_Data->m_LastInputFreq;
-        }
+unsigned int syAudioBuffer::ReadBlock(syAudioBlock* dest, unsigned int count) const {
+    unsigned int numchannels = m_Data->m_NumChannels;
+    if(dest->GetNumChannels() != numchannels || dest->GetCapacity() < count) {
+        dest->Realloc(numchannels, count);
+    }
+    dest->SetLength(0);
+    if(!count) { return 0; }
+    unsigned int available = m_Data->GetReadable(count);
+    if(!available) {
+        return 0; // Buffer empty
+    }
+    if(count > available) { count = available; }
 
-        if(quotient + GetLength() >= GetSize()) {
-            return false; // Buffer full
-        }
+    unsigned int curhead = m_Data->m_Head;
+    unsigned int pos = curhead & m_Data->m_Mask;
+
+    // Convert the samples up to the end of the buffer, and then the ones that wrapped around to the beginning.
+    unsigned int first = m_Data->m_Size - pos;
+    if(first > count) { first = count; }
+    dest->FromInterleaved(&m_Data->m_Data[numchannels*pos], 0, first, m_Data->m_Precision);
+    if(count > first) {
+        dest->FromInterleaved(m_Data->m_Data, first, count - first, m_Data->m_Precision);
+    }
+    dest->SetLength(count);
 
-        // All clear. Let's add the samples.
-        // NOTE: This operation assumes that we're the only thread writing to the buffer.
-        // Otherwise we'd have to check for alterations in Head and Tail.
-        for(unsigned int i = quotient; i; --i) {
-            int* ptr = &m_Data->m_Data[m_Data->m_NumChannels*m_Data->m_Tail];
-            syAudioBuffer::Data::CopySample(src, ptr, m_Data->m_NumChannels, precision, m_Data->m_Precision);
-            // We have to update tail everytime because we could wrap at the end of the buffer.
-            m_Data->m_Tail = (m_Data->m_Tail + 1) % m_Data->m_Size;
-        }
+    syAtomic::StoreRelease(&m_Data->m_Head, curhead + count);
+    return count;
+}
 
-        syAtomic::MemoryBarrier();
+unsigned int syAudioBuffer::WriteBlock(const syAudioBlock* src, unsigned int freq) {
+    unsigned int numchannels = m_Data->m_NumChannels;
+    unsigned int count = src->GetLength();
+    if(!count || src->GetNumChannels() != numchannels) { return 0; }
+    if(!freq) { freq = m_Data->m_Freq; }
 
-        // Now, update the remainder counter.
-        m_Data->m_RCounter = newr;
+    if(freq != m_Data->m_Freq) {
+        // The resampler works with integers; convert the block a chunk at a time.
+        int converted[4096];
+        unsigned int chunk = 4096 / numchannels;
+        unsigned int written = 0;
+        while(written < count) {
+            unsigned int n = (count - written < chunk) ? count - written : chunk;
+            src->ToInterleaved(converted, written, n, m_Data->m_Precision);
+            unsigned int done = m_Data->WriteResampled(converted, n, freq, m_Data->m_Precision);
+            written += done;
+            if(done < n) {
+                break; // Buffer full
+            }
+        }
+        return written;
     }
-    if(m_Data->m_Clear) {
-        m_Data->m_LastInputFreq = 0;
-        syAtomic::MemoryBarrier();
-        m_Data->m_Clear = false;
+    unsigned int written = m_Data->GetWritable(count);
+    m_Data->SetInputFrequency(freq);
+    if(written > count) { written = count; }
+
+    unsigned int curtail = m_Data->m_Tail;
+    unsigned int pos = curtail & m_Data->m_Mask;
+    unsigned int first = m_Data->m_Size - pos;
+    if(first > written) { first = written; }
+    src->ToInterleaved(&m_Data->m_Data[numchannels*pos], 0, first, m_Data->m_Precision);
+    if(written > first) {
+        src->ToInterleaved(m_Data->m_Data, first, written - first, m_Data->m_Precision);
     }
-    return true;
+    syAtomic::StoreRelease(&m_Data->m_Tail, curtail + written);
+    return written;
 }
 
 bool syAudioBuffer::ReadInto(syAudioBuffer* dest) const {
-    if(m_Data->m_Head == m_Data->m_Tail) { m_Data->m_Clear = true; return false; }
-    if(m_Data->m_Clear) { return false; } // Buffer empty
-    int* ptr = &m_Data->m_Data[m_Data->m_NumChannels*m_Data->m_Head];
-    if(dest->Write(ptr)) {
-        m_Data->m_Head = (m_Data->m_Head + 1) % m_Data->m_Size;
+    if(!m_Data->GetReadable(1)) {
+        return false; // Buffer empty
+    }
+    unsigned int curhead = m_Data->m_Head;
+    const int* ptr = &m_Data->m_Data[m_Data->m_NumChannels*(curhead & m_Data->m_Mask)];
+    if(dest->Write(ptr, m_Data->m_Freq, m_Data->m_Precision)) {
+        syAtomic::StoreRelease(&m_Data->m_Head, curhead + 1);
         return true;
     }
     return false;
 }
 
+unsigned int syAudioBuffer::ReadBlockInto(syAudioBuffer* dest, unsigned int count) const {
+    if(!count) { return 0; }
+    unsigned int available = m_Data->GetReadable(count);
+    if(!available) {
+        return 0; // Buffer empty
+    }
+    if(count > available) { count = available; }
+
+    unsigned int numchannels = m_Data->m_NumChannels;
+    unsigned int curhead = m_Data->m_Head;
+    unsigned int pos = curhead & m_Data->m_Mask;
+
+    // Write the samples up to the end of the buffer, and then the ones that wrapped around to the beginning.
+    // The destination converts them to its own precision and frequency.
+    unsigned int first = m_Data->m_Size - pos;
+    if(first > count) { first = count; }
+    unsigned int written = dest->WriteBlock(&m_Data->m_Data[numchannels*pos], first, m_Data->m_Freq, m_Data->m_Precision);
+    if(written == first && count > first) {
+        written += dest->WriteBlock(m_Data->m_Data, count - first, m_Data->m_Freq, m_Data->m_Precision);
+    }
+
+    syAtomic::StoreRelease(&m_Data->m_Head, curhead + written);
+    return written;
+}
+
 bool syAudioBuffer::WriteFrom(const syAudioBuffer* src) {
     return src->ReadInto(this);
 }
 
 void syAudioBuffer::Clear() const {
-    m_Data->m_Clear = true;
+    syAtomic::StoreRelease(&m_Data->m_ClearTail, syAtomic::LoadAcquire(&m_Data->m_Tail));
+    syAtomic::fetch_and_add1((unsigned int*)&m_Data->m_ClearRequests);
 }
@@ -12,6 +12,8 @@
 #ifndef syaudiobuffer_h
 #define syaudiobuffer_h
 
+class syAudioBlock;
+
 class syAudioBuffer {
 
     public:
@@ -23,7 +25,7 @@ class syAudioBuffer {
         static const unsigned int maxsamplesperbuffer;
 
         /** @brief Constructor.
-         *  @param numsamples The number of samples to reserve for this buffer.
+         *  @param numsamples The number of samples to reserve for this buffer. Rounded up to a power of two.
          *  @param numchannels The number of channels to reserve for this buffer.
          *  @param precision The precision, in bits per sample, to assign to this buffer.
          *  @param freq The frequency, in Hz, to assign to this buffer.
@@ -33,7 +35,7 @@ class syAudioBuffer {
         /** Standard destructor. */
         ~syAudioBuffer();
 
-        /** Gets the number of samples in this buffer */
+        /** Gets the number of samples that this buffer can hold */
         unsigned int GetSize() const;
 
         /** Returns the actual length of the buffer, in samples. */
@@ -69,9 +71,9 @@ class syAudioBuffer {
          *  @return true if the sample was read correctly; false if the buffer's empty.
          *
          *  @note We declare this method as 'const' so we can pass the buffer as 'const' when
-         *        we want only to read the buffer. But since reading actually alters two hidden variables
-         *        (namely m_Head and m_Clear), we declare them as 'mutable', which allows them to be modified
-         *        even if the object was accessed as 'const'.
+         *        we want only to read the buffer. But since reading actually alters the reader's hidden variables
+         *        (namely the head and the reader's copy of the tail), we declare them as 'mutable', which allows
+         *        them to be modified even if the object was accessed as 'const'.
          */
         bool Read(int* dst, unsigned int precision = 0) const;
 
@@ -79,27 +81,84 @@ class syAudioBuffer {
          *
          *  @param src The source minibuffer for the sample. Must have as many integers as channels in the data.
          *  @param freq The input sample frequency, in Hz.
-         *         The input will be resampled (i.e. ignored and/or duplicated) to match output frequency.
+         *         The input will be resampled with a band-limited filter (see syAudioResampler) to match output
+         *         frequency; the filter holds back a few samples until the next ones arrive.
          *         Set freq to 0 if you want to match the buffer's sampling frequency.
          *  @param precision The source precision, in bits per sample. Use 0 to match the buffer's precision.
          *  @return true if the sample was written correctly; false if the buffer's full.
          */
         bool Write(const int* src, unsigned int freq = 0, unsigned int precision = 0);
 
+        /** @brief Reads up to count samples from the buffer and stores them in dst.
+         *
+         *  Unlike calling Read() count times, the samples are copied in at most two contiguous spans
+         *  (before and after the wrap point), and the head is published only once for the whole block.
+         *
+         *  @param dst The destination buffer. Must have room for count * GetNumChannels() integers (interleaved).
+         *  @param count The maximum number of samples to read.
+         *  @param precision The destination precision, in bits per sample. 0 to use the same precision as the buffer
+         *  @return the number of samples actually read; 0 if the buffer's empty.
+         */
+        unsigned int ReadBlock(int* dst, unsigned int count, unsigned int precision = 0) const;
+
+        /** @brief Writes up to count samples into the buffer from src.
+         *
+         *  Unlike calling Write() count times, the samples are copied in at most two contiguous spans
+         *  (before and after the wrap point), and the tail is published only once for the whole block.
+         *
+         *  @param src The source buffer, holding count * GetNumChannels() integers (interleaved).
+         *  @param count The number of samples to write.
+         *  @param freq The input sample frequency, in Hz. Resampled like in Write(); 0 to match the buffer's frequency.
+         *  @param precision The source precision, in bits per sample. Use 0 to match the buffer's precision.
+         *  @return the number of source samples actually written; less than count if the buffer became full.
+         */
+        unsigned int WriteBlock(const int* src, unsigned int count, unsigned int freq = 0, unsigned int precision = 0);
+
+        /** @brief Reads up to count samples from the buffer and converts them to floating point.
+         *
+         *  The samples are converted straight from the buffer into the block's channels (see syAudioBlock).
+         *  @param dst The destination block. It's reallocated if it doesn't have the buffer's number of channels
+         *         or room for count samples. Its length is set to the number of samples read.
+         *  @param count The maximum number of samples to read.
+         *  @return the number of samples actually read; 0 if the buffer's empty.
+         */
+        unsigned int ReadBlock(syAudioBlock* dst, unsigned int count) const;
+
+        /** @brief Converts the samples of a floating point block to integers and writes them into the buffer.
+         *
+         *  @param src The source block. Must have the buffer's number of channels; all its samples
+         *         (up to its length) are written.
+         *  @param freq The input sample frequency, in Hz. Resampled like in Write(); 0 to match the buffer's frequency.
+         *  @return the number of source samples actually written; less than the block's length if the buffer
+         *          became full. 0 if the number of channels doesn't match.
+         */
+        unsigned int WriteBlock(const syAudioBlock* src, unsigned int freq = 0);
+
         /**  @brief Reads one sample of data and writes it into a destination buffer.
-         *   @param dst the destination buffer.
+         *   @param dst the destination buffer. The sample is converted to its precision and frequency.
          *   @return true on success; false if either the source was empty or the destination was full.
          */
         bool ReadInto(syAudioBuffer* dst) const;
 
+        /**  @brief Reads up to count samples and writes them into a destination buffer.
+         *
+         *   Like ReadBlock() and WriteBlock(), the samples are moved in at most two contiguous spans, and are
+         *   converted to the destination's precision and frequency on the way.
+         *   @param dst the destination buffer. Must have the same number of channels.
+         *   @param count The maximum number of samples to move.
+         *   @return the number of samples moved; less than count if the source was empty or the destination became full.
+         */
+        unsigned int ReadBlockInto(syAudioBuffer* dst, unsigned int count) const;
+
         /**  @brief Writes one sample of data from a source buffer.
          *   @param src The source buffer.
          *   @return true on success; false if either the source was empty or the destination was full.
          */
         bool WriteFrom(const syAudioBuffer* src);
 
-        /**  @brief Signals the buffer to be cleared for the next write.
-         *   @note Reads done before the next write, will return false.
+        /**  @brief Signals the buffer to be cleared.
+         *   @note The next read discards all the samples written before this call, and the next write restarts
+         *   the resampling. Samples written after the call are kept.
          *   We set this function to const because technically, a reader can clear the buffer if it
          *   reads all the input, so setting a flag will just suffice.
          */
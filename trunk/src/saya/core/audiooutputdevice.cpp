@@ -18,6 +18,9 @@ const unsigned int DefaultAODNumChannels = 2;
 const unsigned int DefaultAODBufferSize = 88200;
 const unsigned int DefaultAODPrecision = 16;
 
+/** Maximum number of samples moved at once by LoadAudioData(), so that a stop signal isn't missed for long. */
+static const unsigned long sy_loadblocksize = 4096;
+
 class syAudioOutputDeviceData {
     public:
         syAudioOutputDeviceData() : m_Condition(m_Mutex) {}
@@ -54,6 +57,9 @@ class syAudioOutputDeviceData {
 
         /** Default precision. */
         unsigned int m_DefaultPrecision;
+
+        /** Number of samples handed to the hardware since the last Clear(). Protected by m_Mutex. */
+        unsigned long long m_PlayedSamples;
         };
 
 AudioOutputDevice::AudioOutputDevice() {
@@ -61,12 +67,14 @@ AudioOutputDevice::AudioOutputDevice() {
     m_IsOutput = true;
 
     m_Data = new syAudioOutputDeviceData;
+    m_Data->m_Buffer = NULL;
 
     // We must keep a copy of the parameters because we haven't allocated the buffer yet.
     m_Data->m_Freq        = m_Data->m_DefaultFreq        = DefaultAODFrequency;
     m_Data->m_NumChannels = m_Data->m_DefaultNumChannels = DefaultAODNumChannels;
     m_Data->m_BufSize     = m_Data->m_DefaultBufSize     = DefaultAODBufferSize;
     m_Data->m_Precision   = m_Data->m_DefaultPrecision   = DefaultAODPrecision;
+    m_Data->m_PlayedSamples = 0;
 }
 
 AudioOutputDevice::~AudioOutputDevice() {
@@ -156,6 +164,11 @@ unsigned int AudioOutputDevice::GetBufferSize() {
     return m_Data->m_BufSize;
 }
 
+unsigned int AudioOutputDevice::GetBufferedSamples() {
+    if(!m_Data->m_Buffer) return 0;
+    return m_Data->m_Buffer->GetLength();
+}
+
 unsigned int AudioOutputDevice::SetBufferSize(unsigned int newsize) {
     if(newsize < syAudioBuffer::minsamplesperbuffer) { newsize = syAudioBuffer::minsamplesperbuffer; }
     if(newsize > syAudioBuffer::maxsamplesperbuffer) { newsize = syAudioBuffer::maxsamplesperbuffer; }
@@ -194,12 +207,16 @@ unsigned long AudioOutputDevice::LoadAudioData(const syAudioBuffer* buf, unsigne
     sySafeMutexLocker lock(*m_InputAudioMutex, this);
     if(lock.IsLocked()) {
         // Read the source buffer until our buffer is filled or the other buffer is empty.
+        // The samples are moved a block at a time, so that the precision conversion can be vectorized.
 
         while(!MustStop() && !(numsamples && samplesread >= numsamples)) {
-            if(!buf->ReadInto(m_Data->m_Buffer)) {
+            unsigned long count = numsamples ? numsamples - samplesread : sy_loadblocksize;
+            if(count > sy_loadblocksize) { count = sy_loadblocksize; }
+            unsigned int moved = buf->ReadBlockInto(m_Data->m_Buffer, count);
+            if(!moved) {
                 break;
             }
-            ++samplesread;
+            samplesread += moved;
         }
     }
     return samplesread;
@@ -208,6 +225,27 @@ unsigned long AudioOutputDevice::LoadAudioData(const syAudioBuffer* buf, unsigne
 void AudioOutputDevice::Clear() {
     if(!IsOk()) return;
     m_Data->m_Buffer->Clear();
+    syMutexLocker lock(m_Data->m_Mutex);
+    m_Data->m_PlayedSamples = 0;
+}
+
+unsigned long long AudioOutputDevice::GetPlayedSamples() {
+    unsigned long long result;
+    {
+        syMutexLocker lock(m_Data->m_Mutex);
+        result = m_Data->m_PlayedSamples;
+    }
+    unsigned long latency = GetDeviceLatency();
+    return (result > latency) ? result - latency : 0;
+}
+
+void AudioOutputDevice::AddPlayedSamples(unsigned long numsamples) {
+    syMutexLocker lock(m_Data->m_Mutex);
+    m_Data->m_PlayedSamples += numsamples;
+}
+
+unsigned long AudioOutputDevice::GetDeviceLatency() {
+    return 0; // Default
 }
 
 
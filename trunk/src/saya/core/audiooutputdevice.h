@@ -33,6 +33,8 @@ class syAudioOutputDeviceData;
   * SetDeviceSampleFreq()       - Tries to Set the output device's sample frequency.
   * SetDeviceBytesPerSample()   - Tries to set the output device's bytes-per-sample size.
   * GetDeviceNumChannels()      - Gets the output device's number of channels.
+  * HasPlaybackClock()          - Returns true if RenderAudioData() reports the played samples with AddPlayedSamples().
+  * GetDeviceLatency()          - Gets the number of samples queued in the hardware.
   *
   * These protected methods are used by the derived classes to implement low-level audio playback / encoding.
   */
@@ -51,6 +53,9 @@ class AudioOutputDevice : public AVDevice {
         /** Returns the output buffer length, in samples. */
         unsigned int GetBufferSize();
 
+        /** Returns the number of samples waiting in the buffer to be played/encoded. */
+        unsigned int GetBufferedSamples();
+
         /** Sets the default buffer length for the next Init(). */
         unsigned int SetBufferSize(unsigned int newsize);
 
@@ -106,9 +111,24 @@ class AudioOutputDevice : public AVDevice {
          */
         virtual bool IsEncoder() { return false; }
 
-        /** Mutes the audio output device. */
+        /** Mutes the audio output device. Also resets the count of played samples. */
         virtual void Clear();
 
+        /** @brief Gets the number of samples that have been heard since the last Clear().
+         *
+         *  This is the count reported by the device with AddPlayedSamples(), minus the samples that are
+         *  still queued in the hardware (see GetDeviceLatency()). It's the audio clock used for A/V sync.
+         *  @return The number of samples, at GetSampleFreq().
+         */
+        unsigned long long GetPlayedSamples();
+
+        /** @brief Tells whether the device reports its played samples.
+         *
+         *  Devices that call AddPlayedSamples() from RenderAudioData() must return true, so that
+         *  their played samples can be used as the playback clock (see GetPlayedSamples()).
+         */
+        virtual bool HasPlaybackClock() { return false; }
+
     protected:
 
         /** @brief Initializes the audio output and sets the frequency, number of channels and sample precision.
@@ -141,6 +161,16 @@ class AudioOutputDevice : public AVDevice {
           */
         virtual void RenderAudioData(const syAudioBuffer* buf);
 
+        /** @brief Adds samples to the count of played samples (see GetPlayedSamples()).
+         *  Must be called by RenderAudioData() once the samples have been handed to the hardware.
+         */
+        void AddPlayedSamples(unsigned long numsamples);
+
+        /** @brief Gets the number of samples handed to the hardware that haven't been heard yet.
+         *  Used by GetPlayedSamples(). The default implementation returns 0.
+         */
+        virtual unsigned long GetDeviceLatency();
+
         /** Returns the device's sample frequency in Hz. */
         virtual unsigned int GetDeviceSampleFreq();
 
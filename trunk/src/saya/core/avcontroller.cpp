@@ -8,10 +8,19 @@
  **************************************************************/
 
 #include "avcontroller.h"
+#include "aborter.h"
 #include "sythread.h"
 #include "avsource.h"
 #include "videooutputdevice.h"
 #include "audiooutputdevice.h"
+#include "audiobuffer.h"
+#include "syaudioblock.h"
+#include "sytimestretcher.h"
+#include "syframescheduler.h"
+#include "syframequeue.h"
+#include "syreverseframereader.h"
+#include "syframecache.h"
+#include "sybitmap.h"
 
 #include "debuglog.h" // Remove when debugging is finished
 #include "systring.h" // Remove when debugging is finished
@@ -29,6 +38,15 @@ namespace AVControllerConsts {
     unsigned int MinimumPlaybackDelay = 1000 / static_cast<unsigned int>(DefaultMaximumFramerate);
     const unsigned long DefaultAudioGranularity = 100;
     const unsigned long MinimumAudioGranularity = 10;
+    const avtime_t DefaultSyncTolerance = 40000000; // 40 ms, one frame at 25 fps.
+    const avtime_t MinimumSyncTolerance = 1000000;
+
+    /** Number of audio granules that the device can go without reporting played samples before the playback
+     *  clock stops following it. */
+    const unsigned int ClockStallGranules = 4;
+
+    /** Maximum time that the video threads sleep when there's nothing to do; they're woken up to pause or stop. */
+    const avtime_t IdleWaitTime = 100000000;
 
     // 1 meg for stack is quite a good size. We're using 4 threads max, so 4 megs isn't a bad size.
     const unsigned long AVThreadStackSize = 1048576;
@@ -36,7 +54,8 @@ namespace AVControllerConsts {
 
 using namespace AVControllerConsts;
 
-class AVControllerData {
+/** The controller's data is also the syAborter of the long operations of playback (see InternalMustAbort()). */
+class AVControllerData : public syAborter {
     public:
         /** Constructor */
         AVControllerData(AVController* parent);
@@ -88,6 +107,8 @@ class AVControllerData {
         void PlaybackAudioInLoop();
         /** Playback Loop for video In. */
         void PlaybackVideoInLoop();
+        /** Playback Loop for video In, at negative speeds. */
+        void PlaybackReverseVideoInLoop();
         /** Playback Loop for Audio Out. */
         void PlaybackAudioOutLoop();
         /** Playback Loop for Video Out. */
@@ -102,6 +123,21 @@ class AVControllerData {
         /** Encoding Loop for Video Out. */
         void EncodingVideoOutLoop();
 
+        /** @brief Called by each encoding stage when it's done with the whole stream.
+         *
+         *  The last stage to finish marks the encoding as finished (see AVController::GetEncodingStats()).
+         */
+        void EncodingStageDone();
+
+        /** @brief Gets the source frame of the given video frame sent to the encoder.
+         *
+         *  The source advances m_PlaybackSpeed frames per encoded frame from m_EncodingStartFrame; the fractional
+         *  part tells how far into the source frame we are. At speeds below 1.0, a source frame is encoded
+         *  more than once.
+         *  @param count The number of frames encoded since the encoding was started or resumed.
+         */
+        double GetEncodingSourceFrame(unsigned long count);
+
         /** Returns true if the Video In thread is running. */
         bool IsVideoInRunning();
         /** Returns true if the Audio In thread is running. */
@@ -128,6 +164,61 @@ class AVControllerData {
         /** Returns true if any of the threads are alive, false otherwise. */
         bool IsAlive();
 
+        /** @brief Returns true if the audio output is the playback clock.
+         *
+         *  That's the case when audio is being played (not in stutter mode) by a device that reports
+         *  its played samples (see AudioOutputDevice::HasPlaybackClock()).
+         */
+        bool IsAudioClock();
+
+        /** Returns true if the audio input has been read up to its end (i.e. it's shorter than the video). */
+        bool IsAudioAtEnd();
+
+        /** @brief Returns true if the audio can be heard at the current playback speed.
+         *
+         *  Audio is time-stretched (see syTimeStretcher) at speeds other than 1.0, and muted at the speeds
+         *  the stretcher doesn't support (including reverse playback).
+         */
+        bool IsAudioAudible();
+
+        /** Returns true if the video plays in reverse (i.e. the playback speed is negative). */
+        bool IsReverse();
+
+        /** Gets the rate at which the playback clock runs: the absolute value of the playback speed. */
+        double GetClockRate();
+
+        /** @brief Gets the position of the last audio sample heard.
+         *  @note Valid only if IsAudioClock() returns true.
+         */
+        avtime_t GetPlayedAudioPos();
+
+        /** @brief Gets the current playback position, according to the playback clock.
+         *
+         *  If IsAudioClock() is true, the clock is the audio heard (see GetPlayedAudioPos()); the time
+         *  elapsed since the device last reported played samples is added to it, so that the clock advances
+         *  smoothly between reports. Once the audio has been read to its end, or the device hasn't reported
+         *  for ClockStallGranules granules, the clock continues on the system's from there.
+         *  Otherwise, the clock is the system's since m_StartTime, scaled by GetClockRate();
+         *  in reverse, it runs backwards from m_StartVideoPos, and stops at 0.
+         *  @note Called by the Video In and Video Out threads.
+         */
+        avtime_t GetPlaybackClock();
+
+        /** @brief Sends time-stretched audio to the output device, for playback at speeds other than 1.0.
+         *
+         *  The stretched samples that the device couldn't take are kept in m_StretchBuffer and sent first
+         *  on the next call.
+         *  @param numsamples The number of samples to produce.
+         *  @return The number of samples sent.
+         *  @note Called only by the Audio In thread.
+         */
+        unsigned long SendStretchedAudio(unsigned long numsamples);
+
+        /** @brief Discards the audio held by the stretcher. Called when playback starts or resumes.
+         *  @note Called only by the Audio In thread.
+         */
+        void ResetStretcher();
+
         /** Current playback framerate. */
         volatile float m_FrameRate;
 
@@ -188,6 +279,94 @@ class AVControllerData {
         /** The current position for audio in the current playback. Used for relative seeking. */
         volatile avtime_t m_CurrentAudioPos;
 
+        /** @brief Maximum distance between the video and the playback clock.
+         *
+         *  @see AVController::SetSyncTolerance
+         */
+        volatile avtime_t m_SyncTolerance;
+
+        /** The system time (see syGetNanoTicks()) when playback was started or resumed. */
+        avtime_t m_StartTime;
+
+        /** The played samples the last time GetPlaybackClock() read them. */
+        unsigned long long m_ClockSamples;
+
+        /** The system time when m_ClockSamples changed. */
+        avtime_t m_ClockTicks;
+
+        /** Protects m_ClockSamples and m_ClockTicks. */
+        syMutex m_ClockMutex;
+
+        /** Time stretcher for playback at speeds other than 1.0. */
+        syTimeStretcher* m_Stretcher;
+
+        /** Stretched audio waiting to be sent to the output device. Created on demand. */
+        syAudioBuffer* m_StretchBuffer;
+
+        /** Audio read from the source, to be stretched. */
+        syAudioBlock* m_StretchIn;
+
+        /** Audio received from the stretcher. */
+        syAudioBlock* m_StretchOut;
+
+        /** Times the video frames presented by the Video Out thread. */
+        syFrameScheduler* m_Scheduler;
+
+        /** Frames decoded by the Video In thread, waiting to be presented by the Video Out thread. */
+        syFrameQueue* m_FrameQueue;
+
+        /** Number of frames in m_FrameQueue for the next playback. @see AVController::SetVideoQueueSize */
+        volatile unsigned int m_VideoQueueSize;
+
+        /** Reads the video backwards for the Video In thread, when playing in reverse. */
+        syReverseFrameReader* m_ReverseReader;
+
+        /** Number of frames in each chunk of m_ReverseReader. @see AVController::SetReverseChunkSize */
+        volatile unsigned int m_ReverseChunkSize;
+
+        // Encoding
+
+        /** Flag telling that the video is being encoded (i.e. it's enabled, and there are devices for it). */
+        volatile bool m_EncodeVideo;
+
+        /** Flag telling that the audio is being encoded. */
+        volatile bool m_EncodeAudio;
+
+        /** Flag set by the Video In thread when it has sent the last frame to encode. */
+        volatile bool m_VideoInDone;
+
+        /** Flag set by the Audio In thread when it has sent the last sample to encode. */
+        volatile bool m_AudioInDone;
+
+        /** Stream position where the encoding ends. */
+        avtime_t m_EncodingEndPos;
+
+        /** Source frame (with its fractional part) of the first frame encoded. @see GetEncodingSourceFrame */
+        double m_EncodingStartFrame;
+
+        /** Position where Pause() left the video source for the encoding to resume. */
+        avtime_t m_EncodingResumePos;
+
+        /** Fractional part of the source frame at m_EncodingResumePos. */
+        double m_EncodingResumeFraction;
+
+        /** The system time when the encoding was started. */
+        avtime_t m_EncodingStartTime;
+
+        /** The system time when the encoding finished; 0 while it's in progress. */
+        volatile avtime_t m_EncodingEndTime;
+
+        /** Number of encoding stages (i.e. threads) that haven't finished yet. Protected by m_EncodingMutex. */
+        unsigned int m_EncodingStages;
+
+        syMutex m_EncodingMutex;
+
+        /** Number of video frames sent to the output device. */
+        volatile unsigned long m_FramesEncoded;
+
+        /** Number of audio samples sent to the output device. */
+        volatile unsigned long long m_SamplesEncoded;
+
         AVController* m_Parent;
 
         /** Thread for handling Audio Input. */
@@ -198,6 +377,12 @@ class AVControllerData {
         syThread* m_AudioOutThread;
         /** Thread for handling Video Output. */
         syThread* m_VideoOutThread;
+
+    protected:
+        /** Tells the long operations of playback (i.e. decoding a chunk for reverse playback) to stop when
+         *  playback is paused or stopped.
+         */
+        virtual bool InternalMustAbort();
 };
 
 // ------------------------------
@@ -333,12 +518,39 @@ m_StartVideoPos(0),
 m_StartAudioPos(0),
 m_CurrentVideoPos(0),
 m_CurrentAudioPos(0),
+m_SyncTolerance(DefaultSyncTolerance),
+m_StartTime(0),
+m_ClockSamples(0),
+m_ClockTicks(0),
+m_Stretcher(new syTimeStretcher),
+m_StretchBuffer(NULL),
+m_StretchIn(new syAudioBlock),
+m_StretchOut(new syAudioBlock),
+m_Scheduler(new syFrameScheduler),
+m_FrameQueue(new syFrameQueue),
+m_VideoQueueSize(syFrameQueue::DefaultCapacity),
+m_ReverseReader(new syReverseFrameReader),
+m_ReverseChunkSize(syReverseFrameReader::DefaultChunkSize),
+m_EncodeVideo(false),
+m_EncodeAudio(false),
+m_VideoInDone(false),
+m_AudioInDone(false),
+m_EncodingEndPos(0),
+m_EncodingStartFrame(0.0),
+m_EncodingResumePos(0),
+m_EncodingResumeFraction(0.0),
+m_EncodingStartTime(0),
+m_EncodingEndTime(0),
+m_EncodingStages(0),
+m_FramesEncoded(0),
+m_SamplesEncoded(0),
 m_Parent(parent),
 m_AudioInThread(new syAudioInThread(this)),
 m_VideoInThread(new syVideoInThread(this)),
 m_AudioOutThread(new syAudioOutThread(this)),
 m_VideoOutThread(new syVideoOutThread(this))
 {
+    m_ReverseReader->SetAborter(this);
 }
 
 AVControllerData::~AVControllerData() {
@@ -346,10 +558,22 @@ AVControllerData::~AVControllerData() {
     m_AudioOutThread->Delete();
     m_VideoInThread->Delete();
     m_AudioInThread->Delete();
+    delete m_StretchOut;
+    delete m_StretchIn;
+    delete m_StretchBuffer;
+    delete m_Stretcher;
+    delete m_ReverseReader;
+    delete m_FrameQueue;
+    delete m_Scheduler;
 }
 
 void AVControllerData::StartEncoding() {
     if(!m_Parent->IsEncoderOnly()) { return; } // Playback streams do not concern us.
+    if(!syThread::IsMain()) { return; }
+    // The stages of the last encoding may still be pausing themselves.
+    while(IsPlaying()) {
+        syMilliSleep(1);
+    }
     m_StartVideoPos = 0;
     m_StartAudioPos = 0;
     if(m_VideoIn) {
@@ -358,8 +582,41 @@ void AVControllerData::StartEncoding() {
     if(m_AudioIn) {
         m_StartAudioPos = m_AudioIn->GetAudioPos();
     }
+    m_CurrentVideoPos = m_StartVideoPos;
+    m_CurrentAudioPos = m_StartAudioPos;
+    avtime_t startpos = (m_VideoEnabled && m_VideoIn) ? m_StartVideoPos : m_StartAudioPos;
+    m_EncodingEndPos = m_PlaybackDuration ? startpos + m_PlaybackDuration : m_Parent->GetLength();
+    m_EncodingStartFrame = 0.0;
+    if(m_VideoIn) {
+        m_EncodingStartFrame = m_VideoIn->GetFrameIndex(m_StartVideoPos);
+        if(m_StartVideoPos == m_EncodingResumePos) {
+            // Resuming; Pause() may have stopped us in the middle of a source frame.
+            m_EncodingStartFrame += m_EncodingResumeFraction;
+        }
+    }
+    m_EncodingResumeFraction = 0.0;
+
+    // Speeds other than 1.0 step over the video frames, and time-stretch the audio.
+    m_EncodeVideo = m_VideoEnabled && m_VideoIn && m_VideoOut && m_PlaybackSpeed > 0.0;
+    m_EncodeAudio = m_AudioEnabled && m_AudioIn && m_AudioOut && m_PlaybackSpeed > 0.0 && IsAudioAudible();
+    m_VideoInDone = m_AudioInDone = false;
+    m_EncodingStages = (m_EncodeVideo ? 2 : 0) + (m_EncodeAudio ? 2 : 0);
+    m_FramesEncoded = 0;
+    m_SamplesEncoded = 0;
+    m_EncodingStartTime = syGetNanoTicks();
+    m_EncodingEndTime = m_EncodingStages ? 0 : m_EncodingStartTime;
+    if(!m_EncodingStages) {
+        return;
+    }
+
+    // The worker threads are paused, so we can set up the frame queue.
+    if(m_FrameQueue->GetCapacity() != m_VideoQueueSize) {
+        m_FrameQueue->SetCapacity(m_VideoQueueSize);
+    }
+    m_FrameQueue->Clear();
+    m_FrameQueue->ResetStats();
     // And start!
-    StartWorkerThreads();
+    m_IsPlaying = StartWorkerThreads();
 }
 
 inline bool AVControllerData::IsVideoInRunning() {
@@ -404,13 +661,166 @@ bool AVControllerData::IsAlive() {
     return false;
 }
 
+bool AVControllerData::IsAudioClock() {
+    return m_AudioEnabled && !m_StutterMode && m_AudioIn && m_AudioOut && IsAudioAudible() &&
+           m_AudioOut->HasPlaybackClock() && m_AudioOut->GetSampleFreq();
+}
+
+bool AVControllerData::IsAudioAtEnd() {
+    AVSource* source = m_AudioIn;
+    return source && source->GetAudioLength() && source->GetAudioPos() >= source->GetAudioLength();
+}
+
+bool AVControllerData::IsAudioAudible() {
+    float speed = m_PlaybackSpeed;
+    return speed == 1.0 ||
+           (speed >= syTimeStretcher::GetMinimumSpeed() && speed <= syTimeStretcher::GetMaximumSpeed());
+}
+
+bool AVControllerData::InternalMustAbort() {
+    return m_Pause || m_Stop;
+}
+
+bool AVControllerData::IsReverse() {
+    return m_PlaybackSpeed < 0.0;
+}
+
+double AVControllerData::GetClockRate() {
+    double rate = fabs(m_PlaybackSpeed);
+    return (rate > 0.0) ? rate : 1.0;
+}
+
+avtime_t AVControllerData::GetPlayedAudioPos() {
+    unsigned long long played = m_AudioOut->GetPlayedSamples();
+    unsigned long long freq = m_AudioOut->GetSampleFreq();
+    // Split the conversion to avoid overflowing on long sessions.
+    avtime_t result = (avtime_t)(played / freq) * AVTIME_T_SCALE;
+    result += (avtime_t)(((played % freq) * AVTIME_T_SCALE) / freq);
+    if(m_PlaybackSpeed != 1.0) {
+        // Each sample heard took GetClockRate() samples of the source (see SendStretchedAudio()).
+        result = (avtime_t)(result * GetClockRate());
+    }
+    return m_StartAudioPos + result;
+}
+
+avtime_t AVControllerData::GetPlaybackClock() {
+    avtime_t now = syGetNanoTicks();
+    if(!IsAudioClock()) {
+        if(m_PlaybackSpeed == 1.0) {
+            return m_StartVideoPos + (now - m_StartTime);
+        }
+        avtime_t distance = (avtime_t)((now - m_StartTime) * GetClockRate());
+        if(IsReverse()) {
+            return (distance < m_StartVideoPos) ? m_StartVideoPos - distance : 0;
+        }
+        return m_StartVideoPos + distance;
+    }
+    unsigned long long played = m_AudioOut->GetPlayedSamples();
+    avtime_t ticks;
+    {
+        syMutexLocker lock(m_ClockMutex);
+        if(played != m_ClockSamples) {
+            m_ClockSamples = played;
+            m_ClockTicks = now;
+        }
+        ticks = m_ClockTicks;
+    }
+    avtime_t result = GetPlayedAudioPos();
+    avtime_t elapsed = (now > ticks) ? now - ticks : 0;
+    if(!IsAudioAtEnd()) {
+        // Interpolate until the next report, but don't run ahead of the audio for more than a granule
+        // (none before the first report). If the device stalls, so does the clock; if it stalls for too long,
+        // the clock continues on the system's from where it stopped.
+        // At the end of the audio the device stops reporting for good, so the clock just keeps running.
+        avtime_t granule = (avtime_t)m_AudioGranularity * 1000000;
+        avtime_t maxelapsed = played ? granule : 0;
+        avtime_t stalltime = granule * ClockStallGranules;
+        if(elapsed > stalltime) {
+            elapsed = maxelapsed + (elapsed - stalltime);
+        } else if(elapsed > maxelapsed) {
+            elapsed = maxelapsed;
+        }
+    }
+    result += (m_PlaybackSpeed == 1.0) ? elapsed : (avtime_t)(elapsed * GetClockRate());
+    return result;
+}
+
+unsigned long AVControllerData::SendStretchedAudio(unsigned long numsamples) {
+    unsigned int freq = m_AudioIn->GetAudioFrequency();
+    unsigned int numchannels = m_AudioIn->GetNumAudioChannels();
+    if(!m_Stretcher->IsOk() || m_Stretcher->GetSampleFrequency() != freq || m_Stretcher->GetNumChannels() != numchannels) {
+        if(!m_Stretcher->Init(freq, numchannels)) {
+            return 0;
+        }
+        delete m_StretchBuffer;
+        m_StretchBuffer = NULL;
+    }
+    if(!m_StretchBuffer || m_StretchBuffer->GetSize() < 2 * numsamples) {
+        delete m_StretchBuffer;
+        m_StretchBuffer = new syAudioBuffer(2 * numsamples, numchannels, syAudioBuffer::maxbitspersample, freq);
+    }
+
+    // First, send what the device couldn't take last time.
+    unsigned long samplessent = 0;
+    if(m_StretchBuffer->GetLength()) {
+        samplessent = m_AudioOut->LoadAudioData(m_StretchBuffer);
+        if(m_StretchBuffer->GetLength()) {
+            return samplessent; // The device's buffer is full.
+        }
+    }
+
+    // Then stretch a new granule, reading the source as needed.
+    m_Stretcher->SetSpeed(m_PlaybackSpeed);
+    unsigned long received = 0;
+    while(received < numsamples && !syThread::MustAbort()) {
+        received += m_Stretcher->ReceiveSamples(m_StretchOut, numsamples - received);
+        if(m_StretchOut->GetLength()) {
+            m_StretchBuffer->WriteBlock(m_StretchOut);
+        }
+        if(received >= numsamples) {
+            break;
+        }
+        unsigned int needed = m_Stretcher->GetInputNeeded(numsamples - received);
+        if(!m_AudioIn->ReadAudioBlock(m_StretchIn, needed ? needed : 1)) {
+            break; // End of the audio.
+        }
+        m_Stretcher->PutSamples(m_StretchIn);
+    }
+    return samplessent + m_AudioOut->LoadAudioData(m_StretchBuffer);
+}
+
+void AVControllerData::ResetStretcher() {
+    m_Stretcher->Reset();
+    if(m_StretchBuffer) {
+        m_StretchBuffer->Clear();
+    }
+}
+
 
 inline void AVControllerData::Pause() {
+    bool wasplaying = m_IsPlaying;
     m_Pause = true;
+    m_Scheduler->Wake();
+    m_FrameQueue->Wake();
     if(syThread::IsMain()) {
         while(IsPlaying()) {
             syMilliSleep(1);
         }
+        if(wasplaying && m_VideoEnabled && m_VideoIn) {
+            // The Video In thread decodes ahead of the frames shown; resume from the last one shown,
+            // or from the source frame of the next one to encode.
+            avtime_t resumepos = m_CurrentVideoPos;
+            if(m_Parent->IsVideoEncoder() && m_EncodeVideo) {
+                double nextframe = GetEncodingSourceFrame(m_FramesEncoded);
+                unsigned long resumeframe = (unsigned long)nextframe;
+                resumepos = m_VideoIn->GetTimeFromFrameIndex(resumeframe, false);
+                m_EncodingResumePos = resumepos;
+                m_EncodingResumeFraction = nextframe - resumeframe;
+            }
+            if(m_VideoIn->GetVideoPos() != resumepos) {
+                m_VideoIn->SeekVideo(resumepos);
+            }
+        }
     }
     m_IsPlaying = false;
 }
@@ -421,6 +831,8 @@ inline void AVControllerData::Stop() {
     if(m_AudioInThread) { m_AudioInThread->Stop(false); }
     if(m_VideoOutThread) { m_VideoOutThread->Stop(false); }
     if(m_AudioOutThread) { m_AudioOutThread->Stop(false); }
+    m_Scheduler->Wake();
+    m_FrameQueue->Wake();
     if(syThread::IsMain()) {
         while(IsAlive()) {
             syMilliSleep(1);
@@ -474,6 +886,8 @@ bool AVControllerData::VideoInLoop() {
     }
     if(m_Parent->IsVideoEncoder()) {
         EncodingVideoInLoop();
+    } else if(IsReverse()) {
+        PlaybackReverseVideoInLoop();
     } else {
         PlaybackVideoInLoop();
     }
@@ -518,97 +932,197 @@ bool AVControllerData::VideoOutLoop() {
 
 void AVControllerData::PlaybackAudioInLoop() {
     if(m_StutterMode) return; // In stutter mode, Audio Input will be handled by the video thread.
+    ResetStretcher();
     while(!syThread::MustAbort() && m_AudioEnabled && !m_Stop) {
         while(m_Pause) {
             if(m_Stop || syThread::MustAbort() || !m_AudioEnabled) return;
+
+            // Rewind the source to the last sample heard. The samples still queued in the output device
+            // are discarded by StartPlayback(), so they'll be sent again when playback resumes.
+            if(IsAudioClock()) {
+                m_CurrentAudioPos = m_StartAudioPos = m_AudioIn->SeekAudio(GetPlayedAudioPos());
+            }
             if(!m_AudioInThread->SelfPause()) return;
+            ResetStretcher();
+        }
+        if(!m_AudioIn || !m_AudioOut) {
+            syMilliSleep(1);
+            continue;
+        }
+
+        // Keep the output device fed, a granule at a time.
+        unsigned long granule = (m_AudioIn->GetAudioFrequency() * m_AudioGranularity) / 1000;
+        if(granule < 1) { granule = 1; }
+        unsigned long samplessent = 0;
+        if(m_PlaybackSpeed == 1.0) {
+            samplessent = m_AudioIn->SendAudioData(m_AudioOut, granule);
+        } else if(IsAudioAudible()) {
+            // Shuttling: change the speed, but keep the pitch.
+            samplessent = SendStretchedAudio(granule);
+        }
+        m_CurrentAudioPos = IsAudioClock() ? GetPlayedAudioPos() : m_AudioIn->GetAudioPos();
+        if(samplessent < granule) {
+            // The device's buffer is full, we reached the end of the audio, or the audio is muted at this speed.
+            syMilliSleep(1);
         }
-        //TODO: Implement AVControllerData::PlaybackAudioInLoop()
-        syMicroSleep(10); // Remove this line after PlaybackAudioInLoop() has been implemented.
     }
 }
 
 void AVControllerData::PlaybackVideoInLoop() {
-    avtime_t curvideopos, curaudiopos, nextaudiopos, starttime;
-    unsigned long curvideoframe,nextvideoframe;
+    avtime_t videopos, lastvideopos, minpos, clock;
+    unsigned long videoframe, minframe, clockframe;
+    bool started = false;
+    syBitmap* slot;
 
-    starttime = syGetNanoTicks();
-    m_CurrentVideoPos = curaudiopos = curvideopos = m_StartVideoPos;
-    nextaudiopos = curaudiopos;
-    nextvideoframe = m_VideoIn->GetFrameIndex(m_StartVideoPos);
-    curvideoframe = nextvideoframe;
+    // Decode the frames ahead into the frame queue; the Video Out thread shows them when they're due.
+    videoframe = m_VideoIn->GetFrameIndex(m_StartVideoPos);
+    lastvideopos = 0;
+    DebugLog(syString("Current Frame: ") << videoframe);
+    DebugLog(syString("Current Video Pos: ") << m_StartVideoPos);
 
-    if(!syThread::MustAbort() && m_VideoEnabled && !m_Stop && m_VideoIn && m_VideoOut) {
-        m_VideoIn->SendCurrentFrame(m_VideoOut);
-    }
+    while(!syThread::MustAbort() && m_VideoEnabled && !m_Stop && m_VideoIn && m_VideoOut) {
+        while(m_Pause) {
+            if(m_Stop || syThread::MustAbort() || !m_VideoEnabled || !m_VideoIn || !m_VideoOut) return;
+            DebugLog("Pausing Video Playback thread...");
+            if(!m_VideoInThread->SelfPause()) return;
+            DebugLog("Resuming Video Playback thread...");
+            if(IsReverse()) return; // VideoInLoop() calls the reverse loop instead.
+
+            // StartPlayback() may have changed the position if we were sought.
+            videoframe = m_VideoIn->GetFrameIndex(m_StartVideoPos);
+            started = false;
+            DebugLog(syString("Current Frame: ") << videoframe);
+            DebugLog(syString("Current Video Pos: ") << m_StartVideoPos);
+        }
 
-    if(m_StutterMode && m_AudioEnabled) {
-        m_CurrentAudioPos = curaudiopos = m_AudioIn->SeekAudio(curvideopos);
+        videopos = m_VideoIn->GetTimeFromFrameIndex(videoframe, false);
+        if(started && videopos <= lastvideopos) {
+            // We're past the last frame; sleep until we're paused or stopped.
+            m_Scheduler->WaitUntil(syGetNanoTicks() + IdleWaitTime, this);
+            continue;
+        }
+
+        // Wait for a free slot. This is what keeps us from running too far ahead.
+        slot = m_FrameQueue->BeginPush(IdleWaitTime, this);
+        if(!slot) {
+            continue;
+        }
+
+        if(started && !m_StutterMode) {
+            // If we're too far behind the playback clock, don't decode the frames that would be dropped.
+            // (Don't skip video frames in stutter mode.)
+            clock = GetPlaybackClock();
+            if(clock > videopos && clock - videopos > m_SyncTolerance) {
+                clockframe = m_VideoIn->GetFrameIndex(clock);
+                if(clockframe > videoframe) {
+                    DebugLog(syString("Dropping frames: ") << (clockframe - videoframe));
+                    m_Scheduler->FramesDropped(clockframe - videoframe);
+                    videoframe = clockframe;
+                    videopos = m_VideoIn->GetTimeFromFrameIndex(videoframe, false);
+                    if(videopos <= lastvideopos) {
+                        continue;
+                    }
+                }
+            }
+        }
+
+        videopos = m_VideoIn->SeekVideo(videopos);
+        syFrameCache::SendCurrentFrame(m_VideoIn, slot);
+        m_FrameQueue->EndPush(videopos);
+        lastvideopos = videopos;
+        started = true;
+        ++videoframe;
+
+        if(!m_StutterMode) {
+            // Don't decode the frames that the maximum framerate wouldn't let us show
+            // (see AVController::SetMaximumFrameRate()).
+            minpos = videopos + (avtime_t)(GetClockRate() * AVTIME_T_SCALE / CurrentMaximumFramerate);
+            minframe = m_VideoIn->GetFrameIndex(minpos);
+            if(m_VideoIn->GetTimeFromFrameIndex(minframe, false) < minpos) {
+                ++minframe;
+            }
+            if(minframe > videoframe) {
+                m_Scheduler->FramesDropped(minframe - videoframe);
+                videoframe = minframe;
+            }
+        }
     }
-    DebugLog(syString("Current Frame: ") << curvideoframe);
-    DebugLog(syString("Current Video Pos: ") << curvideopos);
+}
+
+void AVControllerData::PlaybackReverseVideoInLoop() {
+    avtime_t videopos, nextpos, maxpos, clock, step;
+    unsigned long nextframe, clockframe, maxframe;
+    bool started = false;
+    const syBitmap* frame;
+    syBitmap* slot;
+
+    // Seeking back for every frame would decode each one many times; instead, the reader decodes a chunk of
+    // frames forward, and gives them to us backwards. We queue them like PlaybackVideoInLoop() does.
+    m_ReverseReader->Start(m_VideoIn, m_VideoIn->GetFrameIndex(m_StartVideoPos));
+    DebugLog(syString("Current Frame (reverse): ") << m_ReverseReader->GetNextFrame());
 
     while(!syThread::MustAbort() && m_VideoEnabled && !m_Stop && m_VideoIn && m_VideoOut) {
         while(m_Pause) {
             if(m_Stop || syThread::MustAbort() || !m_VideoEnabled || !m_VideoIn || !m_VideoOut) return;
-
-            // Save the last position
-            m_CurrentVideoPos = m_StartVideoPos = curvideopos;
-            if(m_StutterMode && m_AudioEnabled) {
-                m_CurrentAudioPos = curaudiopos = curvideopos;
-            }
             DebugLog("Pausing Video Playback thread...");
-            DebugLog(syString("Current Frame: ") << curvideoframe);
-            DebugLog(syString("Current Video Pos: ") << curvideopos);
             if(!m_VideoInThread->SelfPause()) return;
             DebugLog("Resuming Video Playback thread...");
+            if(!IsReverse()) return; // VideoInLoop() calls the forward loop instead.
 
-            // Restore the last position
-            starttime = syGetNanoTicks();
-            if(m_StutterMode && m_AudioEnabled) {
-                m_CurrentAudioPos = curaudiopos = m_AudioIn->SeekAudio(curvideopos);
-            }
-            DebugLog(syString("Current Frame: ") << curvideoframe);
-            DebugLog(syString("Current Video Pos: ") << curvideopos);
+            // StartPlayback() may have changed the position if we were sought.
+            m_ReverseReader->Start(m_VideoIn, m_VideoIn->GetFrameIndex(m_StartVideoPos));
+            started = false;
+            DebugLog(syString("Current Frame (reverse): ") << m_ReverseReader->GetNextFrame());
         }
-        curvideoframe = m_VideoIn->GetFrameIndex(curvideopos);
-        if(curvideoframe != nextvideoframe) {
-            if(m_StutterMode && m_AudioEnabled) {
-                // In "stutter mode", we play back the audio using the video thread.
 
-                // Calculate the length of the audio, in seconds.
-                nextaudiopos = m_VideoIn->GetTimeFromFrameIndex(curvideoframe + 1, false);
+        if(m_ReverseReader->IsFinished()) {
+            // We're past the first frame; sleep until we're paused or stopped.
+            m_Scheduler->WaitUntil(syGetNanoTicks() + IdleWaitTime, this);
+            continue;
+        }
 
-                avtime_t audiolen = nextaudiopos - curaudiopos;
-                if(audiolen > 0) {
-                    m_AudioIn->SendAudioData(m_AudioOut,audiolen);
+        // Wait for a free slot. This is what keeps us from running too far ahead.
+        slot = m_FrameQueue->BeginPush(IdleWaitTime, this);
+        if(!slot) {
+            continue;
+        }
+
+        if(started && !m_StutterMode) {
+            // If we're too far behind the playback clock (i.e. above it), skip the frames that would be dropped.
+            // If they're in the current chunk, they're already decoded; otherwise, they won't be.
+            clock = GetPlaybackClock();
+            nextframe = m_ReverseReader->GetNextFrame();
+            nextpos = m_VideoIn->GetTimeFromFrameIndex(nextframe, false);
+            if(nextpos > clock && nextpos - clock > m_SyncTolerance) {
+                clockframe = m_VideoIn->GetFrameIndex(clock);
+                if(clockframe < nextframe) {
+                    DebugLog(syString("Dropping frames: ") << (nextframe - clockframe));
+                    m_Scheduler->FramesDropped(nextframe - clockframe);
+                    m_ReverseReader->SkipTo(clockframe);
                 }
             }
-            m_VideoIn->SendCurrentFrame(m_VideoOut);
-            curvideoframe = nextvideoframe;
-            DebugLog(syString("Current Frame: ") << curvideoframe);
-            DebugLog(syString("Current Video Pos: ") << curvideopos);
-        } else {
-            // syMilliSleep(MinimumPlaybackDelay); // This will prevent us from surpassing the maximum framerate.
-            syMilliSleep(1); // Until the framerate/timing issue is fixed, this will have to suffice.
         }
 
-        // Calculate the next video position based on the current time.
-        curvideopos = m_StartVideoPos + (syGetNanoTicks() - starttime);
-        if(m_StutterMode && nextvideoframe > curvideoframe + 1) {
-            // Don't skip video frames in stutter mode.
-            nextvideoframe = curvideoframe + 1;
-            curvideopos = m_VideoIn->GetTimeFromFrameIndex(nextvideoframe, false);
-        } else {
-            nextvideoframe = m_VideoIn->GetFrameIndex(curvideopos);
+        frame = m_ReverseReader->ReadFrame(videopos);
+        if(!frame) {
+            continue;
         }
-
-        // Seek to the calculated video position.
-        m_CurrentVideoPos = curvideopos = m_VideoIn->SeekVideo(curvideopos);
-
-        if(m_StutterMode && m_AudioEnabled) {
-            // Seek to the calculated audio position.
-            m_CurrentAudioPos = curaudiopos = m_AudioIn->SeekVideo(curvideopos);
+        // The slot shares the frame's buffer; the reader gets its own when it decodes into its bitmap again.
+        slot->LoadData(frame);
+        m_FrameQueue->EndPush(videopos);
+        started = true;
+
+        if(!m_StutterMode && !m_ReverseReader->IsFinished()) {
+            // Don't queue the frames that the maximum framerate wouldn't let us show
+            // (see AVController::SetMaximumFrameRate()).
+            step = (avtime_t)(GetClockRate() * AVTIME_T_SCALE / CurrentMaximumFramerate);
+            maxpos = (videopos > step) ? videopos - step : 0;
+            maxframe = m_VideoIn->GetFrameIndex(maxpos);
+            nextframe = m_ReverseReader->GetNextFrame();
+            if(maxframe < nextframe) {
+                m_Scheduler->FramesDropped(nextframe - maxframe);
+                m_ReverseReader->SkipTo(maxframe);
+            }
         }
     }
 }
@@ -619,17 +1133,69 @@ void AVControllerData::PlaybackAudioOutLoop() {
             if(m_Stop || syThread::MustAbort() || !m_AudioEnabled) return;
             if(!m_AudioOutThread->SelfPause()) return;
         }
+        if(m_AudioOut) {
+            // The device reports the samples it plays, which drives the playback clock (see GetPlaybackClock()).
+            m_AudioOut->FlushAudioData();
+        }
+        syMilliSleep(1);
     }
 }
 
 void AVControllerData::PlaybackVideoOutLoop() {
+    avtime_t framepos, nextpos, audiopos, clock, now, allowed, deadline;
+    const syBitmap* frame;
+    bool reverse;
     while(!syThread::MustAbort() && m_VideoEnabled && !m_Stop) {
         while(m_Pause) {
             if(m_Stop || syThread::MustAbort() || !m_VideoEnabled) return;
             if(!m_VideoOutThread->SelfPause()) return;
         }
+        frame = m_FrameQueue->Front(framepos, IdleWaitTime, this);
+        if(!frame) {
+            continue;
+        }
+
+        // Show the frame when the playback clock reaches it: the audio heard, if there's any.
+        // In reverse, the clock runs backwards, and reaches the frames from above.
+        reverse = IsReverse();
+        now = syGetNanoTicks();
+        clock = GetPlaybackClock();
+        if(reverse ? (clock > framepos) : (clock < framepos)) {
+            // It isn't due yet; keep showing the current one, and sleep until it's due.
+            // We check the clock again when we wake up, since the audio clock doesn't follow the system's exactly.
+            m_Scheduler->WaitUntil(now + (avtime_t)((reverse ? clock - framepos : framepos - clock) / GetClockRate()), this);
+            continue;
+        }
+        allowed = m_Scheduler->GetNextAllowedTime();
+        if(!m_StutterMode && m_FrameQueue->PeekNext(nextpos) && (reverse ? clock <= nextpos : clock >= nextpos) &&
+            ((reverse ? nextpos - clock : clock - nextpos) > m_SyncTolerance || now < allowed)) {
+            // The next frame is due too, and we're either too far behind the clock, or the maximum framerate
+            // doesn't let us show both (see AVController::SetMaximumFrameRate()); drop this one.
+            m_FrameQueue->Pop();
+            m_Scheduler->FramesDropped(1);
+            continue;
+        }
+        if(now < allowed) {
+            m_Scheduler->WaitUntil(allowed, this);
+            continue;
+        }
+
+        // The frame was due when the clock reached its position.
+        deadline = now - (avtime_t)((reverse ? framepos - clock : clock - framepos) / GetClockRate());
+
+        if(m_StutterMode && m_AudioEnabled && m_AudioIn) {
+            // In "stutter mode", we play back the audio along with the video: Send the frame's audio.
+            m_CurrentAudioPos = audiopos = m_AudioIn->SeekAudio(framepos);
+            nextpos = m_VideoIn->GetTimeFromFrameIndex(m_VideoIn->GetFrameIndex(framepos) + 1, false);
+            if(nextpos > audiopos) {
+                m_AudioIn->SendAudioData(m_AudioOut, nextpos - audiopos);
+            }
+        }
+        m_VideoOut->LoadData(frame);
         m_VideoOut->FlushVideoData();
-        syMilliSleep(1); // FIXME: Sleep using the maximum framerate when the timing issue gets fixed.
+        m_CurrentVideoPos = framepos;
+        m_FrameQueue->Pop();
+        m_Scheduler->FramePresented(deadline);
     }
 }
 
@@ -642,19 +1208,161 @@ void AVControllerData::PlaybackVideoOutLoop() {
 //// --------------------
 
 void AVControllerData::EncodingAudioInLoop() {
-    // TODO: Implement AVControllerData::EncodingAudioInLoop()
+    // Send the audio to the output device as fast as it takes it. The device's buffer is the queue
+    // between us and the Audio Out thread.
+    if(m_EncodeAudio) {
+        ResetStretcher();
+        unsigned long granule, sent;
+        unsigned long long freq, remaining;
+        avtime_t audiopos, left;
+        while(!syThread::MustAbort() && !m_Stop && !m_Pause) {
+            audiopos = m_AudioIn->GetAudioPos();
+            if(audiopos >= m_EncodingEndPos) {
+                break;
+            }
+            // Split the conversion to avoid overflowing on long streams.
+            freq = m_AudioIn->GetAudioFrequency();
+            left = m_EncodingEndPos - audiopos;
+            remaining = (left / AVTIME_T_SCALE) * freq + ((left % AVTIME_T_SCALE) * freq) / AVTIME_T_SCALE;
+            if(!remaining) {
+                break;
+            }
+            granule = (freq * m_AudioGranularity) / 1000;
+            if(granule < 1) { granule = 1; }
+            if(m_PlaybackSpeed == 1.0) {
+                if(granule > remaining) { granule = (unsigned long)remaining; }
+                sent = m_AudioIn->SendAudioData(m_AudioOut, granule);
+            } else {
+                sent = SendStretchedAudio(granule);
+            }
+            m_SamplesEncoded += sent;
+            m_CurrentAudioPos = m_AudioIn->GetAudioPos();
+            if(!sent) {
+                if(m_CurrentAudioPos == audiopos && m_AudioOut->GetBufferedSamples() < m_AudioOut->GetBufferSize()) {
+                    // There's room in the device, but the source gave us nothing: It ended before its length.
+                    break;
+                }
+                // The device's buffer is full.
+                syMilliSleep(1);
+            }
+        }
+        if(syThread::MustAbort() || m_Stop || m_Pause) {
+            return;
+        }
+        m_AudioInDone = true;
+        EncodingStageDone();
+    }
+    m_AudioInThread->SelfPause();
 }
 
 void AVControllerData::EncodingVideoInLoop() {
-    // TODO: Implement AVControllerData::EncodingVideoInLoop()
+    // Decode the frames into the frame queue as fast as the Video Out thread takes them;
+    // no frames are dropped.
+    if(m_EncodeVideo) {
+        avtime_t videopos, lastvideopos = 0;
+        unsigned long count = 0, videoframe, lastvideoframe = 0;
+        syBitmap* slot;
+        syBitmap lastframe; // Shares the buffer of the last frame decoded.
+        while(!syThread::MustAbort() && !m_Stop && !m_Pause) {
+            videoframe = (unsigned long)GetEncodingSourceFrame(count);
+            videopos = m_VideoIn->GetTimeFromFrameIndex(videoframe, false);
+            if(videopos >= m_EncodingEndPos) {
+                break;
+            }
+            slot = m_FrameQueue->BeginPush(IdleWaitTime, this);
+            if(!slot) {
+                continue;
+            }
+            if(count && videoframe == lastvideoframe) {
+                // At speeds below 1.0, the source frame lasts for more than one encoded frame.
+                slot->LoadData(&lastframe);
+                videopos = lastvideopos;
+            } else {
+                videopos = m_VideoIn->SeekVideo(videopos);
+                if(count && videopos <= lastvideopos) {
+                    break; // The source has no more frames.
+                }
+                m_VideoIn->SendCurrentFrame(slot);
+                lastframe.CopyFrom(slot);
+            }
+            m_FrameQueue->EndPush(videopos);
+            lastvideopos = videopos;
+            lastvideoframe = videoframe;
+            ++count;
+        }
+        if(syThread::MustAbort() || m_Stop || m_Pause) {
+            return;
+        }
+        m_VideoInDone = true;
+        m_FrameQueue->Wake();
+        EncodingStageDone();
+    }
+    m_VideoInThread->SelfPause();
 }
 
 void AVControllerData::EncodingAudioOutLoop() {
-    // TODO: Implement AVControllerData::EncodingAudioOutLoop()
+    if(m_EncodeAudio) {
+        bool indone;
+        while(!syThread::MustAbort() && !m_Stop && !m_Pause) {
+            indone = m_AudioInDone;
+            m_AudioOut->FlushAudioData();
+            if(!m_AudioOut->GetBufferedSamples()) {
+                if(indone) {
+                    break;
+                }
+                syMilliSleep(1);
+            }
+        }
+        if(syThread::MustAbort() || m_Stop || m_Pause) {
+            return;
+        }
+        EncodingStageDone();
+    }
+    m_AudioOutThread->SelfPause();
 }
 
 void AVControllerData::EncodingVideoOutLoop() {
-    // TODO: Implement AVControllerData::EncodingVideoOutLoop()
+    if(m_EncodeVideo) {
+        avtime_t framepos;
+        const syBitmap* frame;
+        bool indone;
+        while(!syThread::MustAbort() && !m_Stop && !m_Pause) {
+            indone = m_VideoInDone;
+            frame = m_FrameQueue->Front(framepos, IdleWaitTime, this);
+            if(!frame) {
+                if(indone) {
+                    break;
+                }
+                continue;
+            }
+            m_VideoOut->LoadData(frame);
+            m_VideoOut->FlushVideoData();
+            m_CurrentVideoPos = framepos;
+            m_FrameQueue->Pop();
+            ++m_FramesEncoded;
+        }
+        if(syThread::MustAbort() || m_Stop || m_Pause) {
+            return;
+        }
+        EncodingStageDone();
+    }
+    m_VideoOutThread->SelfPause();
+}
+
+void AVControllerData::EncodingStageDone() {
+    syMutexLocker lock(m_EncodingMutex);
+    if(m_EncodingStages && !--m_EncodingStages) {
+        m_EncodingEndTime = syGetNanoTicks();
+        m_IsPlaying = false;
+    }
+}
+
+double AVControllerData::GetEncodingSourceFrame(unsigned long count) {
+    if(m_PlaybackSpeed == 1.0) {
+        return m_EncodingStartFrame + count;
+    }
+    // Speeds are floats; a little slack keeps, i.e., 10 frames at 0.7 from landing right below frame 7.
+    return m_EncodingStartFrame + (double)count * m_PlaybackSpeed + 1e-6;
 }
 
 //// ------------------
@@ -676,7 +1384,14 @@ void AVControllerData::StartPlayback() {
         startvideopos = m_VideoIn->GetVideoPos();
     }
     if(m_AudioIn) {
-        startaudiopos = m_AudioIn->GetVideoPos();
+        startaudiopos = m_AudioIn->GetAudioPos();
+        if(m_VideoIn && m_VideoEnabled && m_AudioEnabled) {
+            avtime_t distance = (startaudiopos > startvideopos) ? startaudiopos - startvideopos : startvideopos - startaudiopos;
+            if(distance > m_SyncTolerance) {
+                // The audio was muted (see IsAudioAudible()), so it didn't follow the video.
+                startaudiopos = m_AudioIn->SeekAudio(startvideopos);
+            }
+        }
         if(m_AudioOut) {
             // We MUST clear the audio buffer, otherwise we'll lose sync!
             m_AudioOut->Clear();
@@ -684,6 +1399,23 @@ void AVControllerData::StartPlayback() {
     }
     m_StartVideoPos = startvideopos;
     m_StartAudioPos = startaudiopos;
+
+    // The worker threads are paused, so we can set up the frame queue.
+    if(m_FrameQueue->GetCapacity() != m_VideoQueueSize) {
+        m_FrameQueue->SetCapacity(m_VideoQueueSize);
+    }
+    m_FrameQueue->Clear();
+    m_FrameQueue->ResetStats();
+    if(!IsReverse()) {
+        m_ReverseReader->Clear(); // Give the chunk's memory back to the pool.
+    } else if(m_ReverseReader->GetChunkSize() != m_ReverseChunkSize) {
+        m_ReverseReader->SetChunkSize(m_ReverseChunkSize);
+    }
+    m_ReverseReader->ResetStats();
+    m_Scheduler->ResetStats();
+    m_Scheduler->SetMinimumInterval((avtime_t)(AVTIME_T_SCALE / CurrentMaximumFramerate));
+    m_ClockSamples = 0;
+    m_StartTime = m_ClockTicks = syGetNanoTicks();
     // And start!
     m_IsPlaying = StartWorkerThreads();
 }
@@ -882,7 +1614,7 @@ void AVController::Snapshot() {
     if(IsVideoEncoder()) { return; }
     if(m_Data->IsPlaying()) { m_Data->Pause(); }
     if(m_Data->m_VideoIn && m_Data->m_VideoOut) {
-        m_Data->m_VideoIn->SendCurrentFrame(m_Data->m_VideoOut);
+        syFrameCache::SendCurrentFrame(m_Data->m_VideoIn, m_Data->m_VideoOut);
     }
     if(m_Data->m_VideoOut) {
         m_Data->m_VideoOut->FlushVideoData();
@@ -925,7 +1657,7 @@ void AVController::Pause() {
     if(!IsVideoEncoder()) {
         if(m_Data->m_VideoIn && m_Data->m_VideoOut) {
             // After pausing, always send a snapshot of the current frame to the screen
-            m_Data->m_VideoIn->SendCurrentFrame(m_Data->m_VideoOut);
+            syFrameCache::SendCurrentFrame(m_Data->m_VideoIn, m_Data->m_VideoOut);
         }
     }
 }
@@ -1166,6 +1898,85 @@ bool AVController::GetDontSkipVideoFrames() {
     return m_Data->m_StutterMode;
 }
 
+void AVController::SetSyncTolerance(avtime_t tolerance) {
+    if(tolerance < MinimumSyncTolerance) {
+        tolerance = MinimumSyncTolerance;
+    }
+    m_Data->m_SyncTolerance = tolerance;
+}
+
+avtime_t AVController::GetSyncTolerance() {
+    return m_Data->m_SyncTolerance;
+}
+
+syFrameStats AVController::GetFrameStats() {
+    return m_Data->m_Scheduler->GetStats();
+}
+
+void AVController::SetVideoQueueSize(unsigned int frames) {
+    if(frames < 1) { frames = 1; }
+    if(frames > syFrameQueue::MaxCapacity) { frames = syFrameQueue::MaxCapacity; }
+    m_Data->m_VideoQueueSize = frames;
+}
+
+unsigned int AVController::GetVideoQueueSize() {
+    return m_Data->m_VideoQueueSize;
+}
+
+syFrameQueueStats AVController::GetFrameQueueStats() {
+    return m_Data->m_FrameQueue->GetStats();
+}
+
+void AVController::SetReverseChunkSize(unsigned int frames) {
+    if(frames < 1) { frames = 1; }
+    if(frames > syReverseFrameReader::MaxChunkSize) { frames = syReverseFrameReader::MaxChunkSize; }
+    m_Data->m_ReverseChunkSize = frames;
+}
+
+unsigned int AVController::GetReverseChunkSize() {
+    return m_Data->m_ReverseChunkSize;
+}
+
+syReverseFrameStats AVController::GetReverseFrameStats() {
+    return m_Data->m_ReverseReader->GetStats();
+}
+
+syEncodingStats AVController::GetEncodingStats() {
+    syEncodingStats result;
+    result.m_FramesEncoded = m_Data->m_FramesEncoded;
+    result.m_SamplesEncoded = m_Data->m_SamplesEncoded;
+    result.m_EndPosition = m_Data->m_EncodingEndPos;
+    avtime_t endtime = m_Data->m_EncodingEndTime;
+    result.m_Finished = (endtime != 0);
+    if(!result.m_Finished) {
+        endtime = m_Data->m_EncodingStartTime ? syGetNanoTicks() : 0;
+    }
+    result.m_Elapsed = (endtime > m_Data->m_EncodingStartTime) ? endtime - m_Data->m_EncodingStartTime : 0;
+    result.m_FramesPerSecond = result.m_Elapsed ? ((double)result.m_FramesEncoded * AVTIME_T_SCALE) / result.m_Elapsed : 0.0;
+
+    // The slowest stream tells how far we are.
+    avtime_t startpos, position;
+    if(m_Data->m_EncodeVideo) {
+        startpos = m_Data->m_StartVideoPos;
+        position = m_Data->m_CurrentVideoPos;
+        if(m_Data->m_EncodeAudio && m_Data->m_CurrentAudioPos < position) {
+            startpos = m_Data->m_StartAudioPos;
+            position = m_Data->m_CurrentAudioPos;
+        }
+    } else {
+        startpos = m_Data->m_StartAudioPos;
+        position = m_Data->m_CurrentAudioPos;
+    }
+    result.m_Position = result.m_Finished ? result.m_EndPosition : position;
+    result.m_TimeLeft = 0;
+    if(!result.m_Finished && position > startpos && result.m_EndPosition > position) {
+        double done = (double)(position - startpos);
+        double left = (double)(result.m_EndPosition - position);
+        result.m_TimeLeft = (avtime_t)(result.m_Elapsed * (left / done));
+    }
+    return result;
+}
+
 bool AVController::InnerSetVideoIn(AVSource* device) {
     if(!syThread::IsMain() || m_Data->m_IsPlaying) { return false; }
     if(m_Data->m_VideoIn) {
@@ -11,12 +11,42 @@
 #define avcontroller_h
 
 #include "avtypes.h"
+#include "syframescheduler.h"
+#include "syframequeue.h"
+#include "syreverseframereader.h"
 
 class AVSource;
 class VideoOutputDevice;
 class AudioOutputDevice;
 class AVControllerData;
 
+/** Progress of an encoding. @see AVController::GetEncodingStats */
+struct syEncodingStats {
+    /** Number of video frames sent to the output device */
+    unsigned long m_FramesEncoded;
+
+    /** Number of audio samples sent to the output device */
+    unsigned long long m_SamplesEncoded;
+
+    /** Stream position encoded so far (the least advanced of video and audio), in nanoseconds */
+    avtime_t m_Position;
+
+    /** Stream position where the encoding ends, in nanoseconds */
+    avtime_t m_EndPosition;
+
+    /** Time spent encoding, in nanoseconds */
+    avtime_t m_Elapsed;
+
+    /** Video frames encoded per second */
+    double m_FramesPerSecond;
+
+    /** Estimated time left, in nanoseconds. 0 if unknown or finished. */
+    avtime_t m_TimeLeft;
+
+    /** true if the whole stream was encoded */
+    bool m_Finished;
+};
+
 class AVController {
     public:
 
@@ -76,6 +106,8 @@ class AVController {
         /** @brief Plays video at given speed for the given duration.
          *
          *  @param speed Desired playback speed (can be negative). 1.0 = normal. If 0, playback is paused.
+         *         Between 0.25 and 4.0, the audio is time-stretched, keeping its pitch; otherwise, it's muted.
+         *         At negative speeds, the video plays in reverse (see SetReverseChunkSize()) and the audio is muted.
          *  @param duration Playback duration, in nanoseconds. 0 = Unlimited.
          *  @param muted Whether playback should be video-only (default false).
          *  @note  Only valid for non-encoding output devices.
@@ -99,6 +131,11 @@ class AVController {
         void PlayAudio(float speed = 1.0, avtime_t duration = 0);
 
         /** @brief Encodes video and audio at given speed for the given duration.
+         *
+         *  The encoding ignores the system clock, and doesn't drop frames: it runs as fast as the devices allow.
+         *  The input and output of video and audio run in their own threads, with bounded queues between them
+         *  (see SetVideoQueueSize()). When the whole stream is encoded, the threads are paused and IsPlaying()
+         *  returns false; see GetEncodingStats() for the progress.
          *
          *  @param speed Desired playback speed (can be negative). 1.0 = normal. If 0, no output is sent.
          *  @param duration Duration of the data stream, in nanoseconds. 0 = Unlimited.
@@ -125,6 +162,7 @@ class AVController {
 
         /** @brief Sends a snapshot of the current frame to the VideoOutputDevice.
          *
+         *  The frames recently shown are kept in syFrameCache, so scrubbing over them doesn't decode them again.
          *  @note  Only valid for non-encoding VideoOutputDevices.
          */
         void Snapshot();
@@ -135,6 +173,62 @@ class AVController {
         /** Gets the status of non-frame-skipping flag. */
         bool GetDontSkipVideoFrames();
 
+        /** @brief Sets how far the video may lag behind the playback clock, in nanoseconds.
+         *
+         *  During playback, the audio output device's played samples are the master clock (unless the device
+         *  doesn't report them; see AudioOutputDevice::HasPlaybackClock(), in which case the system clock is used).
+         *  Frames are shown when the clock reaches them, so the video repeats frames while it's ahead; if it
+         *  falls behind by more than the tolerance, the frames in between are dropped (except when
+         *  DontSkipVideoFrames() is set). Default is 40ms.
+         */
+        void SetSyncTolerance(avtime_t tolerance);
+
+        /** Gets the maximum lag of the video behind the playback clock, in nanoseconds. */
+        avtime_t GetSyncTolerance();
+
+        /** @brief Gets the statistics of the frames presented since playback was last started.
+         *
+         *  Reports the frames presented and dropped, and how far from their due time (in nanoseconds)
+         *  the frames were presented.
+         */
+        syFrameStats GetFrameStats();
+
+        /** @brief Sets how many frames the video may be decoded ahead of the frame shown. Takes effect on the next play.
+         *
+         *  During playback, the Video In thread decodes the frames into a queue (see syFrameQueue), and the Video Out
+         *  thread shows them when they're due; the queue absorbs the frames that take longer than usual to decode.
+         *  Each frame in the queue takes the memory of a full frame of the source. Default is 4 frames.
+         */
+        void SetVideoQueueSize(unsigned int frames);
+
+        /** Gets the number of frames that the video may be decoded ahead. */
+        unsigned int GetVideoQueueSize();
+
+        /** @brief Gets the statistics of the video frame queue since playback was last started.
+         *
+         *  Reports the queue's high-water mark, and how often the Video In thread had to wait for the
+         *  Video Out thread (i.e. how often the queue was full).
+         */
+        syFrameQueueStats GetFrameQueueStats();
+
+        /** @brief Sets how many frames are decoded at a time for reverse playback. Takes effect on the next play.
+         *
+         *  Playing in reverse, the Video In thread seeks to the start of a chunk of frames, decodes it forward,
+         *  and queues its frames from the last to the first (see syReverseFrameReader); so each frame is decoded
+         *  once, as in forward playback. Larger chunks mean fewer seeks; each frame in the chunk takes the memory
+         *  of a full frame of the source. Default is 16 frames.
+         */
+        void SetReverseChunkSize(unsigned int frames);
+
+        /** Gets the number of frames decoded at a time for reverse playback. */
+        unsigned int GetReverseChunkSize();
+
+        /** Gets the statistics of the reverse playback since playback was last started. */
+        syReverseFrameStats GetReverseFrameStats();
+
+        /** Gets the progress of the last encoding, including the frames per second and the estimated time left. */
+        syEncodingStats GetEncodingStats();
+
         /** Pauses playback / encoding. */
         void Pause();
 
@@ -292,7 +386,10 @@ class AVController {
         /** Thread Id for Video Out */
         unsigned long GetVideoOutThreadId();
 
-        /** Sets the maximum framerate, in frames per second. */
+        /** @brief Sets the maximum framerate, in frames per second.
+         *
+         *  During playback, frames that would be shown sooner than allowed are dropped. Takes effect on the next play.
+         */
         static void SetMaximumFrameRate(float maxframerate);
 
     protected:
@@ -11,7 +11,10 @@
 
 #include "sybitmap.h"
 #include "audiobuffer.h"
+#include "syaudioblock.h"
 #include "avsource.h"
+#include "syframecache.h"
+#include "audiooutputdevice.h"
 //#include "videooutputdevice.h"
 #include "sythread.h"
 #include "systring.h"
@@ -117,6 +120,7 @@ m_NumAudioChannels(2)
 }
 
 AVSource::~AVSource() {
+    syFrameCache::Invalidate(this);
     delete m_Bitmap;
 }
 
@@ -131,7 +135,7 @@ avtime_t AVSource::SeekVideoFrame(unsigned long frame,bool fromend) {
 
 avtime_t AVSource::SeekVideo(avtime_t time,bool fromend) {
     sySafeMutexLocker lock(*m_InputVideoMutex, this);
-    bool result = false;
+    avtime_t result = 0;
     if(lock.IsLocked()) {
         result = InternalVideoSeek(time, fromend);
     } else {
@@ -142,7 +146,7 @@ avtime_t AVSource::SeekVideo(avtime_t time,bool fromend) {
 
 avtime_t AVSource::SeekAudio(avtime_t time,bool fromend) {
     sySafeMutexLocker lock(*m_InputAudioMutex, this);
-    bool result = false;
+    avtime_t result = 0;
     if(lock.IsLocked()) {
         result = InternalAudioSeek(time, fromend);
     } else {
@@ -243,24 +247,69 @@ const syBitmap* AVSource::GetBitmap() {
     return m_Bitmap;
 }
 
-void AVSource::SendAudioData(AudioOutputDevice* device,unsigned long numsamples) {
-    // TODO: Implement AVSource::SendAudioData
-    // Here we have to implement a loop to make sure the desired quantity of numsamples
-    // has been sent.
+unsigned long AVSource::SendAudioData(AudioOutputDevice* device,unsigned long numsamples) {
+    sySafeMutexLocker lock(*m_InputAudioMutex, this);
+    if(!lock.IsLocked() || !m_IsAudio || !m_AudioBuffer || !device) {
+        return 0;
+    }
+    unsigned long samplessent = 0;
+    while(!MustAbort() && !(numsamples && samplessent >= numsamples)) {
+        unsigned long wanted = numsamples ? numsamples - samplessent : 0;
+        if(!m_AudioBuffer->GetLength()) {
+            // Refill our buffer; the device takes the samples from there.
+            unsigned long room = m_AudioBuffer->GetSize();
+            LoadAudioBuffer((wanted && wanted < room) ? wanted : room);
+            if(!m_AudioBuffer->GetLength()) {
+                break; // EOF
+            }
+        }
+        unsigned long sent = device->LoadAudioData(m_AudioBuffer, wanted);
+        samplessent += sent;
+        if(m_AudioBuffer->GetLength()) {
+            break; // The device's buffer is full.
+        }
+        if(!sent) {
+            break;
+        }
+    }
+    return samplessent;
 }
 
-void AVSource::SendAudioData(AudioOutputDevice* device,avtime_t duration) {
+unsigned long AVSource::SendAudioData(AudioOutputDevice* device,avtime_t duration) {
     unsigned long numsamples = 0;
     if(duration) {
         unsigned long begin_index = GetSampleIndex(m_CurrentAudioTime);
         unsigned long end_index = GetSampleIndex(m_CurrentAudioTime + duration);
         if(end_index <= begin_index) {
-            return;
+            return 0;
         } else {
             numsamples = end_index + 1- begin_index;
         }
     }
-    SendAudioData(device, numsamples);
+    return SendAudioData(device, numsamples);
+}
+
+unsigned long AVSource::ReadAudioBlock(syAudioBlock* dst, unsigned long numsamples) {
+    sySafeMutexLocker lock(*m_InputAudioMutex, this);
+    if(!lock.IsLocked() || !m_IsAudio || !m_AudioBuffer) {
+        dst->SetLength(0);
+        return 0;
+    }
+    unsigned long available = m_AudioBuffer->GetLength();
+    if(available < numsamples && !MustAbort()) {
+        unsigned long room = m_AudioBuffer->GetSize() - available;
+        unsigned long wanted = numsamples - available;
+        LoadAudioBuffer((wanted < room) ? wanted : room);
+    }
+    return m_AudioBuffer->ReadBlock(dst, numsamples);
+}
+
+unsigned int AVSource::GetAudioFrequency() const {
+    return m_AudioFrequency;
+}
+
+unsigned int AVSource::GetNumAudioChannels() const {
+    return m_NumAudioChannels;
 }
 
 
@@ -327,6 +376,9 @@ avtime_t AVSource::InternalAudioSeek(avtime_t time, bool fromend) {
     avtime_t result;
     if(!MustAbort()) {
         m_CurrentAudioTime = result = SeekAudioResource(time);
+        if(m_AudioBuffer) {
+            m_AudioBuffer->Clear(); // Drop the samples read before the seek.
+        }
     } else {
         result = m_CurrentAudioTime;
     }
@@ -360,6 +412,8 @@ bool AVSource::AllocateResources() {
 
 
 void AVSource::FreeResources() {
+    // The frames cached from the resource are no longer valid.
+    syFrameCache::Invalidate(this);
 
     if(m_AudioBuffer) {
         delete m_AudioBuffer;
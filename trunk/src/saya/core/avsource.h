@@ -17,6 +17,7 @@
 class sySafeMutex;
 class syBitmap;
 class syBitmapSink;
+class syAudioBlock;
 class syAudioBuffer;
 class AudioOutputDevice;
 class AVSource;
@@ -155,24 +156,44 @@ class AVSource : public AVDevice {
          * calls device->LoadAudioData(this->m_Buffer, numsamples).
          * @param device the AudioOutputDevice object to send the data to.
          * @param numsamples The number of samples to send. 0 = unlimited.
-         * @note When sending data, the device will not exit until the specified number
-         * of samples has been sent, we have reached EOF, or a stop/abort signal has been received.
+         * @return The number of samples sent.
+         * @note This method doesn't wait for the device to make room: it returns when the specified number
+         * of samples has been sent, the device's buffer is full, we have reached EOF, or a stop/abort signal
+         * has been received.
          */
-        void SendAudioData(AudioOutputDevice* device,unsigned long numsamples = 0);
+        unsigned long SendAudioData(AudioOutputDevice* device,unsigned long numsamples = 0);
 
         /** @brief Sends the buffer contents to the specified AudioOutputDevice.
          *
          *  This method calls LoadAudioBuffer() and then device->LoadAudioData.
          *  If duration != 0, the number of samples is obtained via GetSampleIndex;
          *  then SendAudioData is called using the obtained number of samples.
+         *  @return The number of samples sent.
          */
-        void SendAudioData(AudioOutputDevice* device,avtime_t duration = 0);
+        unsigned long SendAudioData(AudioOutputDevice* device,avtime_t duration = 0);
+
+        /** @brief Reads a block of audio, converted to floating point, from the current audio position.
+         *
+         *  If the audio buffer holds less than numsamples samples, LoadAudioBuffer() is called first to refill it.
+         *  @param dst The destination block (see syAudioBuffer::ReadBlock). Its length is set to the number of samples read.
+         *  @param numsamples The maximum number of samples to read.
+         *  @return The number of samples read; less than numsamples at the end of the resource.
+         */
+        unsigned long ReadAudioBlock(syAudioBlock* dst, unsigned long numsamples);
+
+        /** Gets the audio source's sample frequency, in Hz. */
+        unsigned int GetAudioFrequency() const;
+
+        /** Gets the audio source's number of channels. */
+        unsigned int GetNumAudioChannels() const;
 
     protected:
 
         /** @brief Loads the current frame into m_Bitmap.
          *
          *  This is a stub; you need to override this function to acomplish anything.
+         *  @note The sinks share m_Bitmap's buffer instead of copying it (see syBitmap::CopyFrom). If you overwrite
+         *  the whole frame, call m_Bitmap->Unshare(false) first so that the old pixels aren't copied for nothing.
          *  @warning You MUST NOT call Seek() from LoadCurrentFrame(), or you will trigger a mutex deadlock!!
          *  If you need to do a seeking, call InternalSeek() instead.
          */
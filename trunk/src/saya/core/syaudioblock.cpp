@@ -0,0 +1,447 @@
+/***************************************************************
+ * Name:      syaudioblock.cpp
+ * Purpose:   Implementation of the syAudioBlock class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syAudioBlock holds a block of audio as one row of
+ *            32-bit float samples per channel. It's the format
+ *            used for processing audio internally; integer
+ *            samples are only used at the device boundaries.
+ **************************************************************/
+
+#include "syaudioblock.h"
+#include "syrowconverter.h"
+#include "sysimd.h"
+#include <cmath>
+#include <cstring>
+
+/** Number of floats in syAudioBlock::Alignment bytes */
+static const unsigned int sy_alignfloats = syAudioBlock::Alignment / sizeof(float);
+
+/** Maximum number of sources mixed in one pass by syAudioBlock::Mix() */
+static const unsigned int sy_maxmixsources = 32;
+
+// -----------------------
+// Begin sample converters
+// -----------------------
+
+// Integers are converted to floats exactly like the CPU does it (rounding to nearest, ties to even), and then
+// multiplied by a power of two, which is also exact. Floats are converted back to integers with lrintf(), which
+// uses the same rounding mode as _mm_cvtps_epi32(); they're clamped before the conversion, so the SSE2 versions
+// give exactly the same results as the plain C ones.
+
+/** Gets the factor that converts integers of the given precision into the -1.0 to 1.0 range. */
+static float sy_intscale(unsigned int precision) {
+    return (float)ldexp(1.0, 1 - (int)precision);
+}
+
+/** Gets the largest float that doesn't overflow an integer of the given precision. */
+static float sy_intmax(unsigned int precision) {
+    double exact = ldexp(1.0, (int)precision - 1) - 1.0;
+    float result = (float)exact;
+    if((double)result > exact) {
+        result = nextafterf(result, 0.0f);
+    }
+    return result;
+}
+
+static void sy_from_int(const int* src, float* dst, unsigned int stride, unsigned int count, float scale) {
+    for(unsigned int i = 0; i < count; ++i, src += stride) {
+        dst[i] = (float)*src * scale;
+    }
+}
+
+static void sy_to_int(const float* src, int* dst, unsigned int stride, unsigned int count, float scale, float minvalue, float maxvalue) {
+    for(unsigned int i = 0; i < count; ++i, dst += stride) {
+        float value = src[i] * scale;
+        if(value < minvalue) { value = minvalue; }
+        if(value > maxvalue) { value = maxvalue; }
+        *dst = (int)lrintf(value);
+    }
+}
+
+#ifdef SY_X86_SIMD
+
+/** Converts one channel of interleaved integers. Returns the number of samples converted (a multiple of 4). */
+SY_TARGET_SSE2 static unsigned int sy_from_int_sse2(const int* src, float* dst, unsigned int stride, unsigned int count, float scale) {
+    __m128 vscale = _mm_set1_ps(scale);
+    unsigned int i = 0;
+    if(stride == 1) {
+        for(; i + 4 <= count; i += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), vscale));
+        }
+    } else {
+        for(; i + 4 <= count; i += 4, src += 4*stride) {
+            __m128i v = _mm_setr_epi32(src[0], src[stride], src[2*stride], src[3*stride]);
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), vscale));
+        }
+    }
+    return i;
+}
+
+/** Converts two interleaved channels at once. Returns the number of samples converted (a multiple of 4). */
+SY_TARGET_SSE2 static unsigned int sy_from_int_stereo_sse2(const int* src, float* left, float* right, unsigned int count, float scale) {
+    __m128 vscale = _mm_set1_ps(scale);
+    unsigned int i = 0;
+    for(; i + 4 <= count; i += 4, src += 8) {
+        __m128 a = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)src));
+        __m128 b = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(src + 4)));
+        _mm_storeu_ps(left + i, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), vscale));
+        _mm_storeu_ps(right + i, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), vscale));
+    }
+    return i;
+}
+
+SY_TARGET_SSE2 static inline __m128i sy_to_int4_sse2(const float* src, __m128 vscale, __m128 vmin, __m128 vmax) {
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(src), vscale);
+    return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v, vmin), vmax));
+}
+
+/** Converts one channel into interleaved integers. Returns the number of samples converted (a multiple of 4). */
+SY_TARGET_SSE2 static unsigned int sy_to_int_sse2(const float* src, int* dst, unsigned int stride, unsigned int count, float scale, float minvalue, float maxvalue) {
+    __m128 vscale = _mm_set1_ps(scale);
+    __m128 vmin = _mm_set1_ps(minvalue);
+    __m128 vmax = _mm_set1_ps(maxvalue);
+    unsigned int i = 0;
+    if(stride == 1) {
+        for(; i + 4 <= count; i += 4) {
+            _mm_storeu_si128((__m128i*)(dst + i), sy_to_int4_sse2(src + i, vscale, vmin, vmax));
+        }
+    } else {
+        for(; i + 4 <= count; i += 4, dst += 4*stride) {
+            __m128i v = sy_to_int4_sse2(src + i, vscale, vmin, vmax);
+            dst[0] = _mm_cvtsi128_si32(v);
+            dst[stride] = _mm_cvtsi128_si32(_mm_shuffle_epi32(v, _MM_SHUFFLE(1, 1, 1, 1)));
+            dst[2*stride] = _mm_cvtsi128_si32(_mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 2, 2)));
+            dst[3*stride] = _mm_cvtsi128_si32(_mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3)));
+        }
+    }
+    return i;
+}
+
+/** Converts two channels into interleaved integers at once. Returns the number of samples converted (a multiple of 4). */
+SY_TARGET_SSE2 static unsigned int sy_to_int_stereo_sse2(const float* left, const float* right, int* dst, unsigned int count, float scale, float minvalue, float maxvalue) {
+    __m128 vscale = _mm_set1_ps(scale);
+    __m128 vmin = _mm_set1_ps(minvalue);
+    __m128 vmax = _mm_set1_ps(maxvalue);
+    unsigned int i = 0;
+    for(; i + 4 <= count; i += 4, dst += 8) {
+        __m128i l = sy_to_int4_sse2(left + i, vscale, vmin, vmax);
+        __m128i r = sy_to_int4_sse2(right + i, vscale, vmin, vmax);
+        _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi32(l, r));
+        _mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi32(l, r));
+    }
+    return i;
+}
+
+#endif
+
+// -----------------------
+// End sample converters
+// -----------------------
+
+// -----------------
+// Begin mix kernels
+// -----------------
+
+// Every output sample is accumulated in a register, adding the sources one by one in the same order, and
+// written once. The products and sums are done separately (not with FMA), so the vector versions give
+// exactly the same results as the plain C one.
+
+static void sy_mix(float* dst, const float* const* srcs, const float* gains, unsigned int numsrcs, unsigned int first, unsigned int count, bool accumulate) {
+    for(unsigned int i = first; i < count; ++i) {
+        float acc = accumulate ? dst[i] : 0.0f;
+        for(unsigned int k = 0; k < numsrcs; ++k) {
+            acc += srcs[k][i] * gains[k];
+        }
+        dst[i] = acc;
+    }
+}
+
+#ifdef SY_X86_SIMD
+
+/** Returns the number of samples mixed (a multiple of 4). */
+SY_TARGET_SSE2 static unsigned int sy_mix_sse2(float* dst, const float* const* srcs, const float* gains, unsigned int numsrcs, unsigned int count, bool accumulate) {
+    __m128 vgains[sy_maxmixsources];
+    for(unsigned int k = 0; k < numsrcs; ++k) {
+        vgains[k] = _mm_set1_ps(gains[k]);
+    }
+    unsigned int i = 0;
+    for(; i + 4 <= count; i += 4) {
+        __m128 acc = accumulate ? _mm_loadu_ps(dst + i) : _mm_setzero_ps();
+        for(unsigned int k = 0; k < numsrcs; ++k) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(srcs[k] + i), vgains[k]));
+        }
+        _mm_storeu_ps(dst + i, acc);
+    }
+    return i;
+}
+
+/** Returns the number of samples mixed (a multiple of 8). */
+SY_TARGET_AVX2 static unsigned int sy_mix_avx2(float* dst, const float* const* srcs, const float* gains, unsigned int numsrcs, unsigned int count, bool accumulate) {
+    __m256 vgains[sy_maxmixsources];
+    for(unsigned int k = 0; k < numsrcs; ++k) {
+        vgains[k] = _mm256_set1_ps(gains[k]);
+    }
+    unsigned int i = 0;
+    for(; i + 8 <= count; i += 8) {
+        __m256 acc = accumulate ? _mm256_loadu_ps(dst + i) : _mm256_setzero_ps();
+        for(unsigned int k = 0; k < numsrcs; ++k) {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(srcs[k] + i), vgains[k]));
+        }
+        _mm256_storeu_ps(dst + i, acc);
+    }
+    _mm256_zeroupper();
+    return i;
+}
+
+#endif
+
+// -----------------
+// End mix kernels
+// -----------------
+
+class syAudioBlock::Data {
+    public:
+        Data();
+        ~Data();
+
+        /** Releases the samples */
+        void Free();
+
+        unsigned int m_NumChannels;
+        unsigned int m_Capacity;
+        unsigned int m_Length;
+
+        /** Distance between the rows of two channels, in floats. A multiple of sy_alignfloats. */
+        unsigned int m_Stride;
+
+        /** The allocated memory */
+        float* m_Buffer;
+
+        /** The first row, aligned to syAudioBlock::Alignment */
+        float* m_Samples;
+};
+
+syAudioBlock::Data::Data() :
+m_NumChannels(0),
+m_Capacity(0),
+m_Length(0),
+m_Stride(0),
+m_Buffer(0),
+m_Samples(0)
+{
+}
+
+syAudioBlock::Data::~Data() {
+    Free();
+}
+
+void syAudioBlock::Data::Free() {
+    delete[] m_Buffer;
+    m_Buffer = 0;
+    m_Samples = 0;
+    m_NumChannels = 0;
+    m_Capacity = 0;
+    m_Length = 0;
+    m_Stride = 0;
+}
+
+syAudioBlock::syAudioBlock() {
+    m_Data = new Data;
+}
+
+syAudioBlock::syAudioBlock(unsigned int numchannels, unsigned int capacity) {
+    m_Data = new Data;
+    Realloc(numchannels, capacity);
+}
+
+syAudioBlock::~syAudioBlock() {
+    delete m_Data;
+}
+
+bool syAudioBlock::Realloc(unsigned int numchannels, unsigned int capacity) {
+    m_Data->Free();
+    if(!numchannels || !capacity) {
+        return false;
+    }
+    unsigned int stride = (capacity + sy_alignfloats - 1) & ~(sy_alignfloats - 1);
+    m_Data->m_Buffer = new float[numchannels*stride + sy_alignfloats];
+    unsigned long misalign = ((unsigned long)m_Data->m_Buffer) & (syAudioBlock::Alignment - 1);
+    m_Data->m_Samples = m_Data->m_Buffer + (misalign ? (syAudioBlock::Alignment - misalign) / sizeof(float) : 0);
+    m_Data->m_NumChannels = numchannels;
+    m_Data->m_Capacity = capacity;
+    m_Data->m_Stride = stride;
+    return true;
+}
+
+unsigned int syAudioBlock::GetNumChannels() const {
+    return m_Data->m_NumChannels;
+}
+
+unsigned int syAudioBlock::GetCapacity() const {
+    return m_Data->m_Capacity;
+}
+
+unsigned int syAudioBlock::GetLength() const {
+    return m_Data->m_Length;
+}
+
+void syAudioBlock::SetLength(unsigned int length) {
+    m_Data->m_Length = (length > m_Data->m_Capacity) ? m_Data->m_Capacity : length;
+}
+
+float* syAudioBlock::GetChannel(unsigned int channel) {
+    if(channel >= m_Data->m_NumChannels) {
+        return 0;
+    }
+    return m_Data->m_Samples + channel*m_Data->m_Stride;
+}
+
+const float* syAudioBlock::GetChannel(unsigned int channel) const {
+    if(channel >= m_Data->m_NumChannels) {
+        return 0;
+    }
+    return m_Data->m_Samples + channel*m_Data->m_Stride;
+}
+
+void syAudioBlock::Silence() {
+    for(unsigned int ch = 0; ch < m_Data->m_NumChannels; ++ch) {
+        memset(GetChannel(ch), 0, m_Data->m_Length*sizeof(float));
+    }
+}
+
+void syAudioBlock::ApplyGain(float gain) {
+    for(unsigned int ch = 0; ch < m_Data->m_NumChannels; ++ch) {
+        const float* row = GetChannel(ch);
+        MixRow(GetChannel(ch), &row, &gain, 1, m_Data->m_Length, false);
+    }
+}
+
+void syAudioBlock::FromInterleaved(const int* src, unsigned int first, unsigned int count, unsigned int precision) {
+    if(first >= m_Data->m_Capacity) {
+        return;
+    }
+    if(count > m_Data->m_Capacity - first) {
+        count = m_Data->m_Capacity - first;
+    }
+    if(precision < 1) { precision = 1; }
+    if(precision > 32) { precision = 32; }
+    float scale = sy_intscale(precision);
+    unsigned int numchannels = m_Data->m_NumChannels;
+    unsigned int ch = 0;
+    #ifdef SY_X86_SIMD
+    if(syRowConverter::HasSSE2()) {
+        if(numchannels == 2) {
+            float* left = GetChannel(0) + first;
+            float* right = GetChannel(1) + first;
+            unsigned int done = sy_from_int_stereo_sse2(src, left, right, count, scale);
+            sy_from_int(src + 2*done, left + done, 2, count - done, scale);
+            sy_from_int(src + 2*done + 1, right + done, 2, count - done, scale);
+            ch = 2;
+        }
+        for(; ch < numchannels; ++ch) {
+            float* row = GetChannel(ch) + first;
+            unsigned int done = sy_from_int_sse2(src + ch, row, numchannels, count, scale);
+            sy_from_int(src + ch + numchannels*done, row + done, numchannels, count - done, scale);
+        }
+    }
+    #endif
+    for(; ch < numchannels; ++ch) {
+        sy_from_int(src + ch, GetChannel(ch) + first, numchannels, count, scale);
+    }
+}
+
+void syAudioBlock::ToInterleaved(int* dst, unsigned int first, unsigned int count, unsigned int precision) const {
+    if(first >= m_Data->m_Capacity) {
+        return;
+    }
+    if(count > m_Data->m_Capacity - first) {
+        count = m_Data->m_Capacity - first;
+    }
+    if(precision < 1) { precision = 1; }
+    if(precision > 32) { precision = 32; }
+    float scale = 1.0f / sy_intscale(precision);
+    float minvalue = -scale;
+    float maxvalue = sy_intmax(precision);
+    unsigned int numchannels = m_Data->m_NumChannels;
+    unsigned int ch = 0;
+    #ifdef SY_X86_SIMD
+    if(syRowConverter::HasSSE2()) {
+        if(numchannels == 2) {
+            const float* left = GetChannel(0) + first;
+            const float* right = GetChannel(1) + first;
+            unsigned int done = sy_to_int_stereo_sse2(left, right, dst, count, scale, minvalue, maxvalue);
+            sy_to_int(left + done, dst + 2*done, 2, count - done, scale, minvalue, maxvalue);
+            sy_to_int(right + done, dst + 2*done + 1, 2, count - done, scale, minvalue, maxvalue);
+            ch = 2;
+        }
+        for(; ch < numchannels; ++ch) {
+            const float* row = GetChannel(ch) + first;
+            unsigned int done = sy_to_int_sse2(row, dst + ch, numchannels, count, scale, minvalue, maxvalue);
+            sy_to_int(row + done, dst + ch + numchannels*done, numchannels, count - done, scale, minvalue, maxvalue);
+        }
+    }
+    #endif
+    for(; ch < numchannels; ++ch) {
+        sy_to_int(GetChannel(ch) + first, dst + ch, numchannels, count, scale, minvalue, maxvalue);
+    }
+}
+
+void syAudioBlock::Mix(const syAudioBlock* const* sources, const float* gains, unsigned int numsources, bool accumulate) {
+    unsigned int length = m_Data->m_Length;
+    for(unsigned int ch = 0; ch < m_Data->m_NumChannels; ++ch) {
+        float* dst = GetChannel(ch);
+        // Mix the sources that cover the whole block in one pass (or one per sy_maxmixsources sources).
+        const float* rows[sy_maxmixsources];
+        float rowgains[sy_maxmixsources];
+        unsigned int numrows = 0;
+        bool added = accumulate;
+        for(unsigned int k = 0; k < numsources; ++k) {
+            if(ch >= sources[k]->GetNumChannels() || sources[k]->GetLength() < length) {
+                continue;
+            }
+            rows[numrows] = sources[k]->GetChannel(ch);
+            rowgains[numrows] = gains[k];
+            if(++numrows == sy_maxmixsources) {
+                MixRow(dst, rows, rowgains, numrows, length, added);
+                numrows = 0;
+                added = true;
+            }
+        }
+        if(numrows || !added) {
+            MixRow(dst, rows, rowgains, numrows, length, added);
+        }
+        // Then add the shorter ones.
+        for(unsigned int k = 0; k < numsources; ++k) {
+            if(ch >= sources[k]->GetNumChannels() || sources[k]->GetLength() >= length) {
+                continue;
+            }
+            const float* row = sources[k]->GetChannel(ch);
+            MixRow(dst, &row, &gains[k], 1, sources[k]->GetLength(), true);
+        }
+    }
+}
+
+void syAudioBlock::MixRow(float* dst, const float* const* srcs, const float* gains, unsigned int numsrcs, unsigned int count, bool accumulate) {
+    // The vector kernels keep the gains in registers; mix larger groups a slice at a time.
+    while(numsrcs > sy_maxmixsources) {
+        MixRow(dst, srcs, gains, sy_maxmixsources, count, accumulate);
+        srcs += sy_maxmixsources;
+        gains += sy_maxmixsources;
+        numsrcs -= sy_maxmixsources;
+        accumulate = true;
+    }
+    unsigned int done = 0;
+    #ifdef SY_X86_SIMD
+    if(syRowConverter::HasAVX2()) {
+        done = sy_mix_avx2(dst, srcs, gains, numsrcs, count, accumulate);
+    } else if(syRowConverter::HasSSE2()) {
+        done = sy_mix_sse2(dst, srcs, gains, numsrcs, count, accumulate);
+    }
+    #endif
+    sy_mix(dst, srcs, gains, numsrcs, done, count, accumulate);
+}
@@ -0,0 +1,117 @@
+/***************************************************************
+ * Name:      syaudioblock.h
+ * Purpose:   Declaration for the syAudioBlock class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syAudioBlock holds a block of audio as one row of
+ *            32-bit float samples per channel. It's the format
+ *            used for processing audio internally; integer
+ *            samples are only used at the device boundaries.
+ **************************************************************/
+
+#ifndef syaudioblock_h
+#define syaudioblock_h
+
+/** @brief A block of planar 32-bit float audio.
+ *
+ *  Each channel is stored in its own row of GetCapacity() samples, aligned to syAudioBlock::Alignment bytes.
+ *  Full scale is -1.0 to 1.0; samples out of range are kept until the block is converted back to integers.
+ *
+ *  Integer samples, like the ones in a syAudioBuffer, are interleaved and have a precision in bits:
+ *  FromInterleaved() and ToInterleaved() convert between both formats, with SSE2 kernels when available.
+ *
+ *  Mix() adds up any number of blocks, each with its own gain, in a single pass over the destination.
+ *  All the kernels use separate multiplications and additions (not fused), so the results are exactly
+ *  the same on every CPU.
+ */
+class syAudioBlock {
+    public:
+        /** Alignment of each channel row, in bytes */
+        static const unsigned int Alignment = 32;
+
+        /** Standard constructor. Creates an empty block. */
+        syAudioBlock();
+
+        /** @brief Constructor.
+         *  @param numchannels The number of channels.
+         *  @param capacity The number of samples per channel.
+         */
+        syAudioBlock(unsigned int numchannels, unsigned int capacity);
+
+        /** Standard destructor. */
+        ~syAudioBlock();
+
+        /** @brief Reallocates the block. The contents are lost, and the length is set to 0.
+         *  @return false if either parameter is 0 (the block is left empty).
+         */
+        bool Realloc(unsigned int numchannels, unsigned int capacity);
+
+        /** Gets the number of channels. */
+        unsigned int GetNumChannels() const;
+
+        /** Gets the maximum number of samples per channel. */
+        unsigned int GetCapacity() const;
+
+        /** Gets the number of valid samples per channel. */
+        unsigned int GetLength() const;
+
+        /** Sets the number of valid samples per channel. Limited to GetCapacity(). */
+        void SetLength(unsigned int length);
+
+        /** Gets the row of samples for a channel; NULL if channel is out of range. */
+        float* GetChannel(unsigned int channel);
+
+        /** @see GetChannel(unsigned int) */
+        const float* GetChannel(unsigned int channel) const;
+
+        /** Sets the first GetLength() samples of every channel to 0. */
+        void Silence();
+
+        /** Multiplies the first GetLength() samples of every channel by gain. */
+        void ApplyGain(float gain);
+
+        /** @brief Converts interleaved integer samples into the block.
+         *  @param src The source samples, count * GetNumChannels() integers.
+         *  @param first The first sample of the block to write.
+         *  @param count The number of samples per channel to convert. Limited to the capacity.
+         *  @param precision The precision of the source samples, in bits (1 to 32).
+         *  @note The length of the block isn't changed.
+         */
+        void FromInterleaved(const int* src, unsigned int first, unsigned int count, unsigned int precision);
+
+        /** @brief Converts samples of the block into interleaved integers.
+         *  The samples are rounded to the nearest integer and clamped to the precision's range.
+         *  @param dst The destination, with room for count * GetNumChannels() integers.
+         *  @param first The first sample of the block to read.
+         *  @param count The number of samples per channel to convert. Limited to the capacity.
+         *  @param precision The precision of the destination samples, in bits (1 to 32).
+         */
+        void ToInterleaved(int* dst, unsigned int first, unsigned int count, unsigned int precision) const;
+
+        /** @brief Mixes several blocks into this one: sample = sum(sources[i] sample * gains[i]).
+         *
+         *  Only the first GetLength() samples are mixed; sources with fewer samples or channels add silence.
+         *  @param sources The blocks to mix. This block may be one of them.
+         *  @param gains The gain of each source.
+         *  @param numsources The number of sources.
+         *  @param accumulate If true, the sources are added to the current contents of the block.
+         */
+        void Mix(const syAudioBlock* const* sources, const float* gains, unsigned int numsources, bool accumulate = false);
+
+        /** @brief Mixes rows of samples: dst[i] = (accumulate ? dst[i] : 0) + sum(srcs[k][i] * gains[k]).
+         *  The kernel used by Mix(). The sources are added in order, so the result doesn't depend on the CPU.
+         */
+        static void MixRow(float* dst, const float* const* srcs, const float* gains, unsigned int numsrcs, unsigned int count, bool accumulate);
+
+    private:
+        class Data;
+        friend class Data;
+        Data* m_Data;
+
+        syAudioBlock(const syAudioBlock& copy);
+        syAudioBlock& operator=(const syAudioBlock& copy);
+};
+
+#endif
@@ -0,0 +1,588 @@
+/***************************************************************
+ * Name:      syaudiofilesink.cpp
+ * Purpose:   Implementation of the syAudioFileSink class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syAudioFileSink writes audio to a WAV or raw PCM
+ *            file, for exporting audio without a sound card.
+ **************************************************************/
+
+#include "syaudiofilesink.h"
+#include "audiobuffer.h"
+#include "sythread.h"
+#include <cstring>
+
+#ifdef __WIN32__
+    #include <windows.h>
+#else
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif
+
+/** Alignment of the write buffer, and of the blocks written with direct I/O. */
+static const unsigned int sy_filesinkalignment = 4096;
+
+/** The write buffer is a multiple of this size. */
+static const unsigned int sy_filesinkgranularity = 65536;
+
+static const unsigned int sy_filesinkdefaultbuffer = 1048576;
+
+/** Maximum number of values (samples times channels) converted at once by RenderAudioData(). */
+static const unsigned int sy_filesinkvalues = 8192;
+
+/** Size of the canonical WAV header: RIFF header, 16-byte "fmt " chunk and "data" chunk header. */
+static const unsigned int sy_wavheadersize = 44;
+
+/** Size of the WAV header with a WAVE_FORMAT_EXTENSIBLE "fmt " chunk. */
+static const unsigned int sy_wavextheadersize = 68;
+
+// -----------------------
+// Begin syAudioFileWriter
+// -----------------------
+
+/** @brief A file opened for writing, optionally around the system's cache.
+ *
+ *  With direct I/O, the data written with Write() must be aligned, both in memory and in size, to
+ *  sy_filesinkalignment. Reopen() goes back to normal I/O for the last, unaligned, block.
+ */
+class syAudioFileWriter {
+    public:
+        syAudioFileWriter();
+        ~syAudioFileWriter() { Close(); }
+
+        /** Creates the file, or truncates it. If direct I/O isn't available, the file is opened normally. */
+        bool Open(const char* filename, bool direct);
+
+        /** Reopens the file with normal I/O, at its end. */
+        bool Reopen();
+
+        /** Writes data at the current position. */
+        bool Write(const void* data, unsigned int size);
+
+        /** Writes data at an offset from the beginning of the file. The current position is lost. */
+        bool WriteAt(unsigned long long offset, const void* data, unsigned int size);
+
+        void Close();
+
+        bool IsOpened() const;
+
+        /** Returns true if the file was opened with direct I/O. */
+        bool IsDirect() const { return m_Direct; }
+
+    private:
+        syString m_Filename;
+        bool m_Direct;
+        #ifdef __WIN32__
+        HANDLE m_File;
+        #else
+        int m_File;
+        #endif
+};
+
+syAudioFileWriter::syAudioFileWriter() :
+m_Direct(false),
+#ifdef __WIN32__
+m_File(INVALID_HANDLE_VALUE)
+#else
+m_File(-1)
+#endif
+{
+}
+
+bool syAudioFileWriter::IsOpened() const {
+    #ifdef __WIN32__
+    return m_File != INVALID_HANDLE_VALUE;
+    #else
+    return m_File >= 0;
+    #endif
+}
+
+bool syAudioFileWriter::Open(const char* filename, bool direct) {
+    Close();
+    m_Filename = filename;
+    m_Direct = false;
+    #ifdef __WIN32__
+    if(direct) {
+        m_File = CreateFileA(filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, NULL);
+        m_Direct = (m_File != INVALID_HANDLE_VALUE);
+    }
+    if(!m_Direct) {
+        m_File = CreateFileA(filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    }
+    #else
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+    #ifdef O_DIRECT
+    if(direct) {
+        // Some filesystems (i.e. tmpfs) refuse O_DIRECT; fall back to normal I/O.
+        m_File = open(filename, flags | O_DIRECT, 0644);
+        m_Direct = (m_File >= 0);
+    }
+    #endif
+    if(!m_Direct) {
+        m_File = open(filename, flags, 0644);
+    }
+    #endif
+    return IsOpened();
+}
+
+bool syAudioFileWriter::Reopen() {
+    if(!m_Direct) {
+        return IsOpened();
+    }
+    Close();
+    m_Direct = false;
+    #ifdef __WIN32__
+    m_File = CreateFileA(m_Filename.c_str(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(m_File != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER zero;
+        zero.QuadPart = 0;
+        SetFilePointerEx(m_File, zero, NULL, FILE_END);
+    }
+    #else
+    m_File = open(m_Filename.c_str(), O_WRONLY);
+    if(m_File >= 0) {
+        lseek(m_File, 0, SEEK_END);
+    }
+    #endif
+    return IsOpened();
+}
+
+bool syAudioFileWriter::Write(const void* data, unsigned int size) {
+    const char* ptr = (const char*)data;
+    while(size) {
+        #ifdef __WIN32__
+        DWORD written = 0;
+        if(!WriteFile(m_File, ptr, size, &written, NULL) || !written) {
+            return false;
+        }
+        #else
+        ssize_t written = write(m_File, ptr, size);
+        if(written < 0 && errno == EINTR) {
+            continue;
+        }
+        if(written <= 0) {
+            return false;
+        }
+        #endif
+        ptr += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool syAudioFileWriter::WriteAt(unsigned long long offset, const void* data, unsigned int size) {
+    #ifdef __WIN32__
+    LARGE_INTEGER pos;
+    pos.QuadPart = offset;
+    if(!SetFilePointerEx(m_File, pos, NULL, FILE_BEGIN)) {
+        return false;
+    }
+    #else
+    if(lseek(m_File, (off_t)offset, SEEK_SET) == (off_t)-1) {
+        return false;
+    }
+    #endif
+    return Write(data, size);
+}
+
+void syAudioFileWriter::Close() {
+    if(!IsOpened()) {
+        return;
+    }
+    #ifdef __WIN32__
+    CloseHandle(m_File);
+    m_File = INVALID_HANDLE_VALUE;
+    #else
+    close(m_File);
+    m_File = -1;
+    #endif
+}
+
+// ---------------------
+// End syAudioFileWriter
+// ---------------------
+
+// -----------------
+// Begin WAV headers
+// -----------------
+
+static void sy_put16(unsigned char* dst, unsigned int value) {
+    dst[0] = value & 0xff;
+    dst[1] = (value >> 8) & 0xff;
+}
+
+static void sy_put32(unsigned char* dst, unsigned long value) {
+    dst[0] = value & 0xff;
+    dst[1] = (value >> 8) & 0xff;
+    dst[2] = (value >> 16) & 0xff;
+    dst[3] = (value >> 24) & 0xff;
+}
+
+/** Returns true if the WAV file needs a WAVE_FORMAT_EXTENSIBLE header. */
+static bool sy_wavextensible(unsigned int numchannels, unsigned int precision, unsigned int bytespersample) {
+    return numchannels > 2 || bytespersample > 2 || precision != 8*bytespersample;
+}
+
+/** @brief Writes a WAV header into dst, which must have room for sy_wavextheadersize bytes.
+ *  Sizes that don't fit in 32 bits are written as 0xFFFFFFFF. The RIFF size counts the pad byte
+ *  that follows a data chunk of odd size.
+ *  @return The size of the header.
+ */
+static unsigned int sy_wavheader(unsigned char* dst, unsigned int freq, unsigned int numchannels, unsigned int precision,
+    unsigned int bytespersample, unsigned long long databytes) {
+    bool extensible = sy_wavextensible(numchannels, precision, bytespersample);
+    unsigned int headersize = extensible ? sy_wavextheadersize : sy_wavheadersize;
+    unsigned long long riffsize = databytes + (databytes & 1) + headersize - 8;
+    unsigned int blockalign = numchannels * bytespersample;
+
+    memcpy(dst, "RIFF", 4);
+    sy_put32(dst + 4, (riffsize > 0xffffffffULL) ? 0xffffffffUL : (unsigned long)riffsize);
+    memcpy(dst + 8, "WAVEfmt ", 8);
+    sy_put32(dst + 16, extensible ? 40 : 16);
+    sy_put16(dst + 20, extensible ? 0xfffe : 1); // WAVE_FORMAT_EXTENSIBLE or WAVE_FORMAT_PCM
+    sy_put16(dst + 22, numchannels);
+    sy_put32(dst + 24, freq);
+    sy_put32(dst + 28, freq * blockalign);
+    sy_put16(dst + 32, blockalign);
+    sy_put16(dst + 34, 8*bytespersample);
+    unsigned char* data = dst + 36;
+    if(extensible) {
+        // The speaker positions follow the standard order, so the first channels take the first positions.
+        static const unsigned char pcmguid[16] = {
+            0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71
+        };
+        sy_put16(dst + 36, 22);
+        sy_put16(dst + 38, precision);
+        sy_put32(dst + 40, (numchannels < 18) ? (1UL << numchannels) - 1 : 0);
+        memcpy(dst + 44, pcmguid, 16);
+        data = dst + 60;
+    }
+    memcpy(data, "data", 4);
+    sy_put32(data + 4, (databytes > 0xffffffffULL) ? 0xffffffffUL : (unsigned long)databytes);
+    return headersize;
+}
+
+// ---------------
+// End WAV headers
+// ---------------
+
+/** Packs integers of 8*bytespersample bits into little-endian bytes. 8-bit samples become unsigned. */
+static void sy_packsamples(const int* src, unsigned char* dst, unsigned int count, unsigned int bytespersample) {
+    unsigned int i;
+    switch(bytespersample) {
+        case 1:
+            for(i = 0; i < count; ++i) {
+                dst[i] = (unsigned char)(src[i] + 128);
+            }
+            break;
+        case 2:
+            for(i = 0; i < count; ++i, dst += 2) {
+                dst[0] = src[i] & 0xff;
+                dst[1] = (src[i] >> 8) & 0xff;
+            }
+            break;
+        case 3:
+            for(i = 0; i < count; ++i, dst += 3) {
+                dst[0] = src[i] & 0xff;
+                dst[1] = (src[i] >> 8) & 0xff;
+                dst[2] = (src[i] >> 16) & 0xff;
+            }
+            break;
+        default:
+            for(i = 0; i < count; ++i, dst += 4) {
+                dst[0] = src[i] & 0xff;
+                dst[1] = (src[i] >> 8) & 0xff;
+                dst[2] = (src[i] >> 16) & 0xff;
+                dst[3] = (src[i] >> 24) & 0xff;
+            }
+            break;
+    }
+}
+
+// ---------------------------
+// Begin syAudioFileSink::Data
+// ---------------------------
+
+class syAudioFileSink::Data {
+    public:
+        Data();
+        ~Data();
+
+        /** Allocates the write buffer, aligned to sy_filesinkalignment. */
+        void AllocateBuffer(unsigned int size);
+
+        void FreeBuffer();
+
+        /** Appends bytes to the write buffer, writing it to the file whenever it's full. */
+        void Append(const unsigned char* data, unsigned int size);
+
+        /** Writes the (full) write buffer to the file. */
+        bool WriteBuffer();
+
+        /** Writes the rest of the write buffer and the final header, and closes the file. */
+        void Finish();
+
+        // Settings
+
+        syString m_Filename;
+        FileFormat m_Format;
+        bool m_DirectIO;
+        unsigned int m_WriteBufferSize;
+
+        // Current file
+
+        syAudioFileWriter m_File;
+        unsigned int m_Freq;
+        unsigned int m_NumChannels;
+        unsigned int m_Precision;
+        unsigned int m_BytesPerSample;
+        unsigned int m_HeaderSize;
+
+        /** Number of bytes of samples received, including the ones still in the write buffer */
+        unsigned long long m_DataBytes;
+
+        /** Number of samples received; guarded by m_Mutex. */
+        unsigned long long m_SamplesWritten;
+
+        volatile bool m_Error;
+
+        mutable syMutex m_Mutex;
+
+        // Write buffer
+
+        /** The memory allocated for the write buffer */
+        char* m_Memory;
+
+        /** The write buffer, aligned */
+        unsigned char* m_Buffer;
+
+        unsigned int m_BufferSize;
+        unsigned int m_BufferUsed;
+
+        /** The samples read from the device's buffer */
+        int m_Samples[sy_filesinkvalues];
+
+        /** The samples packed as bytes */
+        unsigned char m_Packed[sy_filesinkvalues * 4];
+};
+
+syAudioFileSink::Data::Data() :
+m_Format(syAudioFileSink::WAVFile),
+m_DirectIO(false),
+m_WriteBufferSize(sy_filesinkdefaultbuffer),
+m_Freq(0),
+m_NumChannels(0),
+m_Precision(0),
+m_BytesPerSample(0),
+m_HeaderSize(0),
+m_DataBytes(0),
+m_SamplesWritten(0),
+m_Error(false),
+m_Memory(NULL),
+m_Buffer(NULL),
+m_BufferSize(0),
+m_BufferUsed(0)
+{
+}
+
+syAudioFileSink::Data::~Data() {
+    FreeBuffer();
+}
+
+void syAudioFileSink::Data::AllocateBuffer(unsigned int size) {
+    FreeBuffer();
+    m_Memory = new char[size + sy_filesinkalignment];
+    unsigned long misalign = (unsigned long)m_Memory % sy_filesinkalignment;
+    m_Buffer = (unsigned char*)(m_Memory + (misalign ? sy_filesinkalignment - misalign : 0));
+    m_BufferSize = size;
+    m_BufferUsed = 0;
+}
+
+void syAudioFileSink::Data::FreeBuffer() {
+    delete[] m_Memory;
+    m_Memory = NULL;
+    m_Buffer = NULL;
+    m_BufferSize = m_BufferUsed = 0;
+}
+
+bool syAudioFileSink::Data::WriteBuffer() {
+    if(!m_Error && !m_File.Write(m_Buffer, m_BufferUsed)) {
+        // If direct I/O was accepted on open but not on write, try again without it.
+        if(!m_File.IsDirect() || !m_File.Reopen() || !m_File.Write(m_Buffer, m_BufferUsed)) {
+            m_Error = true;
+        }
+    }
+    m_BufferUsed = 0;
+    return !m_Error;
+}
+
+void syAudioFileSink::Data::Append(const unsigned char* data, unsigned int size) {
+    while(size) {
+        unsigned int count = m_BufferSize - m_BufferUsed;
+        if(count > size) { count = size; }
+        memcpy(m_Buffer + m_BufferUsed, data, count);
+        m_BufferUsed += count;
+        data += count;
+        size -= count;
+        if(m_BufferUsed == m_BufferSize) {
+            WriteBuffer();
+        }
+    }
+}
+
+void syAudioFileSink::Data::Finish() {
+    if(!m_File.IsOpened()) {
+        return;
+    }
+    // RIFF chunks are word-aligned: a data chunk of odd size is followed by a zero pad byte.
+    if(m_Format == syAudioFileSink::WAVFile && (m_DataBytes & 1) && m_Buffer) {
+        static const unsigned char pad = 0;
+        Append(&pad, 1);
+    }
+    // The last block isn't aligned; write it (and the header) with normal I/O.
+    if(m_BufferUsed) {
+        if(!m_File.Reopen()) {
+            m_Error = true;
+        }
+        WriteBuffer();
+    }
+    if(m_Format == syAudioFileSink::WAVFile && !m_Error) {
+        unsigned char header[sy_wavextheadersize];
+        sy_wavheader(header, m_Freq, m_NumChannels, m_Precision, m_BytesPerSample, m_DataBytes);
+        if(!m_File.Reopen() || !m_File.WriteAt(0, header, m_HeaderSize)) {
+            m_Error = true;
+        }
+    }
+    m_File.Close();
+}
+
+// -------------------------
+// End syAudioFileSink::Data
+// -------------------------
+
+// ---------------------
+// Begin syAudioFileSink
+// ---------------------
+
+syAudioFileSink::syAudioFileSink() :
+m_Data(new Data)
+{
+}
+
+syAudioFileSink::~syAudioFileSink() {
+    ShutDown();
+    delete m_Data;
+}
+
+void syAudioFileSink::SetFilename(const syString& filename) {
+    m_Data->m_Filename = filename;
+}
+
+const syString& syAudioFileSink::GetFilename() const {
+    return m_Data->m_Filename;
+}
+
+void syAudioFileSink::SetFileFormat(FileFormat format) {
+    m_Data->m_Format = format;
+}
+
+syAudioFileSink::FileFormat syAudioFileSink::GetFileFormat() const {
+    return m_Data->m_Format;
+}
+
+void syAudioFileSink::SetDirectIO(bool direct) {
+    m_Data->m_DirectIO = direct;
+}
+
+bool syAudioFileSink::GetDirectIO() const {
+    return m_Data->m_DirectIO;
+}
+
+void syAudioFileSink::SetWriteBufferSize(unsigned int size) {
+    if(size < sy_filesinkgranularity) { size = sy_filesinkgranularity; }
+    m_Data->m_WriteBufferSize = ((size + sy_filesinkgranularity - 1) / sy_filesinkgranularity) * sy_filesinkgranularity;
+}
+
+unsigned long long syAudioFileSink::GetSamplesWritten() const {
+    syMutexLocker lock(m_Data->m_Mutex);
+    return m_Data->m_SamplesWritten;
+}
+
+bool syAudioFileSink::HasError() const {
+    return m_Data->m_Error;
+}
+
+bool syAudioFileSink::ConnectAudioOutput(unsigned int& freq, unsigned int& numchannels, unsigned int& precision) {
+    if(m_Data->m_Filename.empty()) {
+        return false;
+    }
+    if(!m_Data->m_File.Open(m_Data->m_Filename.c_str(), m_Data->m_DirectIO)) {
+        return false;
+    }
+    m_Data->m_Freq = freq;
+    m_Data->m_NumChannels = numchannels;
+    m_Data->m_Precision = precision;
+    m_Data->m_BytesPerSample = (precision + 7) / 8;
+    m_Data->m_DataBytes = 0;
+    m_Data->m_Error = false;
+    {
+        syMutexLocker lock(m_Data->m_Mutex);
+        m_Data->m_SamplesWritten = 0;
+    }
+    return true;
+}
+
+void syAudioFileSink::Disconnect() {
+    m_Data->Finish();
+}
+
+bool syAudioFileSink::AllocateAudioData() {
+    m_Data->AllocateBuffer(m_Data->m_WriteBufferSize);
+    m_Data->m_HeaderSize = 0;
+    if(m_Data->m_Format == WAVFile) {
+        // The header goes first in the write buffer, so that the blocks written stay aligned.
+        // It's written again with the final sizes when the file is closed.
+        m_Data->m_HeaderSize = sy_wavheader(m_Data->m_Buffer, m_Data->m_Freq, m_Data->m_NumChannels,
+            m_Data->m_Precision, m_Data->m_BytesPerSample, 0);
+        m_Data->m_BufferUsed = m_Data->m_HeaderSize;
+    }
+    return true;
+}
+
+void syAudioFileSink::FreeAudioData() {
+    m_Data->FreeBuffer();
+}
+
+void syAudioFileSink::RenderAudioData(const syAudioBuffer* buf) {
+    if(!IsOk() || !m_Data->m_Buffer) return;
+    unsigned int numchannels = m_Data->m_NumChannels;
+    unsigned int bytespersample = m_Data->m_BytesPerSample;
+    unsigned int chunk = sy_filesinkvalues / numchannels; // At least 32 samples (see syAudioBuffer::maxaudiochannels)
+    while(!MustAbort()) {
+        unsigned int count = buf->ReadBlock(m_Data->m_Samples, chunk, 8*bytespersample);
+        if(!count) {
+            break;
+        }
+        if(!m_Data->m_Error) {
+            unsigned int values = count * numchannels;
+            sy_packsamples(m_Data->m_Samples, m_Data->m_Packed, values, bytespersample);
+            m_Data->Append(m_Data->m_Packed, values * bytespersample);
+            m_Data->m_DataBytes += values * bytespersample;
+        }
+        {
+            syMutexLocker lock(m_Data->m_Mutex);
+            m_Data->m_SamplesWritten += count;
+        }
+        AddPlayedSamples(count);
+    }
+}
+
+// -------------------
+// End syAudioFileSink
+// -------------------
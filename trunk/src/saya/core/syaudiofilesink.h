@@ -0,0 +1,110 @@
+/***************************************************************
+ * Name:      syaudiofilesink.h
+ * Purpose:   Declaration for the syAudioFileSink class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syAudioFileSink writes audio to a WAV or raw PCM
+ *            file, for exporting audio without a sound card.
+ **************************************************************/
+
+#ifndef syaudiofilesink_h
+#define syaudiofilesink_h
+
+#include "audiooutputdevice.h"
+#include "systring.h"
+
+/** @brief An AudioOutputDevice that writes the audio to a file.
+ *
+ *  The samples are written as little-endian PCM, with 1 to 4 bytes per sample: the sample precision
+ *  is rounded up to whole bytes, and 8-bit samples are unsigned, like in WAV files. The file is either a WAV file
+ *  or the raw samples with no header.
+ *
+ *  The device is an encoder (see IsEncoder()): RenderAudioData() writes everything it finds in the buffer,
+ *  as fast as the disk allows. The samples written are reported with AddPlayedSamples().
+ *
+ *  The samples are collected in a large write buffer, so that the file is written in few big blocks.
+ *  With SetDirectIO(), the file is opened with O_DIRECT (FILE_FLAG_NO_BUFFERING on Windows), bypassing
+ *  the system's cache; the blocks are aligned as needed.
+ *
+ *  Set the file name and format, and then call Init(). The file is completed (i.e. the WAV header is updated)
+ *  and closed by ShutDown().
+ */
+class syAudioFileSink : public AudioOutputDevice {
+    public:
+        /** The file formats */
+        enum FileFormat {
+            WAVFile = 0, /**< A RIFF WAVE file. WAVE_FORMAT_EXTENSIBLE is used for more than 2 channels or 16 bits. */
+            RawFile      /**< The samples only, interleaved. */
+        };
+
+        /** Standard constructor. */
+        syAudioFileSink();
+
+        /** Standard destructor. */
+        virtual ~syAudioFileSink();
+
+        /** Sets the name of the file to create on the next Init(). An existing file is overwritten. */
+        void SetFilename(const syString& filename);
+
+        /** Gets the name of the file. */
+        const syString& GetFilename() const;
+
+        /** Sets the file format for the next Init(). The default is WAVFile. */
+        void SetFileFormat(FileFormat format);
+
+        /** Gets the file format. */
+        FileFormat GetFileFormat() const;
+
+        /** @brief Enables writing around the system's cache, on the next Init().
+         *  If the system doesn't support it for the file, the file is written normally.
+         */
+        void SetDirectIO(bool direct);
+
+        /** Returns true if direct I/O was requested. */
+        bool GetDirectIO() const;
+
+        /** @brief Sets the size of the write buffer for the next Init(), in bytes.
+         *  Rounded up to a multiple of 64 KB. The default is 1 MB.
+         */
+        void SetWriteBufferSize(unsigned int size);
+
+        /** Gets the number of samples written so far. */
+        unsigned long long GetSamplesWritten() const;
+
+        /** Returns true if writing the file failed. The samples received afterwards are discarded. */
+        bool HasError() const;
+
+        /** We're an encoder. */
+        virtual bool IsEncoder() { return true; }
+
+        /** The samples written are reported with AddPlayedSamples(). */
+        virtual bool HasPlaybackClock() { return true; }
+
+    protected:
+        /** Opens the file. Fails if no filename was set or the file can't be created. */
+        virtual bool ConnectAudioOutput(unsigned int& freq, unsigned int& numchannels, unsigned int& precision);
+
+        /** Writes the pending samples, completes the file and closes it. */
+        virtual void Disconnect();
+
+        /** Allocates the write buffer, and starts it with the file header. */
+        virtual bool AllocateAudioData();
+
+        /** Frees the write buffer. */
+        virtual void FreeAudioData();
+
+        /** Writes all the samples in the buffer to the file. */
+        virtual void RenderAudioData(const syAudioBuffer* buf);
+
+    private:
+        class Data;
+        friend class Data;
+        Data* m_Data;
+
+        syAudioFileSink(const syAudioFileSink& copy);
+        syAudioFileSink& operator=(const syAudioFileSink& copy);
+};
+
+#endif
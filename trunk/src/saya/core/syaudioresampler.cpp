@@ -0,0 +1,484 @@
+/***************************************************************
+ * Name:      syaudioresampler.cpp
+ * Purpose:   Implementation of the syAudioResampler class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syAudioResampler converts a stream of audio samples
+ *            from one sample rate to another with a polyphase
+ *            windowed-sinc filter, so that clips at different
+ *            sample rates can be played together in real time.
+ **************************************************************/
+
+#include "syaudioresampler.h"
+#include "syrowconverter.h"
+#include "sythread.h"
+#include "sysimd.h"
+#include <cmath>
+#include <cstring>
+
+// -------------------
+// Begin dot products
+// -------------------
+
+// Both versions add up the products in four interleaved partial sums, and add the partial sums in the same
+// order; so the SSE2 version gives exactly the same results as the plain C one.
+
+/** Multiplies taps coefficients by taps samples and adds the results. taps must be a multiple of 4. */
+static float sy_dot(const float* coefs, const float* x, unsigned int taps) {
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    for(unsigned int k = 0; k < taps; k += 4) {
+        s0 += coefs[k]*x[k];
+        s1 += coefs[k + 1]*x[k + 1];
+        s2 += coefs[k + 2]*x[k + 2];
+        s3 += coefs[k + 3]*x[k + 3];
+    }
+    return (s0 + s2) + (s1 + s3);
+}
+
+#ifdef SY_X86_SIMD
+
+SY_TARGET_SSE2 static float sy_dot_sse2(const float* coefs, const float* x, unsigned int taps) {
+    __m128 sum = _mm_setzero_ps();
+    for(unsigned int k = 0; k < taps; k += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(coefs + k), _mm_loadu_ps(x + k)));
+    }
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+#endif
+
+// -------------------
+// End dot products
+// -------------------
+
+// ------------------
+// Begin filter banks
+// ------------------
+
+/** @brief The coefficients of a polyphase filter for one L / M ratio. */
+class syAudioFilterBank {
+    public:
+        syAudioFilterBank(unsigned int l, unsigned int m);
+        ~syAudioFilterBank();
+
+        /** Upsampling factor */
+        unsigned int m_L;
+
+        /** Downsampling factor */
+        unsigned int m_M;
+
+        /** Number of phases; m_L unless it's larger than syAudioResampler::MaxPhases */
+        unsigned int m_Phases;
+
+        /** Number of coefficients per phase. Always a multiple of 4. */
+        unsigned int m_Taps;
+
+        /** m_Phases * m_Taps coefficients */
+        float* m_Coefs;
+
+        /** Number of users, counting the cache. Protected by the cache's mutex. */
+        unsigned int m_RefCount;
+};
+
+/** Zero-order modified Bessel function of the first kind, for the Kaiser window. */
+static double sy_bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for(unsigned int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if(term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+syAudioFilterBank::syAudioFilterBank(unsigned int l, unsigned int m) :
+m_L(l),
+m_M(m),
+m_RefCount(1)
+{
+    // Kaiser window parameter; gives about 80 dB of stopband attenuation.
+    const double beta = 8.0;
+    // Cutoff, relative to the input's Nyquist frequency. When downsampling, the output's Nyquist frequency
+    // is lower, and the filter must be longer to keep the same transition band.
+    double cutoff = 0.91;
+    unsigned int taps = syAudioResampler::BaseTaps;
+    if(l < m) {
+        cutoff = cutoff * l / m;
+        unsigned long long wider = ((unsigned long long)taps * m + l - 1) / l;
+        taps = (wider > syAudioResampler::MaxTaps) ? syAudioResampler::MaxTaps : (unsigned int)wider;
+        taps = (taps + 3) & ~3;
+    }
+    m_Taps = taps;
+    m_Phases = (l > syAudioResampler::MaxPhases) ? syAudioResampler::MaxPhases : l;
+    m_Coefs = new float[m_Phases * m_Taps];
+
+    double half = m_Taps / 2;
+    double i0beta = sy_bessel_i0(beta);
+    double* h = new double[m_Taps];
+    for(unsigned int p = 0; p < m_Phases; ++p) {
+        // Tap k of phase p multiplies the input sample at distance d from the output sample.
+        double sum = 0.0;
+        for(unsigned int k = 0; k < m_Taps; ++k) {
+            double d = (half - 1 - k) + (double)p / m_Phases;
+            double x = M_PI * cutoff * d;
+            double sinc = (fabs(x) < 1e-9) ? 1.0 : sin(x) / x;
+            double w = d / half;
+            double window = (w >= 1.0 || w <= -1.0) ? 0.0 : sy_bessel_i0(beta * sqrt(1.0 - w * w)) / i0beta;
+            h[k] = sinc * window;
+            sum += h[k];
+        }
+        // Normalize each phase, so that a constant signal stays constant.
+        float* coefs = m_Coefs + p * m_Taps;
+        for(unsigned int k = 0; k < m_Taps; ++k) {
+            coefs[k] = (float)(h[k] / sum);
+        }
+    }
+    delete[] h;
+}
+
+syAudioFilterBank::~syAudioFilterBank() {
+    delete[] m_Coefs;
+}
+
+/** @brief A small Most-Recently-Used list of filter banks. */
+class syAudioFilterBankCache {
+    public:
+        /** The number of filter banks kept when they're not in use */
+        static const unsigned int Capacity = 8;
+
+        syAudioFilterBankCache();
+        ~syAudioFilterBankCache();
+
+        static syAudioFilterBankCache& Get();
+
+        /** Gets a filter bank, creating it if necessary. */
+        static syAudioFilterBank* GetBank(unsigned int l, unsigned int m);
+
+        /** Releases a filter bank obtained by GetBank(). */
+        static void ReleaseBank(syAudioFilterBank* bank);
+
+        syMutex m_Mutex;
+        syAudioFilterBank* m_Items[Capacity];
+
+        /** Decrements the reference count and deletes the bank if unused. Must be called with m_Mutex locked. */
+        static void Unref(syAudioFilterBank* bank);
+};
+
+syAudioFilterBankCache::syAudioFilterBankCache() {
+    for(unsigned int i = 0; i < Capacity; ++i) {
+        m_Items[i] = 0;
+    }
+}
+
+syAudioFilterBankCache::~syAudioFilterBankCache() {
+    for(unsigned int i = 0; i < Capacity; ++i) {
+        if(m_Items[i]) {
+            Unref(m_Items[i]);
+        }
+    }
+}
+
+syAudioFilterBankCache& syAudioFilterBankCache::Get() {
+    static syAudioFilterBankCache cache;
+    return cache;
+}
+
+void syAudioFilterBankCache::Unref(syAudioFilterBank* bank) {
+    if(--bank->m_RefCount == 0) {
+        delete bank;
+    }
+}
+
+syAudioFilterBank* syAudioFilterBankCache::GetBank(unsigned int l, unsigned int m) {
+    syAudioFilterBankCache& cache = Get();
+    syMutexLocker lock(cache.m_Mutex);
+    syAudioFilterBank* result = 0;
+    unsigned int i;
+    for(i = 0; i < Capacity; ++i) {
+        if(cache.m_Items[i] && cache.m_Items[i]->m_L == l && cache.m_Items[i]->m_M == m) {
+            result = cache.m_Items[i];
+            break;
+        }
+    }
+    if(result) {
+        // Move it to the front of the list
+        for(; i > 0; --i) {
+            cache.m_Items[i] = cache.m_Items[i - 1];
+        }
+    } else {
+        result = new syAudioFilterBank(l, m);
+        if(cache.m_Items[Capacity - 1]) {
+            Unref(cache.m_Items[Capacity - 1]);
+        }
+        for(i = Capacity - 1; i > 0; --i) {
+            cache.m_Items[i] = cache.m_Items[i - 1];
+        }
+    }
+    cache.m_Items[0] = result;
+    ++result->m_RefCount;
+    return result;
+}
+
+void syAudioFilterBankCache::ReleaseBank(syAudioFilterBank* bank) {
+    syAudioFilterBankCache& cache = Get();
+    syMutexLocker lock(cache.m_Mutex);
+    Unref(bank);
+}
+
+// ------------------
+// End filter banks
+// ------------------
+
+class syAudioResampler::Data {
+    public:
+        /** Number of input samples added to the history at a time */
+        static const unsigned int ChunkSize = 1024;
+
+        Data();
+        ~Data();
+
+        /** Releases the filter bank and the history */
+        void Free();
+
+        /** Produces all the output samples that the history allows. */
+        unsigned int Produce(int* dst, double minvalue, double maxvalue);
+
+        unsigned int m_InputFreq;
+        unsigned int m_OutputFreq;
+        unsigned int m_NumChannels;
+
+        syAudioFilterBank* m_Bank;
+
+        /** Half the number of taps: the number of input samples that the filter looks ahead */
+        unsigned int m_Half;
+
+        /** The last input samples, one row of m_HistorySize samples per channel */
+        float* m_History;
+
+        /** The length of each row of m_History */
+        unsigned int m_HistorySize;
+
+        /** The number of samples in each row of m_History */
+        unsigned int m_Count;
+
+        /** The history sample at (or just before) the next output sample */
+        unsigned int m_Base;
+
+        /** The position of the next output sample between m_Base and m_Base + 1, in 1 / L units */
+        unsigned int m_Phase;
+};
+
+syAudioResampler::Data::Data() :
+m_InputFreq(0),
+m_OutputFreq(0),
+m_NumChannels(0),
+m_Bank(0),
+m_Half(0),
+m_History(0),
+m_HistorySize(0),
+m_Count(0),
+m_Base(0),
+m_Phase(0)
+{
+}
+
+syAudioResampler::Data::~Data() {
+    Free();
+}
+
+void syAudioResampler::Data::Free() {
+    if(m_Bank) {
+        syAudioFilterBankCache::ReleaseBank(m_Bank);
+        m_Bank = 0;
+    }
+    delete[] m_History;
+    m_History = 0;
+}
+
+unsigned int syAudioResampler::Data::Produce(int* dst, double minvalue, double maxvalue) {
+    unsigned int taps = m_Bank->m_Taps;
+    unsigned int l = m_Bank->m_L;
+    unsigned int m = m_Bank->m_M;
+    unsigned int phases = m_Bank->m_Phases;
+    float (*dot)(const float*, const float*, unsigned int) = sy_dot;
+    #ifdef SY_X86_SIMD
+    if(syRowConverter::HasSSE2()) {
+        dot = sy_dot_sse2;
+    }
+    #endif
+    unsigned int produced = 0;
+    while(m_Base + m_Half < m_Count) {
+        unsigned int phase = m_Phase;
+        if(phases != l) {
+            // Use the phase just before the output sample.
+            phase = (unsigned int)(((unsigned long long)m_Phase * phases) / l);
+        }
+        const float* coefs = m_Bank->m_Coefs + phase * taps;
+        const float* history = m_History + m_Base + 1 - m_Half;
+        for(unsigned int ch = 0; ch < m_NumChannels; ++ch, history += m_HistorySize) {
+            double value = dot(coefs, history, taps);
+            if(value < minvalue) { value = minvalue; }
+            if(value > maxvalue) { value = maxvalue; }
+            *dst++ = (int)floor(value + 0.5);
+        }
+        ++produced;
+        m_Phase += m;
+        m_Base += m_Phase / l;
+        m_Phase %= l;
+    }
+    return produced;
+}
+
+syAudioResampler::syAudioResampler() {
+    m_Data = new Data;
+}
+
+syAudioResampler::~syAudioResampler() {
+    delete m_Data;
+}
+
+bool syAudioResampler::Init(unsigned int inputfreq, unsigned int outputfreq, unsigned int numchannels) {
+    m_Data->Free();
+    if(!inputfreq || !outputfreq || !numchannels) {
+        return false;
+    }
+    unsigned int a = inputfreq, b = outputfreq;
+    while(b) {
+        unsigned int t = a % b;
+        a = b;
+        b = t;
+    }
+    m_Data->m_InputFreq = inputfreq;
+    m_Data->m_OutputFreq = outputfreq;
+    m_Data->m_NumChannels = numchannels;
+    m_Data->m_Bank = syAudioFilterBankCache::GetBank(outputfreq / a, inputfreq / a);
+    m_Data->m_Half = m_Data->m_Bank->m_Taps / 2;
+    m_Data->m_HistorySize = m_Data->m_Bank->m_Taps + Data::ChunkSize;
+    m_Data->m_History = new float[m_Data->m_HistorySize * numchannels];
+    Reset();
+    return true;
+}
+
+bool syAudioResampler::IsOk() const {
+    return (m_Data->m_Bank != 0);
+}
+
+void syAudioResampler::Reset() {
+    if(!IsOk()) {
+        return;
+    }
+    // The first output sample is centered on the first input sample; the samples before it are silence.
+    m_Data->m_Count = m_Data->m_Half - 1;
+    m_Data->m_Base = m_Data->m_Half - 1;
+    m_Data->m_Phase = 0;
+    for(unsigned int ch = 0; ch < m_Data->m_NumChannels; ++ch) {
+        memset(m_Data->m_History + ch * m_Data->m_HistorySize, 0, m_Data->m_Count * sizeof(float));
+    }
+}
+
+unsigned int syAudioResampler::GetInputFrequency() const {
+    return m_Data->m_InputFreq;
+}
+
+unsigned int syAudioResampler::GetOutputFrequency() const {
+    return m_Data->m_OutputFreq;
+}
+
+unsigned int syAudioResampler::GetNumChannels() const {
+    return m_Data->m_NumChannels;
+}
+
+unsigned int syAudioResampler::GetLatency() const {
+    return m_Data->m_Half;
+}
+
+unsigned int syAudioResampler::GetOutputCount(unsigned int count) const {
+    if(!IsOk()) {
+        return 0;
+    }
+    // Output sample k can be calculated once the input reaches m_Base + (m_Phase + k*M) / L + m_Half.
+    long long lastbase = (long long)m_Data->m_Count + count - m_Data->m_Half - 1 - m_Data->m_Base;
+    if(lastbase < 0) {
+        return 0;
+    }
+    unsigned long long l = m_Data->m_Bank->m_L, m = m_Data->m_Bank->m_M;
+    return (unsigned int)(((lastbase + 1) * l - m_Data->m_Phase + m - 1) / m);
+}
+
+unsigned int syAudioResampler::GetInputCount(unsigned int maxoutput) const {
+    if(!IsOk()) {
+        return 0;
+    }
+    // Output sample number maxoutput must not be calculated yet.
+    unsigned long long l = m_Data->m_Bank->m_L, m = m_Data->m_Bank->m_M;
+    unsigned long long limit = m_Data->m_Base + (m_Data->m_Phase + maxoutput * m) / l + m_Data->m_Half;
+    if(limit <= m_Data->m_Count) {
+        return 0;
+    }
+    limit -= m_Data->m_Count;
+    return (limit > 0xffffffffULL) ? 0xffffffffU : (unsigned int)limit;
+}
+
+unsigned int syAudioResampler::Process(const int* src, unsigned int count, int* dst, unsigned int precision) {
+    if(!IsOk()) {
+        return 0;
+    }
+    if(precision < 1) { precision = 1; }
+    if(precision > 32) { precision = 32; }
+    double maxvalue = ldexp(1.0, precision - 1) - 1.0;
+    double minvalue = -maxvalue - 1.0;
+    unsigned int numchannels = m_Data->m_NumChannels;
+    unsigned int rowsize = m_Data->m_HistorySize;
+    unsigned int produced = 0;
+    while(count) {
+        // Append the next chunk of input to the history, one row per channel.
+        unsigned int n = rowsize - m_Data->m_Count;
+        if(n > count) { n = count; }
+        for(unsigned int ch = 0; ch < numchannels; ++ch) {
+            float* row = m_Data->m_History + ch * rowsize + m_Data->m_Count;
+            const int* p = src + ch;
+            for(unsigned int i = 0; i < n; ++i, p += numchannels) {
+                row[i] = (float)*p;
+            }
+        }
+        m_Data->m_Count += n;
+        src += n * numchannels;
+        count -= n;
+
+        unsigned int outputs = m_Data->Produce(dst, minvalue, maxvalue);
+        dst += outputs * numchannels;
+        produced += outputs;
+
+        // Drop the samples that no output sample will use anymore.
+        unsigned int drop = m_Data->m_Base + 1 - m_Data->m_Half;
+        if(drop > m_Data->m_Count) {
+            drop = m_Data->m_Count;
+        }
+        if(drop) {
+            for(unsigned int ch = 0; ch < numchannels; ++ch) {
+                float* row = m_Data->m_History + ch * rowsize;
+                memmove(row, row + drop, (m_Data->m_Count - drop) * sizeof(float));
+            }
+            m_Data->m_Count -= drop;
+            m_Data->m_Base -= drop;
+        }
+    }
+    return produced;
+}
+
+void syAudioResampler::ClearCache() {
+    syAudioFilterBankCache& cache = syAudioFilterBankCache::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    for(unsigned int i = 0; i < syAudioFilterBankCache::Capacity; ++i) {
+        if(cache.m_Items[i]) {
+            syAudioFilterBankCache::Unref(cache.m_Items[i]);
+            cache.m_Items[i] = 0;
+        }
+    }
+}
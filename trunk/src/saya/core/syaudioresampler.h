@@ -0,0 +1,105 @@
+/***************************************************************
+ * Name:      syaudioresampler.h
+ * Purpose:   Declaration for the syAudioResampler class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syAudioResampler converts a stream of audio samples
+ *            from one sample rate to another with a polyphase
+ *            windowed-sinc filter, so that clips at different
+ *            sample rates can be played together in real time.
+ **************************************************************/
+
+#ifndef syaudioresampler_h
+#define syaudioresampler_h
+
+/** @brief Band-limited sample rate converter for interleaved integer audio.
+ *
+ *  The ratio between the output and input frequencies is reduced to a fraction L / M. Each output sample
+ *  is the dot product of a window of input samples and one of L precomputed phases of a Kaiser-windowed
+ *  sinc filter, whose cutoff is just below the lower of both Nyquist frequencies. The filter banks are
+ *  cached and shared, so that the usual ratios (44.1 <-> 48 kHz, 48 <-> 96 kHz) are only calculated once.
+ *
+ *  The resampler keeps the last input samples between calls to Process(), so a stream can be fed in blocks
+ *  of any size. The filter looks ahead GetLatency() input samples, which are held back until more input
+ *  arrives.
+ *
+ *  @note The filter works in single-precision floating point; 32-bit samples are resampled with 24 bits
+ *  of precision.
+ */
+class syAudioResampler {
+    public:
+
+        /** Number of filter taps per phase when the ratio is 1:1 or higher. Downsampling needs more. */
+        static const unsigned int BaseTaps = 64;
+
+        /** Maximum number of filter taps per phase */
+        static const unsigned int MaxTaps = 1024;
+
+        /** @brief Maximum number of filter phases.
+         *  Ratios with a larger L (i.e. 44100 -> 44101) use the closest preceding one of MaxPhases evenly spaced phases.
+         */
+        static const unsigned int MaxPhases = 4096;
+
+        /** Standard constructor. The resampler must be set up with Init() before use. */
+        syAudioResampler();
+
+        /** Standard destructor. */
+        ~syAudioResampler();
+
+        /** @brief Sets up the resampler and clears its history.
+         *  @param inputfreq The input sample frequency, in Hz.
+         *  @param outputfreq The output sample frequency, in Hz.
+         *  @param numchannels The number of interleaved channels.
+         *  @return false if any of the parameters is 0.
+         */
+        bool Init(unsigned int inputfreq, unsigned int outputfreq, unsigned int numchannels);
+
+        /** Returns true if Init() succeeded. */
+        bool IsOk() const;
+
+        /** Clears the history, as if the stream started again. Call it after a seek. */
+        void Reset();
+
+        /** Gets the input frequency, in Hz. */
+        unsigned int GetInputFrequency() const;
+
+        /** Gets the output frequency, in Hz. */
+        unsigned int GetOutputFrequency() const;
+
+        /** Gets the number of channels. */
+        unsigned int GetNumChannels() const;
+
+        /** Gets the number of input samples that the filter looks ahead. */
+        unsigned int GetLatency() const;
+
+        /** @brief Gets the number of output samples that Process() will produce for the given number of input samples.
+         *  The result is exact; it depends on the samples already fed.
+         */
+        unsigned int GetOutputCount(unsigned int count) const;
+
+        /** @brief Gets the largest number of input samples that can be processed without producing more
+         *  than maxoutput output samples.
+         */
+        unsigned int GetInputCount(unsigned int maxoutput) const;
+
+        /** @brief Resamples a block of samples.
+         *  @param src The input samples, count * GetNumChannels() interleaved integers.
+         *  @param count The number of input samples.
+         *  @param dst The output samples. Must have room for GetOutputCount(count) * GetNumChannels() integers.
+         *  @param precision The sample precision, in bits (1 to 32). The output is clamped to its range.
+         *  @return The number of output samples written to dst.
+         */
+        unsigned int Process(const int* src, unsigned int count, int* dst, unsigned int precision);
+
+        /** Removes all the unused filter banks from the cache. */
+        static void ClearCache();
+
+    private:
+        class Data;
+        friend class Data;
+        Data* m_Data;
+};
+
+#endif
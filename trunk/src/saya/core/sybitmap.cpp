@@ -18,19 +18,45 @@
 #include "iocommon.h"
 #include "aborter.h"
 #include "sythread.h"
+#include "atomic.h"
 #include "sybitmap.h"
 #include "sybitmapcopier.h"
+#include "sybitmapview.h"
+#include "syrowconverter.h"
+#include "syworkerpool.h"
+#include "sybitmappool.h"
 #include "codecplugin.h"
 #include "sentryfuncs.h"
 #include "debuglog.h"
 #include "base64.h"
 #include <math.h>
 #include <cstddef>
+#include <cstring>
+
+/** The geometry for which PasteFrom calculated its scaling tables. @see syBitmap::Data::m_ScalingKey */
+struct syScalingKey {
+    unsigned int m_SourceWidth;
+    unsigned int m_SourceHeight;
+    unsigned int m_SourceRowLength;
+    unsigned int m_SourceBypp;
+    unsigned int m_Width;
+    unsigned int m_Height;
+    syStretchMode m_StretchMode;
+    bool m_Bilinear;
+
+    bool operator==(const syScalingKey& other) const {
+        return m_SourceWidth == other.m_SourceWidth && m_SourceHeight == other.m_SourceHeight &&
+            m_SourceRowLength == other.m_SourceRowLength && m_SourceBypp == other.m_SourceBypp &&
+            m_Width == other.m_Width && m_Height == other.m_Height &&
+            m_StretchMode == other.m_StretchMode && m_Bilinear == other.m_Bilinear;
+    }
+};
 
 class syBitmap::Data {
 
     public:
         Data();
+        ~Data();
 
         /** Width in pixels */
         unsigned int m_Width;
@@ -50,6 +76,13 @@ class syBitmap::Data {
         /** Length in bytes of the whole buffer */
         unsigned long m_BufferSize;
 
+        /** @brief Number of bitmaps sharing m_Buffer; NULL if there's no buffer.
+         *
+         *  CopyFrom() shares the buffer instead of copying it. The first bitmap that writes into
+         *  a shared buffer gets its own copy (see Unshare).
+         */
+        unsigned long* m_RefCount;
+
         /** Bytes per pixel of the current color format */
         unsigned int m_bypp;
 
@@ -66,6 +99,9 @@ class syBitmap::Data {
         /** Length in bytes of each row */
         int m_RowSize;
 
+        /** The matrix used to convert the YUV pixels from / to RGB */
+        syColorMatrix m_ColorMatrix;
+
         /** @brief Placeholder for an syAborter object.
           *
           * @see syBitmap::MustAbort
@@ -74,21 +110,63 @@ class syBitmap::Data {
 
         /** @brief For use by PasteFrom when scaling bitmaps.
          *
-         *  Contains the source bitmap's y offsets (in bytes) corresponding to our nth row.
+         *  Contains the source bitmap's y offsets (in bytes) corresponding to our nth row,
+         *  Rows outside the source get offsets outside the source buffer (-1, for bilinear scaling).
          */
         mutable int* m_YOffsets;
 
         /** @brief For use by PasteFrom when scaling bitmaps.
          *
          *  Contains the source bitmap's x offsets (in bytes) corresponding to our nth column.
+         *  For bilinear scaling, it contains the source column itself.
          */
         mutable int* m_XOffsets;
 
+        /** For bilinear scaling: Weight (0 to 256) of the row after the one given by m_YOffsets. */
+        mutable int* m_YWeights;
+
+        /** For bilinear scaling: Weight (0 to 256) of the column after the one given by m_XOffsets. */
+        mutable int* m_XWeights;
+
         /** Contains the current size used by m_YOffsets */
         mutable unsigned long m_YOffsetsSize;
 
         /** Contains the current size used by m_XOffsets */
         mutable unsigned long m_XOffsetsSize;
+
+        /** @brief The geometry for which the scaling tables above were calculated.
+         *
+         *  During playback the source and destination sizes almost never change, so PasteFrom only
+         *  recalculates the tables when the key changes. Only valid if m_ScalingKeyValid is true.
+         */
+        syScalingKey m_ScalingKey;
+
+        /** False if the scaling tables must be recalculated. */
+        bool m_ScalingKeyValid;
+
+        /** First destination column inside the source, for the current scaling tables */
+        unsigned int m_ScaledX0;
+
+        /** Destination column after the last one inside the source, for the current scaling tables */
+        unsigned int m_ScaledX1;
+
+        /** Drops our reference to the buffer, releasing it if we were the last user. */
+        void FreeBuffer();
+
+        /** Replaces the buffer with a new one of (at least) size bytes. @return false if there's not enough memory. */
+        bool AllocBuffer(unsigned long size);
+
+        /** Returns true if other bitmaps share our buffer. */
+        bool IsShared() const;
+
+        /** If the buffer is shared, replaces it with a buffer of our own, copying the contents if keepcontents is true. */
+        void Unshare(bool keepcontents);
+
+        /** Shares the source's buffer. The dimensions and the color format must be copied separately. */
+        void ShareFrom(const Data* source);
+
+        /** Calculates the scaling tables used by PasteFrom for the given geometry, allocating them if necessary. */
+        void CalculateScalingTables(const syScalingKey& key);
 };
 
 syBitmap::Data::Data() :
@@ -98,19 +176,249 @@ syBitmap::Data::Data() :
     m_Buffer(NULL),
     m_BufferLength(0),
     m_BufferSize(0),
+    m_RefCount(NULL),
     m_bypp(4),
     m_Depth(0),
     m_RMask(0),
     m_GMask(0),
     m_BMask(0),
     m_RowSize(0),
+    m_ColorMatrix(sy_cmbt601),
     m_Aborter(NULL),
     m_YOffsets(NULL),
     m_XOffsets(NULL),
+    m_YWeights(NULL),
+    m_XWeights(NULL),
     m_YOffsetsSize(0),
-    m_XOffsetsSize(0)
+    m_XOffsetsSize(0),
+    m_ScalingKeyValid(false),
+    m_ScaledX0(0),
+    m_ScaledX1(0)
 {}
 
+syBitmap::Data::~Data() {
+    delete[] m_XOffsets;
+    delete[] m_YOffsets;
+    delete[] m_XWeights;
+    delete[] m_YWeights;
+}
+
+void syBitmap::Data::FreeBuffer() {
+    if(m_Buffer) {
+        // Whoever drops the last reference gives the buffer back to the pool.
+        if(syAtomic::fetch_and_sub1(m_RefCount) == 1) {
+            syBitmapPool::Release(m_Buffer, m_BufferSize);
+            delete m_RefCount;
+        }
+    }
+    m_Buffer = NULL;
+    m_RefCount = NULL;
+    m_BufferSize = 0;
+}
+
+bool syBitmap::Data::AllocBuffer(unsigned long size) {
+    FreeBuffer();
+    m_Buffer = syBitmapPool::Allocate(size, &m_BufferSize);
+    if(!m_Buffer) {
+        m_BufferSize = 0;
+        return false;
+    }
+    m_RefCount = new unsigned long(1);
+    return true;
+}
+
+bool syBitmap::Data::IsShared() const {
+    return m_RefCount && *(volatile unsigned long*)m_RefCount > 1;
+}
+
+void syBitmap::Data::Unshare(bool keepcontents) {
+    if(!IsShared()) {
+        return;
+    }
+    unsigned long size = 0;
+    unsigned char* buffer = syBitmapPool::Allocate(m_BufferSize, &size);
+    if(!buffer) {
+        return;
+    }
+    if(keepcontents) {
+        memcpy(buffer, m_Buffer, m_BufferLength);
+    }
+    FreeBuffer();
+    m_Buffer = buffer;
+    m_BufferSize = size;
+    m_RefCount = new unsigned long(1);
+}
+
+void syBitmap::Data::ShareFrom(const Data* source) {
+    if(source->m_Buffer == m_Buffer) {
+        return;
+    }
+    FreeBuffer();
+    if(!source->m_Buffer) {
+        return;
+    }
+    syAtomic::fetch_and_add1(source->m_RefCount);
+    m_Buffer = source->m_Buffer;
+    m_BufferSize = source->m_BufferSize;
+    m_RefCount = source->m_RefCount;
+}
+
+/** @brief Calculates a source position for bilinear scaling.
+ *  @param pos The source position, in pixels, where pixel centers lie on integer positions.
+ *  @param length The source width (or height).
+ *  @param index Receives the source pixel to the left of (or above) the position.
+ *  @param weight Receives the weight (0 to 256) of the next pixel.
+ */
+static void sy_bilinear_position(double pos, unsigned int length, int& index, int& weight) {
+    index = int(floor(pos));
+    weight = int((pos - index)*256.0 + 0.5);
+    if(weight >= 256) {
+        ++index;
+        weight = 0;
+    }
+    if(index < 0) {
+        index = 0;
+        weight = 0;
+    } else if(index >= (int)length - 1) {
+        index = length - 1;
+        weight = 0;
+    }
+}
+
+void syBitmap::Data::CalculateScalingTables(const syScalingKey& key) {
+    double xscale, yscale, xoffset, yoffset, tmpx, tmpy;
+    int x, y;
+    unsigned int srcw = key.m_SourceWidth;
+    unsigned int srch = key.m_SourceHeight;
+    unsigned int width = key.m_Width;
+    unsigned int height = key.m_Height;
+
+    if(height > m_YOffsetsSize) {
+        delete[] m_YOffsets;
+        delete[] m_YWeights;
+        m_YOffsets = new int[height];
+        m_YWeights = new int[height];
+        m_YOffsetsSize = height;
+    }
+    if(width > m_XOffsetsSize) {
+        delete[] m_XOffsets;
+        delete[] m_XWeights;
+        m_XOffsets = new int[width];
+        m_XWeights = new int[width];
+        m_XOffsetsSize = width;
+    }
+
+    // xscale, yscale, xoffset and yoffset are calculated according to the following formula:
+    // srcx = (x * xscale) + xoffset // This formula is applied in the loop at the bottom
+    // Ignoring the offset, we have:
+    //      srcx = x * xscale;
+    // Therefore,
+    //      xscale = srcx / x;
+    // If x = width, then:
+    //      xscale = srcw / width.
+    //
+    // Now, if we want to make the centers fit together, then we have the following condition:
+    //      srcx = srcw/2, and x = width/2.
+    // Applying it to srcx = (x * xscale) + xoffset, we have:
+    //      srcw/2 = (width/2 * xscale) + xoffset
+    //      xoffset = srcw/2 - (width/2 * xscale).
+    // By Getting the 1/2 out, we have:
+    //      xoffset = (srcw - width*xscale)/2
+    // And so, we end up with the following formulas:
+    //
+    // -----------------------------------------
+    // xscale = srcw / width;
+    // yscale = srch / height;
+    // xoffset = (srcw - (width*xscale)) / 2;
+    // yoffset = (srch - (height*yscale)) / 2;
+    // -----------------------------------------
+
+    switch(key.m_StretchMode) {
+        case sy_stcopy: // Just center the bitmap
+        xscale = 1.0;
+        yscale = 1.0;
+        xoffset = ((double)srcw - width) / 2;
+        yoffset = ((double)srch - height) / 2;
+        break;
+
+        case sy_stkeepaspectratio: // Scale without distorting
+        default: // Resize to fit
+        xscale = ((double)srcw) / width;
+        yscale = ((double)srch) / height;
+
+        if(key.m_StretchMode == sy_stkeepaspectratio) {
+            if(yscale >= xscale) { // Pick the greatest scale so that everything fits inside
+                xscale = yscale;
+            } else {
+                yscale = xscale;
+            }
+        }
+        xoffset = ((double)srcw - (double)(width*xscale)) / 2;
+        yoffset = ((double)srch - (double)(height*yscale)) / 2;
+    }
+
+    if(!key.m_Bilinear) {
+        // Now, we implement the formula srcx = (x * xscale) + xoffset into a for loop
+        // But instead of just calculating x and y, we calculate the byte offsets, too!
+        for(y = 0, tmpy = yoffset; y < (int)height; ++y, tmpy += yscale) {
+            m_YOffsets[y] = key.m_SourceRowLength*int(floor(tmpy));
+        }
+        for(x = 0, tmpx = xoffset; x < (int)width; ++x, tmpx += xscale) {
+            m_XOffsets[x] = key.m_SourceBypp*int(floor(tmpx));
+        }
+
+        // Since the offsets always increase, the columns falling outside the source row
+        // form a left and a right margin. Everything in between is copied a row at a time.
+        // Note that rows may have padding, so we can't use the row length as the limit.
+        unsigned int x0 = 0, x1 = width;
+        unsigned int srcrowend = srcw*key.m_SourceBypp;
+        while(x0 < x1 && m_XOffsets[x0] < 0) {
+            ++x0;
+        }
+        while(x1 > x0 && (unsigned int)m_XOffsets[x1 - 1] >= srcrowend) {
+            --x1;
+        }
+        m_ScaledX0 = x0;
+        m_ScaledX1 = x1;
+    } else {
+        // For bilinear scaling we sample at the pixel centers, so the formula becomes
+        // srcx + 0.5 = ((x + 0.5) * xscale) + xoffset. Pixels whose nearest source pixel
+        // falls outside the source form the margins, just like above.
+        int index, weight;
+        for(y = 0; y < (int)height; ++y) {
+            tmpy = (y + 0.5)*yscale + yoffset - 0.5;
+            int nearest = int(floor(tmpy + 0.5));
+            if(nearest < 0 || nearest >= (int)srch) {
+                m_YOffsets[y] = -1;
+                m_YWeights[y] = 0;
+                continue;
+            }
+            sy_bilinear_position(tmpy, srch, index, weight);
+            m_YOffsets[y] = key.m_SourceRowLength*index;
+            m_YWeights[y] = weight;
+        }
+        m_ScaledX0 = m_ScaledX1 = width;
+        for(x = 0; x < (int)width; ++x) {
+            tmpx = (x + 0.5)*xscale + xoffset - 0.5;
+            int nearest = int(floor(tmpx + 0.5));
+            if(nearest < 0 || nearest >= (int)srcw) {
+                m_XOffsets[x] = 0;
+                m_XWeights[x] = 0;
+                continue;
+            }
+            if(m_ScaledX0 == width) {
+                m_ScaledX0 = x;
+            }
+            m_ScaledX1 = x + 1;
+            sy_bilinear_position(tmpx, srcw, index, weight);
+            m_XOffsets[x] = index;
+            m_XWeights[x] = weight;
+        }
+    }
+    m_ScalingKey = key;
+    m_ScalingKeyValid = true;
+}
+
 syBitmap::syBitmap() :
 m_Mutex(new sySafeMutex(true)),
 m_Data(new Data)
@@ -125,8 +433,7 @@ m_Data(new Data)
 }
 
 syBitmap::~syBitmap() {
-    delete[] m_Data->m_XOffsets;
-    delete[] m_Data->m_YOffsets;
+    m_Data->FreeBuffer();
     delete m_Mutex;
     delete m_Data;
 }
@@ -136,11 +443,18 @@ void syBitmap::Create(unsigned int width,unsigned int height,VideoColorFormat co
 }
 
 void syBitmap::Realloc(unsigned int newwidth,unsigned int newheight,VideoColorFormat newformat) {
+    Realloc(newwidth, newheight, newformat, false);
+}
+
+void syBitmap::Realloc(unsigned int newwidth,unsigned int newheight,VideoColorFormat newformat, bool keepshared) {
     if(!newwidth || !newheight) {
         return;
     }
     unsigned int bypp = syBitmap::CalculateBytesperPixel(newformat);
     unsigned int rowlen = bypp * newwidth;
+    if(newformat == vcfYUY2 || newformat == vcfUYVY || newformat == vcfYVYU) {
+        rowlen = ((newwidth + 1) & ~1) * 2; // 4:2:2 formats store pixels in pairs.
+    }
 
     if(rowlen & 1 || rowlen < 2) {
         rowlen = (rowlen + 2) & ~1; // Round up the row size to 2 bytes.
@@ -152,44 +466,26 @@ void syBitmap::Realloc(unsigned int newwidth,unsigned int newheight,VideoColorFo
         }
     }
     unsigned int newsize = rowlen * newheight;
+    if(IsPlanarFormat(newformat)) {
+        // Luma plane followed by two chroma planes of half the width and half the height.
+        newsize += 2 * (rowlen / 2) * ((newheight + 1) / 2);
+    }
     if(newsize & 3 || newsize < 4) {
         newsize = (newsize + 4) & ~3; // Round up the buffer size to 4 bytes.
     }
 
-    if(newsize > m_Data->m_BufferSize) {
-
-        if(m_Data->m_Buffer != NULL) {
-            delete[] m_Data->m_Buffer;
-            m_Data->m_Buffer = NULL;
-        }
-        m_Data->m_Buffer = new unsigned char[newsize];
-        m_Data->m_BufferSize = newsize;
-    }
-
-    if(newheight > m_Data->m_YOffsetsSize) {
-        if(m_Data->m_YOffsets != NULL) {
-            delete[] m_Data->m_YOffsets;
-            m_Data->m_YOffsets = NULL;
-        }
-        m_Data->m_YOffsets = new int[newheight];
-        m_Data->m_YOffsetsSize = newheight;
+    if(newsize > m_Data->m_BufferSize || (!keepshared && m_Data->IsShared())) {
+        // The buffers are recycled through syBitmapPool, which may give us a bigger buffer than we asked for.
+        // Since the contents are lost anyway, a shared buffer is simply replaced.
+        m_Data->AllocBuffer(newsize);
     }
 
-    if(newwidth > m_Data->m_XOffsetsSize) {
-        if(m_Data->m_XOffsets != NULL) {
-            delete[] m_Data->m_XOffsets;
-            m_Data->m_XOffsets = NULL;
-        }
-        m_Data->m_XOffsets = new int[newwidth];
-        m_Data->m_XOffsetsSize = newwidth;
-    }
-
-    m_Data->m_BufferLength = newsize;
+    m_Data->m_BufferLength = m_Data->m_Buffer ? newsize : 0;
     m_Data->m_ColorFormat = newformat;
     m_Data->m_bypp = CalculateBytesperPixel(newformat);
     m_Data->m_Width = newwidth;
     m_Data->m_Height = newheight;
-    m_Data->m_RowSize = newwidth*m_Data->m_bypp;
+    m_Data->m_RowSize = IsYUVFormat(newformat) ? rowlen : newwidth*m_Data->m_bypp;
     int depth;
     switch(newformat) {
         case vcfRGB8:
@@ -210,6 +506,18 @@ void syBitmap::Realloc(unsigned int newwidth,unsigned int newheight,VideoColorFo
             m_Data->m_GMask = 0x0000ff00;
             m_Data->m_BMask = 0x000000ff;
             break;
+        case vcfRGBA32:
+            depth = 32;
+            m_Data->m_RMask = 0x000000ff;
+            m_Data->m_GMask = 0x0000ff00;
+            m_Data->m_BMask = 0x00ff0000;
+            break;
+        case vcfBGRA32:
+            depth = 32;
+            m_Data->m_RMask = 0x00ff0000;
+            m_Data->m_GMask = 0x0000ff00;
+            m_Data->m_BMask = 0x000000ff;
+            break;
         case vcfRGB24:
         case vcfRGB24_Line32:
             depth = 24;
@@ -248,14 +556,7 @@ void syBitmap::Realloc(unsigned int newwidth,unsigned int newheight,VideoColorFo
             m_Data->m_GMask = 0x000003e0;
             m_Data->m_BMask = 0x0000001f;
             break;
-        case vcfYUY2:
-            depth = 8;
-            break;
         case vcfYV12:
-            depth = 12;
-            m_Data->m_RMask = 0;
-            m_Data->m_GMask = 0;
-            m_Data->m_BMask = 0;
         case vcfYUV12:
             depth = 12;
             m_Data->m_RMask = 0;
@@ -263,8 +564,9 @@ void syBitmap::Realloc(unsigned int newwidth,unsigned int newheight,VideoColorFo
             m_Data->m_BMask = 0;
             break;
         case vcfYUV:
-        case vcfYVYU: // Not sure about these two, but since we're only using Depth() for X11
-        case vcfUYVY: // and these formats aren't supported, it doesn't matter.
+        case vcfYUY2: // Not sure about these, but since we're only using Depth() for X11
+        case vcfYVYU: // and these formats aren't supported, it doesn't matter.
+        case vcfUYVY:
             depth = 16;
             m_Data->m_RMask = 0;
             m_Data->m_GMask = 0;
@@ -286,7 +588,9 @@ void syBitmap::Realloc(unsigned int newwidth,unsigned int newheight,VideoColorFo
             ;
     }
     m_Data->m_Depth = depth;
-    Clear();
+    if(!keepshared) {
+        Clear();
+    }
 }
 
 bool syBitmap::ReleaseBuffer(bool force) {
@@ -294,16 +598,15 @@ bool syBitmap::ReleaseBuffer(bool force) {
      bool isLockedNow = lock.IsLocked();
      bool result = isLockedNow;
      if(isLockedNow || force) {
-         delete[] m_Data->m_Buffer;
-         m_Data->m_Buffer = NULL;
+         m_Data->FreeBuffer();
          m_Data->m_BufferLength = 0;
-         m_Data->m_BufferSize = 0;
          result = true;
     }
     return result;
 }
 
 unsigned char* syBitmap::GetBuffer() {
+    m_Data->Unshare(true);
     return m_Data->m_Buffer;
 }
 
@@ -401,14 +704,16 @@ unsigned int syBitmap::CalculateBytesperPixel(VideoColorFormat format) {
             result = 3;
             break;
         case vcfBGR32:
+        case vcfRGBA32:
+        case vcfBGRA32:
             result = 4;
             break;
-        case vcfYUY2:
-            result = 2;
-            break;
-        case vcfYUV:
         case vcfYV12:
         case vcfYUV12:
+            result = 1; // Only the luma plane; the chroma planes are stored separately.
+            break;
+        case vcfYUY2:
+        case vcfYUV:
         case vcfYVYU:
         case vcfUYVY:
         case vcfYUY9:
@@ -420,26 +725,52 @@ unsigned int syBitmap::CalculateBytesperPixel(VideoColorFormat format) {
     return result;
 }
 
+bool syBitmap::IsYUVFormat(VideoColorFormat format) {
+    switch(format) {
+        case vcfYUY2:
+        case vcfUYVY:
+        case vcfYVYU:
+        case vcfYV12:
+        case vcfYUV12:
+        case vcfY800:
+            return true;
+        default:
+            ;
+    }
+    return false;
+}
+
+bool syBitmap::IsPlanarFormat(VideoColorFormat format) {
+    return (format == vcfYV12 || format == vcfYUV12);
+}
+
+bool syBitmap::IsAlphaFormat(VideoColorFormat format) {
+    return (format == vcfRGBA32 || format == vcfBGRA32);
+}
+
 void syBitmap::CopyFrom(const unsigned char* source, unsigned int width, unsigned int height, VideoColorFormat colorformat, unsigned long maxlength) {
     if(!source) {
         return;
     }
-    Realloc(width,height,colorformat);
-
-    const unsigned long* src = (const unsigned long*)source;
-    unsigned long* dst = (unsigned long*)(m_Data->m_Buffer);
-
-    // Copy the data in 4-byte chunks
-    for(unsigned int i = maxlength >> 2; i; --i, ++src, ++dst) {
-        if((i & 8192) == 0 && MustAbort()) { break; } // Check for abort every 32K
-        *dst = *src;
+    if(width != m_Data->m_Width || height != m_Data->m_Height || colorformat != m_Data->m_ColorFormat || !m_Data->m_Buffer) {
+        Realloc(width,height,colorformat);
     }
-
-    // Copy the remaining 3 bytes
-    unsigned int i = maxlength;
-    i = (i > 3) ? (i - 3) : 0;
-    for(; i < maxlength; ++i) {
-        m_Data->m_Buffer[i] = source[i];
+    if(maxlength > m_Data->m_BufferLength) {
+        maxlength = m_Data->m_BufferLength;
+    }
+    m_Data->Unshare(maxlength < m_Data->m_BufferLength);
+
+    // Copy the data in 256K chunks, checking for abort between them
+    const unsigned long chunksize = 262144;
+    unsigned long offset = 0;
+    while(offset < maxlength) {
+        if(offset && MustAbort()) { break; }
+        unsigned long len = maxlength - offset;
+        if(len > chunksize) {
+            len = chunksize;
+        }
+        memcpy(m_Data->m_Buffer + offset, source + offset, len);
+        offset += len;
     }
 }
 
@@ -447,176 +778,313 @@ void syBitmap::CopyFrom(const syBitmap* source) {
     if(!source) {
         return;
     }
-    Realloc(source->GetWidth(),source->GetHeight(),source->GetColorFormat());
     const unsigned char* original_buffer = source->GetReadOnlyBuffer();
+    m_Data->m_ColorMatrix = source->GetColorMatrix();
     if(!original_buffer) {
+        Realloc(source->GetWidth(),source->GetHeight(),source->GetColorFormat());
+        return;
+    }
+    if(source == this) {
         return;
     }
-    CopyFrom(original_buffer, source->GetWidth(),source->GetHeight(),source->GetColorFormat(),source->GetBufferLength());
+
+    // Instead of copying the pixels, we share the source's buffer. Whichever bitmap writes first gets its own copy.
+    m_Data->ShareFrom(source->m_Data);
+    Realloc(source->GetWidth(),source->GetHeight(),source->GetColorFormat(), true);
 }
 
+// ---------------------------------
+// Begin band tasks for syWorkerPool
+// ---------------------------------
+
+/** Base class for the band tasks. The tasks abort when the destination bitmap must abort. */
+class syBitmapBandTask : public syBandTask {
+    public:
+        syBitmapBandTask(syBitmap* bitmap, syBitmapCopier* copier) : m_Bitmap(bitmap), m_Copier(copier) {}
+
+    protected:
+        virtual bool InternalMustAbort() { return m_Bitmap && m_Bitmap->MustAbort(); }
+
+        syBitmap* m_Bitmap;
+        syBitmapCopier* m_Copier;
+};
+
+/** First pass of ResampleFrom: Resamples the source rows horizontally. */
+class syResampleRowsTask : public syBitmapBandTask {
+    public:
+        syResampleRowsTask(syBitmap* bitmap, syBitmapCopier* copier) : syBitmapBandTask(bitmap, copier) {}
+        virtual void ProcessBand(unsigned int first, unsigned int last, unsigned int slot) {
+            for(unsigned int y = first; y < last; ++y) {
+                m_Copier->ResampleRow(y, slot);
+            }
+        }
+};
+
+/** Second pass of ResampleFrom: Resamples the destination rows vertically. */
+class syResampleDestRowsTask : public syBitmapBandTask {
+    public:
+        syResampleDestRowsTask(syBitmap* bitmap, syBitmapCopier* copier) : syBitmapBandTask(bitmap, copier) {}
+        virtual void ProcessBand(unsigned int first, unsigned int last, unsigned int slot) {
+            for(unsigned int y = first; y < last; ++y) {
+                m_Copier->ResampleDestRow(y, slot);
+            }
+        }
+};
+
+/** PasteFrom with the same dimensions: Converts the rows. */
+class syCopyRowsTask : public syBitmapBandTask {
+    public:
+        syCopyRowsTask(syBitmap* bitmap, syBitmapCopier* copier) : syBitmapBandTask(bitmap, copier) {}
+        virtual void ProcessBand(unsigned int first, unsigned int last, unsigned int slot) {
+            for(unsigned int y = first; y < last; ++y) {
+                m_Copier->CopyRow(m_Copier->m_Src + y*m_Copier->m_SourceRowLength, m_Copier->m_Dst + y*m_Copier->m_DestRowLength);
+            }
+        }
+};
+
+/** PasteFrom with different dimensions: Picks the nearest source pixels. */
+class syScaledRowsTask : public syBitmapBandTask {
+    public:
+        syScaledRowsTask(syBitmap* bitmap, syBitmapCopier* copier, const int* yoffsets, const int* xoffsets,
+            unsigned int x0, unsigned int x1, unsigned int srcend) :
+            syBitmapBandTask(bitmap, copier),
+            m_YOffsets(yoffsets),
+            m_XOffsets(xoffsets),
+            m_X0(x0),
+            m_X1(x1),
+            m_SourceEnd(srcend) {}
+
+        virtual void ProcessBand(unsigned int first, unsigned int last, unsigned int slot) {
+            for(unsigned int y = first; y < last; ++y) {
+                unsigned char* dst = m_Copier->m_Dst + y*m_Copier->m_DestRowLength;
+                int srcy = m_YOffsets[y];
+                if((srcy < 0) | ((unsigned int)srcy >= m_SourceEnd)) {
+                    m_Copier->ClearRow(dst);
+                } else {
+                    m_Copier->CopyScaledRow(dst, srcy, m_XOffsets, m_X0, m_X1, slot);
+                }
+            }
+        }
+
+    private:
+        const int* m_YOffsets;
+        const int* m_XOffsets;
+        unsigned int m_X0;
+        unsigned int m_X1;
+        unsigned int m_SourceEnd;
+};
+
+/** PasteFrom with bilinear filtering: Interpolates between the four nearest source pixels. */
+class syBilinearRowsTask : public syBitmapBandTask {
+    public:
+        syBilinearRowsTask(syBitmap* bitmap, syBitmapCopier* copier, const int* yoffsets, const int* yweights,
+            const int* xoffsets, const int* xweights, unsigned int x0, unsigned int x1) :
+            syBitmapBandTask(bitmap, copier),
+            m_YOffsets(yoffsets),
+            m_YWeights(yweights),
+            m_XOffsets(xoffsets),
+            m_XWeights(xweights),
+            m_X0(x0),
+            m_X1(x1) {}
+
+        virtual void ProcessBand(unsigned int first, unsigned int last, unsigned int slot) {
+            for(unsigned int y = first; y < last; ++y) {
+                unsigned char* dst = m_Copier->m_Dst + y*m_Copier->m_DestRowLength;
+                if(m_YOffsets[y] < 0) {
+                    m_Copier->ClearRow(dst);
+                } else {
+                    m_Copier->CopyBilinearRow(dst, m_YOffsets[y], m_YWeights[y], m_XOffsets, m_XWeights, m_X0, m_X1, slot);
+                }
+            }
+        }
+
+    private:
+        const int* m_YOffsets;
+        const int* m_YWeights;
+        const int* m_XOffsets;
+        const int* m_XWeights;
+        unsigned int m_X0;
+        unsigned int m_X1;
+};
+
+// -------------------------------
+// End band tasks for syWorkerPool
+// -------------------------------
+
 void syBitmap::ResampleFrom(const syBitmap* source, syFilterType resamplemode) {
     if(!source || !source->GetReadOnlyBuffer()) {
         return;
     }
+    // Trivial case: Original has exactly the same dimensions and color format
+    if(source->GetWidth() == m_Data->m_Width && source->GetHeight() == m_Data->m_Height &&
+        source->GetColorFormat() == m_Data->m_ColorFormat) {
+        CopyFrom(source);
+        return;
+    }
+    ResampleFrom(source->GetReadOnlyView(), resamplemode);
+}
+
+void syBitmap::ResampleFrom(const syBitmapView& source, syFilterType resamplemode) {
+    if(!source.IsOk() || !m_Data->m_Width || !m_Data->m_Height) {
+        return;
+    }
+    if(!syRowConverter::CanConvert(source.GetColorFormat(), m_Data->m_ColorFormat)) {
+        return; // Keep the current contents.
+    }
+    Unshare(false); // Every row will be overwritten.
+    ResampleView(source, GetView(), resamplemode);
+}
+
+void syBitmap::ResampleView(const syBitmapView& source, const syBitmapView& dest, syFilterType resamplemode) {
+    if(!source.IsOk() || !dest.IsOk() || dest.IsReadOnly()) {
+        return;
+    }
 
     do {
-        unsigned int srcw = source->GetWidth();
-        unsigned int srch = source->GetHeight();
-        VideoColorFormat srcfmt = source->GetColorFormat();
-        if(!srcw || !srch || !m_Data->m_Width || !m_Data->m_Height) {
-            break; // Invalid width/height
-        }
-        if(srcw == m_Data->m_Width && srch == m_Data->m_Height) {
-            if(srcfmt == m_Data->m_ColorFormat) {
-                CopyFrom(source);
-            } else {
-                PasteFrom(source);
-            }
+        unsigned int srcw = source.GetWidth();
+        unsigned int srch = source.GetHeight();
+        VideoColorFormat destfmt = dest.GetColorFormat();
+        if(srcw == dest.GetWidth() && srch == dest.GetHeight()) {
+            PasteView(source, dest, sy_stkeepaspectratio, filter_none);
             break; // Get out of the do-while-false construct
         }
 
-        syBitmapCopier copier;
-        copier.Init(source, this, resamplemode);
-
-        int x,y;
+        // The resampler writes one pixel at a time, which can't be done on subsampled YUV formats.
+        // In that case we resample into an RGB bitmap and convert the result.
+        if(IsYUVFormat(destfmt) && destfmt != vcfY800) {
+            syBitmap tmpbitmap(dest.GetWidth(), dest.GetHeight(), vcfRGB32);
+            if(dest.GetBitmap()) {
+                tmpbitmap.SetAborter(dest.GetBitmap()->m_Data->m_Aborter);
+            }
+            ResampleView(source, tmpbitmap.GetView(), resamplemode);
+            PasteView(tmpbitmap.GetReadOnlyView(), dest, sy_stkeepaspectratio, filter_none);
+            break;
+        }
 
-        // Pass 1: Resample all the source rows
-        for(y = 0; y < (int)(source->GetHeight()); ++y) {
-            if((y & 32) == 0 && MustAbort()) { break; } // Check for abort every 32 rows
-            copier.ResampleRow(y);
+        syBitmapCopier copier;
+        copier.Init(source, dest, resamplemode);
+        if(!copier.IsOk()) {
+            break; // The color formats can't be converted.
         }
+        copier.ReserveScratch(syWorkerPool::Get()->GetThreadCount());
 
-        // Pass 2: Resample all the destination columns
-        for(x = 0; x < (int)m_Data->m_Width; ++x) {
-            if((x & 32) == 0 && MustAbort()) { break; } // Check for abort every 32 columns
-            copier.ResampleCol(x);
+        // Both passes are split into bands of rows for the worker pool, which checks for abort between bands.
+        // Pass 1: Resample all the source rows horizontally
+        syResampleRowsTask pass1(dest.GetBitmap(), &copier);
+        if(!syWorkerPool::Get()->Run(&pass1, srch)) {
+            break;
         }
 
+        // Pass 2: Resample all the destination rows vertically
+        syResampleDestRowsTask pass2(dest.GetBitmap(), &copier);
+        syWorkerPool::Get()->Run(&pass2, dest.GetHeight());
+
     }while(false);
 
 }
 
-void syBitmap::PasteFrom(const syBitmap* source,syStretchMode stretchmode) {
+void syBitmap::PasteFrom(const syBitmap* source,syStretchMode stretchmode,syFilterType filtertype) {
     if(!source || !source->GetReadOnlyBuffer()) {
         return;
     }
+    // Trivial case: Original has exactly the same dimensions and color format
+    if(source->GetWidth() == m_Data->m_Width && source->GetHeight() == m_Data->m_Height &&
+        source->GetColorFormat() == m_Data->m_ColorFormat) {
+        CopyFrom(source);
+        return;
+    }
+    PasteFrom(source->GetReadOnlyView(), stretchmode, filtertype);
+}
 
-    do {
-        unsigned int srcw = source->GetWidth();
-        unsigned int srch = source->GetHeight();
-        if(!srcw || !srch || !m_Data->m_Width || !m_Data->m_Height) {
-            break; // Invalid width/height
-        }
-        int x,y;
-        VideoColorFormat srcfmt = source->GetColorFormat();
-        // Trivial case: Original has exactly the same dimensions and color format
-        if(srcw == m_Data->m_Width && srch == m_Data->m_Height && srcfmt == m_Data->m_ColorFormat) {
-            CopyFrom(source);
-            break; // Get out of the do-while-false construct
-        }
+void syBitmap::PasteFrom(const syBitmapView& source,syStretchMode stretchmode,syFilterType filtertype) {
+    if(!source.IsOk() || !m_Data->m_Width || !m_Data->m_Height) {
+        return;
+    }
+    if(!syRowConverter::CanConvert(source.GetColorFormat(), m_Data->m_ColorFormat)) {
+        return; // Keep the current contents.
+    }
+    Unshare(false); // Every row will be overwritten.
+    PasteView(source, GetView(), stretchmode, filtertype);
+}
 
+void syBitmap::PasteView(const syBitmapView& source, const syBitmapView& dest, syStretchMode stretchmode, syFilterType filtertype) {
+    if(!source.IsOk() || !dest.IsOk() || dest.IsReadOnly()) {
+        return;
+    }
 
+    do {
+        unsigned int srcw = source.GetWidth();
+        unsigned int srch = source.GetHeight();
+        unsigned int width = dest.GetWidth();
+        unsigned int height = dest.GetHeight();
+        syBitmap* bitmap = dest.GetBitmap();
         syBitmapCopier copier;
-        copier.Init(source, this);
+        copier.Init(source, dest);
+        if(!copier.IsOk()) {
+            break; // The color formats can't be converted.
+        }
 
-        // Near trivial case: Same dimensions, different color format
-        if(srcw == m_Data->m_Width && srch == m_Data->m_Height) {
-            for(y = 0; y < (int)m_Data->m_Height; ++y) {
-                if((y & 32) == 0 && MustAbort()) { break; } // Check for abort every 32 rows
-                copier.CopyRowAndIncrementBoth();
-            }
+        // Near trivial case: Same dimensions
+        if(srcw == width && srch == height) {
+            syCopyRowsTask task(bitmap, &copier);
+            syWorkerPool::Get()->Run(&task, height);
             break; // Get out of the do-while-false construct
         }
 
 
         // Nontrivial case: Resize and possibly stretch from the original
-        int srcx, srcy;
-        double xscale, yscale, xoffset, yoffset, tmpx, tmpy;
-
-        if(stretchmode == sy_stcopy && (srcw > m_Data->m_Width || srch > m_Data->m_Height)) {
+        if(stretchmode == sy_stcopy && (srcw > width || srch > height)) {
             stretchmode = sy_stkeepaspectratio;
         }
 
-        // xscale, yscale, xoffset and yoffset are calculated according to the following formula:
-        // srcx = (x * xscale) + xoffset // This formula is applied in the loop at the bottom
-        // Ignoring the offset, we have:
-        //      srcx = x * xscale;
-        // Therefore,
-        //      xscale = srcx / x;
-        // If x = m_Data->m_Width, then:
-        //      xscale = srcw / m_Data->m_Width.
-        //
-        // Now, if we want to make the centers fit together, then we have the following condition:
-        //      srcx = srcw/2, and x = m_Data->m_Width/2.
-        // Applying it to srcx = (x * xscale) + xoffset, we have:
-        //      srcw/2 = (m_Data->m_Width/2 * xscale) + xoffset
-        //      xoffset = srcw/2 - (m_Data->m_Width/2 * xscale).
-        // By Getting the 1/2 out, we have:
-        //      xoffset = (srcw - m_Data->m_Width*xscale)/2
-        // And so, we end up with the following formulas:
-        //
-        // -----------------------------------------
-        // xscale = srcw / m_Data->m_Width;
-        // yscale = srch / m_Data->m_Height;
-        // xoffset = (srcw - (m_Data->m_Width*xscale)) / 2;
-        // yoffset = (srch - (m_Data->m_Height*yscale)) / 2;
-        // -----------------------------------------
-
-        switch(stretchmode) {
-            case sy_stcopy: // Just center the bitmap
-            xscale = 1.0;
-            yscale = 1.0;
-            xoffset = (double)(srcw - m_Data->m_Width) / 2;
-            yoffset = (double)(srch - m_Data->m_Height) / 2;
-            break;
-
-            case sy_stkeepaspectratio: // Scale without distorting
-            default: // Resize to fit
-            xscale = ((double)srcw) / m_Data->m_Width;
-            yscale = ((double)srch) / m_Data->m_Height;
-
-            if(stretchmode == sy_stkeepaspectratio) {
-                if(yscale >= xscale) { // Pick the greatest scale so that everything fits inside
-                    xscale = yscale;
-                } else {
-                    yscale = xscale;
-                }
-            }
-            xoffset = ((double)srcw - (double)(m_Data->m_Width*xscale)) / 2;
-            yoffset = ((double)srch - (double)(m_Data->m_Height*yscale)) / 2;
+        // The scaling tables only depend on the geometry, so a bitmap keeps them until it changes.
+        // Parts of a bitmap may be pasted into at the same time, so they calculate their own tables.
+        Data tmptables;
+        Data* tables = &tmptables;
+        if(bitmap && width == bitmap->m_Data->m_Width && height == bitmap->m_Data->m_Height) {
+            tables = bitmap->m_Data;
         }
-
-        // Now, we implement the formula srcx = (x * xscale) + xoffset into a for loop
-        // But instead of just calculating x and y, we calculate the byte offsets, too!
-        for(y = 0, tmpy = yoffset; y < (int)m_Data->m_Height; ++y, tmpy += yscale) {
-            m_Data->m_YOffsets[y] = copier.m_SourceRowLength*int(floor(tmpy));
-        }
-        for(x = 0, tmpx = xoffset; x < (int)m_Data->m_Width; ++x, tmpx += xscale) {
-            m_Data->m_XOffsets[x] = copier.m_SourceBypp*int(floor(tmpx));
+        syScalingKey key;
+        key.m_SourceWidth = srcw;
+        key.m_SourceHeight = srch;
+        key.m_SourceRowLength = copier.m_SourceRowLength;
+        key.m_SourceBypp = copier.m_SourceBypp;
+        key.m_Width = width;
+        key.m_Height = height;
+        key.m_StretchMode = stretchmode;
+        key.m_Bilinear = (filtertype == filter_bilinear);
+        if(!tables->m_ScalingKeyValid || !(tables->m_ScalingKey == key)) {
+            tables->CalculateScalingTables(key);
         }
-
-        copier.Reset();
-        for(y = 0; y < (int)m_Data->m_Height; ++y, copier.m_Dst += copier.m_DestRowLength) {
-            if((y & 32) == 0 && MustAbort()) { break; } // Check for abort every 32 rows
-            srcy = m_Data->m_YOffsets[y];
-            if((srcy < 0) | ((unsigned int)srcy >= copier.m_SourceBufferLength)) {
-                copier.ClearRow();
-            } else {
-                unsigned int xoffset = 0;
-                for(x = 0; x < (int)m_Data->m_Width; ++x, xoffset += copier.m_DestBypp) {
-                    srcx = m_Data->m_XOffsets[x];
-                    if((srcx < 0) || ((unsigned int)srcx >= copier.m_SourceRowLength)) {
-                        copier.ClearPixelAt(xoffset);
-                    } else {
-                        copier.SetPixelAt(xoffset,syBitmapCopier::ConvertPixel(copier.GetPixelAt(srcy+srcx), srcfmt, m_Data->m_ColorFormat));
-                    }
-                }
-            }
+        copier.ReserveScratch(syWorkerPool::Get()->GetThreadCount());
+
+        if(key.m_Bilinear) {
+            syBilinearRowsTask task(bitmap, &copier, tables->m_YOffsets, tables->m_YWeights, tables->m_XOffsets,
+                tables->m_XWeights, tables->m_ScaledX0, tables->m_ScaledX1);
+            syWorkerPool::Get()->Run(&task, height);
+        } else {
+            // For planar formats, the chroma planes come after the luma rows, so we only check the luma rows.
+            unsigned int srcend = srch*copier.m_SourceRowLength;
+            syScaledRowsTask task(bitmap, &copier, tables->m_YOffsets, tables->m_XOffsets,
+                tables->m_ScaledX0, tables->m_ScaledX1, srcend);
+            syWorkerPool::Get()->Run(&task, height);
         }
     }while(false);
 }
 
+syBitmapView syBitmap::GetView() {
+    syBitmapView result(GetBuffer(), m_Data->m_Width, m_Data->m_Height, m_Data->m_ColorFormat, m_Data->m_RowSize);
+    result.m_ColorMatrix = m_Data->m_ColorMatrix;
+    result.m_Bitmap = this;
+    return result;
+}
+
+syBitmapView syBitmap::GetReadOnlyView() const {
+    syBitmapView result(GetReadOnlyBuffer(), m_Data->m_Width, m_Data->m_Height, m_Data->m_ColorFormat, m_Data->m_RowSize);
+    result.m_ColorMatrix = m_Data->m_ColorMatrix;
+    return result;
+}
+
 bool syBitmap::ExchangeWith(syBitmap* other) {
     if(!this || !other) {
         return false;
@@ -652,6 +1120,31 @@ void syBitmap::Clear() {
     if(!m_Data->m_Buffer || m_Data->m_Width == 0 || m_Data->m_Height == 0) {
         return;
     }
+    m_Data->Unshare(false);
+    if(IsYUVFormat(m_Data->m_ColorFormat)) {
+        // Black is Y = 16, U = V = 128.
+        unsigned long lumasize = m_Data->m_RowSize*m_Data->m_Height;
+        switch(m_Data->m_ColorFormat) {
+            case vcfYUY2:
+            case vcfYVYU:
+            case vcfUYVY: {
+                unsigned int pattern = (m_Data->m_ColorFormat == vcfUYVY) ? 0x10801080 : 0x80108010;
+                unsigned int* ptr = (unsigned int*)m_Data->m_Buffer;
+                for(unsigned long i = m_Data->m_BufferLength >> 2; i; --i, ++ptr) {
+                    memcpy(ptr, &pattern, 4);
+                }
+                break;
+            }
+            case vcfYV12:
+            case vcfYUV12:
+                memset(m_Data->m_Buffer, 16, lumasize);
+                memset(m_Data->m_Buffer + lumasize, 128, m_Data->m_BufferLength - lumasize);
+                break;
+            default:
+                memset(m_Data->m_Buffer, 16, m_Data->m_BufferLength);
+        }
+        return;
+    }
     // Now we'll clear all the buffer and not just the visible part
 
     // By using pointer to ints, we can cut the clearing time by 4x.
@@ -666,7 +1159,8 @@ unsigned char* syBitmap::GetRow(int y) {
     if(m_Data->m_Width == 0 || m_Data->m_Height == 0 || y < 0 || y >= (int)m_Data->m_Height) {
         return NULL;
     }
-    unsigned long w = m_Data->m_Width*m_Data->m_bypp;
+    m_Data->Unshare(true);
+    unsigned long w = m_Data->m_RowSize;
     return (m_Data->m_Buffer + (w*y));
 }
 
@@ -693,10 +1187,64 @@ const unsigned char* syBitmap::GetReadOnlyRow(int y) const {
     if(m_Data->m_Width == 0 || m_Data->m_Height == 0 || y < 0 || y >= (int)m_Data->m_Height) {
         return NULL;
     }
-    unsigned long w = m_Data->m_Width*m_Data->m_bypp;
+    unsigned long w = m_Data->m_RowSize;
     return (m_Data->m_Buffer + (w*y));
 }
 
+bool syBitmap::IsPlanar() const {
+    return IsPlanarFormat(m_Data->m_ColorFormat);
+}
+
+int syBitmap::GetPlaneBytesPerLine(unsigned int plane) const {
+    if(plane == 0) {
+        return m_Data->m_RowSize;
+    }
+    return IsPlanar() ? m_Data->m_RowSize / 2 : 0;
+}
+
+unsigned int syBitmap::GetPlaneHeight(unsigned int plane) const {
+    if(plane == 0) {
+        return m_Data->m_Height;
+    }
+    return IsPlanar() ? (m_Data->m_Height + 1) / 2 : 0;
+}
+
+const unsigned char* syBitmap::GetReadOnlyPlaneRow(unsigned int plane, int y) const {
+    if(plane == 0) {
+        return GetReadOnlyRow(y);
+    }
+    if(plane > 2 || !IsPlanar() || y < 0 || y >= (int)GetPlaneHeight(plane) || !m_Data->m_Buffer) {
+        return NULL;
+    }
+    unsigned long lumasize = m_Data->m_RowSize*m_Data->m_Height;
+    unsigned long chromasize = GetPlaneBytesPerLine(plane)*GetPlaneHeight(plane);
+
+    // vcfYUV12 (I420) stores U before V; vcfYV12 stores V before U.
+    bool second = (m_Data->m_ColorFormat == vcfYV12) ? (plane == 1) : (plane == 2);
+    return m_Data->m_Buffer + lumasize + (second ? chromasize : 0) + GetPlaneBytesPerLine(plane)*y;
+}
+
+unsigned char* syBitmap::GetPlaneRow(unsigned int plane, int y) {
+    m_Data->Unshare(true);
+    return const_cast<unsigned char*>(GetReadOnlyPlaneRow(plane, y));
+}
+
+void syBitmap::Unshare(bool keepcontents) {
+    m_Data->Unshare(keepcontents);
+}
+
+bool syBitmap::IsShared() const {
+    return m_Data->IsShared();
+}
+
+void syBitmap::SetColorMatrix(syColorMatrix matrix) {
+    m_Data->m_ColorMatrix = matrix;
+}
+
+syColorMatrix syBitmap::GetColorMatrix() const {
+    return m_Data->m_ColorMatrix;
+}
+
 const unsigned char* syBitmap::GetReadOnlyPixelAddr(int x, int y) const {
     const unsigned char* base = GetReadOnlyRow(y);
     if(x < 0 || x >= (int)m_Data->m_Width) {
@@ -758,24 +1306,9 @@ void syBitmap::SetPixel(int x, int y, unsigned long pixel) {
 }
 
 void syBitmap::CopyPixel(unsigned char* src,unsigned char* dst,VideoColorFormat sourcefmt,VideoColorFormat destfmt) {
-    unsigned int srcbypp = syBitmap::CalculateBytesperPixel(sourcefmt);
-    unsigned int i;
-    if(sourcefmt == destfmt) {
-        for(i = 0; i < srcbypp; ++i, ++src, ++dst) {
-            *dst = *src;
-        }
-    } else {
-        unsigned int dstbypp = syBitmap::CalculateBytesperPixel(destfmt);
-        unsigned long pixel = 0;
-        for(i = 0; i < srcbypp; ++i, ++src) {
-            pixel = (pixel << 8) | (*src & 255);
-        }
-        pixel = syBitmapCopier::ConvertPixel(pixel, sourcefmt, destfmt);
-        for(i = 0; i < dstbypp; ++i, ++dst) {
-            *dst = pixel & 255;
-            pixel >>= 8;
-        }
-    }
+    syRowConverter converter;
+    converter.Init(sourcefmt, destfmt);
+    converter.Convert(src, dst, 1);
 }
 
 unsigned long syBitmap::ConvertPixel(unsigned long pixel,VideoColorFormat sourcefmt,VideoColorFormat destfmt) {
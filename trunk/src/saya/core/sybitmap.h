@@ -24,6 +24,7 @@
 #include "imagefilters.h"
 
 class syBitmap;
+class syBitmapView;
 class sySafeMutex;
 class syString;
 
@@ -55,12 +56,22 @@ class syBitmap : public syBitmapSink {
         /** Makes a copy from a raw buffer. */
         void CopyFrom(const unsigned char* source, unsigned int width, unsigned int height, VideoColorFormat colorformat, unsigned long maxlength);
 
-        /** Makes a copy of another syBitmap */
+        /** @brief Makes a copy of another syBitmap.
+         *  @note No pixels are copied: Both bitmaps share the same buffer until either of them is modified.
+         *  @see Unshare
+         */
         void CopyFrom(const syBitmap* source);
 
-        /** Resamples from another bitmap using the given resample algorithm. */
+        /** @brief Resamples from another bitmap using the given resample algorithm.
+         *  @note If the color formats can't be converted (see syRowConverter::CanConvert()), nothing is done.
+         */
         void ResampleFrom(const syBitmap* source, syFilterType resamplemode = filter_lanczos4);
 
+        /** @brief Resamples from a view (i.e. a part of another bitmap) using the given resample algorithm.
+         *  @warning The view must not be a view of this bitmap.
+         */
+        void ResampleFrom(const syBitmapView& source, syFilterType resamplemode = filter_lanczos4);
+
         /** Makes a copy of another syBitmap. */
         void LoadData(const syBitmap* bitmap);
 
@@ -133,8 +144,22 @@ class syBitmap : public syBitmapSink {
          */
         static bool CreateBase64IconFromFile(syString& dest, const syString& filename, const char* mimetype = "image/jpeg", unsigned int width = 64, unsigned int height = 64);
 
-        /** Pastes from another bitmap, resizing if necessary */
-        void PasteFrom(const syBitmap* source,syStretchMode stretchmode = sy_stkeepaspectratio);
+        /** @brief Pastes from another bitmap, resizing if necessary.
+         *  @param source The bitmap to paste from.
+         *  @param stretchmode How to fit the source into this bitmap.
+         *  @param filtertype filter_bilinear for bilinear interpolation; any other value picks the nearest
+         *  source pixels. For the other filters, use ResampleFrom().
+         *  @note The scaling tables are kept between calls, so pasting many frames with the same dimensions
+         *  only calculates them once.
+         *  @note If the color formats can't be converted (see syRowConverter::CanConvert()), nothing is done.
+         */
+        void PasteFrom(const syBitmap* source,syStretchMode stretchmode = sy_stkeepaspectratio,syFilterType filtertype = filter_none);
+
+        /** @brief Pastes from a view (i.e. a part of another bitmap), resizing if necessary.
+         *  @see PasteFrom(const syBitmap*,syStretchMode,syFilterType)
+         *  @warning The view must not be a view of this bitmap.
+         */
+        void PasteFrom(const syBitmapView& source,syStretchMode stretchmode = sy_stkeepaspectratio,syFilterType filtertype = filter_none);
 
         /** @brief Exchanges data with another bitmap.
          *  For the bitmaps to be exchanged successfully, both bitmaps' mutexes must be either unlocked or belonging to this thread.
@@ -143,12 +168,23 @@ class syBitmap : public syBitmapSink {
          */
         bool ExchangeWith(syBitmap* other);
 
-        /** Returns a pointer to the Buffer being used */
+        /** @brief Returns a pointer to the Buffer being used.
+         *  @note If the buffer is shared with other bitmaps, the bitmap gets its own copy first.
+         *  Use GetReadOnlyBuffer() when you only need to read the pixels.
+         */
         unsigned char* GetBuffer();
 
         /** Returns a const pointer to the bitmap's buffer */
         const unsigned char* GetReadOnlyBuffer() const;
 
+        /** @brief Returns a writable view of the whole bitmap. Use syBitmapView::GetSubView() to get a part of it.
+         *  @note Just like GetBuffer(), if the buffer is shared with other bitmaps, the bitmap gets its own copy first.
+         */
+        syBitmapView GetView();
+
+        /** Returns a read-only view of the whole bitmap. */
+        syBitmapView GetReadOnlyView() const;
+
         /** Returns the bitmap's current width */
         unsigned int GetWidth() const;
 
@@ -202,6 +238,37 @@ class syBitmap : public syBitmapSink {
          */
         const unsigned char* GetReadOnlyRow(int y) const;
 
+        /** Returns true if the bitmap's color format stores the luma and chroma in separate planes. */
+        bool IsPlanar() const;
+
+        /** @brief Returns a pointer to the start of the specified row of a plane
+         *
+         *  @param plane 0 for the luma (or the whole pixels, for non-planar formats); 1 for U; 2 for V.
+         *  @param y The row to be accessed (zero-based), counted in the plane's own rows.
+         *  @return A pointer to the row if the plane and the value of "y" are valid; NULL otherwise.
+         *  @note The U and V planes are returned in the same order regardless of their order in memory.
+         */
+        unsigned char* GetPlaneRow(unsigned int plane, int y);
+
+        /** @brief Returns a const pointer to the start of the specified row of a plane
+         *  @see GetPlaneRow
+         */
+        const unsigned char* GetReadOnlyPlaneRow(unsigned int plane, int y) const;
+
+        /** Returns the length in bytes of each row of the given plane. */
+        int GetPlaneBytesPerLine(unsigned int plane) const;
+
+        /** Returns the number of rows of the given plane. */
+        unsigned int GetPlaneHeight(unsigned int plane) const;
+
+        /** @brief Sets the color matrix used to convert this bitmap's YUV pixels from / to RGB.
+         *  @note The matrix is only a label; the pixels aren't modified.
+         */
+        void SetColorMatrix(syColorMatrix matrix);
+
+        /** Returns the color matrix used to convert this bitmap's YUV pixels from / to RGB. */
+        syColorMatrix GetColorMatrix() const;
+
 
         /** @brief Returns a pointer to the pixel corresponding to the specified coordinates
          *  @param x The column (zero-based)
@@ -275,8 +342,22 @@ class syBitmap : public syBitmapSink {
          */
         static void CopyPixel(unsigned char* src,unsigned char* dst,VideoColorFormat sourcefmt,VideoColorFormat destfmt);
 
+        /** @brief Returns the size in bytes of each pixel for the given color format.
+         *  @note For planar formats, this is the size of each luma sample.
+         */
         static unsigned int CalculateBytesperPixel(VideoColorFormat format);
 
+        /** Returns true if the color format is one of the supported YUV formats. */
+        static bool IsYUVFormat(VideoColorFormat format);
+
+        /** Returns true if the color format stores the luma and chroma in separate planes (vcfYV12, vcfYUV12). */
+        static bool IsPlanarFormat(VideoColorFormat format);
+
+        /** @brief Returns true if the color format carries an alpha channel (vcfRGBA32, vcfBGRA32).
+         *  The alpha is premultiplied: The color components are already scaled by it.
+         */
+        static bool IsAlphaFormat(VideoColorFormat format);
+
         /** @brief Sets the Aborter object so we can interrupt a copy operation on request.
          *  @see syAborter
          */
@@ -296,13 +377,35 @@ class syBitmap : public syBitmapSink {
         /** Releases the buffer from memory. */
         bool ReleaseBuffer(bool force = false);
 
-        /** Clears the buffer, filling it with zeroes. */
+        /** @brief Gives the bitmap its own buffer if it's shared with other bitmaps (see CopyFrom).
+         *
+         *  This is done automatically by all the functions that give write access to the pixels.
+         *  Call it with keepcontents = false before overwriting the whole bitmap to skip copying the old pixels.
+         */
+        void Unshare(bool keepcontents = true);
+
+        /** Returns true if the bitmap's buffer is shared with other bitmaps. */
+        bool IsShared() const;
+
+        /** Clears the buffer, filling it with zeroes (or black, for YUV formats). */
         void Clear();
 
         /** A mutex to protect the buffer for multithreaded apps */
         mutable sySafeMutex* m_Mutex;
 
     private:
+        /** @brief Reallocates the buffer.
+         *  If keepshared is true and the shared buffer is big enough, it's kept, and it isn't cleared.
+         */
+        void Realloc(unsigned int newwidth,unsigned int newheight,const VideoColorFormat newformat, bool keepshared);
+
+        /** Does the work of PasteFrom() for the views. */
+        static void PasteView(const syBitmapView& source, const syBitmapView& dest, syStretchMode stretchmode, syFilterType filtertype);
+
+        /** Does the work of ResampleFrom() for the views. */
+        static void ResampleView(const syBitmapView& source, const syBitmapView& dest, syFilterType resamplemode);
+
+        friend class syBitmapView;
         class Data;
         friend class Data;
         Data* m_Data;
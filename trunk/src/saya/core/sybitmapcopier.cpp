@@ -11,75 +11,164 @@
 
 #include "sybitmapcopier.h"
 #include "sybitmap.h"
-#include <algorithm>
-using std::min;
-using std::max;
-
-bool syPixelContribBuffer::AddWeight(int sourcex,int destx,float weight) {
-    if(m_Size >= m_Capacity) {
-        return false;
-    }
-    syPixelContrib* pixel = &pixels[m_Size];
-    pixel->srcx = sourcex;
-    pixel->dstx = destx;
-    pixel->weight = weight;
-    ++m_Size;
-    return true;
+#include "sysimd.h"
+
+// ----------------------
+// Begin bilinear kernels
+// ----------------------
+
+// The bilinear kernels work on vcfRGB32 rows. Each component is interpolated as
+// (a*(256 - w) + b*w + 128) >> 8, which fits in 16 bits for weights from 0 to 256.
+
+/** Interpolates the row b into the row a: a = a + (b - a)*weight. */
+static void sy_bilinear_v(unsigned char* a, const unsigned char* b, unsigned int weight, unsigned int first, unsigned int last) {
+    unsigned int inverse = 256 - weight;
+    for(unsigned int i = first; i < last; ++i) {
+        a[i] = (a[i]*inverse + b[i]*weight + 128) >> 8;
+    }
 }
 
-void syPixelContribBuffer::Clear() {
-    m_Size = 0;
+/** Interpolates each destination pixel between the source pixels at xindices and the ones after them. */
+static void sy_bilinear_h(const unsigned char* src, unsigned char* dst, const int* xindices, const int* xweights, unsigned int first, unsigned int last) {
+    for(unsigned int x = first; x < last; ++x) {
+        const unsigned char* p = src + (xindices[x] << 2);
+        unsigned int weight = xweights[x];
+        unsigned int inverse = 256 - weight;
+        unsigned char* q = dst + (x << 2);
+        for(unsigned int i = 0; i < 4; ++i) {
+            q[i] = (p[i]*inverse + p[i + 4]*weight + 128) >> 8;
+        }
+    }
 }
 
+#ifdef SY_X86_SIMD
+
+SY_TARGET_SSE2 static void sy_bilinear_v_sse2(unsigned char* a, const unsigned char* b, unsigned int weight, unsigned int length) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i w = _mm_set1_epi16(weight);
+    const __m128i inv = _mm_set1_epi16(256 - weight);
+    unsigned int i = 0;
+    for(; i + 16 <= length; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(x, zero), inv), _mm_mullo_epi16(_mm_unpacklo_epi8(y, zero), w));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(x, zero), inv), _mm_mullo_epi16(_mm_unpackhi_epi8(y, zero), w));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+        _mm_storeu_si128((__m128i*)(a + i), _mm_packus_epi16(lo, hi));
+    }
+    sy_bilinear_v(a, b, weight, i, length);
+}
+
+// Each source pixel and the one after it are loaded together as 8 bytes, and multiplied by their weights at once.
+// Then the halves of two such products are added to get two destination pixels.
+
+SY_TARGET_SSE2 static void sy_bilinear_h_sse2(const unsigned char* src, unsigned char* dst, const int* xindices, const int* xweights, unsigned int first, unsigned int last) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(128);
+    unsigned int x = first;
+    for(; x + 2 <= last; x += 2) {
+        __m128i p0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + (xindices[x] << 2))), zero);
+        __m128i p1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + (xindices[x + 1] << 2))), zero);
+        short w0 = xweights[x], w1 = xweights[x + 1];
+        short i0 = 256 - w0, i1 = 256 - w1;
+        p0 = _mm_mullo_epi16(p0, _mm_set_epi16(w0, w0, w0, w0, i0, i0, i0, i0));
+        p1 = _mm_mullo_epi16(p1, _mm_set_epi16(w1, w1, w1, w1, i1, i1, i1, i1));
+        __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(p0, p1), _mm_unpackhi_epi64(p0, p1));
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 8);
+        _mm_storel_epi64((__m128i*)(dst + (x << 2)), _mm_packus_epi16(sum, sum));
+    }
+    sy_bilinear_h(src, dst, xindices, xweights, x, last);
+}
+
+#endif
+
+/** Interpolates the row b into the row a, which holds length bytes. */
+static void sy_bilinear_rows(unsigned char* a, const unsigned char* b, unsigned int weight, unsigned int length) {
+    #ifdef SY_X86_SIMD
+    if(syRowConverter::HasSSE2()) {
+        sy_bilinear_v_sse2(a, b, weight, length);
+        return;
+    }
+    #endif
+    sy_bilinear_v(a, b, weight, 0, length);
+}
+
+/** Interpolates the destination pixels from first to last. */
+static void sy_bilinear_cols(const unsigned char* src, unsigned char* dst, const int* xindices, const int* xweights, unsigned int first, unsigned int last) {
+    #ifdef SY_X86_SIMD
+    if(syRowConverter::HasSSE2()) {
+        sy_bilinear_h_sse2(src, dst, xindices, xweights, first, last);
+        return;
+    }
+    #endif
+    sy_bilinear_h(src, dst, xindices, xweights, first, last);
+}
+
+// --------------------
+// End bilinear kernels
+// --------------------
+
 syBitmapCopier::syBitmapCopier() :
-m_SourceBitmap(0),
-m_DestBitmap(0),
 m_Src(0),
 m_Dst(0),
-m_XContrib(0),
-m_YContrib(0),
-m_YBuffer(0),
-m_FullBuffer(0)
+m_Resampler(0),
+m_ResampleBuffer(0),
+m_ScratchSize(0),
+m_SourceSubsampled(false),
+m_DestYUV(false),
+m_Planar(false)
 {}
 
 void syBitmapCopier::Init(const syBitmap *sourcebmp, syBitmap *destbmp, syFilterType filtertype) {
     if(!sourcebmp || !destbmp) { return; }
-    m_SourceBitmap = sourcebmp;
-    m_DestBitmap = destbmp;
-    m_SourceFmt = sourcebmp->GetColorFormat();
-    m_DestFmt = destbmp->GetColorFormat();
-    m_SourceBypp = sourcebmp->GetBytesPerPixel();
-    m_DestBypp = destbmp->GetBytesPerPixel();
-    m_Src = sourcebmp->GetReadOnlyBuffer();
-    m_Dst = destbmp->GetBuffer();
-    m_SourceWidth = sourcebmp->GetWidth();
-    m_DestWidth = destbmp->GetWidth();
+    Init(sourcebmp->GetReadOnlyView(), destbmp->GetView(), filtertype);
+}
+
+void syBitmapCopier::Init(const syBitmapView& source, const syBitmapView& dest, syFilterType filtertype) {
+    m_Source = source;
+    m_Dest = dest;
+    m_SourceFmt = source.GetColorFormat();
+    m_DestFmt = dest.GetColorFormat();
+    m_SourceBypp = source.GetBytesPerPixel();
+    m_DestBypp = dest.GetBytesPerPixel();
+    m_Src = source.GetReadOnlyRow(0);
+    m_Dst = dest.GetRow(0);
+    m_SourceWidth = source.GetWidth();
+    m_DestWidth = dest.GetWidth();
     m_EffectiveDestWidth = m_DestWidth;
-    m_SourceHeight = sourcebmp->GetHeight();
-    m_DestHeight = destbmp->GetHeight();
+    m_SourceHeight = source.GetHeight();
+    m_DestHeight = dest.GetHeight();
     m_EffectiveDestHeight = m_DestHeight;
-    m_SourceRowLength = sourcebmp->GetBytesPerLine();
-    m_DestRowLength = destbmp->GetBytesPerLine();
-    m_SourceBufferLength = sourcebmp->GetBufferLength();
-    m_DestBufferLength = destbmp->GetBufferLength();
-    if(m_XContrib) {
-        delete m_XContrib;
-        m_XContrib = 0;
-    }
-    if(m_YContrib) {
-        delete m_YContrib;
-        m_YContrib = 0;
+    m_SourceRowLength = source.GetBytesPerLine();
+    m_DestRowLength = dest.GetBytesPerLine();
+    m_SourceBufferLength = m_SourceRowLength*m_SourceHeight;
+    m_DestBufferLength = m_DestRowLength*m_DestHeight;
+    m_SourceSubsampled = syBitmap::IsYUVFormat(m_SourceFmt) && m_SourceFmt != vcfY800;
+    m_DestYUV = syBitmap::IsYUVFormat(m_DestFmt);
+    m_Planar = source.IsPlanar() || dest.IsPlanar();
+    m_Converter.Init(m_SourceFmt, m_DestFmt, source.GetColorMatrix(), dest.GetColorMatrix());
+    // vcfRGBA32 has the same layout as vcfRGB32, but keeps the alpha of the source (or makes it opaque).
+    VideoColorFormat rgbfmt = syBitmap::IsAlphaFormat(m_DestFmt) ? vcfRGBA32 : vcfRGB32;
+    m_ToRGB32.Init(m_SourceFmt, rgbfmt, source.GetColorMatrix());
+    m_FromRGB32.Init(rgbfmt, m_DestFmt, sy_cmbt601, dest.GetColorMatrix());
+    m_ScratchSize = ((m_SourceWidth + 1) << 1) + m_DestWidth;
+    m_Scratch.clear();
+    if(m_DestYUV) {
+        // Converting an RGB black row gives us the right values for each format.
+        m_BlackRow.assign(m_DestWidth, 0);
+    } else {
+        m_BlackRow.clear();
     }
-    if(m_YBuffer) {
-        delete[] m_YBuffer;
-        m_YBuffer = 0;
+    if(m_Resampler) {
+        m_Resampler->Release();
+        m_Resampler = 0;
     }
-    if(m_FullBuffer) {
-        delete[] m_FullBuffer;
-        m_FullBuffer = 0;
+    if(m_ResampleBuffer) {
+        delete[] m_ResampleBuffer;
+        m_ResampleBuffer = 0;
     }
-    m_YBuffer  = new syFloatPixel[m_DestHeight];
-    m_FullBuffer  = new syFloatPixel[m_DestWidth*m_SourceHeight];
 
     if(m_DestWidth == m_SourceWidth && m_DestHeight == m_SourceHeight) {
         m_EffectiveDestHeight = m_DestHeight;
@@ -112,243 +201,256 @@ void syBitmapCopier::Init(const syBitmap *sourcebmp, syBitmap *destbmp, syFilter
         // We divide by two to get the initial X coordinate. Same goes with m_DestY0
 
         m_DestY0 = (m_DestHeight - m_EffectiveDestHeight)/2;
-        m_XContrib = 0;
-        m_YContrib = 0;
+    }
 
-        if(filtertype == filter_none) {
-            m_Filter = 0;
-        } else {
-            m_Filter = syImageFilter::Create(filtertype);
-            InitContribBuffers();
+    if(filtertype != filter_none) {
+        m_Resampler = syResampler::Get(m_SourceWidth, m_SourceHeight, m_EffectiveDestWidth, m_EffectiveDestHeight, filtertype);
+        if(m_Resampler) {
+            m_ResampleBuffer = new unsigned char[(m_EffectiveDestWidth*m_SourceHeight) << 2];
         }
     }
 }
 
 syBitmapCopier::~syBitmapCopier() {
-    if(m_XContrib) {
-        delete m_XContrib;
-        m_XContrib = 0;
-    }
-    if(m_YContrib) {
-        delete m_YContrib;
-        m_YContrib = 0;
+    if(m_Resampler) {
+        m_Resampler->Release();
+        m_Resampler = 0;
     }
-    if(m_YBuffer) {
-        delete[] m_YBuffer;
-        m_YBuffer = 0;
-    }
-    if(m_FullBuffer) {
-        delete[] m_FullBuffer;
-        m_FullBuffer = 0;
+    if(m_ResampleBuffer) {
+        delete[] m_ResampleBuffer;
+        m_ResampleBuffer = 0;
     }
 }
 
-void syBitmapCopier::InitContribBuffers() {
-    if(!m_Filter) {
-        return;
-    }
-    if(m_XContrib) {
-        delete m_XContrib;
-        m_XContrib = 0;
-    }
-    if(m_YContrib) {
-        delete m_YContrib;
-        m_YContrib = 0;
-    }
+void syBitmapCopier::ReserveScratch(unsigned int slots) {
+    m_Scratch.resize(slots*m_ScratchSize);
+}
 
-    int fullfilterwidth = (int)(ceil(m_Filter->GetWidth())*2+1);
-    m_XContrib = new syPixelContribBuffer(fullfilterwidth*m_EffectiveDestWidth);
-    m_YContrib = new syPixelContribBuffer(fullfilterwidth*m_EffectiveDestHeight);
-    unsigned int finalx = m_DestX0 + m_EffectiveDestWidth, finaly = m_DestY0 + m_EffectiveDestHeight;
+unsigned int* syBitmapCopier::GetSourceScratch(unsigned int slot) {
+    return &m_Scratch[slot*m_ScratchSize];
+}
 
-    // Calculating X contributions
+unsigned int* syBitmapCopier::GetDestScratch(unsigned int slot) {
+    return &m_Scratch[slot*m_ScratchSize + ((m_SourceWidth + 1) << 1)];
+}
 
-    float xdiff = 1/m_XScale;
-    float filter_scale = min(1.0f, m_XScale); // Used for calculating the weights.
+bool syBitmapCopier::IsOk() const {
+    return m_Converter.IsOk() && m_ToRGB32.IsOk() && m_FromRGB32.IsOk();
+}
 
-    float center = 0;
-    for(unsigned int x = m_DestX0; x < finalx && center < m_SourceWidth; ++x) {
-        int left = (int)floor(center - m_Filter->GetWidth()); // It's actually the half-width; This is, the filter's radius
-        if(left < 0) { left = 0; }
-        int right = (int)ceil(center + m_Filter->GetWidth());
-        if(right >= (int)m_SourceWidth) { right = m_SourceWidth - 1; }
+void syBitmapCopier::Reset() {
+    m_Src = m_Source.GetReadOnlyRow(0);
+    m_Dst = m_Dest.GetRow(0);
+}
 
-        // Check if we're taking samples outside the sliding window
-        if(right - left >= fullfilterwidth) {
-            // Either we increment left, or decrease right.
-            // First, check if incrementing the left limit would pass the center of the source image
-            if(left + 1 <= (int)m_SourceWidth / 2) {
-                ++left;
-            } else {
-                --right;
-            }
-        }
-        float weight_sum = 0; // For normalization
-        int weight_count = 0;
-        int srcx;
-        for(srcx = left; srcx <= right; ++srcx) {
-            float deltax = center - (float)srcx;
-            float curweight = filter_scale * m_Filter->Filter(filter_scale * deltax);
-            weight_sum += curweight;
-            if(m_XContrib->AddWeight(srcx,x,curweight)) {
-                ++weight_count;
-            }
-        }
-        // Normalize the weights
-        if(weight_sum > 0.000000001) { // We use a minimum to differentiate from zero
-            for(int i = 1; i <= weight_count; ++i) {
-                m_XContrib->pixels[m_XContrib->size() - i].weight /= weight_sum;
-            }
-        }
-        center+=xdiff;
+unsigned long syBitmapCopier::ConvertPixel(unsigned long pixel,VideoColorFormat sourcefmt,VideoColorFormat destfmt) {
+    if(syRowConverter::GetPixelFormat(sourcefmt) == syRowConverter::GetPixelFormat(destfmt)) {
+        return pixel; // Trivial case: Formats are the same
     }
 
-    // Calculating Y contributions
-
-    float ydiff = 1/m_YScale;
-    filter_scale = min(1.0f, m_YScale); // Used for calculating the weights.
+    // Pixels are stored in little-endian order (see syBitmap::GetPixel), so we unpack the pixel,
+    // run it through the row converter and pack it back.
+    unsigned char src[4], dst[4] = { 0, 0, 0, 0 };
+    unsigned int i;
+    for(i = 0; i < 4; ++i) {
+        src[i] = (pixel >> (i << 3)) & 255;
+    }
+    syRowConverter converter;
+    converter.Init(sourcefmt, destfmt);
+    if(!converter.IsOk()) {
+        return pixel; // No conversion available; keep the pixel as it is.
+    }
+    converter.Convert(src, dst, 1);
+    pixel = 0;
+    for(i = 0; i < 4; ++i) {
+        pixel |= ((unsigned long)dst[i]) << (i << 3);
+    }
+    return pixel;
+}
 
-    center = 0;
-    for(unsigned int y = m_DestY0; y < finaly && center < m_SourceHeight; ++y,center+=ydiff) {
-        int top = (int)floor(center - m_Filter->GetWidth()); // It's actually the half-width; This is, the filter's radius
-        if(top < 0) { top = 0; }
-        int bottom = (int)ceil(center + m_Filter->GetWidth());
-        if(bottom >= (int)m_SourceHeight) { bottom = m_SourceHeight - 1; }
+void syBitmapCopier::GetSourcePlanes(const unsigned char* row, const unsigned char** planes) {
+    planes[0] = row;
+    planes[1] = planes[2] = 0;
+    if(m_Source.IsPlanar()) {
+        int y = (row - m_Source.GetReadOnlyRow(0)) / m_SourceRowLength;
+        planes[1] = m_Source.GetReadOnlyPlaneRow(1, y >> 1);
+        planes[2] = m_Source.GetReadOnlyPlaneRow(2, y >> 1);
+    }
+}
 
-        // Check if we're taking samples outside the sliding window
-        if(bottom - top >= fullfilterwidth) {
-            // Either we increment top, or decrease bottom.
-            // First, check if incrementing the top limit would pass the center of the source image
-            if(top + 1 <= (int)m_SourceHeight / 2) {
-                ++top;
-            } else {
-                --bottom;
-            }
-        }
-        float weight_sum = 0; // For normalization
-        int weight_count = 0;
-        int srcy;
-        for(srcy = top; srcy <= bottom; ++srcy) {
-            float deltay = center - (float)srcy;
-            float curweight = filter_scale * m_Filter->Filter(filter_scale * deltay);
-            weight_sum += curweight;
-            if(m_YContrib->AddWeight(srcy,y,curweight)) {
-                ++weight_count;
-            }
-        }
-        // Normalize the weights
-        if(weight_sum > 0.000000001) { // We use a minimum to differentiate from zero
-            for(int i = 1; i <= weight_count; ++i) {
-                m_YContrib->pixels[m_YContrib->size() - i].weight /= weight_sum;
-            }
+void syBitmapCopier::GetDestPlanes(unsigned char* row, unsigned char** planes) {
+    planes[0] = row;
+    planes[1] = planes[2] = 0;
+    if(m_Dest.IsPlanar()) {
+        int y = (row - m_Dest.GetReadOnlyRow(0)) / m_DestRowLength;
+        if((y & 1) == 0) {
+            planes[1] = m_Dest.GetPlaneRow(1, y >> 1);
+            planes[2] = m_Dest.GetPlaneRow(2, y >> 1);
         }
     }
 }
 
-void syBitmapCopier::Reset() {
-    m_Src = m_SourceBitmap->GetReadOnlyBuffer();
-    m_Dst = m_DestBitmap->GetBuffer();
+void syBitmapCopier::CopyPlanarRow(const unsigned char* src, unsigned char* dst) {
+    const unsigned char* srcplanes[3];
+    unsigned char* dstplanes[3];
+    GetSourcePlanes(src, srcplanes);
+    GetDestPlanes(dst, dstplanes);
+    unsigned int maxw = m_SourceWidth;
+    if(maxw > m_DestWidth) {
+        maxw = m_DestWidth;
+    }
+    m_Converter.Convert(srcplanes, dstplanes, maxw);
 }
 
-unsigned long syBitmapCopier::ConvertPixel(unsigned long pixel,VideoColorFormat sourcefmt,VideoColorFormat destfmt) {
+void syBitmapCopier::ClearYUVRow(unsigned char* dst) {
+    if(m_BlackRow.empty()) {
+        return;
+    }
+    const unsigned char* black = (const unsigned char*)&m_BlackRow[0];
+    unsigned char* dstplanes[3];
+    GetDestPlanes(dst, dstplanes);
+    m_FromRGB32.Convert(&black, dstplanes, m_DestWidth);
+}
 
-    // Let's get the "real" color format
-    if(sourcefmt == vcfRGB24_Line32) {
-        sourcefmt = vcfRGB24;
+void syBitmapCopier::CopyScaledRow(unsigned char* dst, unsigned int srcrowoffset, const int* xoffsets, unsigned int x0, unsigned int x1,
+    unsigned int slot) {
+    if(m_SourceSubsampled || m_DestYUV) {
+        // Subsampled pixels can't be copied one by one, so we go through vcfRGB32: We unpack the whole
+        // source row, pick the pixels and pack the whole destination row. The margins end up black.
+        unsigned int* srcrow = GetSourceScratch(slot);
+        unsigned int* dstrow = GetDestScratch(slot);
+        const unsigned char* srcplanes[3];
+        unsigned char* dstplanes[3];
+        GetSourcePlanes(m_Src + srcrowoffset, srcplanes);
+        GetDestPlanes(dst, dstplanes);
+        unsigned char* srcrowptr = (unsigned char*)srcrow;
+        m_ToRGB32.Convert(srcplanes, &srcrowptr, m_SourceWidth);
+        unsigned int x;
+        for(x = 0; x < x0; ++x) {
+            dstrow[x] = 0;
+        }
+        for(; x < x1; ++x) {
+            dstrow[x] = srcrow[xoffsets[x] / m_SourceBypp];
+        }
+        for(; x < m_DestWidth; ++x) {
+            dstrow[x] = 0;
+        }
+        const unsigned char* rgbrow = (const unsigned char*)dstrow;
+        m_FromRGB32.Convert(&rgbrow, dstplanes, m_DestWidth);
+        return;
     }
-    if(sourcefmt == vcfBGR24_Line32) {
-        sourcefmt = vcfBGR24;
+
+    if(x0 > 0) {
+        memset(dst, 0, x0*m_DestBypp);
     }
-    if(destfmt == vcfRGB24_Line32) {
-        destfmt = vcfRGB24;
+    if(x1 < m_DestWidth) {
+        memset(dst + x1*m_DestBypp, 0, (m_DestWidth - x1)*m_DestBypp);
     }
-    if(destfmt == vcfBGR24_Line32) {
-        destfmt = vcfBGR24;
+    if(x1 <= x0) {
+        return;
     }
 
-    if(sourcefmt == destfmt) { // Trivial case: Formats are the same
-        return pixel;
+    // First we gather the source pixels in their original format; then we convert them all at once.
+    // If no conversion is needed, we can gather them directly into the destination.
+    const unsigned char* src = m_Src + srcrowoffset;
+    unsigned int width = x1 - x0;
+    dst += x0*m_DestBypp;
+    unsigned char* gathered = dst;
+    if(!m_Converter.IsTrivial()) {
+        gathered = (unsigned char*)GetDestScratch(slot);
     }
-
-    // Near trivial case: Swap B and R components in the pixel.
-    if(
-       (sourcefmt == vcfRGB24 && destfmt == vcfBGR24) ||
-       (sourcefmt == vcfBGR24 && destfmt == vcfRGB24) ||
-       (sourcefmt == vcfRGB32 && destfmt == vcfBGR32) ||
-       (sourcefmt == vcfBGR32 && destfmt == vcfRGB32)
-      ) {
-        // Swap first and third bytes
-        unsigned char c0, c1, c2, c3;
-        c0 = pixel & 0xFF;
-        c1 = (pixel >> 8) & 0xFF;
-        c2 = (pixel >> 16) & 0xFF;
-        c3 = (pixel >> 24) & 0xFF;
-        pixel = (c3 << 24) | (c0 << 16) | (c1 << 8) | c2;
+    const int* ofs = xoffsets + x0;
+    unsigned int x;
+    switch(m_SourceBypp) {
+        case 1:
+            for(x = 0; x < width; ++x) {
+                gathered[x] = src[ofs[x]];
+            }
+            break;
+        case 2:
+            for(x = 0; x < width; ++x) {
+                memcpy(gathered + (x << 1), src + ofs[x], 2);
+            }
+            break;
+        case 3:
+            for(x = 0; x < width; ++x) {
+                memcpy(gathered + x*3, src + ofs[x], 3);
+            }
+            break;
+        default:
+            for(x = 0; x < width; ++x) {
+                memcpy(gathered + (x << 2), src + ofs[x], 4);
+            }
+    }
+    if(gathered != dst) {
+        m_Converter.Convert(gathered, dst, width);
     }
-
-    // TODO: Implement non-trivial cases in syBitmap::ConvertPixel
-    return pixel;
 }
 
-void syBitmapCopier::ResampleRow(unsigned int y) {
-    unsigned int i;
-    const unsigned char* src = &m_Src[y*m_SourceRowLength];
-    syFloatPixel* dst = &m_FullBuffer[y*m_DestWidth];
-
-    if(m_SourceWidth == m_DestWidth) {
-        for(i = 0; i < m_SourceWidth; ++i) {
-            dst[i].fromRGBA(ConvertPixel(m_SourceBitmap->GetPixel(src,i), m_SourceFmt,vcfRGB32));
-        }
-    } else if(m_XContrib) {
-        // Clear destination buffer
-        for(i = 0; i < m_DestWidth; ++i) {
-            dst[i].clear();
-        }
+void syBitmapCopier::CopyBilinearRow(unsigned char* dst, unsigned int srcrowoffset, unsigned int yweight,
+    const int* xindices, const int* xweights, unsigned int x0, unsigned int x1, unsigned int slot) {
+    // The source rows are unpacked to vcfRGB32, with an extra copy of the last pixel
+    // so that the rightmost columns can always read the pixel after them.
+    unsigned int* row0 = GetSourceScratch(slot);
+    unsigned int* row1 = row0 + m_SourceWidth + 1;
+    unsigned int* dstrow = GetDestScratch(slot);
+    const unsigned char* srcplanes[3];
+    unsigned char* dstplanes[3];
+    unsigned char* rowptr = (unsigned char*)row0;
+
+    GetSourcePlanes(m_Src + srcrowoffset, srcplanes);
+    m_ToRGB32.Convert(srcplanes, &rowptr, m_SourceWidth);
+    if(yweight) {
+        rowptr = (unsigned char*)row1;
+        GetSourcePlanes(m_Src + srcrowoffset + m_SourceRowLength, srcplanes);
+        m_ToRGB32.Convert(srcplanes, &rowptr, m_SourceWidth);
+        sy_bilinear_rows((unsigned char*)row0, (const unsigned char*)row1, yweight, m_SourceWidth << 2);
+    }
+    row0[m_SourceWidth] = row0[m_SourceWidth - 1];
 
-        // First we iterate over the source row and convert all the pixels to float.
-        syFloatPixel floatpixels[m_SourceWidth];
-        for(i = 0; i < m_SourceWidth; ++i) {
-            floatpixels[i].fromRGBA(syBitmap::ConvertPixel(m_SourceBitmap->GetPixel(src,i),m_SourceFmt,vcfRGB32));
-        }
+    unsigned int x;
+    for(x = 0; x < x0; ++x) {
+        dstrow[x] = 0;
+    }
+    for(x = x1; x < m_DestWidth; ++x) {
+        dstrow[x] = 0;
+    }
 
-        // Now we iterate over the contrib buffer and resample each pixel.
-        for(i = 0; i < m_XContrib->size();++i) {
-            syPixelContrib* contrib = &m_XContrib->pixels[i];
-            if(contrib->srcx >= 0 && contrib->srcx < (int)m_SourceWidth) {
-                dst[contrib->dstx].MultiplyAndAdd(floatpixels[contrib->srcx],contrib->weight);
-            }
-        }
+    if(x0 < x1) {
+        sy_bilinear_cols((const unsigned char*)row0, (unsigned char*)dstrow, xindices, xweights, x0, x1);
     }
+
+    const unsigned char* rgbrow = (const unsigned char*)dstrow;
+    GetDestPlanes(dst, dstplanes);
+    m_FromRGB32.Convert(&rgbrow, dstplanes, m_DestWidth);
 }
 
-void syBitmapCopier::ResampleCol(unsigned int x) {
-    syFloatPixel* src = m_FullBuffer;
+void syBitmapCopier::ResampleRow(unsigned int y, unsigned int slot) {
+    if(!m_Resampler) {
+        return;
+    }
+    const unsigned char* srcplanes[3];
+    GetSourcePlanes(&m_Src[y*m_SourceRowLength], srcplanes);
 
-    if(m_YContrib) {
-        // 1. Clear the temporary Y buffer.
-        unsigned int i;
-        for(i = 0; i < m_DestHeight; ++i) {
-            m_YBuffer[i].clear();
-        }
+    // Convert the whole source row to RGB32 at once.
+    unsigned char* rgbptr = (unsigned char*)GetSourceScratch(slot);
+    m_ToRGB32.Convert(srcplanes, &rgbptr, m_SourceWidth);
+    m_Resampler->ResampleRow(rgbptr, m_ResampleBuffer + ((y*m_EffectiveDestWidth) << 2));
+}
 
-        // 2. Iterate over the contrib buffer and resample each pixel.
-        for(i = 0; i < m_YContrib->size();++i) {
-            syPixelContrib* contrib = &m_YContrib->pixels[i];
-            // Here, contrib->srcx and contrib->dstx refer to Y coordinates,
-            // because we're operating on a x-to-y translated vector.
-            int srcy = contrib->srcx;
-            int dsty = contrib->dstx;
-            if(srcy >= 0 && srcy < (int)m_SourceHeight && dsty >=0 && dsty < (int)m_DestHeight) {
-                m_YBuffer[dsty].MultiplyAndAdd(src[srcy*m_DestWidth + x],contrib->weight);
-            }
+void syBitmapCopier::ResampleDestRow(unsigned int y, unsigned int slot) {
+    unsigned int* rgbrow = GetDestScratch(slot);
+    if(!m_Resampler || y < m_DestY0 || y >= m_DestY0 + m_EffectiveDestHeight) {
+        memset(rgbrow, 0, m_DestWidth << 2);
+    } else {
+        unsigned int x;
+        for(x = 0; x < m_DestX0; ++x) {
+            rgbrow[x] = 0;
         }
-
-        // TODO: 3. Convert the the float pixels into bitmap pixels and store them in dst.
-        unsigned int xofs = x*m_DestBypp;
-        for(i = 0; i < m_DestHeight; ++i) {
-            unsigned long pixel = ConvertPixel(m_YBuffer[i].toRGBA(),vcfRGB32,m_DestFmt);
-            SetPixelAt(xofs,pixel);
-            xofs += m_DestRowLength;
+        for(x = m_DestX0 + m_EffectiveDestWidth; x < m_DestWidth; ++x) {
+            rgbrow[x] = 0;
         }
+        m_Resampler->ResampleCols(m_ResampleBuffer, y - m_DestY0, (unsigned char*)(rgbrow + m_DestX0));
     }
+    m_FromRGB32.Convert((const unsigned char*)rgbrow, m_Dst + y*m_DestRowLength, m_DestWidth);
 }
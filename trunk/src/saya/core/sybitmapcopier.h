@@ -14,102 +14,12 @@
 
 #include "videocolorformat.h"
 #include "imagefilters.h"
+#include "syrowconverter.h"
+#include "syresampler.h"
+#include "sybitmapview.h"
 #include <cmath>
-
-class syBitmap;
-
-class syFloatPixel {
-    public:
-        float r;
-        float g;
-        float b;
-        float a;
-        syFloatPixel(float r0 = 0,float g0 = 0, float b0 = 0, float a0 = 0) : r(r0),g(g0),b(b0),a(a0) {}
-
-        inline void fromRGBAValues(unsigned long r0 = 0,unsigned long g0 = 0, unsigned long b0 = 0, unsigned long a0 = 0) {
-            r = pixeltofloat(r0);
-            g = pixeltofloat(g0);
-            b = pixeltofloat(b0);
-            a = pixeltofloat(a0);
-        }
-
-        inline void fromRGBA(unsigned long pixel) {
-            fromRGBAValues(pixel, pixel >> 8, pixel >> 16, pixel >> 24);
-        }
-
-        inline void clear() {
-            r = g = b = a = 0;
-        }
-
-        syFloatPixel(unsigned long r0,unsigned long g0, unsigned long b0, unsigned long a0) {
-            fromRGBAValues(r0,g0,b0,a0);
-        }
-        syFloatPixel(unsigned long pixel) {
-            fromRGBA(pixel);
-        }
-
-        static inline float  truncate(float d) {
-            if(d < 0) {
-                d = 0;
-            } else if(d > 1.0) {
-                d = 1.0;
-            }
-            return d;
-        };
-
-        static inline unsigned long floattopixel(float d) {
-            return (unsigned long)(truncate(d)*255.0);
-        }
-
-        static inline float pixeltofloat(unsigned long p) {
-            return truncate((1/255.0d)*(p & 0xFF));
-        }
-
-        inline unsigned long toRGBA() {
-            unsigned long result;
-            result = (floattopixel(a) << 24) | (floattopixel(b) << 16) | (floattopixel(g) << 8) | (floattopixel(r));
-            return result;
-        }
-
-        inline void MultiplyAndAdd(const syFloatPixel& sourcepixel, float weight) {
-            r+=sourcepixel.r*weight;
-            g+=sourcepixel.g*weight;
-            b+=sourcepixel.b*weight;
-            a+=sourcepixel.a*weight;
-        }
-
-};
-
-class syPixelContrib {
-    public:
-        int srcx;
-        int dstx;
-        float weight;
-};
-
-class syPixelContribBuffer {
-    public:
-        syPixelContribBuffer(unsigned long sizeinpixels) : m_Capacity(sizeinpixels),m_Size(0),pixels(new syPixelContrib[sizeinpixels]) {}
-        ~syPixelContribBuffer() { delete[] pixels;pixels = 0; }
-        /** Returns false if ran out of space */
-        bool AddWeight(int sourcex,int destx,float weight);
-        void Clear();
-        inline unsigned long size() {
-            return m_Size;
-        }
-        inline unsigned long capacity() {
-            return m_Capacity;
-        }
-    private:
-        unsigned long m_Capacity;
-        unsigned long m_Size;
-    public:
-        syPixelContrib* pixels;
-
-};
-
-
-
+#include <cstring>
+#include <vector>
 
 /** @brief Optimized bitmap pixel copier.
   *
@@ -117,6 +27,10 @@ class syPixelContribBuffer {
   * then you can keep copying without needing to recalculate the pointers, the bytes per pixel or
   * pass the color formats through the stack.
   * Feel free to add as many functions as you need.
+  *
+  * The functions that take explicit row addresses or row numbers (as well as ResampleRow and ResampleDestRow)
+  * don't modify the copier, so several threads can use the same copier at once on different rows.
+  * The ones that need temporary rows take a slot; call ReserveScratch() first, and give each thread its own slot.
   */
 class syBitmapCopier {
     public:
@@ -125,6 +39,19 @@ class syBitmapCopier {
         /** Initializes the member variables to perform the batch copying */
         void Init(const syBitmap *sourcebmp, syBitmap *destbmp, syFilterType filtertype = filter_none);
 
+        /** Initializes the member variables to copy between two views (i.e. parts of bitmaps). */
+        void Init(const syBitmapView& source, const syBitmapView& dest, syFilterType filtertype = filter_none);
+
+        /** @brief Allocates the temporary rows for the functions that take a slot.
+         *  @param slots The number of threads that will use the copier at once (see syBandTask::ProcessBand).
+         */
+        void ReserveScratch(unsigned int slots);
+
+        /** @brief Returns false if the color formats given to Init() can't be converted (see syRowConverter::IsOk()).
+         *  In that case, the copy functions leave the destination untouched.
+         */
+        bool IsOk() const;
+
         /** Resets m_Src and m_Dst to the bitmaps original addresses */
         void Reset();
 
@@ -153,6 +80,12 @@ class syBitmapCopier {
          */
         void CopyRow();
 
+        /** @brief Copies a row from src to dst, converting the color format if necessary.
+         *  @param src The start of the source row in the source bitmap.
+         *  @param dst The start of the destination row in the destination bitmap.
+         */
+        void CopyRow(const unsigned char* src, unsigned char* dst);
+
         /** @brief Copies row from m_Src to m_Dst, converting the color format if necessary.
          *  m_Src is incremented by one row.
          *
@@ -177,9 +110,12 @@ class syBitmapCopier {
         /** @brief Fills row in m_Dst with the specified pixel color. m_Dst is not incremented. */
         void FillRow(unsigned long pixel);
 
-        /** @brief Fills row in m_Dst with zeroes. m_Dst is not incremented. */
+        /** @brief Fills row in m_Dst with zeroes (black, for YUV formats). m_Dst is not incremented. */
         void ClearRow();
 
+        /** @brief Fills the destination row at dst with zeroes (black, for YUV formats). */
+        void ClearRow(unsigned char* dst);
+
         /** @brief Gets the pixel in m_SourceBitmap at the given offset. */
         unsigned long GetPixelAt(unsigned int offset);
 
@@ -189,11 +125,39 @@ class syBitmapCopier {
         /** @brief Clears the pixel in m_DestBitmap at the given offset. */
         void ClearPixelAt(unsigned int offset);
 
-        /** Source bitmap */
-        const syBitmap* m_SourceBitmap;
+        /** @brief Copies a scaled row from m_SourceBitmap into dst, converting the color format if necessary.
+         *
+         *  @param dst The start of the destination row in the destination bitmap.
+         *  @param srcrowoffset Offset in bytes of the source row, relative to m_Src.
+         *  @param xoffsets The source byte offsets (relative to the row) for each destination column.
+         *  @param x0 The first destination column to copy.
+         *  @param x1 The destination column after the last one to copy.
+         *  @param slot The temporary rows to use. @see ReserveScratch
+         *  @note Columns outside [x0, x1) are cleared. The offsets for [x0, x1) must be within the source row.
+         */
+        void CopyScaledRow(unsigned char* dst, unsigned int srcrowoffset, const int* xoffsets, unsigned int x0, unsigned int x1,
+            unsigned int slot);
 
-        /** Destination bitmap */
-        syBitmap* m_DestBitmap;
+        /** @brief Interpolates a scaled row from m_SourceBitmap into dst, converting the color format if necessary.
+         *
+         *  @param dst The start of the destination row in the destination bitmap.
+         *  @param srcrowoffset Offset in bytes of the upper source row, relative to m_Src.
+         *  @param yweight The weight (0 to 256) of the source row below the upper one.
+         *  @param xindices The left source column for each destination column.
+         *  @param xweights The weight (0 to 256) of the column to the right of the left one.
+         *  @param x0 The first destination column to copy.
+         *  @param x1 The destination column after the last one to copy.
+         *  @param slot The temporary rows to use. @see ReserveScratch
+         *  @note Columns outside [x0, x1) are cleared. If a weight is zero, the next row (or column) isn't read.
+         */
+        void CopyBilinearRow(unsigned char* dst, unsigned int srcrowoffset, unsigned int yweight,
+            const int* xindices, const int* xweights, unsigned int x0, unsigned int x1, unsigned int slot);
+
+        /** Source pixels */
+        syBitmapView m_Source;
+
+        /** Destination pixels */
+        syBitmapView m_Dest;
 
         /** Source color format obtained by Init(). Kept public to allow external modification. */
         VideoColorFormat m_SourceFmt;
@@ -201,6 +165,17 @@ class syBitmapCopier {
         /** Destination color format obtained by Init(). Kept public to allow external modification. */
         VideoColorFormat m_DestFmt;
 
+        /** @brief Row converter from m_SourceFmt to m_DestFmt, picked by Init().
+         *  @note If you modify m_SourceFmt or m_DestFmt, you must call m_Converter.Init() again.
+         */
+        syRowConverter m_Converter;
+
+        /** Row converter from m_SourceFmt to vcfRGB32 (for resampling), or to vcfRGBA32 if m_DestFmt has alpha. */
+        syRowConverter m_ToRGB32;
+
+        /** Row converter from vcfRGB32 (or vcfRGBA32) to m_DestFmt (for resampling). */
+        syRowConverter m_FromRGB32;
+
         /** Source bytes per pixel obtained by Init(). Kept public to allow external modification. */
         unsigned int m_SourceBypp;
 
@@ -255,14 +230,58 @@ class syBitmapCopier {
         /** Destination pixel's y coordinates corresponding to source pixel (0,0) (for resampling). */
         unsigned int m_DestY0;
 
-        /** Filter for resampling */
-        syImageFilter* m_Filter;
+        /** Cached filter weights for resampling, obtained by Init(). */
+        syResampler* m_Resampler;
+
+        /** @brief Intermediate vcfRGB32 buffer for resampling.
+         *  Holds m_SourceHeight rows of m_EffectiveDestWidth pixels, already resampled horizontally.
+         */
+        unsigned char* m_ResampleBuffer;
+
+        /** @brief Temporary rows, allocated by ReserveScratch().
+         *  Each slot holds two source rows of m_SourceWidth + 1 vcfRGB32 pixels, followed by a row of m_DestWidth pixels.
+         */
+        std::vector<unsigned int> m_Scratch;
+
+        /** Number of pixels of each slot of m_Scratch, obtained by Init(). */
+        unsigned int m_ScratchSize;
+
+        /** Gets the first temporary source row of a slot. The second one starts m_SourceWidth + 1 pixels later. */
+        unsigned int* GetSourceScratch(unsigned int slot);
+
+        /** Gets the temporary destination row of a slot. */
+        unsigned int* GetDestScratch(unsigned int slot);
+
+        /** A black vcfRGB32 row of m_DestWidth pixels, for ClearYUVRow(). Obtained by Init() for YUV destinations. */
+        std::vector<unsigned int> m_BlackRow;
+
+        /** True if the source format has subsampled chroma (4:2:2 or 4:2:0), obtained by Init(). */
+        bool m_SourceSubsampled;
 
-        /** Contribution Destination buffer length (not size) in bytes */
-        syPixelContribBuffer *m_XContrib, *m_YContrib;
-        syFloatPixel *m_YBuffer, *m_FullBuffer;
+        /** True if the destination format is a YUV format, obtained by Init(). */
+        bool m_DestYUV;
 
-        void InitContribBuffers();
+        /** True if either the source or the destination is a planar format, obtained by Init(). */
+        bool m_Planar;
+
+        /** @brief Gets the plane addresses for the source row starting at row.
+         *  @param row The start of the row in the luma plane (or the only plane, for non-planar formats).
+         *  @param planes The array to hold the Y, U and V row addresses.
+         */
+        void GetSourcePlanes(const unsigned char* row, const unsigned char** planes);
+
+        /** @brief Gets the plane addresses for the destination row starting at row.
+         *  @param row The start of the row in the luma plane (or the only plane, for non-planar formats).
+         *  @param planes The array to hold the Y, U and V row addresses.
+         *  @note Since each chroma row is shared by two rows, the chroma addresses are NULL for odd rows.
+         */
+        void GetDestPlanes(unsigned char* row, unsigned char** planes);
+
+        /** Copies a row from / to a planar format. @see CopyRow */
+        void CopyPlanarRow(const unsigned char* src, unsigned char* dst);
+
+        /** Fills the row at dst with black for YUV formats. @see ClearRow */
+        void ClearYUVRow(unsigned char* dst);
 
         /** @brief Converts a pixel between two color formats.
          *  @param pixel The original pixel
@@ -272,37 +291,24 @@ class syBitmapCopier {
          */
         static unsigned long ConvertPixel(unsigned long pixel,VideoColorFormat sourcefmt,VideoColorFormat destfmt);
 
-        /** @brief Resamples a Row from a bitmap into the current floating-point pixel buffer.
+        /** @brief Resamples a Row from a bitmap horizontally into m_ResampleBuffer.
          *  This is done during the first stage of resampling.
          *  @param y Row to resample from the source bitmap.
+         *  @param slot The temporary rows to use. @see ReserveScratch
          */
-        void ResampleRow(unsigned int y);
+        void ResampleRow(unsigned int y, unsigned int slot);
 
-        /** @brief Resamples a Column from the floating-point pixel buffer into the destination bitmap.
-         *  This is done during the second and final stage of resampling.
-         *  @param x The current column to resample
+        /** @brief Resamples a destination row vertically from m_ResampleBuffer into the destination bitmap.
+         *  This is done during the second and final stage of resampling, after all the source rows
+         *  have been resampled. The rows outside the effective destination area are cleared.
+         *  @param y The destination row to resample.
+         *  @param slot The temporary rows to use. @see ReserveScratch
          */
-        void ResampleCol(unsigned int x);
+        void ResampleDestRow(unsigned int y, unsigned int slot);
 };
 
 inline void syBitmapCopier::CopyPixel() {
-    unsigned int i;
-    if(m_SourceFmt == m_DestFmt) {
-        for(i = 0; i < m_SourceBypp; ++i) {
-            m_Dst[i] = m_Src[i];
-        }
-    } else {
-        unsigned long pixel = 0;
-        // FIXME: Make sure we don't invert the R and B components in this code
-        for(i = 0; i < m_SourceBypp; ++i) {
-            pixel = (pixel << 8) | (m_Src[i] & 255);
-        }
-        pixel = syBitmapCopier::ConvertPixel(pixel, m_SourceFmt, m_DestFmt);
-        for(i = 0; i < m_DestBypp; ++i) {
-            m_Dst[i] = pixel & 255;
-            pixel >>= 8;
-        }
-    }
+    m_Converter.Convert(m_Src, m_Dst, 1);
 }
 
 inline void syBitmapCopier::CopyPixelAndIncrementSrc() {
@@ -322,34 +328,25 @@ inline void syBitmapCopier::CopyPixelAndIncrementBoth() {
 }
 
 inline void syBitmapCopier::CopyRow() {
-    if(m_SourceFmt == m_DestFmt) {
-        unsigned int maxlength = m_SourceRowLength;
-        if(maxlength > m_DestRowLength) {
-            maxlength = m_DestRowLength;
-        }
-        for(unsigned int j = 0; j < maxlength; ++j) {
-            m_Dst[j] = m_Src[j];
+    CopyRow(m_Src, m_Dst);
+}
+
+inline void syBitmapCopier::CopyRow(const unsigned char* src, unsigned char* dst) {
+    if(m_Planar) {
+        CopyPlanarRow(src, dst);
+    } else if(m_Converter.IsTrivial()) {
+        // The rows of a view may be followed by other pixels, so we only copy our own.
+        unsigned int maxlength = m_Source.GetRowLength();
+        if(maxlength > m_Dest.GetRowLength()) {
+            maxlength = m_Dest.GetRowLength();
         }
+        memcpy(dst, src, maxlength);
     } else {
         unsigned int maxw = m_SourceWidth;
         if(maxw > m_DestWidth) {
             maxw = m_DestWidth;
         }
-        const unsigned char* sourceptr = m_Src;
-        unsigned char* destptr = m_Dst;
-        for(unsigned int j = 0; j < maxw; ++j, sourceptr += m_SourceBypp, destptr += m_DestBypp) {
-            unsigned long pixel = 0;
-            unsigned int i;
-            // FIXME: Make sure we don't invert the R and B components in this code
-            for(i = 0; i < m_SourceBypp; ++i) {
-                pixel = (pixel << 8) | (sourceptr[i] & 255);
-            }
-            pixel = syBitmapCopier::ConvertPixel(pixel, m_SourceFmt, m_DestFmt);
-            for(i = 0; i < m_DestBypp; ++i) {
-                destptr[i] = pixel & 255;
-                pixel >>= 8;
-            }
-        }
+        m_Converter.Convert(src, dst, maxw);
     }
 }
 
@@ -364,9 +361,14 @@ inline void syBitmapCopier::FillRow(unsigned long pixel) {
 }
 
 inline void syBitmapCopier::ClearRow() {
-    unsigned char* destptr = m_Dst;
-    for(unsigned int j = 0; j < m_DestRowLength;  ++j, ++destptr) {
-        *destptr = 0;
+    ClearRow(m_Dst);
+}
+
+inline void syBitmapCopier::ClearRow(unsigned char* dst) {
+    if(m_DestYUV) {
+        ClearYUVRow(dst);
+    } else {
+        memset(dst, 0, m_Dest.GetRowLength());
     }
 }
 
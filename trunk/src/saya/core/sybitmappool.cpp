@@ -0,0 +1,243 @@
+/***************************************************************
+ * Name:      sybitmappool.cpp
+ * Purpose:   Implementation of the syBitmapPool class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syBitmapPool recycles the pixel buffers of the
+ *            syBitmaps, so that switching between clips of
+ *            different resolutions doesn't keep asking the
+ *            system for fresh memory.
+ **************************************************************/
+
+#include "sybitmappool.h"
+#include "sythread.h"
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#ifdef __WIN32__
+    #include <malloc.h>
+#else
+    #include <sys/mman.h>
+#endif
+
+/** Set when the pool is destroyed at exit; from then on, buffers go straight to the system. */
+static bool gs_PoolDestroyed = false;
+
+/** @brief Allocates an aligned buffer from the system.
+ *  @param size The size of the buffer, in bytes.
+ *  @param hugepages true to align big buffers to a huge page and ask for transparent huge pages.
+ */
+static unsigned char* syAlignedAlloc(unsigned long size, bool hugepages) {
+    #ifdef __WIN32__
+        return (unsigned char*)_aligned_malloc(size, syBitmapPool::Alignment);
+    #else
+        bool huge = hugepages && size >= syBitmapPool::HugePageSize;
+        void* ptr = 0;
+        if(posix_memalign(&ptr, huge ? syBitmapPool::HugePageSize : syBitmapPool::Alignment, size)) {
+            return 0;
+        }
+        #ifdef MADV_HUGEPAGE
+        if(huge) {
+            madvise(ptr, size, MADV_HUGEPAGE);
+        }
+        #endif
+        return (unsigned char*)ptr;
+    #endif
+}
+
+/** Frees a buffer allocated by syAlignedAlloc. */
+static void syAlignedFree(unsigned char* buffer) {
+    #ifdef __WIN32__
+        _aligned_free(buffer);
+    #else
+        free(buffer);
+    #endif
+}
+
+// ----------------------
+// Begin syBitmapPoolData
+// ----------------------
+
+class syBitmapPoolData {
+    public:
+        syBitmapPoolData();
+        ~syBitmapPoolData();
+
+        static syBitmapPoolData& Get();
+
+        /** Frees all the cached buffers. Must be called with m_Mutex locked. */
+        void Purge();
+
+        syMutex m_Mutex;
+
+        /** The released buffers, by size class */
+        std::map<unsigned long, std::vector<unsigned char*> > m_Free;
+
+        unsigned long long m_MaxCachedBytes;
+        bool m_UseHugePages;
+        syBitmapPoolStats m_Stats;
+};
+
+syBitmapPoolData::syBitmapPoolData() :
+m_MaxCachedBytes(268435456ULL),
+m_UseHugePages(false)
+{
+    m_Stats.m_Hits = 0;
+    m_Stats.m_Misses = 0;
+    m_Stats.m_BytesInUse = 0;
+    m_Stats.m_BytesCached = 0;
+    m_Stats.m_BytesResident = 0;
+}
+
+syBitmapPoolData::~syBitmapPoolData() {
+    {
+        syMutexLocker lock(m_Mutex);
+        Purge();
+    }
+    gs_PoolDestroyed = true;
+}
+
+syBitmapPoolData& syBitmapPoolData::Get() {
+    static syBitmapPoolData pool;
+    return pool;
+}
+
+void syBitmapPoolData::Purge() {
+    std::map<unsigned long, std::vector<unsigned char*> >::iterator it;
+    for(it = m_Free.begin(); it != m_Free.end(); ++it) {
+        std::vector<unsigned char*>& buffers = it->second;
+        for(unsigned int i = 0; i < buffers.size(); ++i) {
+            syAlignedFree(buffers[i]);
+        }
+        m_Stats.m_BytesCached -= (unsigned long long)(it->first)*buffers.size();
+        m_Stats.m_BytesResident -= (unsigned long long)(it->first)*buffers.size();
+    }
+    m_Free.clear();
+}
+
+// --------------------
+// End syBitmapPoolData
+// --------------------
+
+// ------------------
+// Begin syBitmapPool
+// ------------------
+
+unsigned long syBitmapPool::GetBucketSize(unsigned long size) {
+    if(size <= (Alignment << 2)) {
+        return (size + Alignment - 1) & ~(Alignment - 1);
+    }
+    // Four size classes per power of two: 1, 1.25, 1.5 and 1.75 times the power.
+    unsigned long power = Alignment << 2;
+    while((power << 1) <= size) {
+        power <<= 1;
+    }
+    unsigned long step = power >> 2;
+    return (size + step - 1) & ~(step - 1);
+}
+
+unsigned char* syBitmapPool::Allocate(unsigned long size, unsigned long* allocated) {
+    if(!size) {
+        size = 1;
+    }
+    size = GetBucketSize(size);
+    if(allocated) {
+        *allocated = size;
+    }
+    if(gs_PoolDestroyed) {
+        return syAlignedAlloc(size, false);
+    }
+
+    syBitmapPoolData& pool = syBitmapPoolData::Get();
+    bool hugepages;
+    {
+        syMutexLocker lock(pool.m_Mutex);
+        std::map<unsigned long, std::vector<unsigned char*> >::iterator it = pool.m_Free.find(size);
+        if(it != pool.m_Free.end() && !it->second.empty()) {
+            unsigned char* buffer = it->second.back();
+            it->second.pop_back();
+            ++pool.m_Stats.m_Hits;
+            pool.m_Stats.m_BytesCached -= size;
+            pool.m_Stats.m_BytesInUse += size;
+            return buffer;
+        }
+        ++pool.m_Stats.m_Misses;
+        hugepages = pool.m_UseHugePages;
+    }
+
+    unsigned char* buffer = syAlignedAlloc(size, hugepages);
+    syMutexLocker lock(pool.m_Mutex);
+    if(!buffer) {
+        // Give the cached memory back to the system and try again.
+        pool.Purge();
+        buffer = syAlignedAlloc(size, hugepages);
+        if(!buffer) {
+            return 0;
+        }
+    }
+    pool.m_Stats.m_BytesInUse += size;
+    pool.m_Stats.m_BytesResident += size;
+    return buffer;
+}
+
+void syBitmapPool::Release(unsigned char* buffer, unsigned long size) {
+    if(!buffer) {
+        return;
+    }
+    if(gs_PoolDestroyed) {
+        syAlignedFree(buffer);
+        return;
+    }
+    syBitmapPoolData& pool = syBitmapPoolData::Get();
+    syMutexLocker lock(pool.m_Mutex);
+    pool.m_Stats.m_BytesInUse -= size;
+    if(pool.m_Stats.m_BytesCached + size > pool.m_MaxCachedBytes) {
+        pool.m_Stats.m_BytesResident -= size;
+        lock.Unlock();
+        syAlignedFree(buffer);
+        return;
+    }
+    pool.m_Free[size].push_back(buffer);
+    pool.m_Stats.m_BytesCached += size;
+}
+
+void syBitmapPool::Purge() {
+    syBitmapPoolData& pool = syBitmapPoolData::Get();
+    syMutexLocker lock(pool.m_Mutex);
+    pool.Purge();
+}
+
+void syBitmapPool::SetMaxCachedBytes(unsigned long long bytes) {
+    syBitmapPoolData& pool = syBitmapPoolData::Get();
+    syMutexLocker lock(pool.m_Mutex);
+    pool.m_MaxCachedBytes = bytes;
+    if(pool.m_Stats.m_BytesCached > bytes) {
+        pool.Purge();
+    }
+}
+
+void syBitmapPool::SetUseHugePages(bool use) {
+    syBitmapPoolData& pool = syBitmapPoolData::Get();
+    syMutexLocker lock(pool.m_Mutex);
+    pool.m_UseHugePages = use;
+}
+
+syBitmapPoolStats syBitmapPool::GetStats() {
+    syBitmapPoolData& pool = syBitmapPoolData::Get();
+    syMutexLocker lock(pool.m_Mutex);
+    return pool.m_Stats;
+}
+
+void syBitmapPool::ResetStats() {
+    syBitmapPoolData& pool = syBitmapPoolData::Get();
+    syMutexLocker lock(pool.m_Mutex);
+    pool.m_Stats.m_Hits = 0;
+    pool.m_Stats.m_Misses = 0;
+}
+
+// ----------------
+// End syBitmapPool
+// ----------------
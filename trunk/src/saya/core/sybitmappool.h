@@ -0,0 +1,88 @@
+/***************************************************************
+ * Name:      sybitmappool.h
+ * Purpose:   Declaration for the syBitmapPool class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syBitmapPool recycles the pixel buffers of the
+ *            syBitmaps, so that switching between clips of
+ *            different resolutions doesn't keep asking the
+ *            system for fresh memory.
+ **************************************************************/
+
+#ifndef sybitmappool_h
+#define sybitmappool_h
+
+/** Statistics of the syBitmapPool. @see syBitmapPool::GetStats */
+struct syBitmapPoolStats {
+    /** Number of allocations served from a recycled buffer */
+    unsigned long m_Hits;
+
+    /** Number of allocations that had to ask the system for memory */
+    unsigned long m_Misses;
+
+    /** Bytes currently handed out to bitmaps */
+    unsigned long long m_BytesInUse;
+
+    /** Bytes currently held by the pool, waiting to be recycled */
+    unsigned long long m_BytesCached;
+
+    /** Total bytes allocated by the pool (in use + cached) */
+    unsigned long long m_BytesResident;
+};
+
+/** @brief Process-wide pool of aligned buffers for bitmaps.
+ *
+ *  Buffers are bucketed by size: each request is rounded up to the next of four size classes per power of two,
+ *  so that bitmaps of similar sizes share their buffers at the cost of at most 25% of wasted memory.
+ *  Released buffers are kept for later requests, up to a maximum amount of cached memory.
+ *
+ *  All buffers are aligned to syBitmapPool::Alignment bytes. On Linux, buffers of at least HugePageSize bytes
+ *  are aligned to HugePageSize and, if enabled with SetUseHugePages(), marked for transparent huge pages.
+ *
+ *  All the functions are thread-safe.
+ */
+class syBitmapPool {
+    public:
+        /** Alignment of the buffers, in bytes. Enough for the widest SIMD loads and a cache line. */
+        static const unsigned long Alignment = 64;
+
+        /** Size of a huge page, in bytes. */
+        static const unsigned long HugePageSize = 2097152;
+
+        /** @brief Gets a buffer.
+         *  @param size The minimum size of the buffer, in bytes.
+         *  @param allocated Receives the actual size of the buffer, which is always greater or equal than size.
+         *  @return The buffer, or NULL if there's not enough memory. The contents are undefined.
+         */
+        static unsigned char* Allocate(unsigned long size, unsigned long* allocated);
+
+        /** @brief Returns a buffer to the pool.
+         *  @param buffer The buffer obtained by Allocate(). May be NULL.
+         *  @param size The actual size given by Allocate().
+         */
+        static void Release(unsigned char* buffer, unsigned long size);
+
+        /** Frees all the cached buffers. */
+        static void Purge();
+
+        /** @brief Sets the maximum amount of memory kept for recycling.
+         *  Released buffers that don't fit are freed immediately. The default is 256 MB.
+         */
+        static void SetMaxCachedBytes(unsigned long long bytes);
+
+        /** Enables or disables transparent huge pages for big buffers. They're disabled by default. */
+        static void SetUseHugePages(bool use);
+
+        /** Gets the statistics of the pool. */
+        static syBitmapPoolStats GetStats();
+
+        /** Resets the hit and miss counters. */
+        static void ResetStats();
+
+        /** Returns the size class for a request of size bytes. */
+        static unsigned long GetBucketSize(unsigned long size);
+};
+
+#endif
@@ -0,0 +1,201 @@
+/***************************************************************
+ * Name:      sybitmapview.cpp
+ * Purpose:   Implementation of the syBitmapView class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syBitmapView refers to a rectangle of pixels inside
+ *            a syBitmap (or any other buffer) without copying
+ *            it, so that crops, picture-in-picture and tiled
+ *            processing can work in place.
+ **************************************************************/
+
+#include "sybitmapview.h"
+#include <cstddef>
+
+/** Returns true for the 4:2:2 formats, which store the pixels in pairs. */
+static bool sy_is_422_format(VideoColorFormat format) {
+    return (format == vcfYUY2 || format == vcfUYVY || format == vcfYVYU);
+}
+
+syBitmapView::syBitmapView() :
+m_Width(0),
+m_Height(0),
+m_ColorFormat(vcfRGB32),
+m_ColorMatrix(sy_cmbt601),
+m_ReadOnly(true),
+m_Bitmap(NULL)
+{
+    SetPlanes(NULL, 0);
+}
+
+syBitmapView::syBitmapView(unsigned char* buffer, unsigned int width, unsigned int height, VideoColorFormat colorformat, unsigned int bytesperline) :
+m_Width(width),
+m_Height(height),
+m_ColorFormat(colorformat),
+m_ColorMatrix(sy_cmbt601),
+m_ReadOnly(false),
+m_Bitmap(NULL)
+{
+    SetPlanes(buffer, bytesperline ? bytesperline : GetRowLength());
+}
+
+syBitmapView::syBitmapView(const unsigned char* buffer, unsigned int width, unsigned int height, VideoColorFormat colorformat, unsigned int bytesperline) :
+m_Width(width),
+m_Height(height),
+m_ColorFormat(colorformat),
+m_ColorMatrix(sy_cmbt601),
+m_ReadOnly(true),
+m_Bitmap(NULL)
+{
+    SetPlanes(const_cast<unsigned char*>(buffer), bytesperline ? bytesperline : GetRowLength());
+}
+
+void syBitmapView::SetPlanes(unsigned char* buffer, unsigned int bytesperline) {
+    m_Planes[0] = buffer;
+    m_BytesPerLine[0] = bytesperline;
+    m_Planes[1] = m_Planes[2] = NULL;
+    m_BytesPerLine[1] = m_BytesPerLine[2] = 0;
+    if(buffer && IsPlanar()) {
+        // Same layout as syBitmap: The luma plane, followed by two chroma planes of half the width and half the height.
+        unsigned long lumasize = (unsigned long)bytesperline*m_Height;
+        unsigned long chromasize = (unsigned long)(bytesperline / 2)*GetPlaneHeight(1);
+        // vcfYUV12 (I420) stores U before V; vcfYV12 stores V before U.
+        bool yv12 = (m_ColorFormat == vcfYV12);
+        m_Planes[1] = buffer + lumasize + (yv12 ? chromasize : 0);
+        m_Planes[2] = buffer + lumasize + (yv12 ? 0 : chromasize);
+        m_BytesPerLine[1] = m_BytesPerLine[2] = bytesperline / 2;
+    }
+}
+
+syBitmapView syBitmapView::GetSubView(int x, int y, unsigned int width, unsigned int height) const {
+    long x0 = x, y0 = y;
+    long x1 = x0 + (long)width, y1 = y0 + (long)height;
+    if(x0 < 0) {
+        x0 = 0;
+    }
+    if(y0 < 0) {
+        y0 = 0;
+    }
+    if(x1 > (long)m_Width) {
+        x1 = m_Width;
+    }
+    if(y1 > (long)m_Height) {
+        y1 = m_Height;
+    }
+    if(!IsOk() || x1 <= x0 || y1 <= y0) {
+        return syBitmapView();
+    }
+
+    // The chroma samples are shared by pairs of pixels (and rows, for 4:2:0), so we can't split them.
+    if(sy_is_422_format(m_ColorFormat) || IsPlanar()) {
+        x0 &= ~1L;
+    }
+    if(IsPlanar()) {
+        y0 &= ~1L;
+    }
+
+    syBitmapView result(*this);
+    result.m_Width = x1 - x0;
+    result.m_Height = y1 - y0;
+    result.m_Planes[0] += y0*m_BytesPerLine[0] + x0*GetBytesPerPixel();
+    if(IsPlanar()) {
+        for(unsigned int plane = 1; plane <= 2; ++plane) {
+            result.m_Planes[plane] += (y0 / 2)*m_BytesPerLine[plane] + x0 / 2;
+        }
+    }
+    return result;
+}
+
+bool syBitmapView::IsOk() const {
+    return m_Planes[0] && m_Width && m_Height;
+}
+
+bool syBitmapView::IsReadOnly() const {
+    return m_ReadOnly;
+}
+
+unsigned int syBitmapView::GetWidth() const {
+    return m_Width;
+}
+
+unsigned int syBitmapView::GetHeight() const {
+    return m_Height;
+}
+
+VideoColorFormat syBitmapView::GetColorFormat() const {
+    return m_ColorFormat;
+}
+
+unsigned int syBitmapView::GetBytesPerPixel() const {
+    return syBitmap::CalculateBytesperPixel(m_ColorFormat);
+}
+
+unsigned int syBitmapView::GetBytesPerLine() const {
+    return m_BytesPerLine[0];
+}
+
+unsigned int syBitmapView::GetRowLength() const {
+    if(sy_is_422_format(m_ColorFormat)) {
+        return ((m_Width + 1) & ~1) * 2;
+    }
+    return m_Width*GetBytesPerPixel();
+}
+
+bool syBitmapView::IsPlanar() const {
+    return syBitmap::IsPlanarFormat(m_ColorFormat);
+}
+
+unsigned int syBitmapView::GetPlaneBytesPerLine(unsigned int plane) const {
+    return (plane <= 2) ? m_BytesPerLine[plane] : 0;
+}
+
+unsigned int syBitmapView::GetPlaneHeight(unsigned int plane) const {
+    if(plane == 0) {
+        return m_Height;
+    }
+    return (plane <= 2 && IsPlanar()) ? (m_Height + 1) / 2 : 0;
+}
+
+const unsigned char* syBitmapView::GetReadOnlyRow(int y) const {
+    return GetReadOnlyPlaneRow(0, y);
+}
+
+unsigned char* syBitmapView::GetRow(int y) const {
+    return GetPlaneRow(0, y);
+}
+
+const unsigned char* syBitmapView::GetReadOnlyPlaneRow(unsigned int plane, int y) const {
+    if(!IsOk() || y < 0 || y >= (int)GetPlaneHeight(plane)) {
+        return NULL;
+    }
+    return m_Planes[plane] + (unsigned long)m_BytesPerLine[plane]*y;
+}
+
+unsigned char* syBitmapView::GetPlaneRow(unsigned int plane, int y) const {
+    if(m_ReadOnly) {
+        return NULL;
+    }
+    return const_cast<unsigned char*>(GetReadOnlyPlaneRow(plane, y));
+}
+
+void syBitmapView::SetColorMatrix(syColorMatrix matrix) {
+    m_ColorMatrix = matrix;
+}
+
+syColorMatrix syBitmapView::GetColorMatrix() const {
+    return m_ColorMatrix;
+}
+
+syBitmap* syBitmapView::GetBitmap() const {
+    return m_Bitmap;
+}
+
+void syBitmapView::PasteFrom(const syBitmapView& source, syStretchMode stretchmode, syFilterType filtertype) {
+    syBitmap::PasteView(source, *this, stretchmode, filtertype);
+}
+
+void syBitmapView::ResampleFrom(const syBitmapView& source, syFilterType resamplemode) {
+    syBitmap::ResampleView(source, *this, resamplemode);
+}
@@ -0,0 +1,140 @@
+/***************************************************************
+ * Name:      sybitmapview.h
+ * Purpose:   Declaration for the syBitmapView class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syBitmapView refers to a rectangle of pixels inside
+ *            a syBitmap (or any other buffer) without copying
+ *            it, so that crops, picture-in-picture and tiled
+ *            processing can work in place.
+ **************************************************************/
+
+#ifndef sybitmapview_h
+#define sybitmapview_h
+
+#include "videocolorformat.h"
+#include "imagefilters.h"
+#include "sybitmap.h"
+
+/** @brief A strided rectangle of pixels that belongs to somebody else.
+ *
+ *  A view is only a set of row pointers, strides, dimensions and a color format, so it's cheap to create and
+ *  to pass by value. It doesn't own the pixels: The bitmap or buffer must outlive the view, and it must not be
+ *  reallocated (or shared again with syBitmap::CopyFrom) while the view is in use.
+ *
+ *  Get views of a syBitmap with syBitmap::GetView() (writable) or syBitmap::GetReadOnlyView().
+ *  For the formats with subsampled chroma, the left column of a sub-view must be even, and for 4:2:0 formats
+ *  the top row must be even too. GetSubView() rounds them down.
+ */
+class syBitmapView {
+    public:
+        /** Creates an empty view. */
+        syBitmapView();
+
+        /** @brief Creates a writable view of a raw buffer.
+         *  @param buffer The first row of pixels.
+         *  @param width The width in pixels.
+         *  @param height The height in pixels.
+         *  @param colorformat The color format of the pixels.
+         *  @param bytesperline The distance in bytes between two rows. If zero, the rows are packed together.
+         *  @note For planar formats, the chroma planes must follow the luma plane, just like in syBitmap.
+         */
+        syBitmapView(unsigned char* buffer, unsigned int width, unsigned int height, VideoColorFormat colorformat, unsigned int bytesperline = 0);
+
+        /** Creates a read-only view of a raw buffer. @see syBitmapView(unsigned char*, unsigned int, unsigned int, VideoColorFormat, unsigned int) */
+        syBitmapView(const unsigned char* buffer, unsigned int width, unsigned int height, VideoColorFormat colorformat, unsigned int bytesperline = 0);
+
+        /** @brief Gets a view of a part of this view.
+         *  @return The view of the given rectangle, clipped to this view's rectangle. It may be empty.
+         */
+        syBitmapView GetSubView(int x, int y, unsigned int width, unsigned int height) const;
+
+        /** Returns true if the view has pixels. */
+        bool IsOk() const;
+
+        /** Returns true if the pixels must not be written to. */
+        bool IsReadOnly() const;
+
+        /** Gets the width in pixels. */
+        unsigned int GetWidth() const;
+
+        /** Gets the height in pixels. */
+        unsigned int GetHeight() const;
+
+        /** Gets the color format. */
+        VideoColorFormat GetColorFormat() const;
+
+        /** Gets the bytes per pixel (of the luma plane, for planar formats). */
+        unsigned int GetBytesPerPixel() const;
+
+        /** Gets the distance in bytes between two rows (of the luma plane, for planar formats). */
+        unsigned int GetBytesPerLine() const;
+
+        /** Gets the number of bytes taken by the pixels of a row, which may be less than GetBytesPerLine(). */
+        unsigned int GetRowLength() const;
+
+        /** Returns true if the color format is planar. */
+        bool IsPlanar() const;
+
+        /** Gets the distance in bytes between two rows of the given plane. */
+        unsigned int GetPlaneBytesPerLine(unsigned int plane) const;
+
+        /** Gets the number of rows of the given plane. */
+        unsigned int GetPlaneHeight(unsigned int plane) const;
+
+        /** Gets a row for reading. @return NULL if y is out of bounds. */
+        const unsigned char* GetReadOnlyRow(int y) const;
+
+        /** Gets a row for writing. @return NULL if y is out of bounds, or if the view is read-only. */
+        unsigned char* GetRow(int y) const;
+
+        /** Gets a row of the given plane for reading. @see syBitmap::GetReadOnlyPlaneRow */
+        const unsigned char* GetReadOnlyPlaneRow(unsigned int plane, int y) const;
+
+        /** Gets a row of the given plane for writing. @return NULL if the view is read-only. */
+        unsigned char* GetPlaneRow(unsigned int plane, int y) const;
+
+        /** Sets the matrix used to convert the YUV pixels from / to RGB. */
+        void SetColorMatrix(syColorMatrix matrix);
+
+        /** Gets the matrix used to convert the YUV pixels from / to RGB. */
+        syColorMatrix GetColorMatrix() const;
+
+        /** Gets the bitmap that owns the pixels of a writable view; NULL for raw buffers and read-only views. */
+        syBitmap* GetBitmap() const;
+
+        /** @brief Pastes from another view, resizing if necessary. @see syBitmap::PasteFrom
+         *  @warning The views must not overlap.
+         */
+        void PasteFrom(const syBitmapView& source, syStretchMode stretchmode = sy_stkeepaspectratio, syFilterType filtertype = filter_none);
+
+        /** @brief Resamples from another view using the given resample algorithm. @see syBitmap::ResampleFrom
+         *  @warning The views must not overlap.
+         */
+        void ResampleFrom(const syBitmapView& source, syFilterType resamplemode = filter_lanczos4);
+
+    private:
+        /** Sets the plane pointers for a buffer laid out like a syBitmap's. */
+        void SetPlanes(unsigned char* buffer, unsigned int bytesperline);
+
+        /** The row (0, 0) of each plane */
+        unsigned char* m_Planes[3];
+
+        /** The bytes per line of each plane */
+        unsigned int m_BytesPerLine[3];
+
+        unsigned int m_Width;
+        unsigned int m_Height;
+        VideoColorFormat m_ColorFormat;
+        syColorMatrix m_ColorMatrix;
+        bool m_ReadOnly;
+
+        /** The bitmap that owns the pixels (writable views only) */
+        syBitmap* m_Bitmap;
+
+        friend class syBitmap;
+};
+
+#endif
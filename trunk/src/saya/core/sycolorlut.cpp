@@ -0,0 +1,543 @@
+/***************************************************************
+ * Name:      sycolorlut.cpp
+ * Purpose:   Implementation of the syColorLUT class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syColorLUT applies a 3D color lookup table (i.e.
+ *            a color grade loaded from a .cube file) to the
+ *            pixels of a bitmap, in a single pass.
+ **************************************************************/
+
+#include "sycolorlut.h"
+#include "syrowconverter.h"
+#include "syworkerpool.h"
+#include "iocommon.h"
+#include "systring.h"
+#include "sysimd.h"
+#include <cstring>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ----------------------
+// Begin syColorLUT::Data
+// ----------------------
+
+/** The table's state is also the band task run by Apply(). */
+class syColorLUT::Data : public syBandTask {
+    public:
+        Data();
+        virtual ~Data() {}
+
+        /** Fills m_Offsets and m_Fractions for the current size and domain. */
+        void CalculateAxes();
+
+        /** @brief Finds the tetrahedron of grid points around a color.
+         *  @param c Receives the four entries of m_Table.
+         *  @param w Receives their weights, which add up to 1.
+         */
+        void FindTetrahedron(unsigned int r, unsigned int g, unsigned int b, const float** c, float* w) const;
+
+        /** @brief Transforms a row of pixels with the fastest kernel available.
+         *  R, G and B are the byte offsets of the components; BYPP is the number of bytes per pixel.
+         *  ALPHA tells whether the fourth byte holds a premultiplied alpha.
+         */
+        template<int R, int G, int B, int BYPP, bool ALPHA> void Transform(unsigned char* row, unsigned int width) const;
+
+        /** Scalar kernel for Transform() */
+        template<int R, int G, int B, int BYPP, bool ALPHA> void TransformRow(unsigned char* row, unsigned int width) const;
+
+        #ifdef SY_X86_SIMD
+        /** SSE2 kernel for Transform(). Transforms four pixels at a time. */
+        template<int R, int G, int B, int BYPP, bool ALPHA> SY_TARGET_SSE2 void TransformRowSSE2(unsigned char* row, unsigned int width) const;
+        #endif
+
+        /** Calls the Transform() that fits the color format; returns false if the format isn't RGB. */
+        bool TransformRGBRow(VideoColorFormat format, unsigned char* row, unsigned int width) const;
+
+        virtual void ProcessBand(unsigned int first, unsigned int last, unsigned int slot);
+
+        unsigned int m_Size;
+
+        /** The output colors, scaled to 0-255, with red varying fastest. Each entry is padded to four floats. */
+        std::vector<float> m_Table;
+
+        float m_DomainMin[3];
+        float m_DomainMax[3];
+
+        /** For each component and input value, the offset of its lower grid point inside m_Table. */
+        unsigned int m_Offsets[3][256];
+
+        /** For each component and input value, its distance from the lower grid point (0.0 to 1.0). */
+        float m_Fractions[3][256];
+
+        syString m_Title;
+
+        /** The view being transformed by Apply() */
+        syBitmapView m_View;
+
+        /** Converts m_View's rows into vcfRGB32 and back, when it isn't an RGB format. */
+        syRowConverter m_ToRGB32;
+        syRowConverter m_FromRGB32;
+
+        /** Two vcfRGB32 rows of m_View's width for each slot of the worker pool (for the non-RGB formats), sized by Apply(). */
+        std::vector<unsigned int> m_Scratch;
+
+    protected:
+        virtual bool InternalMustAbort() { return m_View.GetBitmap() && m_View.GetBitmap()->MustAbort(); }
+};
+
+syColorLUT::Data::Data() :
+m_Size(0)
+{
+    for(unsigned int i = 0; i < 3; ++i) {
+        m_DomainMin[i] = 0.0f;
+        m_DomainMax[i] = 1.0f;
+    }
+}
+
+void syColorLUT::Data::CalculateAxes() {
+    if(m_Size < MinSize) {
+        return;
+    }
+    unsigned int strides[3] = { 4, 4*m_Size, 4*m_Size*m_Size };
+    for(unsigned int axis = 0; axis < 3; ++axis) {
+        float range = m_DomainMax[axis] - m_DomainMin[axis];
+        for(unsigned int i = 0; i < 256; ++i) {
+            float t = (range > 0.0f) ? ((i / 255.0f) - m_DomainMin[axis]) / range : 0.0f;
+            if(t < 0.0f) {
+                t = 0.0f;
+            } else if(t > 1.0f) {
+                t = 1.0f;
+            }
+            float pos = t*(m_Size - 1);
+            unsigned int index = (unsigned int)pos;
+            if(index > m_Size - 2) {
+                index = m_Size - 2;
+            }
+            m_Offsets[axis][i] = index*strides[axis];
+            m_Fractions[axis][i] = pos - index;
+        }
+    }
+}
+
+/** Undoes the premultiplication of a color component, so that the table sees the actual color. */
+static inline unsigned int sy_unpremultiply(unsigned int c, unsigned int a) {
+    return (c >= a) ? 255 : (c*255 + (a >> 1)) / a;
+}
+
+/** Multiplies a color component by the alpha, rounding to the nearest. */
+static inline unsigned char sy_premultiply(unsigned int c, unsigned int a) {
+    unsigned int t = c*a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+/** @brief The six tetrahedra that split the unit cube along its main diagonal.
+ *  Each one is given by the order of the components (0 = red, 1 = green, 2 = blue) from the largest fraction
+ *  to the smallest, indexed by (fr > fg) * 4 + (fg > fb) * 2 + (fr > fb). Indices 1 and 6 can't happen.
+ */
+static const unsigned char sy_tetrahedra[8][3] = {
+    { 2, 1, 0 }, { 2, 1, 0 }, { 1, 2, 0 }, { 1, 0, 2 }, { 2, 0, 1 }, { 0, 2, 1 }, { 0, 1, 2 }, { 0, 1, 2 }
+};
+
+inline void syColorLUT::Data::FindTetrahedron(unsigned int r, unsigned int g, unsigned int b, const float** c, float* w) const {
+    // Picking the tetrahedron with a lookup instead of branches keeps noisy images from stalling the pipeline.
+    const unsigned int strides[3] = { 4, 4*m_Size, 4*m_Size*m_Size };
+    const float f[3] = { m_Fractions[0][r], m_Fractions[1][g], m_Fractions[2][b] };
+    const unsigned char* order = sy_tetrahedra[((f[0] > f[1]) << 2) | ((f[1] > f[2]) << 1) | (f[0] > f[2])];
+    c[0] = &m_Table[0] + m_Offsets[0][r] + m_Offsets[1][g] + m_Offsets[2][b];
+    c[1] = c[0] + strides[order[0]];
+    c[2] = c[1] + strides[order[1]];
+    c[3] = c[2] + strides[order[2]];
+    w[0] = 1.0f - f[order[0]];
+    w[1] = f[order[0]] - f[order[1]];
+    w[2] = f[order[1]] - f[order[2]];
+    w[3] = f[order[2]];
+}
+
+template<int R, int G, int B, int BYPP, bool ALPHA> void syColorLUT::Data::TransformRow(unsigned char* row, unsigned int width) const {
+    for(; width; --width, row += BYPP) {
+        unsigned int r = row[R], g = row[G], b = row[B], a = ALPHA ? row[3] : 255;
+        if(!a) {
+            continue;
+        }
+        if(a < 255) {
+            r = sy_unpremultiply(r, a);
+            g = sy_unpremultiply(g, a);
+            b = sy_unpremultiply(b, a);
+        }
+        const float* c[4];
+        float w[4];
+        FindTetrahedron(r, g, b, c, w);
+        unsigned char out[3];
+        for(unsigned int k = 0; k < 3; ++k) {
+            int v = (int)(w[0]*c[0][k] + w[1]*c[1][k] + w[2]*c[2][k] + w[3]*c[3][k] + 0.5f);
+            out[k] = (v < 0) ? 0 : ((v > 255) ? 255 : v);
+            if(a < 255) {
+                out[k] = sy_premultiply(out[k], a);
+            }
+        }
+        row[R] = out[0];
+        row[G] = out[1];
+        row[B] = out[2];
+    }
+}
+
+#ifdef SY_X86_SIMD
+
+// The SSE2 version transforms four pixels at a time, in SoA form: each vector holds the same value (a fraction,
+// a weight, a table index, a component) for the four pixels. It gives exactly the same results as the scalar one.
+
+/** Picks a in the lanes where mask is set, and b in the others. */
+static inline SY_TARGET_SSE2 __m128i sy_select_epi32(__m128 mask, __m128i a, __m128i b) {
+    __m128i m = _mm_castps_si128(mask);
+    return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+template<int R, int G, int B, int BYPP, bool ALPHA> SY_TARGET_SSE2 void syColorLUT::Data::TransformRowSSE2(unsigned char* row, unsigned int width) const {
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fourthbyte = _mm_set1_epi32(0xFF000000);
+    const __m128i rstride = _mm_set1_epi32(4);
+    const __m128i gstride = _mm_set1_epi32(4*m_Size);
+    const __m128i bstride = _mm_set1_epi32(4*m_Size*m_Size);
+    const __m128i allstrides = _mm_add_epi32(rstride, _mm_add_epi32(gstride, bstride));
+    const float* table = &m_Table[0];
+    unsigned int r[4], g[4], b[4], i, j;
+    int corners[4][4];
+    for(; width >= 4; width -= 4, row += 4*BYPP) {
+        if(ALPHA && (row[3] & row[7] & row[11] & row[15]) != 255) {
+            // The translucent pixels must be unpremultiplied first.
+            TransformRow<R, G, B, BYPP, ALPHA>(row, 4);
+            continue;
+        }
+        for(i = 0; i < 4; ++i) {
+            r[i] = row[i*BYPP + R];
+            g[i] = row[i*BYPP + G];
+            b[i] = row[i*BYPP + B];
+        }
+        __m128 fr = _mm_setr_ps(m_Fractions[0][r[0]], m_Fractions[0][r[1]], m_Fractions[0][r[2]], m_Fractions[0][r[3]]);
+        __m128 fg = _mm_setr_ps(m_Fractions[1][g[0]], m_Fractions[1][g[1]], m_Fractions[1][g[2]], m_Fractions[1][g[3]]);
+        __m128 fb = _mm_setr_ps(m_Fractions[2][b[0]], m_Fractions[2][b[1]], m_Fractions[2][b[2]], m_Fractions[2][b[3]]);
+        __m128i base = _mm_setr_epi32(m_Offsets[0][r[0]] + m_Offsets[1][g[0]] + m_Offsets[2][b[0]],
+                                      m_Offsets[0][r[1]] + m_Offsets[1][g[1]] + m_Offsets[2][b[1]],
+                                      m_Offsets[0][r[2]] + m_Offsets[1][g[2]] + m_Offsets[2][b[2]],
+                                      m_Offsets[0][r[3]] + m_Offsets[1][g[3]] + m_Offsets[2][b[3]]);
+
+        // Sort the fractions; the weights are the differences between them (see FindTetrahedron()).
+        __m128 hi = _mm_max_ps(fr, _mm_max_ps(fg, fb));
+        __m128 lo = _mm_min_ps(fr, _mm_min_ps(fg, fb));
+        __m128 mid = _mm_max_ps(_mm_min_ps(fr, fg), _mm_min_ps(_mm_max_ps(fr, fg), fb));
+        __m128 weights[4] = { _mm_sub_ps(one, hi), _mm_sub_ps(hi, mid), _mm_sub_ps(mid, lo), lo };
+
+        // The second corner steps along the largest fraction; the third one, along all but the smallest.
+        // Ties pick the same corners as sy_tetrahedra.
+        __m128 rg = _mm_cmpgt_ps(fr, fg), gb = _mm_cmpgt_ps(fg, fb), rb = _mm_cmpgt_ps(fr, fb);
+        __m128i first = sy_select_epi32(_mm_and_ps(rg, rb), rstride, sy_select_epi32(_mm_andnot_ps(rg, gb), gstride, bstride));
+        __m128i last = sy_select_epi32(_mm_and_ps(rb, gb), bstride, sy_select_epi32(_mm_andnot_ps(gb, rg), gstride, rstride));
+        __m128i opposite = _mm_add_epi32(base, allstrides);
+        _mm_storeu_si128((__m128i*)corners[0], base);
+        _mm_storeu_si128((__m128i*)corners[1], _mm_add_epi32(base, first));
+        _mm_storeu_si128((__m128i*)corners[2], _mm_sub_epi32(opposite, last));
+        _mm_storeu_si128((__m128i*)corners[3], opposite);
+
+        // Transposing the entries of a corner for the four pixels gives their red, green and blue.
+        __m128 red = _mm_setzero_ps(), green = _mm_setzero_ps(), blue = _mm_setzero_ps();
+        for(j = 0; j < 4; ++j) {
+            __m128 e0 = _mm_loadu_ps(table + corners[j][0]);
+            __m128 e1 = _mm_loadu_ps(table + corners[j][1]);
+            __m128 e2 = _mm_loadu_ps(table + corners[j][2]);
+            __m128 e3 = _mm_loadu_ps(table + corners[j][3]);
+            _MM_TRANSPOSE4_PS(e0, e1, e2, e3);
+            if(!j) {
+                red = _mm_mul_ps(weights[0], e0);
+                green = _mm_mul_ps(weights[0], e1);
+                blue = _mm_mul_ps(weights[0], e2);
+            } else {
+                red = _mm_add_ps(red, _mm_mul_ps(weights[j], e0));
+                green = _mm_add_ps(green, _mm_mul_ps(weights[j], e1));
+                blue = _mm_add_ps(blue, _mm_mul_ps(weights[j], e2));
+            }
+        }
+
+        // Round and saturate into bytes: the first component of the four pixels, then the second, then the third.
+        __m128i c0 = _mm_cvttps_epi32(_mm_add_ps((R == 0) ? red : blue, half));
+        __m128i c1 = _mm_cvttps_epi32(_mm_add_ps(green, half));
+        __m128i c2 = _mm_cvttps_epi32(_mm_add_ps((R == 0) ? blue : red, half));
+        __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, zero));
+        if(BYPP == 4) {
+            // Interleave them into pixels, keeping the fourth byte.
+            __m128i c01 = _mm_unpacklo_epi8(bytes, _mm_srli_si128(bytes, 4));
+            __m128i c2x = _mm_unpacklo_epi8(_mm_srli_si128(bytes, 8), zero);
+            __m128i pixels = _mm_unpacklo_epi16(c01, c2x);
+            pixels = _mm_or_si128(pixels, _mm_and_si128(_mm_loadu_si128((const __m128i*)row), fourthbyte));
+            _mm_storeu_si128((__m128i*)row, pixels);
+        } else {
+            unsigned int packed[4];
+            _mm_storeu_si128((__m128i*)packed, bytes);
+            for(i = 0; i < 4; ++i) {
+                row[i*BYPP] = packed[0] >> (i << 3);
+                row[i*BYPP + 1] = packed[1] >> (i << 3);
+                row[i*BYPP + 2] = packed[2] >> (i << 3);
+            }
+        }
+    }
+    if(width) {
+        TransformRow<R, G, B, BYPP, ALPHA>(row, width);
+    }
+}
+
+#endif
+
+template<int R, int G, int B, int BYPP, bool ALPHA> void syColorLUT::Data::Transform(unsigned char* row, unsigned int width) const {
+    #ifdef SY_X86_SIMD
+    if(syRowConverter::HasSSE2()) {
+        TransformRowSSE2<R, G, B, BYPP, ALPHA>(row, width);
+        return;
+    }
+    #endif
+    TransformRow<R, G, B, BYPP, ALPHA>(row, width);
+}
+
+bool syColorLUT::Data::TransformRGBRow(VideoColorFormat format, unsigned char* row, unsigned int width) const {
+    switch(format) {
+        case vcfRGB32:
+            Transform<0, 1, 2, 4, false>(row, width);
+            break;
+        case vcfBGR32:
+            Transform<2, 1, 0, 4, false>(row, width);
+            break;
+        case vcfRGB24:
+        case vcfRGB24_Line32:
+            Transform<0, 1, 2, 3, false>(row, width);
+            break;
+        case vcfBGR24:
+        case vcfBGR24_Line32:
+            Transform<2, 1, 0, 3, false>(row, width);
+            break;
+        case vcfRGBA32:
+            Transform<0, 1, 2, 4, true>(row, width);
+            break;
+        case vcfBGRA32:
+            Transform<2, 1, 0, 4, true>(row, width);
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+void syColorLUT::Data::ProcessBand(unsigned int first, unsigned int last, unsigned int slot) {
+    VideoColorFormat format = m_View.GetColorFormat();
+    unsigned int width = m_View.GetWidth();
+    unsigned int y;
+    if(TransformRGBRow(format, m_View.GetRow(first), width)) {
+        for(y = first + 1; y < last; ++y) {
+            TransformRGBRow(format, m_View.GetRow(y), width);
+        }
+        return;
+    }
+
+    // Other formats are transformed in vcfRGB32. The rows of 4:2:0 formats go in pairs, since they share
+    // their chroma; bands always start at an even row.
+    unsigned int* rgbrows[2] = { &m_Scratch[(slot*width) << 1], &m_Scratch[((slot*width) << 1) + width] };
+    unsigned int pairs = m_View.IsPlanar() ? 2 : 1;
+    for(y = first; y < last; y += pairs) {
+        unsigned int count = (y + pairs <= last) ? pairs : last - y;
+        unsigned int i;
+        for(i = 0; i < count; ++i) {
+            const unsigned char* srcplanes[3] = { m_View.GetReadOnlyRow(y + i), 0, 0 };
+            if(m_View.IsPlanar()) {
+                srcplanes[1] = m_View.GetReadOnlyPlaneRow(1, y >> 1);
+                srcplanes[2] = m_View.GetReadOnlyPlaneRow(2, y >> 1);
+            }
+            unsigned char* rgbrow = (unsigned char*)rgbrows[i];
+            m_ToRGB32.Convert(srcplanes, &rgbrow, width);
+            Transform<0, 1, 2, 4, false>(rgbrow, width);
+        }
+        for(i = 0; i < count; ++i) {
+            const unsigned char* rgbrow = (const unsigned char*)rgbrows[i];
+            unsigned char* dstplanes[3] = { m_View.GetRow(y + i), 0, 0 };
+            if(m_View.IsPlanar() && i == 0) {
+                dstplanes[1] = m_View.GetPlaneRow(1, y >> 1);
+                dstplanes[2] = m_View.GetPlaneRow(2, y >> 1);
+            }
+            m_FromRGB32.Convert(&rgbrow, dstplanes, width);
+        }
+    }
+}
+
+// --------------------
+// End syColorLUT::Data
+// --------------------
+
+// ----------------
+// Begin syColorLUT
+// ----------------
+
+syColorLUT::syColorLUT() {
+    m_Data = new Data;
+}
+
+syColorLUT::~syColorLUT() {
+    delete m_Data;
+}
+
+bool syColorLUT::Create(unsigned int size) {
+    if(size < MinSize || size > MaxSize) {
+        return false;
+    }
+    m_Data->m_Size = size;
+    m_Data->m_Table.assign(4*size*size*size, 0.0f);
+    m_Data->m_Title = "";
+    for(unsigned int b = 0; b < size; ++b) {
+        for(unsigned int g = 0; g < size; ++g) {
+            for(unsigned int r = 0; r < size; ++r) {
+                SetEntry(r, g, b, (float)r / (size - 1), (float)g / (size - 1), (float)b / (size - 1));
+            }
+        }
+    }
+    SetDomain(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+    return true;
+}
+
+bool syColorLUT::LoadCube(const char* filename) {
+    FFile file;
+    syString contents;
+    if(!file.Open(filename, "r") || !file.ReadAll(contents)) {
+        return false;
+    }
+    return ParseCube(contents.c_str());
+}
+
+bool syColorLUT::LoadCube(const syString& filename) {
+    return LoadCube(filename.c_str());
+}
+
+bool syColorLUT::ParseCube(const char* text) {
+    if(!text) {
+        return false;
+    }
+    unsigned int size = 0;
+    float domainmin[3] = { 0.0f, 0.0f, 0.0f };
+    float domainmax[3] = { 1.0f, 1.0f, 1.0f };
+    std::string title;
+    std::vector<float> entries;
+
+    // The numbers always use a decimal point, whatever the user's locale says.
+    std::istringstream input(text);
+    std::string line;
+    while(std::getline(input, line)) {
+        std::istringstream fields(line);
+        fields.imbue(std::locale::classic());
+        std::string keyword;
+        if(!(fields >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+        if(keyword == "TITLE") {
+            std::string::size_type quote0 = line.find('"'), quote1 = line.rfind('"');
+            if(quote0 != std::string::npos && quote1 > quote0) {
+                title = line.substr(quote0 + 1, quote1 - quote0 - 1);
+            }
+        } else if(keyword == "LUT_3D_SIZE") {
+            if(!(fields >> size) || size < MinSize || size > MaxSize) {
+                return false;
+            }
+            entries.reserve(3*size*size*size);
+        } else if(keyword == "LUT_1D_SIZE") {
+            return false; // 1D tables aren't supported
+        } else if(keyword == "DOMAIN_MIN") {
+            fields >> domainmin[0] >> domainmin[1] >> domainmin[2];
+        } else if(keyword == "DOMAIN_MAX") {
+            fields >> domainmax[0] >> domainmax[1] >> domainmax[2];
+        } else if(keyword == "LUT_3D_INPUT_RANGE") {
+            fields >> domainmin[0] >> domainmax[0];
+            domainmin[1] = domainmin[2] = domainmin[0];
+            domainmax[1] = domainmax[2] = domainmax[0];
+        } else if((keyword[0] >= '0' && keyword[0] <= '9') || keyword[0] == '-' || keyword[0] == '+' || keyword[0] == '.') {
+            std::istringstream first(keyword);
+            first.imbue(std::locale::classic());
+            float value[3];
+            if(!(first >> value[0]) || !(fields >> value[1] >> value[2])) {
+                return false;
+            }
+            entries.insert(entries.end(), value, value + 3);
+        }
+        // Other keywords (i.e. from newer versions of the format) are ignored.
+    }
+    if(!size || entries.size() != 3*size*size*size) {
+        return false;
+    }
+
+    m_Data->m_Size = size;
+    m_Data->m_Table.assign(4*size*size*size, 0.0f);
+    m_Data->m_Title = title.c_str();
+    for(unsigned int i = 0; i < size*size*size; ++i) {
+        for(unsigned int k = 0; k < 3; ++k) {
+            m_Data->m_Table[4*i + k] = entries[3*i + k]*255.0f;
+        }
+    }
+    SetDomain(domainmin[0], domainmin[1], domainmin[2], domainmax[0], domainmax[1], domainmax[2]);
+    return true;
+}
+
+bool syColorLUT::IsOk() const {
+    return m_Data->m_Size >= MinSize;
+}
+
+unsigned int syColorLUT::GetSize() const {
+    return m_Data->m_Size;
+}
+
+const syString& syColorLUT::GetTitle() const {
+    return m_Data->m_Title;
+}
+
+void syColorLUT::SetEntry(unsigned int r, unsigned int g, unsigned int b, float red, float green, float blue) {
+    unsigned int size = m_Data->m_Size;
+    if(r >= size || g >= size || b >= size) {
+        return;
+    }
+    float* entry = &m_Data->m_Table[4*((b*size + g)*size + r)];
+    entry[0] = red*255.0f;
+    entry[1] = green*255.0f;
+    entry[2] = blue*255.0f;
+}
+
+void syColorLUT::SetDomain(float rmin, float gmin, float bmin, float rmax, float gmax, float bmax) {
+    m_Data->m_DomainMin[0] = rmin;
+    m_Data->m_DomainMin[1] = gmin;
+    m_Data->m_DomainMin[2] = bmin;
+    m_Data->m_DomainMax[0] = rmax;
+    m_Data->m_DomainMax[1] = gmax;
+    m_Data->m_DomainMax[2] = bmax;
+    m_Data->CalculateAxes();
+}
+
+bool syColorLUT::Apply(syBitmap* bitmap) {
+    if(!bitmap || !bitmap->GetWidth() || !bitmap->GetHeight()) {
+        return false;
+    }
+    return Apply(bitmap->GetView());
+}
+
+bool syColorLUT::Apply(const syBitmapView& view) {
+    if(!IsOk() || !view.IsOk() || view.IsReadOnly()) {
+        return false;
+    }
+    m_Data->m_View = view;
+    m_Data->m_ToRGB32.Init(view.GetColorFormat(), vcfRGB32, view.GetColorMatrix());
+    m_Data->m_FromRGB32.Init(vcfRGB32, view.GetColorFormat(), sy_cmbt601, view.GetColorMatrix());
+    m_Data->m_Scratch.resize((syWorkerPool::Get()->GetThreadCount()*view.GetWidth()) << 1);
+    bool result = syWorkerPool::Get()->Run(m_Data, view.GetHeight());
+    m_Data->m_View = syBitmapView();
+    return result;
+}
+
+// --------------
+// End syColorLUT
+// --------------
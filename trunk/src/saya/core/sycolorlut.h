@@ -0,0 +1,101 @@
+/***************************************************************
+ * Name:      sycolorlut.h
+ * Purpose:   Declaration for the syColorLUT class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syColorLUT applies a 3D color lookup table (i.e.
+ *            a color grade loaded from a .cube file) to the
+ *            pixels of a bitmap, in a single pass.
+ **************************************************************/
+
+#ifndef sycolorlut_h
+#define sycolorlut_h
+
+#include "sybitmapview.h"
+
+class syString;
+
+/** @brief A 3D color lookup table.
+ *
+ *  The table holds size x size x size output colors, for input colors evenly spaced between the domain
+ *  minimum and maximum of each component. Colors between the grid points are found by tetrahedral
+ *  interpolation, which only reads four entries per pixel.
+ *
+ *  Since any chain of per-pixel color corrections (brightness, contrast, saturation, curves...) can be baked
+ *  into one table, applying it replaces a pass over the frame for each of them.
+ *
+ *  Apply() works in place on any color format. The RGB formats are transformed directly; the YUV and 16-bit
+ *  formats go through vcfRGB32. Premultiplied colors are transformed without their alpha.
+ */
+class syColorLUT {
+    public:
+        /** Minimum number of entries per component. */
+        static const unsigned int MinSize = 2;
+
+        /** Maximum number of entries per component. */
+        static const unsigned int MaxSize = 256;
+
+        /** Standard constructor. Creates an empty table. */
+        syColorLUT();
+
+        /** Standard destructor. */
+        ~syColorLUT();
+
+        /** @brief Creates an identity table.
+         *  @param size The number of entries per component (usually 17, 33 or 65).
+         *  @return false if the size is out of range.
+         */
+        bool Create(unsigned int size);
+
+        /** @brief Loads a table from a .cube file (the format used by Adobe and DaVinci Resolve).
+         *  @return false if the file can't be read or has no valid 3D table. The current table is kept.
+         */
+        bool LoadCube(const char* filename);
+
+        /** @see LoadCube(const char*) */
+        bool LoadCube(const syString& filename);
+
+        /** @brief Parses the contents of a .cube file.
+         *  @return false if the text has no valid 3D table. The current table is kept.
+         */
+        bool ParseCube(const char* text);
+
+        /** Returns true if the table has entries. */
+        bool IsOk() const;
+
+        /** Gets the number of entries per component; 0 for empty tables. */
+        unsigned int GetSize() const;
+
+        /** Gets the title given by the .cube file, if any. */
+        const syString& GetTitle() const;
+
+        /** @brief Sets an output color.
+         *  @param r, g, b The grid point, from 0 to GetSize() - 1.
+         *  @param red, green, blue The output color, with components from 0.0 to 1.0.
+         */
+        void SetEntry(unsigned int r, unsigned int g, unsigned int b, float red, float green, float blue);
+
+        /** @brief Sets the range of input colors covered by the table.
+         *  Each component goes from 0.0 to 1.0; input colors outside the range are clamped to it.
+         */
+        void SetDomain(float rmin, float gmin, float bmin, float rmax, float gmax, float bmax);
+
+        /** @brief Transforms the pixels of a bitmap.
+         *  @return false if the operation was aborted (see syBitmap::MustAbort); true otherwise.
+         */
+        bool Apply(syBitmap* bitmap);
+
+        /** @brief Transforms the pixels of a view.
+         *  @note Apply() isn't reentrant: Don't apply the same table from two threads at once.
+         */
+        bool Apply(const syBitmapView& view);
+
+    private:
+        class Data;
+        friend class Data;
+        Data* m_Data;
+};
+
+#endif
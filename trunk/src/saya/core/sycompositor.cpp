@@ -0,0 +1,393 @@
+/***************************************************************
+ * Name:      sycompositor.cpp
+ * Purpose:   Implementation of the syCompositor class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syCompositor flattens a stack of video layers (i.e.
+ *            the frames of the video tracks of a sequence) into
+ *            a single frame, using premultiplied alpha.
+ **************************************************************/
+
+#include "sycompositor.h"
+#include "syrowconverter.h"
+#include "syworkerpool.h"
+#include "sysimd.h"
+#include <cstring>
+#include <vector>
+
+// -------------------
+// Begin blend kernels
+// -------------------
+
+// All the kernels work on premultiplied pixels with the alpha in the fourth byte, so they don't care about the
+// order of the color components. The SIMD kernels give exactly the same results as the scalar ones.
+
+/** Multiplies two components as fractions of 255, rounding to the nearest. */
+static inline unsigned int sy_mul255(unsigned int a, unsigned int b) {
+    unsigned int t = a*b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+template<int MODE> static void sy_blend(const unsigned char* src, unsigned char* dst, unsigned int width, unsigned int opacity) {
+    for(; width; --width, src += 4, dst += 4) {
+        if(!(src[0] | src[1] | src[2] | src[3])) {
+            continue; // A fully transparent pixel leaves the destination alone in every mode.
+        }
+        unsigned int s[4];
+        for(unsigned int k = 0; k < 4; ++k) {
+            s[k] = (opacity == 255) ? src[k] : sy_mul255(src[k], opacity);
+        }
+        unsigned int sa = s[3], da = dst[3];
+        for(unsigned int k = 0; k < 4; ++k) {
+            unsigned int d = dst[k], r;
+            switch(MODE) {
+                case sy_bmover:
+                    r = s[k] + sy_mul255(d, 255 - sa);
+                    break;
+                case sy_bmadd:
+                    r = s[k] + d;
+                    break;
+                case sy_bmmultiply:
+                    r = sy_mul255(s[k], d) + sy_mul255(s[k], 255 - da) + sy_mul255(d, 255 - sa);
+                    break;
+                default: // sy_bmscreen
+                    r = s[k] + d - sy_mul255(s[k], d);
+            }
+            dst[k] = (r > 255) ? 255 : r;
+        }
+    }
+}
+
+#ifdef SY_X86_SIMD
+
+/** sy_mul255 on eight 16-bit lanes. */
+SY_TARGET_SSE2 static inline __m128i sy_mul255_sse2(__m128i a, __m128i b) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/** Blends two pixels unpacked into 16-bit lanes (all modes but sy_bmadd, which saturates the bytes directly). */
+template<int MODE> SY_TARGET_SSE2 static inline __m128i sy_blend2_sse2(__m128i s, __m128i d) {
+    const __m128i full = _mm_set1_epi16(255);
+    __m128i sa = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+    switch(MODE) {
+        case sy_bmover:
+            return _mm_add_epi16(s, sy_mul255_sse2(d, _mm_sub_epi16(full, sa)));
+        case sy_bmmultiply: {
+            __m128i da = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0xff), 0xff);
+            __m128i r = _mm_add_epi16(sy_mul255_sse2(s, d), sy_mul255_sse2(s, _mm_sub_epi16(full, da)));
+            return _mm_add_epi16(r, sy_mul255_sse2(d, _mm_sub_epi16(full, sa)));
+        }
+        default: // sy_bmscreen
+            return _mm_sub_epi16(_mm_add_epi16(s, d), sy_mul255_sse2(s, d));
+    }
+}
+
+template<int MODE> SY_TARGET_SSE2 static void sy_blend_sse2(const unsigned char* src, unsigned char* dst, unsigned int width, unsigned int opacity) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    const __m128i fade = _mm_set1_epi16(opacity);
+    bool opaque = (opacity == 255);
+    unsigned int i = 0;
+    for(; i + 4 <= width; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + (i << 2)));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xffff) {
+            continue;
+        }
+        if(MODE == sy_bmover && opaque && _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha), alpha)) == 0xffff) {
+            _mm_storeu_si128((__m128i*)(dst + (i << 2)), s); // Opaque pixels simply replace the destination.
+            continue;
+        }
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + (i << 2)));
+        __m128i slo = _mm_unpacklo_epi8(s, zero);
+        __m128i shi = _mm_unpackhi_epi8(s, zero);
+        if(!opaque) {
+            slo = sy_mul255_sse2(slo, fade);
+            shi = sy_mul255_sse2(shi, fade);
+        }
+        __m128i r;
+        if(MODE == sy_bmadd) {
+            r = _mm_adds_epu8(_mm_packus_epi16(slo, shi), d);
+        } else {
+            __m128i rlo = sy_blend2_sse2<MODE>(slo, _mm_unpacklo_epi8(d, zero));
+            __m128i rhi = sy_blend2_sse2<MODE>(shi, _mm_unpackhi_epi8(d, zero));
+            r = _mm_packus_epi16(rlo, rhi);
+        }
+        _mm_storeu_si128((__m128i*)(dst + (i << 2)), r);
+    }
+    sy_blend<MODE>(src + (i << 2), dst + (i << 2), width - i, opacity);
+}
+
+#endif
+
+// -----------------
+// End blend kernels
+// -----------------
+
+// ------------------------
+// Begin syCompositor::Data
+// ------------------------
+
+/** A layer given to AddLayer(), plus what Flatten() needs to render it. */
+struct syCompositorLayer {
+    syBitmapView m_View;
+    int m_X;
+    int m_Y;
+    syBlendMode m_BlendMode;
+    unsigned int m_Opacity;
+
+    /** The rectangle covered in the destination, from (m_DestX0, m_DestY0) to (m_DestX1, m_DestY1) exclusive. */
+    int m_DestX0, m_DestY0, m_DestX1, m_DestY1;
+
+    /** Set when the layer is already in the blending format, so its rows can be used as they are. */
+    bool m_Direct;
+
+    /** Set for the formats with chroma shared by pairs of pixels, which can't start at an odd column. */
+    bool m_Subsampled;
+
+    /** Converts the layer's rows into the blending format. */
+    syRowConverter m_Converter;
+};
+
+/** The compositor's state is also the band task run by Flatten(). */
+class syCompositor::Data : public syBandTask {
+    public:
+        Data() : m_BlendFormat(vcfRGBA32), m_BlendInPlace(false), m_FirstLayer(0), m_Background(false), m_ScratchSize(0) {}
+        virtual ~Data() {}
+
+        /** Picks the blending format, clips the layers to the destination and sizes the temporary rows. */
+        void Prepare(const syBitmapView& dest);
+
+        virtual void ProcessBand(unsigned int first, unsigned int last, unsigned int slot);
+
+        /** @brief Gets the pixels of a layer that cover a row of the destination, in the blending format.
+         *  @param buffer Room for the converted pixels, plus two more for the subsampled formats.
+         */
+        const unsigned char* GetLayerRow(const syCompositorLayer& layer, unsigned int y, unsigned char* buffer) const;
+
+        std::vector<syCompositorLayer> m_Layers;
+
+        syBitmapView m_Dest;
+
+        /** vcfRGBA32 or vcfBGRA32, whichever is closer to the destination. */
+        VideoColorFormat m_BlendFormat;
+
+        /** Set when the destination is in the blending format, so the layers are blended right into it. */
+        bool m_BlendInPlace;
+
+        /** Converts the blended rows into the destination format. */
+        syRowConverter m_DestConverter;
+
+        /** The lowest visible layer */
+        unsigned int m_FirstLayer;
+
+        /** Set when m_FirstLayer is opaque and covers the whole destination, so it's copied instead of blended. */
+        bool m_Background;
+
+        /** @brief Temporary rows for each slot of the worker pool (see syBandTask::ProcessBand).
+         *  Each slot holds a blending row as wide as m_Dest, followed by a layer row with two more pixels.
+         */
+        std::vector<unsigned int> m_Scratch;
+
+        /** Number of pixels of each slot of m_Scratch */
+        unsigned int m_ScratchSize;
+
+    protected:
+        virtual bool InternalMustAbort() { return m_Dest.GetBitmap() && m_Dest.GetBitmap()->MustAbort(); }
+};
+
+void syCompositor::Data::Prepare(const syBitmapView& dest) {
+    m_Dest = dest;
+    VideoColorFormat destfmt = dest.GetColorFormat();
+    m_BlendFormat = (destfmt == vcfBGR32 || destfmt == vcfBGRA32) ? vcfBGRA32 : vcfRGBA32;
+    m_BlendInPlace = (destfmt == m_BlendFormat);
+    m_DestConverter.Init(m_BlendFormat, destfmt, sy_cmbt601, dest.GetColorMatrix());
+    m_FirstLayer = 0;
+    m_Background = false;
+
+    int width = dest.GetWidth(), height = dest.GetHeight();
+    m_ScratchSize = (width << 1) + 2;
+    m_Scratch.resize(syWorkerPool::Get()->GetThreadCount()*m_ScratchSize);
+
+    for(unsigned int i = 0; i < m_Layers.size(); ++i) {
+        syCompositorLayer& layer = m_Layers[i];
+        VideoColorFormat format = layer.m_View.GetColorFormat();
+        layer.m_DestX0 = (layer.m_X > 0) ? layer.m_X : 0;
+        layer.m_DestY0 = (layer.m_Y > 0) ? layer.m_Y : 0;
+        layer.m_DestX1 = layer.m_X + (int)layer.m_View.GetWidth();
+        layer.m_DestY1 = layer.m_Y + (int)layer.m_View.GetHeight();
+        if(layer.m_DestX1 > width) {
+            layer.m_DestX1 = width;
+        }
+        if(layer.m_DestY1 > height) {
+            layer.m_DestY1 = height;
+        }
+        if(!layer.m_Opacity || layer.m_DestX1 <= layer.m_DestX0 || layer.m_DestY1 <= layer.m_DestY0) {
+            layer.m_DestY0 = layer.m_DestY1 = 0; // Invisible
+        }
+        layer.m_Direct = (format == m_BlendFormat);
+        layer.m_Subsampled = syBitmap::IsYUVFormat(format) && format != vcfY800;
+        layer.m_Converter.Init(format, m_BlendFormat, layer.m_View.GetColorMatrix());
+        if(!layer.m_Converter.IsOk()) {
+            layer.m_DestY0 = layer.m_DestY1 = 0; // Its color format can't be converted; skip it.
+        }
+
+        // An opaque layer covering everything hides all the layers below it.
+        if(layer.m_BlendMode == sy_bmover && layer.m_Opacity >= 255 && !syBitmap::IsAlphaFormat(format) &&
+            layer.m_X <= 0 && layer.m_Y <= 0 && layer.m_DestX1 == width && layer.m_DestY1 == height) {
+            m_FirstLayer = i;
+            m_Background = true;
+        }
+    }
+}
+
+const unsigned char* syCompositor::Data::GetLayerRow(const syCompositorLayer& layer, unsigned int y, unsigned char* buffer) const {
+    const syBitmapView& view = layer.m_View;
+    int srcy = y - layer.m_Y;
+    unsigned int srcx = layer.m_DestX0 - layer.m_X;
+    unsigned int width = layer.m_DestX1 - layer.m_DestX0;
+    if(layer.m_Direct) {
+        return view.GetReadOnlyRow(srcy) + (srcx << 2);
+    }
+
+    // Subsampled formats are converted from the pixel pair that holds the first pixel.
+    unsigned int lead = layer.m_Subsampled ? (srcx & 1) : 0;
+    srcx -= lead;
+    width += lead;
+    const unsigned char* srcplanes[3] = { view.GetReadOnlyRow(srcy) + srcx*view.GetBytesPerPixel(), 0, 0 };
+    if(view.IsPlanar()) {
+        srcplanes[1] = view.GetReadOnlyPlaneRow(1, srcy >> 1) + (srcx >> 1);
+        srcplanes[2] = view.GetReadOnlyPlaneRow(2, srcy >> 1) + (srcx >> 1);
+    } else if(layer.m_Subsampled) {
+        width = (width + 1) & ~1; // The 4:2:2 kernels work with whole pairs.
+    }
+    unsigned char* dstplanes[3] = { buffer, 0, 0 };
+    layer.m_Converter.Convert(srcplanes, dstplanes, width);
+    return buffer + (lead << 2);
+}
+
+void syCompositor::Data::ProcessBand(unsigned int first, unsigned int last, unsigned int slot) {
+    unsigned int width = m_Dest.GetWidth();
+    unsigned int* blendrow = &m_Scratch[slot*m_ScratchSize];
+    unsigned char* layerbuffer = (unsigned char*)(blendrow + width);
+    for(unsigned int y = first; y < last; ++y) {
+        unsigned char* dstrow = m_Dest.GetRow(y);
+        unsigned char* row = m_BlendInPlace ? dstrow : (unsigned char*)blendrow;
+        unsigned int i = m_FirstLayer;
+        if(m_Background) {
+            const unsigned char* src = GetLayerRow(m_Layers[i], y, layerbuffer);
+            memcpy(row, src, width << 2);
+            ++i;
+        } else {
+            memset(row, 0, width << 2);
+        }
+
+        for(; i < m_Layers.size(); ++i) {
+            const syCompositorLayer& layer = m_Layers[i];
+            if((int)y < layer.m_DestY0 || (int)y >= layer.m_DestY1) {
+                continue;
+            }
+            const unsigned char* src = GetLayerRow(layer, y, layerbuffer);
+            BlendRow(src, row + (layer.m_DestX0 << 2), layer.m_DestX1 - layer.m_DestX0, layer.m_BlendMode, layer.m_Opacity);
+        }
+
+        if(!m_BlendInPlace) {
+            const unsigned char* srcrow = row;
+            unsigned char* dstplanes[3] = { dstrow, 0, 0 };
+            if(m_Dest.IsPlanar() && (y & 1) == 0) {
+                // Each chroma row is shared by two luma rows; we take it from the upper one.
+                dstplanes[1] = m_Dest.GetPlaneRow(1, y >> 1);
+                dstplanes[2] = m_Dest.GetPlaneRow(2, y >> 1);
+            }
+            m_DestConverter.Convert(&srcrow, dstplanes, width);
+        }
+    }
+}
+
+// ----------------------
+// End syCompositor::Data
+// ----------------------
+
+// ------------------
+// Begin syCompositor
+// ------------------
+
+syCompositor::syCompositor() {
+    m_Data = new Data;
+}
+
+syCompositor::~syCompositor() {
+    delete m_Data;
+}
+
+void syCompositor::AddLayer(const syBitmapView& view, int x, int y, syBlendMode blendmode, unsigned int opacity) {
+    if(!view.IsOk()) {
+        return;
+    }
+    syCompositorLayer layer;
+    layer.m_View = view;
+    layer.m_X = x;
+    layer.m_Y = y;
+    layer.m_BlendMode = blendmode;
+    layer.m_Opacity = (opacity > 255) ? 255 : opacity;
+    m_Data->m_Layers.push_back(layer);
+}
+
+void syCompositor::ClearLayers() {
+    m_Data->m_Layers.clear();
+}
+
+unsigned int syCompositor::GetLayerCount() const {
+    return m_Data->m_Layers.size();
+}
+
+bool syCompositor::Flatten(syBitmap* dest) {
+    if(!dest || !dest->GetWidth() || !dest->GetHeight()) {
+        return false;
+    }
+    if(!syRowConverter::CanConvert(vcfRGBA32, dest->GetColorFormat())) {
+        return false;
+    }
+    dest->Unshare(false); // Every row will be overwritten.
+    return Flatten(dest->GetView());
+}
+
+bool syCompositor::Flatten(const syBitmapView& dest) {
+    if(!dest.IsOk() || dest.IsReadOnly() || !syRowConverter::CanConvert(vcfRGBA32, dest.GetColorFormat())) {
+        return false;
+    }
+    m_Data->Prepare(dest);
+    return syWorkerPool::Get()->Run(m_Data, dest.GetHeight());
+}
+
+void syCompositor::BlendRow(const unsigned char* src, unsigned char* dst, unsigned int width, syBlendMode blendmode, unsigned int opacity) {
+    if(!opacity) {
+        return;
+    }
+    if(opacity > 255) {
+        opacity = 255;
+    }
+    #ifdef SY_X86_SIMD
+    if(syRowConverter::HasSSE2()) {
+        switch(blendmode) {
+            case sy_bmadd: sy_blend_sse2<sy_bmadd>(src, dst, width, opacity); break;
+            case sy_bmmultiply: sy_blend_sse2<sy_bmmultiply>(src, dst, width, opacity); break;
+            case sy_bmscreen: sy_blend_sse2<sy_bmscreen>(src, dst, width, opacity); break;
+            default: sy_blend_sse2<sy_bmover>(src, dst, width, opacity); break;
+        }
+        return;
+    }
+    #endif
+    switch(blendmode) {
+        case sy_bmadd: sy_blend<sy_bmadd>(src, dst, width, opacity); break;
+        case sy_bmmultiply: sy_blend<sy_bmmultiply>(src, dst, width, opacity); break;
+        case sy_bmscreen: sy_blend<sy_bmscreen>(src, dst, width, opacity); break;
+        default: sy_blend<sy_bmover>(src, dst, width, opacity); break;
+    }
+}
+
+// ----------------
+// End syCompositor
+// ----------------
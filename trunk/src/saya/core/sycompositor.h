@@ -0,0 +1,92 @@
+/***************************************************************
+ * Name:      sycompositor.h
+ * Purpose:   Declaration for the syCompositor class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syCompositor flattens a stack of video layers (i.e.
+ *            the frames of the video tracks of a sequence) into
+ *            a single frame, using premultiplied alpha.
+ **************************************************************/
+
+#ifndef sycompositor_h
+#define sycompositor_h
+
+#include "sybitmapview.h"
+
+/** @brief enumerates the ways of blending a layer over the layers below it.
+ *
+ *  All the modes work on premultiplied colors; s and d are the source (layer) and destination components,
+ *  and sa and da their alphas, all of them as fractions of 255.
+ */
+enum syBlendMode {
+    sy_bmover, /** Porter-Duff "source over destination": s + d*(1 - sa). */
+    sy_bmadd, /** Additive: s + d, saturated. */
+    sy_bmmultiply, /** Multiply: s*d + s*(1 - da) + d*(1 - sa). */
+    sy_bmscreen /** Screen: s + d - s*d. */
+};
+
+/** @brief Composites a stack of layers into one frame.
+ *
+ *  Add the layers from the bottom to the top with AddLayer(), and call Flatten() to render them into the
+ *  destination. The layers may have any size, position and color format; the ones without alpha are opaque.
+ *
+ *  Flatten() renders the frame in a single pass over the destination: The rows are split into bands for the
+ *  worker pool, and each row is blended with all the layers that cover it while it's still in the cache. Layers
+ *  below the topmost opaque layer that covers the whole destination are skipped.
+ *
+ *  The frame starts fully transparent. If the destination has no alpha (see syBitmap::IsAlphaFormat), the result
+ *  is composited over black.
+ */
+class syCompositor {
+    public:
+        /** Standard constructor. */
+        syCompositor();
+
+        /** Standard destructor. */
+        ~syCompositor();
+
+        /** @brief Adds a layer on top of the previous ones.
+         *  @param view The pixels of the layer. They must stay valid until Flatten() returns.
+         *  @param x The left column of the layer inside the destination. May be negative.
+         *  @param y The top row of the layer inside the destination. May be negative.
+         *  @param blendmode How to blend the layer with the layers below it.
+         *  @param opacity The opacity of the whole layer, from 0 (invisible) to 255 (the layer's own alpha).
+         */
+        void AddLayer(const syBitmapView& view, int x = 0, int y = 0, syBlendMode blendmode = sy_bmover, unsigned int opacity = 255);
+
+        /** Removes all the layers. */
+        void ClearLayers();
+
+        /** Gets the number of layers. */
+        unsigned int GetLayerCount() const;
+
+        /** @brief Renders the layers into a bitmap of any color format.
+         *  @return false if the operation was aborted (see syBitmap::MustAbort), or the destination's color
+         *  format can't be converted (see syRowConverter::CanConvert()); true otherwise.
+         *  @note Layers whose color format can't be converted are skipped.
+         */
+        bool Flatten(syBitmap* dest);
+
+        /** @brief Renders the layers into a view.
+         *  @warning The destination must not overlap any of the layers.
+         */
+        bool Flatten(const syBitmapView& dest);
+
+        /** @brief Blends a row of premultiplied pixels over another.
+         *  @param src The source (upper) pixels, in vcfRGBA32 or vcfBGRA32 format.
+         *  @param dst The destination (lower) pixels, in the same format as src. They receive the result.
+         *  @param width The number of pixels.
+         *  @param blendmode How to blend the pixels.
+         *  @param opacity The opacity of the source, from 0 to 255.
+         */
+        static void BlendRow(const unsigned char* src, unsigned char* dst, unsigned int width, syBlendMode blendmode, unsigned int opacity = 255);
+
+    private:
+        class Data;
+        friend class Data;
+        Data* m_Data;
+};
+
+#endif
@@ -0,0 +1,229 @@
+/***************************************************************
+ * Name:      syframecache.cpp
+ * Purpose:   Implementation of the syFrameCache class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syFrameCache keeps the most recently decoded video
+ *            frames, so that scrubbing over them doesn't decode
+ *            them again.
+ **************************************************************/
+
+#include "syframecache.h"
+#include "avsource.h"
+#include "sybitmap.h"
+#include "sythread.h"
+#include <list>
+#include <map>
+#include <utility>
+
+/** Set when the cache is destroyed at exit; from then on, nothing is cached. */
+static bool gs_CacheDestroyed = false;
+
+// ----------------------
+// Begin syFrameCacheData
+// ----------------------
+
+class syFrameCacheData {
+    public:
+        typedef std::pair<const AVSource*, unsigned long> Key;
+
+        /** A cached frame. */
+        struct Entry {
+            Key m_Key;
+            syBitmap* m_Bitmap;
+            unsigned long m_Bytes;
+        };
+
+        typedef std::list<Entry> EntryList;
+        typedef std::map<Key, EntryList::iterator> EntryMap;
+
+        syFrameCacheData();
+        ~syFrameCacheData();
+
+        static syFrameCacheData& Get();
+
+        /** Removes an entry. Must be called with m_Mutex locked. */
+        void Remove(EntryMap::iterator it);
+
+        /** Evicts the least recently used entries until the cache holds at most maxbytes. Must be called with m_Mutex locked. */
+        void Shrink(unsigned long long maxbytes);
+
+        syMutex m_Mutex;
+
+        /** The cached frames, from the most recently used to the least. */
+        EntryList m_Entries;
+
+        /** The cached frames, by key. */
+        EntryMap m_Index;
+
+        unsigned long long m_MaxBytes;
+        syFrameCacheStats m_Stats;
+};
+
+syFrameCacheData::syFrameCacheData() :
+m_MaxBytes(268435456ULL)
+{
+    m_Stats.m_Hits = 0;
+    m_Stats.m_Misses = 0;
+    m_Stats.m_Frames = 0;
+    m_Stats.m_Bytes = 0;
+}
+
+syFrameCacheData::~syFrameCacheData() {
+    {
+        syMutexLocker lock(m_Mutex);
+        Shrink(0);
+    }
+    gs_CacheDestroyed = true;
+}
+
+syFrameCacheData& syFrameCacheData::Get() {
+    static syFrameCacheData cache;
+    return cache;
+}
+
+void syFrameCacheData::Remove(EntryMap::iterator it) {
+    EntryList::iterator entry = it->second;
+    m_Stats.m_Bytes -= entry->m_Bytes;
+    --m_Stats.m_Frames;
+    delete entry->m_Bitmap; // Gives the buffer back to the pool, unless it's still shared.
+    m_Entries.erase(entry);
+    m_Index.erase(it);
+}
+
+void syFrameCacheData::Shrink(unsigned long long maxbytes) {
+    while(!m_Entries.empty() && m_Stats.m_Bytes > maxbytes) {
+        Remove(m_Index.find(m_Entries.back().m_Key));
+    }
+}
+
+// --------------------
+// End syFrameCacheData
+// --------------------
+
+// ------------------
+// Begin syFrameCache
+// ------------------
+
+void syFrameCache::SendCurrentFrame(AVSource* source, syBitmapSink* sink) {
+    if(!source) {
+        return;
+    }
+    if(gs_CacheDestroyed || source->GetFramesPerSecond() <= 0 || !GetMaxBytes()) {
+        source->SendCurrentFrame(sink);
+        return;
+    }
+    unsigned long frame = source->GetFrameIndex(source->GetVideoPos());
+    syBitmap bitmap;
+    if(!Lookup(source, frame, &bitmap)) {
+        source->SendCurrentFrame(&bitmap);
+        if(!bitmap.GetWidth()) {
+            return; // The source couldn't be read (i.e. it's shutting down).
+        }
+        Store(source, frame, &bitmap);
+    }
+    if(sink) {
+        sink->LoadData(&bitmap);
+    }
+}
+
+bool syFrameCache::Lookup(const AVSource* source, unsigned long frame, syBitmap* dest) {
+    if(gs_CacheDestroyed) {
+        return false;
+    }
+    syFrameCacheData& cache = syFrameCacheData::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    syFrameCacheData::EntryMap::iterator it = cache.m_Index.find(syFrameCacheData::Key(source, frame));
+    if(it == cache.m_Index.end()) {
+        ++cache.m_Stats.m_Misses;
+        return false;
+    }
+    // Move it to the front of the list.
+    cache.m_Entries.splice(cache.m_Entries.begin(), cache.m_Entries, it->second);
+    dest->CopyFrom(it->second->m_Bitmap);
+    ++cache.m_Stats.m_Hits;
+    return true;
+}
+
+void syFrameCache::Store(const AVSource* source, unsigned long frame, const syBitmap* bitmap) {
+    if(gs_CacheDestroyed || !bitmap || !bitmap->GetWidth()) {
+        return;
+    }
+    unsigned long bytes = bitmap->GetBufferSize();
+    syFrameCacheData& cache = syFrameCacheData::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    if(bytes > cache.m_MaxBytes) {
+        return;
+    }
+    syFrameCacheData::Key key(source, frame);
+    syFrameCacheData::EntryMap::iterator it = cache.m_Index.find(key);
+    if(it != cache.m_Index.end()) {
+        cache.Remove(it);
+    }
+    cache.Shrink(cache.m_MaxBytes - bytes);
+
+    syFrameCacheData::Entry entry;
+    entry.m_Key = key;
+    entry.m_Bitmap = new syBitmap;
+    entry.m_Bitmap->CopyFrom(bitmap);
+    entry.m_Bytes = bytes;
+    cache.m_Entries.push_front(entry);
+    cache.m_Index[key] = cache.m_Entries.begin();
+    cache.m_Stats.m_Bytes += bytes;
+    ++cache.m_Stats.m_Frames;
+}
+
+void syFrameCache::Invalidate(const AVSource* source) {
+    if(gs_CacheDestroyed) {
+        return;
+    }
+    syFrameCacheData& cache = syFrameCacheData::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    syFrameCacheData::EntryMap::iterator it = cache.m_Index.lower_bound(syFrameCacheData::Key(source, 0));
+    while(it != cache.m_Index.end() && it->first.first == source) {
+        cache.Remove(it++);
+    }
+}
+
+void syFrameCache::Purge() {
+    if(gs_CacheDestroyed) {
+        return;
+    }
+    syFrameCacheData& cache = syFrameCacheData::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    cache.Shrink(0);
+}
+
+void syFrameCache::SetMaxBytes(unsigned long long bytes) {
+    if(gs_CacheDestroyed) {
+        return;
+    }
+    syFrameCacheData& cache = syFrameCacheData::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    cache.m_MaxBytes = bytes;
+    cache.Shrink(bytes);
+}
+
+unsigned long long syFrameCache::GetMaxBytes() {
+    if(gs_CacheDestroyed) {
+        return 0;
+    }
+    syFrameCacheData& cache = syFrameCacheData::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    return cache.m_MaxBytes;
+}
+
+syFrameCacheStats syFrameCache::GetStats() {
+    syFrameCacheData& cache = syFrameCacheData::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    return cache.m_Stats;
+}
+
+void syFrameCache::ResetStats() {
+    syFrameCacheData& cache = syFrameCacheData::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    cache.m_Stats.m_Hits = 0;
+    cache.m_Stats.m_Misses = 0;
+}
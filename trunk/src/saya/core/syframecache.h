@@ -0,0 +1,91 @@
+/***************************************************************
+ * Name:      syframecache.h
+ * Purpose:   Declaration for the syFrameCache class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syFrameCache keeps the most recently decoded video
+ *            frames, so that scrubbing over them doesn't decode
+ *            them again.
+ **************************************************************/
+
+#ifndef syframecache_h
+#define syframecache_h
+
+class AVSource;
+class syBitmap;
+class syBitmapSink;
+
+/** Statistics of the syFrameCache. @see syFrameCache::GetStats */
+struct syFrameCacheStats {
+    /** Number of frames served from the cache */
+    unsigned long m_Hits;
+
+    /** Number of frames that had to be decoded */
+    unsigned long m_Misses;
+
+    /** Number of frames in the cache */
+    unsigned long m_Frames;
+
+    /** Bytes of the buffers held by the cache */
+    unsigned long long m_Bytes;
+};
+
+/** @brief Process-wide, memory-bounded cache of decoded video frames.
+ *
+ *  Frames are keyed by their source and frame index. When the cache is full, the least recently used frames
+ *  are evicted. The cached bitmaps share their buffers with the bitmaps they were stored from and served to
+ *  (see syBitmap::CopyFrom), so neither storing nor serving a frame copies any pixels.
+ *
+ *  AVController sends its frames through SendCurrentFrame(), so going back to a frame that was recently shown
+ *  (i.e. scrubbing, jogging, or rocking over a cut point) doesn't decode it again.
+ *
+ *  Sources call Invalidate() when their resources are freed, so their frames aren't served after the source
+ *  is closed or deleted.
+ *
+ *  All the functions are thread-safe.
+ */
+class syFrameCache {
+    public:
+        /** @brief Sends a source's current frame to a sink, decoding it only if it isn't cached.
+         *
+         *  Replaces AVSource::SendCurrentFrame(). Sources without a framerate aren't cached, since all their
+         *  positions have the same frame index.
+         */
+        static void SendCurrentFrame(AVSource* source, syBitmapSink* sink);
+
+        /** @brief Gets a frame from the cache.
+         *  @param dest Receives the frame. Its buffer is shared with the cached bitmap.
+         *  @return true if the frame was cached; false otherwise.
+         */
+        static bool Lookup(const AVSource* source, unsigned long frame, syBitmap* dest);
+
+        /** @brief Adds a frame to the cache, evicting the least recently used frames if needed.
+         *
+         *  The cache shares the bitmap's buffer. Empty bitmaps and bitmaps bigger than the cache are ignored.
+         */
+        static void Store(const AVSource* source, unsigned long frame, const syBitmap* bitmap);
+
+        /** Removes all the frames of a source. */
+        static void Invalidate(const AVSource* source);
+
+        /** Removes all the frames. */
+        static void Purge();
+
+        /** @brief Sets the maximum amount of memory held by the cache, evicting frames as needed.
+         *  The default is 256 MB. 0 disables the cache.
+         */
+        static void SetMaxBytes(unsigned long long bytes);
+
+        /** Gets the maximum amount of memory held by the cache. */
+        static unsigned long long GetMaxBytes();
+
+        /** Gets the statistics of the cache. */
+        static syFrameCacheStats GetStats();
+
+        /** Resets the hit and miss counters. */
+        static void ResetStats();
+};
+
+#endif
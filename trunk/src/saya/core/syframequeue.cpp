@@ -0,0 +1,218 @@
+/***************************************************************
+ * Name:      syframequeue.cpp
+ * Purpose:   Implementation of the syFrameQueue class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syFrameQueue lets the video input thread decode
+ *            frames ahead of the video output thread.
+ **************************************************************/
+
+#include "syframequeue.h"
+#include "aborter.h"
+#include "sybitmap.h"
+#include "sythread.h"
+#include <cstddef>
+#include <vector>
+
+const unsigned int syFrameQueue::DefaultCapacity = 4;
+const unsigned int syFrameQueue::MaxCapacity = 64;
+
+// ------------------------
+// Begin syFrameQueue::Data
+// ------------------------
+
+class syFrameQueue::Data {
+    public:
+        Data();
+        ~Data();
+
+        /** Deletes the slots. */
+        void FreeSlots();
+
+        syMutex m_Mutex;
+
+        /** Signalled by Wake(), EndPush() and Pop(). */
+        syCondition m_Condition;
+
+        /** Incremented by Wake(), so that the waiting threads can tell they were woken up. */
+        unsigned long m_WakeCount;
+
+        /** The frames. */
+        std::vector<syBitmap*> m_Slots;
+
+        /** Stream position of each frame. */
+        std::vector<avtime_t> m_Positions;
+
+        /** Index of the oldest frame. */
+        unsigned int m_Head;
+
+        /** Number of frames in the queue. */
+        unsigned int m_Count;
+
+        // Statistics
+
+        unsigned int m_HighWater;
+        unsigned long m_FramesQueued;
+        unsigned long m_ProducerWaits;
+};
+
+syFrameQueue::Data::Data() :
+m_Condition(m_Mutex),
+m_WakeCount(0),
+m_Head(0),
+m_Count(0),
+m_HighWater(0),
+m_FramesQueued(0),
+m_ProducerWaits(0)
+{
+}
+
+syFrameQueue::Data::~Data() {
+    FreeSlots();
+}
+
+void syFrameQueue::Data::FreeSlots() {
+    for(unsigned int i = 0; i < m_Slots.size(); ++i) {
+        delete m_Slots[i];
+    }
+    m_Slots.clear();
+    m_Positions.clear();
+    m_Head = 0;
+    m_Count = 0;
+}
+
+// ----------------------
+// End syFrameQueue::Data
+// ----------------------
+
+syFrameQueue::syFrameQueue() :
+m_Data(new Data)
+{
+    SetCapacity(DefaultCapacity);
+}
+
+syFrameQueue::~syFrameQueue() {
+    delete m_Data;
+}
+
+void syFrameQueue::SetCapacity(unsigned int capacity) {
+    if(capacity < 1) { capacity = 1; }
+    if(capacity > MaxCapacity) { capacity = MaxCapacity; }
+    syMutexLocker lock(m_Data->m_Mutex);
+    m_Data->FreeSlots();
+    m_Data->m_Slots.resize(capacity, NULL);
+    m_Data->m_Positions.resize(capacity, 0);
+    for(unsigned int i = 0; i < capacity; ++i) {
+        m_Data->m_Slots[i] = new syBitmap;
+    }
+}
+
+unsigned int syFrameQueue::GetCapacity() const {
+    syMutexLocker lock(m_Data->m_Mutex);
+    return m_Data->m_Slots.size();
+}
+
+unsigned int syFrameQueue::GetCount() const {
+    syMutexLocker lock(m_Data->m_Mutex);
+    return m_Data->m_Count;
+}
+
+syBitmap* syFrameQueue::BeginPush(avtime_t timeout, syAborter* aborter) {
+    avtime_t endtime = syGetNanoTicks() + timeout;
+    syMutexLocker lock(m_Data->m_Mutex);
+    unsigned long wakecount = m_Data->m_WakeCount;
+    unsigned int capacity = m_Data->m_Slots.size();
+    if(m_Data->m_Count >= capacity) {
+        ++m_Data->m_ProducerWaits;
+    }
+    while(m_Data->m_Count >= capacity) {
+        if(m_Data->m_WakeCount != wakecount || syGetNanoTicks() >= endtime || (aborter && aborter->MustAbort())) {
+            return NULL;
+        }
+        m_Data->m_Condition.WaitUntil(endtime);
+    }
+    // Only the producer adds frames, so the slot stays free until EndPush().
+    return m_Data->m_Slots[(m_Data->m_Head + m_Data->m_Count) % capacity];
+}
+
+void syFrameQueue::EndPush(avtime_t pos) {
+    syMutexLocker lock(m_Data->m_Mutex);
+    unsigned int capacity = m_Data->m_Slots.size();
+    if(m_Data->m_Count >= capacity) {
+        return;
+    }
+    m_Data->m_Positions[(m_Data->m_Head + m_Data->m_Count) % capacity] = pos;
+    ++m_Data->m_Count;
+    ++m_Data->m_FramesQueued;
+    if(m_Data->m_Count > m_Data->m_HighWater) {
+        m_Data->m_HighWater = m_Data->m_Count;
+    }
+    m_Data->m_Condition.Broadcast();
+}
+
+const syBitmap* syFrameQueue::Front(avtime_t& pos, avtime_t timeout, syAborter* aborter) {
+    avtime_t endtime = syGetNanoTicks() + timeout;
+    syMutexLocker lock(m_Data->m_Mutex);
+    unsigned long wakecount = m_Data->m_WakeCount;
+    while(!m_Data->m_Count) {
+        if(m_Data->m_WakeCount != wakecount || syGetNanoTicks() >= endtime || (aborter && aborter->MustAbort())) {
+            return NULL;
+        }
+        m_Data->m_Condition.WaitUntil(endtime);
+    }
+    pos = m_Data->m_Positions[m_Data->m_Head];
+    return m_Data->m_Slots[m_Data->m_Head];
+}
+
+bool syFrameQueue::PeekNext(avtime_t& pos) const {
+    syMutexLocker lock(m_Data->m_Mutex);
+    if(m_Data->m_Count < 2) {
+        return false;
+    }
+    pos = m_Data->m_Positions[(m_Data->m_Head + 1) % m_Data->m_Slots.size()];
+    return true;
+}
+
+void syFrameQueue::Pop() {
+    syMutexLocker lock(m_Data->m_Mutex);
+    if(!m_Data->m_Count) {
+        return;
+    }
+    m_Data->m_Head = (m_Data->m_Head + 1) % m_Data->m_Slots.size();
+    --m_Data->m_Count;
+    m_Data->m_Condition.Broadcast();
+}
+
+void syFrameQueue::Clear() {
+    syMutexLocker lock(m_Data->m_Mutex);
+    for(unsigned int i = 0; i < m_Data->m_Slots.size(); ++i) {
+        m_Data->m_Slots[i]->ReleaseBuffer(true);
+    }
+    m_Data->m_Head = 0;
+    m_Data->m_Count = 0;
+}
+
+void syFrameQueue::Wake() {
+    syMutexLocker lock(m_Data->m_Mutex);
+    ++m_Data->m_WakeCount;
+    m_Data->m_Condition.Broadcast();
+}
+
+syFrameQueueStats syFrameQueue::GetStats() const {
+    syFrameQueueStats result;
+    syMutexLocker lock(m_Data->m_Mutex);
+    result.m_Capacity = m_Data->m_Slots.size();
+    result.m_HighWater = m_Data->m_HighWater;
+    result.m_FramesQueued = m_Data->m_FramesQueued;
+    result.m_ProducerWaits = m_Data->m_ProducerWaits;
+    return result;
+}
+
+void syFrameQueue::ResetStats() {
+    syMutexLocker lock(m_Data->m_Mutex);
+    m_Data->m_HighWater = m_Data->m_Count;
+    m_Data->m_FramesQueued = 0;
+    m_Data->m_ProducerWaits = 0;
+}
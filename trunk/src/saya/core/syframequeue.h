@@ -0,0 +1,125 @@
+/***************************************************************
+ * Name:      syframequeue.h
+ * Purpose:   Declaration for the syFrameQueue class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syFrameQueue lets the video input thread decode
+ *            frames ahead of the video output thread.
+ **************************************************************/
+
+#ifndef syframequeue_h
+#define syframequeue_h
+
+#include "avtypes.h"
+
+class syAborter;
+class syBitmap;
+
+/** Statistics of a syFrameQueue. @see syFrameQueue::GetStats */
+struct syFrameQueueStats {
+    /** Maximum number of frames the queue holds */
+    unsigned int m_Capacity;
+
+    /** Largest number of frames that were waiting in the queue at the same time */
+    unsigned int m_HighWater;
+
+    /** Number of frames pushed */
+    unsigned long m_FramesQueued;
+
+    /** Number of times the producer found the queue full, and had to wait for a free slot */
+    unsigned long m_ProducerWaits;
+};
+
+/** @brief A bounded ring of decoded video frames, from one producer thread to one consumer thread.
+ *
+ *  The producer gets a free slot with BeginPush(), loads a frame into it (the slot is a syBitmapSink; see
+ *  AVSource::SendCurrentFrame()), and commits it with EndPush(), along with the frame's position in the stream.
+ *  The consumer gets the oldest frame with Front(), and releases its slot with Pop() when it's done with it.
+ *  While the queue is full, BeginPush() blocks; that's the back-pressure that keeps the producer from running
+ *  too far ahead.
+ *
+ *  The slots are allocated once, and their bitmaps keep their buffers (which come from syBitmapPool) from frame
+ *  to frame.
+ *
+ *  Wake() interrupts the waits; it must be called whenever the threads are asked to pause or stop. As with
+ *  syFrameScheduler, the threads must also give the waits an syAborter that tells if they were.
+ */
+class syFrameQueue {
+    public:
+        /** Default number of frames */
+        static const unsigned int DefaultCapacity;
+
+        /** Maximum number of frames */
+        static const unsigned int MaxCapacity;
+
+        /** Standard constructor. */
+        syFrameQueue();
+
+        /** Standard destructor. */
+        ~syFrameQueue();
+
+        /** @brief Sets the number of frames that the queue can hold, and empties it.
+         *  @warning Must not be called while the producer or the consumer are using the queue.
+         */
+        void SetCapacity(unsigned int capacity);
+
+        /** Gets the number of frames that the queue can hold. */
+        unsigned int GetCapacity() const;
+
+        /** Gets the number of frames waiting in the queue. */
+        unsigned int GetCount() const;
+
+        /** @brief Waits for a free slot.
+         *  @param timeout The maximum time to wait, in nanoseconds.
+         *  @param aborter If given, the wait also ends when aborter->MustAbort() returns true.
+         *  @return The bitmap of the slot, or NULL if the wait timed out, was aborted or Wake() was called.
+         *  @note Until EndPush() is called, the same slot is returned.
+         */
+        syBitmap* BeginPush(avtime_t timeout, syAborter* aborter = 0);
+
+        /** Commits the slot obtained by BeginPush() as the newest frame, at the given stream position. */
+        void EndPush(avtime_t pos);
+
+        /** @brief Waits for a frame.
+         *  @param pos Receives the stream position of the frame.
+         *  @param timeout The maximum time to wait, in nanoseconds.
+         *  @param aborter If given, the wait also ends when aborter->MustAbort() returns true.
+         *  @return The oldest frame in the queue, or NULL if the wait timed out, was aborted or Wake() was called.
+         *  The frame stays valid until Pop() is called.
+         */
+        const syBitmap* Front(avtime_t& pos, avtime_t timeout, syAborter* aborter = 0);
+
+        /** @brief Gets the position of the frame that follows the one returned by Front().
+         *  @return false if there's no such frame in the queue.
+         */
+        bool PeekNext(avtime_t& pos) const;
+
+        /** Removes the oldest frame, and wakes up the producer. */
+        void Pop();
+
+        /** @brief Removes all the frames, and gives their buffers back to the pool.
+         *  @warning Must not be called while the producer or the consumer are using the queue.
+         */
+        void Clear();
+
+        /** Wakes up the threads waiting in BeginPush() or Front(). */
+        void Wake();
+
+        /** Gets the statistics of the queue since the last ResetStats(). */
+        syFrameQueueStats GetStats() const;
+
+        /** Clears the statistics. */
+        void ResetStats();
+
+    private:
+        class Data;
+        friend class Data;
+        Data* m_Data;
+
+        syFrameQueue(const syFrameQueue& copy);
+        syFrameQueue& operator=(const syFrameQueue& copy);
+};
+
+#endif
@@ -0,0 +1,131 @@
+/***************************************************************
+ * Name:      syframescheduler.cpp
+ * Purpose:   Implementation of the syFrameScheduler class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syFrameScheduler lets the playback threads sleep
+ *            until a frame is due, instead of polling.
+ **************************************************************/
+
+#include "syframescheduler.h"
+#include "aborter.h"
+#include "sythread.h"
+
+class syFrameScheduler::Data {
+    public:
+        Data();
+
+        syMutex m_Mutex;
+
+        /** Signalled by Wake(). */
+        syCondition m_Condition;
+
+        /** Incremented by Wake(), so that the waiting threads can tell they were woken up. */
+        unsigned long m_WakeCount;
+
+        /** Deadline of the last frame presented */
+        avtime_t m_LastDeadline;
+
+        avtime_t m_MinimumInterval;
+
+        // Statistics
+
+        unsigned long m_FramesPresented;
+        unsigned long m_FramesDropped;
+        unsigned long long m_TotalJitter;
+        avtime_t m_MaxJitter;
+};
+
+syFrameScheduler::Data::Data() :
+m_Condition(m_Mutex),
+m_WakeCount(0),
+m_LastDeadline(0),
+m_MinimumInterval(0),
+m_FramesPresented(0),
+m_FramesDropped(0),
+m_TotalJitter(0),
+m_MaxJitter(0)
+{
+}
+
+syFrameScheduler::syFrameScheduler() :
+m_Data(new Data)
+{
+}
+
+syFrameScheduler::~syFrameScheduler() {
+    delete m_Data;
+}
+
+bool syFrameScheduler::WaitUntil(avtime_t deadline, syAborter* aborter) {
+    syMutexLocker lock(m_Data->m_Mutex);
+    unsigned long wakecount = m_Data->m_WakeCount;
+    while(m_Data->m_WakeCount == wakecount) {
+        if(syGetNanoTicks() >= deadline) {
+            return true;
+        }
+        if(aborter && aborter->MustAbort()) {
+            break;
+        }
+        // Either a timeout or a signal; we check the time and the wake count again anyway.
+        m_Data->m_Condition.WaitUntil(deadline);
+    }
+    return false;
+}
+
+void syFrameScheduler::Wake() {
+    syMutexLocker lock(m_Data->m_Mutex);
+    ++m_Data->m_WakeCount;
+    m_Data->m_Condition.Broadcast();
+}
+
+void syFrameScheduler::FramePresented(avtime_t deadline) {
+    avtime_t now = syGetNanoTicks();
+    avtime_t jitter = (now > deadline) ? now - deadline : deadline - now;
+    syMutexLocker lock(m_Data->m_Mutex);
+    ++m_Data->m_FramesPresented;
+    m_Data->m_LastDeadline = deadline;
+    m_Data->m_TotalJitter += jitter;
+    if(jitter > m_Data->m_MaxJitter) {
+        m_Data->m_MaxJitter = jitter;
+    }
+}
+
+void syFrameScheduler::FramesDropped(unsigned long count) {
+    syMutexLocker lock(m_Data->m_Mutex);
+    m_Data->m_FramesDropped += count;
+}
+
+void syFrameScheduler::SetMinimumInterval(avtime_t interval) {
+    syMutexLocker lock(m_Data->m_Mutex);
+    m_Data->m_MinimumInterval = interval;
+}
+
+avtime_t syFrameScheduler::GetNextAllowedTime() const {
+    syMutexLocker lock(m_Data->m_Mutex);
+    if(!m_Data->m_FramesPresented) {
+        return 0;
+    }
+    return m_Data->m_LastDeadline + m_Data->m_MinimumInterval;
+}
+
+syFrameStats syFrameScheduler::GetStats() const {
+    syFrameStats result;
+    syMutexLocker lock(m_Data->m_Mutex);
+    result.m_FramesPresented = m_Data->m_FramesPresented;
+    result.m_FramesDropped = m_Data->m_FramesDropped;
+    result.m_MeanJitter = m_Data->m_FramesPresented ? m_Data->m_TotalJitter / m_Data->m_FramesPresented : 0;
+    result.m_MaxJitter = m_Data->m_MaxJitter;
+    return result;
+}
+
+void syFrameScheduler::ResetStats() {
+    syMutexLocker lock(m_Data->m_Mutex);
+    m_Data->m_LastDeadline = 0;
+    m_Data->m_FramesPresented = 0;
+    m_Data->m_FramesDropped = 0;
+    m_Data->m_TotalJitter = 0;
+    m_Data->m_MaxJitter = 0;
+}
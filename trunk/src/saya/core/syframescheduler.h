@@ -0,0 +1,94 @@
+/***************************************************************
+ * Name:      syframescheduler.h
+ * Purpose:   Declaration for the syFrameScheduler class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syFrameScheduler lets the playback threads sleep
+ *            until a frame is due, instead of polling.
+ **************************************************************/
+
+#ifndef syframescheduler_h
+#define syframescheduler_h
+
+#include "avtypes.h"
+
+class syAborter;
+
+/** Statistics of the frames presented during a playback. All times are in nanoseconds. */
+struct syFrameStats {
+    /** Number of frames presented */
+    unsigned long m_FramesPresented;
+
+    /** Number of frames skipped, to keep up with the playback clock or the maximum framerate */
+    unsigned long m_FramesDropped;
+
+    /** Mean distance between the time a frame was due and the time it was presented */
+    avtime_t m_MeanJitter;
+
+    /** Largest distance between the time a frame was due and the time it was presented */
+    avtime_t m_MaxJitter;
+};
+
+/** @brief Schedules the presentation of video frames.
+ *
+ *  The thread that presents the frames computes the time when each one is due (its deadline, in the
+ *  system time given by syGetNanoTicks()), sleeps until then with WaitUntil(), and reports each frame shown
+ *  with FramePresented(). It sleeps on a timed condition, so an idle player doesn't use the CPU at all.
+ *
+ *  Wake() interrupts the waits; it must be called whenever the threads are asked to pause or stop. Since the
+ *  threads check for that before they wait, they must also give WaitUntil() an syAborter that tells if they
+ *  were; otherwise a Wake() that comes between the check and the wait would be lost.
+ *
+ *  The scheduler also enforces a minimum interval between frames (see SetMinimumInterval()), and keeps
+ *  the statistics of the frames presented (see GetStats()).
+ */
+class syFrameScheduler {
+    public:
+        /** Standard constructor. */
+        syFrameScheduler();
+
+        /** Standard destructor. */
+        ~syFrameScheduler();
+
+        /** @brief Waits until the system time reaches the deadline, or until Wake() is called.
+         *  @param aborter If given, the wait also ends when aborter->MustAbort() returns true. It's checked
+         *  under the same lock as Wake(), so a Wake() that follows the abort request is never missed.
+         *  @return true if the deadline was reached; false if woken up or aborted.
+         */
+        bool WaitUntil(avtime_t deadline, syAborter* aborter = 0);
+
+        /** Wakes up the threads waiting in WaitUntil(). */
+        void Wake();
+
+        /** Records that the frame due at deadline has just been presented. */
+        void FramePresented(avtime_t deadline);
+
+        /** Records that frames were skipped. */
+        void FramesDropped(unsigned long count);
+
+        /** Sets the minimum time between the deadlines of two frames, in nanoseconds. */
+        void SetMinimumInterval(avtime_t interval);
+
+        /** @brief Gets the earliest time when the next frame can be presented.
+         *  @return The deadline of the last frame presented plus the minimum interval; 0 if no frames were presented.
+         */
+        avtime_t GetNextAllowedTime() const;
+
+        /** Gets the statistics of the frames presented since the last ResetStats(). */
+        syFrameStats GetStats() const;
+
+        /** Clears the statistics and forgets the frames presented. Call it when playback starts. */
+        void ResetStats();
+
+    private:
+        class Data;
+        friend class Data;
+        Data* m_Data;
+
+        syFrameScheduler(const syFrameScheduler& copy);
+        syFrameScheduler& operator=(const syFrameScheduler& copy);
+};
+
+#endif
@@ -0,0 +1,681 @@
+/***************************************************************
+ * Name:      sypeakcache.cpp
+ * Purpose:   Implementation of the syPeakCache class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syPeakCache holds the waveform overview of an audio
+ *            resource, so that it can be drawn at any zoom level
+ *            without decoding the audio.
+ **************************************************************/
+
+#include "sypeakcache.h"
+#include "syaudioblock.h"
+#include "avsource.h"
+#include "sythread.h"
+#include "iocommon.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#ifdef __WIN32__
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+/** Number of samples in the buckets of the finest level */
+static const unsigned int sy_peakbucketsize = 256;
+
+/** log2 of the ratio between the bucket sizes of two consecutive levels */
+static const unsigned int sy_peaklevelshift = 4;
+
+/** Number of samples read from the source at a time while generating the peaks */
+static const unsigned long sy_peakreadsize = 65536;
+
+/** Full scale of the stored peaks */
+static const float sy_peakscale = 32767.0f;
+
+// -----------------
+// Begin file format
+// -----------------
+
+// A peak file has a header followed by the buckets of each level. Each bucket holds one syPeakEntry per
+// channel, so the buckets of a range can be read sequentially. The numbers are stored in the machine's
+// byte order; files from machines with a different one are rejected (and generated again).
+
+static const char sy_peakmagic[4] = { 'S', 'Y', 'P', 'K' };
+static const unsigned int sy_peakversion = 1;
+static const unsigned int sy_peakbyteorder = 0x01020304;
+
+struct syPeakFileLevel {
+    /** Number of samples per bucket */
+    unsigned int m_BucketSize;
+
+    /** Unused; keeps the following members aligned */
+    unsigned int m_Reserved;
+
+    /** Number of buckets */
+    unsigned long long m_NumBuckets;
+
+    /** Offset of the first bucket, in bytes from the start of the file */
+    unsigned long long m_Offset;
+};
+
+struct syPeakFileHeader {
+    char m_Magic[4];
+    unsigned int m_Version;
+    unsigned int m_ByteOrder;
+    unsigned int m_SampleFrequency;
+    unsigned int m_NumChannels;
+    unsigned int m_NumLevels;
+    unsigned long long m_NumSamples;
+    syPeakFileLevel m_Levels[syPeakCache::NumLevels];
+};
+
+/** The levels of a bucket for one channel, scaled to sy_peakscale. */
+struct syPeakEntry {
+    short m_Min;
+    short m_Max;
+    unsigned short m_Rms;
+};
+
+// ---------------
+// End file format
+// ---------------
+
+// -------------------
+// Begin syPeakMapping
+// -------------------
+
+/** A read-only memory mapping of a whole file. */
+class syPeakMapping {
+    public:
+        syPeakMapping() : m_Base(NULL), m_Size(0)
+        #ifdef __WIN32__
+        , m_File(INVALID_HANDLE_VALUE), m_Mapping(NULL)
+        #endif
+        {}
+
+        ~syPeakMapping() { Unmap(); }
+
+        /** Maps a file. Returns false on error. */
+        bool Map(const char* filename);
+
+        /** Unmaps the file. */
+        void Unmap();
+
+        /** Exchanges the mapped files of two objects. */
+        void Swap(syPeakMapping& other);
+
+        /** The first byte of the file */
+        const char* m_Base;
+
+        /** The size of the file, in bytes */
+        unsigned long long m_Size;
+
+    private:
+        #ifdef __WIN32__
+        HANDLE m_File;
+        HANDLE m_Mapping;
+        #endif
+};
+
+bool syPeakMapping::Map(const char* filename) {
+    Unmap();
+    #ifdef __WIN32__
+    m_File = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(m_File == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    DWORD sizehigh = 0;
+    DWORD sizelow = GetFileSize(m_File, &sizehigh);
+    m_Size = ((unsigned long long)sizehigh << 32) | sizelow;
+    if(m_Size) {
+        m_Mapping = CreateFileMappingA(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+        if(m_Mapping) {
+            m_Base = (const char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+    }
+    #else
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) == 0 && st.st_size > 0) {
+        m_Size = st.st_size;
+        void* base = mmap(NULL, m_Size, PROT_READ, MAP_SHARED, fd, 0);
+        if(base != MAP_FAILED) {
+            m_Base = (const char*)base;
+        }
+    }
+    close(fd); // The mapping keeps the file open.
+    #endif
+    if(!m_Base) {
+        Unmap();
+        return false;
+    }
+    return true;
+}
+
+void syPeakMapping::Unmap() {
+    #ifdef __WIN32__
+    if(m_Base) {
+        UnmapViewOfFile(m_Base);
+    }
+    if(m_Mapping) {
+        CloseHandle(m_Mapping);
+        m_Mapping = NULL;
+    }
+    if(m_File != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_File);
+        m_File = INVALID_HANDLE_VALUE;
+    }
+    #else
+    if(m_Base) {
+        munmap((void*)m_Base, m_Size);
+    }
+    #endif
+    m_Base = NULL;
+    m_Size = 0;
+}
+
+void syPeakMapping::Swap(syPeakMapping& other) {
+    std::swap(m_Base, other.m_Base);
+    std::swap(m_Size, other.m_Size);
+    #ifdef __WIN32__
+    std::swap(m_File, other.m_File);
+    std::swap(m_Mapping, other.m_Mapping);
+    #endif
+}
+
+// -----------------
+// End syPeakMapping
+// -----------------
+
+// ----------------------
+// Begin peak accumulator
+// ----------------------
+
+/** The levels of the bucket being generated, for one channel and level. */
+struct syPeakAccumulator {
+    float m_Min;
+    float m_Max;
+    double m_SumSquares;
+    unsigned long m_Count;
+
+    void Reset() {
+        m_Min = m_Max = 0.0f;
+        m_SumSquares = 0.0;
+        m_Count = 0;
+    }
+
+    /** Adds a row of samples. */
+    void Add(const float* row, unsigned int count);
+
+    /** Adds the samples of another bucket. */
+    void Add(const syPeakAccumulator& other);
+
+    /** Gets the entry to store. */
+    syPeakEntry GetEntry() const;
+};
+
+void syPeakAccumulator::Add(const float* row, unsigned int count) {
+    if(!count) {
+        return;
+    }
+    float minval = m_Count ? m_Min : row[0];
+    float maxval = m_Count ? m_Max : row[0];
+    double sumsquares = 0.0;
+    for(unsigned int i = 0; i < count; ++i) {
+        float sample = row[i];
+        if(sample < minval) { minval = sample; }
+        if(sample > maxval) { maxval = sample; }
+        sumsquares += sample * sample;
+    }
+    m_Min = minval;
+    m_Max = maxval;
+    m_SumSquares += sumsquares;
+    m_Count += count;
+}
+
+void syPeakAccumulator::Add(const syPeakAccumulator& other) {
+    if(!other.m_Count) {
+        return;
+    }
+    if(!m_Count || other.m_Min < m_Min) { m_Min = other.m_Min; }
+    if(!m_Count || other.m_Max > m_Max) { m_Max = other.m_Max; }
+    m_SumSquares += other.m_SumSquares;
+    m_Count += other.m_Count;
+}
+
+/** Scales a level to sy_peakscale, rounding away from silence so that peaks are never understated. */
+static int sy_scalepeak(float value) {
+    double scaled = (double)value * sy_peakscale;
+    scaled = (scaled < 0) ? floor(scaled) : ceil(scaled);
+    if(scaled > sy_peakscale) { scaled = sy_peakscale; }
+    if(scaled < -sy_peakscale) { scaled = -sy_peakscale; }
+    return (int)scaled;
+}
+
+syPeakEntry syPeakAccumulator::GetEntry() const {
+    syPeakEntry result;
+    result.m_Min = (short)sy_scalepeak(m_Min);
+    result.m_Max = (short)sy_scalepeak(m_Max);
+    double rms = m_Count ? sqrt(m_SumSquares / m_Count) : 0.0;
+    result.m_Rms = (unsigned short)sy_scalepeak((float)rms);
+    return result;
+}
+
+// --------------------
+// End peak accumulator
+// --------------------
+
+class syPeakCacheThread;
+
+class syPeakCache::Data {
+    public:
+        Data();
+        ~Data();
+
+        /** Maps a peak file and validates it. Returns false on error. */
+        bool Map(const syString& filename);
+
+        /** Generates the peak file. Runs in the generator thread. */
+        void GenerateLoop();
+
+        /** @brief Stores the bucket of a level and adds it to the next level.
+         *  Called by GenerateLoop() when the bucket is full or the resource has ended.
+         */
+        void FlushBucket(unsigned int level);
+
+        /** Protects the mapping. */
+        mutable syMutex m_Mutex;
+
+        /** The mapped peak file */
+        syPeakMapping m_Mapping;
+
+        /** The header of the mapped file; NULL if no file is mapped. */
+        const syPeakFileHeader* m_Header;
+
+        /** The generator thread */
+        syThread* m_Thread;
+
+        /** The source read by the generator thread */
+        AVSource* m_Source;
+
+        /** The file written by the generator thread */
+        syString m_Filename;
+
+        /** true while the generator thread is running */
+        volatile bool m_Generating;
+
+        /** The progress of the generation */
+        volatile float m_Progress;
+
+        /** Number of channels of the source being read */
+        unsigned int m_NumChannels;
+
+        /** The buckets being generated; NumLevels * m_NumChannels. */
+        std::vector<syPeakAccumulator> m_Accumulators;
+
+        /** Number of buckets of the previous level already added to the bucket being generated, per level */
+        unsigned int m_ChildBuckets[NumLevels];
+
+        /** The stored buckets, per level */
+        std::vector<syPeakEntry> m_Entries[NumLevels];
+
+        /** Number of buckets stored, per level */
+        unsigned long long m_NumBuckets[NumLevels];
+};
+
+class syPeakCacheThread : public syThread {
+    public:
+        syPeakCacheThread(syPeakCache::Data* parent);
+        virtual int Entry();
+
+    private:
+        syPeakCache::Data* m_Parent;
+};
+
+syPeakCacheThread::syPeakCacheThread(syPeakCache::Data* parent) :
+syThread(syTHREAD_JOINABLE),
+m_Parent(parent)
+{
+}
+
+int syPeakCacheThread::Entry() {
+    m_Parent->GenerateLoop();
+    return 0;
+}
+
+// -----------------------
+// Begin syPeakCache::Data
+// -----------------------
+
+syPeakCache::Data::Data() :
+m_Header(NULL),
+m_Thread(NULL),
+m_Source(NULL),
+m_Generating(false),
+m_Progress(0.0f),
+m_NumChannels(0)
+{
+}
+
+syPeakCache::Data::~Data() {
+}
+
+bool syPeakCache::Data::Map(const syString& filename) {
+    syPeakMapping mapping;
+    if(!mapping.Map(filename.c_str()) || mapping.m_Size < sizeof(syPeakFileHeader)) {
+        return false;
+    }
+    const syPeakFileHeader* header = (const syPeakFileHeader*)mapping.m_Base;
+    if(memcmp(header->m_Magic, sy_peakmagic, sizeof(sy_peakmagic)) != 0 ||
+        header->m_Version != sy_peakversion ||
+        header->m_ByteOrder != sy_peakbyteorder ||
+        header->m_NumLevels != NumLevels ||
+        !header->m_NumChannels || !header->m_SampleFrequency) {
+        return false;
+    }
+    for(unsigned int level = 0; level < NumLevels; ++level) {
+        const syPeakFileLevel& info = header->m_Levels[level];
+        unsigned long long bucketsize = syPeakCache::GetBucketSize(level);
+        if(info.m_BucketSize != bucketsize ||
+            info.m_NumBuckets != (header->m_NumSamples + bucketsize - 1) / bucketsize ||
+            info.m_Offset % sizeof(short) ||
+            info.m_Offset > mapping.m_Size ||
+            info.m_NumBuckets * header->m_NumChannels * sizeof(syPeakEntry) > mapping.m_Size - info.m_Offset) {
+            return false;
+        }
+    }
+
+    // The file is valid; replace the current one. The old one is unmapped by mapping's destructor.
+    syMutexLocker lock(m_Mutex);
+    m_Mapping.Swap(mapping);
+    m_Header = (const syPeakFileHeader*)m_Mapping.m_Base;
+    return true;
+}
+
+void syPeakCache::Data::FlushBucket(unsigned int level) {
+    syPeakAccumulator* acc = &m_Accumulators[level * m_NumChannels];
+    syPeakAccumulator* parent = (level + 1 < NumLevels) ? &m_Accumulators[(level + 1) * m_NumChannels] : NULL;
+    for(unsigned int channel = 0; channel < m_NumChannels; ++channel) {
+        m_Entries[level].push_back(acc[channel].GetEntry());
+        if(parent) {
+            parent[channel].Add(acc[channel]);
+        }
+        acc[channel].Reset();
+    }
+    ++m_NumBuckets[level];
+    if(parent && ++m_ChildBuckets[level + 1] == (1u << sy_peaklevelshift)) {
+        FlushBucket(level + 1);
+        m_ChildBuckets[level + 1] = 0;
+    }
+}
+
+void syPeakCache::Data::GenerateLoop() {
+    AVSource* source = m_Source;
+    unsigned int freq = source->GetAudioFrequency();
+    m_NumChannels = source->GetNumAudioChannels();
+    unsigned long long expected = (unsigned long long)((double)source->GetAudioLength() * freq / AVTIME_T_SCALE);
+
+    TempFile file;
+    syPeakFileHeader header;
+    memset(&header, 0, sizeof(header));
+    bool ok = m_NumChannels && freq && file.Open(m_Filename.c_str()) && file.Write(&header, sizeof(header));
+
+    unsigned int level;
+    m_Accumulators.resize(NumLevels * m_NumChannels);
+    for(level = 0; level < m_Accumulators.size(); ++level) {
+        m_Accumulators[level].Reset();
+    }
+    for(level = 0; level < NumLevels; ++level) {
+        m_ChildBuckets[level] = 0;
+        m_Entries[level].clear();
+        m_NumBuckets[level] = 0;
+    }
+
+    // The finest level is written as it's generated; the others are much smaller, so we keep them until the end.
+    unsigned long long numsamples = 0;
+    unsigned int bucketfill = 0;
+    syAudioBlock block;
+    if(ok) {
+        source->SeekAudio(0);
+    }
+    while(ok && !syThread::MustAbort()) {
+        unsigned long count = source->ReadAudioBlock(&block, sy_peakreadsize);
+        if(!count) {
+            break;
+        }
+        unsigned long pos = 0;
+        while(pos < count) {
+            unsigned int take = sy_peakbucketsize - bucketfill;
+            if(take > count - pos) {
+                take = count - pos;
+            }
+            for(unsigned int channel = 0; channel < m_NumChannels; ++channel) {
+                m_Accumulators[channel].Add(block.GetChannel(channel) + pos, take);
+            }
+            pos += take;
+            bucketfill += take;
+            if(bucketfill == sy_peakbucketsize) {
+                FlushBucket(0);
+                bucketfill = 0;
+            }
+        }
+        if(!m_Entries[0].empty()) {
+            ok = file.Write(&m_Entries[0][0], m_Entries[0].size() * sizeof(syPeakEntry));
+            m_Entries[0].clear();
+        }
+        numsamples += count;
+        if(expected) {
+            float progress = (float)numsamples / expected;
+            m_Progress = (progress < 0.99f) ? progress : 0.99f;
+        }
+    }
+    if(!ok || syThread::MustAbort()) {
+        file.Discard();
+        m_Generating = false;
+        return;
+    }
+
+    // Store the partial buckets at the end.
+    for(level = 0; level < NumLevels; ++level) {
+        if(m_Accumulators[level * m_NumChannels].m_Count) {
+            FlushBucket(level);
+        }
+    }
+    if(!m_Entries[0].empty()) {
+        ok = file.Write(&m_Entries[0][0], m_Entries[0].size() * sizeof(syPeakEntry));
+    }
+
+    memcpy(header.m_Magic, sy_peakmagic, sizeof(sy_peakmagic));
+    header.m_Version = sy_peakversion;
+    header.m_ByteOrder = sy_peakbyteorder;
+    header.m_SampleFrequency = freq;
+    header.m_NumChannels = m_NumChannels;
+    header.m_NumLevels = NumLevels;
+    header.m_NumSamples = numsamples;
+    unsigned long long offset = sizeof(header);
+    for(level = 0; level < NumLevels; ++level) {
+        header.m_Levels[level].m_BucketSize = syPeakCache::GetBucketSize(level);
+        header.m_Levels[level].m_NumBuckets = m_NumBuckets[level];
+        header.m_Levels[level].m_Offset = offset;
+        offset += m_NumBuckets[level] * m_NumChannels * sizeof(syPeakEntry);
+        if(level && ok && !m_Entries[level].empty()) {
+            ok = file.Write(&m_Entries[level][0], m_Entries[level].size() * sizeof(syPeakEntry));
+        }
+        m_Entries[level].clear();
+    }
+    if(ok) {
+        file.Seek(0);
+        ok = file.Write(&header, sizeof(header)) && file.Commit();
+    } else {
+        file.Discard();
+    }
+    if(ok) {
+        Map(m_Filename);
+    }
+    m_Progress = 1.0f;
+    m_Generating = false;
+}
+
+// ---------------------
+// End syPeakCache::Data
+// ---------------------
+
+// -----------------
+// Begin syPeakCache
+// -----------------
+
+syPeakCache::syPeakCache() :
+m_Data(new Data)
+{
+}
+
+syPeakCache::~syPeakCache() {
+    Cancel();
+    delete m_Data;
+}
+
+unsigned int syPeakCache::GetBucketSize(unsigned int level) {
+    if(level >= NumLevels) {
+        return 0;
+    }
+    return sy_peakbucketsize << (level * sy_peaklevelshift);
+}
+
+syString syPeakCache::GetSidecarFilename(const syString& filename) {
+    return filename + ".sypeaks";
+}
+
+bool syPeakCache::Load(const syString& filename) {
+    return m_Data->Map(filename);
+}
+
+void syPeakCache::Close() {
+    syMutexLocker lock(m_Data->m_Mutex);
+    m_Data->m_Mapping.Unmap();
+    m_Data->m_Header = NULL;
+}
+
+bool syPeakCache::IsLoaded() const {
+    syMutexLocker lock(m_Data->m_Mutex);
+    return m_Data->m_Header != NULL;
+}
+
+bool syPeakCache::Generate(AVSource* source, const syString& filename) {
+    Cancel();
+    if(!source) {
+        return false;
+    }
+    m_Data->m_Source = source;
+    m_Data->m_Filename = filename;
+    m_Data->m_Progress = 0.0f;
+    m_Data->m_Generating = true;
+    m_Data->m_Thread = new syPeakCacheThread(m_Data);
+    if(m_Data->m_Thread->Create() != syTHREAD_NO_ERROR || m_Data->m_Thread->Run() != syTHREAD_NO_ERROR) {
+        delete m_Data->m_Thread;
+        m_Data->m_Thread = NULL;
+        m_Data->m_Generating = false;
+        return false;
+    }
+    return true;
+}
+
+void syPeakCache::Cancel() {
+    if(!m_Data->m_Thread) {
+        return;
+    }
+    m_Data->m_Thread->Stop(false);
+    m_Data->m_Thread->Wait();
+    delete m_Data->m_Thread;
+    m_Data->m_Thread = NULL;
+    m_Data->m_Generating = false;
+}
+
+bool syPeakCache::IsGenerating() const {
+    return m_Data->m_Generating;
+}
+
+float syPeakCache::GetProgress() const {
+    return m_Data->m_Progress;
+}
+
+unsigned int syPeakCache::GetSampleFrequency() const {
+    syMutexLocker lock(m_Data->m_Mutex);
+    return m_Data->m_Header ? m_Data->m_Header->m_SampleFrequency : 0;
+}
+
+unsigned int syPeakCache::GetNumChannels() const {
+    syMutexLocker lock(m_Data->m_Mutex);
+    return m_Data->m_Header ? m_Data->m_Header->m_NumChannels : 0;
+}
+
+unsigned long long syPeakCache::GetNumSamples() const {
+    syMutexLocker lock(m_Data->m_Mutex);
+    return m_Data->m_Header ? m_Data->m_Header->m_NumSamples : 0;
+}
+
+unsigned int syPeakCache::GetPeaks(unsigned int channel, unsigned long long first, unsigned long long count, syPeak* dst, unsigned int numpeaks) const {
+    syMutexLocker lock(m_Data->m_Mutex);
+    const syPeakFileHeader* header = m_Data->m_Header;
+    if(!header || channel >= header->m_NumChannels || !numpeaks) {
+        return 0;
+    }
+
+    // Pick the coarsest level that still has a bucket per span.
+    double samplesperpeak = (double)count / numpeaks;
+    unsigned int level = NumLevels - 1;
+    while(level > 0 && GetBucketSize(level) > samplesperpeak) {
+        --level;
+    }
+    const syPeakFileLevel& info = header->m_Levels[level];
+    unsigned long long bucketsize = info.m_BucketSize;
+    unsigned int numchannels = header->m_NumChannels;
+    const syPeakEntry* entries = (const syPeakEntry*)(m_Data->m_Mapping.m_Base + info.m_Offset) + channel;
+
+    unsigned int result = 0;
+    for(unsigned int i = 0; i < numpeaks; ++i) {
+        unsigned long long start = first + (unsigned long long)(i * samplesperpeak);
+        unsigned long long end = first + (unsigned long long)((i + 1) * samplesperpeak);
+        if(end <= start) {
+            end = start + 1;
+        }
+        if(start >= header->m_NumSamples) {
+            dst[i].m_Min = dst[i].m_Max = dst[i].m_Rms = 0.0f;
+            continue;
+        }
+        unsigned long long bucket = start / bucketsize;
+        unsigned long long lastbucket = (end + bucketsize - 1) / bucketsize;
+        if(lastbucket > info.m_NumBuckets) {
+            lastbucket = info.m_NumBuckets;
+        }
+        int minval = entries[bucket * numchannels].m_Min;
+        int maxval = entries[bucket * numchannels].m_Max;
+        double sumsquares = 0.0;
+        for(unsigned long long b = bucket; b < lastbucket; ++b) {
+            const syPeakEntry& entry = entries[b * numchannels];
+            if(entry.m_Min < minval) { minval = entry.m_Min; }
+            if(entry.m_Max > maxval) { maxval = entry.m_Max; }
+            sumsquares += (double)entry.m_Rms * entry.m_Rms;
+        }
+        dst[i].m_Min = minval / sy_peakscale;
+        dst[i].m_Max = maxval / sy_peakscale;
+        dst[i].m_Rms = (float)(sqrt(sumsquares / (lastbucket - bucket)) / sy_peakscale);
+        ++result;
+    }
+    return result;
+}
+
+// ---------------
+// End syPeakCache
+// ---------------
@@ -0,0 +1,123 @@
+/***************************************************************
+ * Name:      sypeakcache.h
+ * Purpose:   Declaration for the syPeakCache class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syPeakCache holds the waveform overview of an audio
+ *            resource, so that it can be drawn at any zoom level
+ *            without decoding the audio.
+ **************************************************************/
+
+#ifndef sypeakcache_h
+#define sypeakcache_h
+
+#include "systring.h"
+
+class AVSource;
+
+/** The levels of a span of samples, in full scale (-1.0 to 1.0). */
+struct syPeak {
+    /** The lowest sample */
+    float m_Min;
+
+    /** The highest sample */
+    float m_Max;
+
+    /** The RMS (root mean square) level */
+    float m_Rms;
+};
+
+/** @brief A multi-resolution cache of the peaks of an audio resource.
+ *
+ *  The samples of each channel are split in buckets, and the minimum, maximum and RMS level of every
+ *  bucket are stored with 16-bit precision. There are syPeakCache::NumLevels levels, with buckets of 256,
+ *  4096 and 65536 samples (see GetBucketSize()); GetPeaks() picks the level that best fits the requested zoom.
+ *
+ *  The cache is stored in a sidecar file next to the resource (see GetSidecarFilename()), which is memory-mapped
+ *  by Load(), so opening a project doesn't need to read it. Generate() creates the file in a background thread
+ *  by reading the whole resource, and loads it when it's done.
+ *
+ *  @note Load(), Generate(), Cancel() and Close() must be called by the same thread. The other methods are thread-safe.
+ */
+class syPeakCache {
+    public:
+        /** Number of resolution levels */
+        static const unsigned int NumLevels = 3;
+
+        /** Standard constructor. */
+        syPeakCache();
+
+        /** Standard destructor. Cancels the generation, if running. */
+        ~syPeakCache();
+
+        /** Gets the number of samples per bucket of a level; 0 if level is out of range. */
+        static unsigned int GetBucketSize(unsigned int level);
+
+        /** Gets the name of the peak file for a resource file. */
+        static syString GetSidecarFilename(const syString& filename);
+
+        /** @brief Maps a peak file into memory.
+         *  @return false if the file doesn't exist or isn't valid (the current peaks, if any, are kept).
+         */
+        bool Load(const syString& filename);
+
+        /** Unloads the peaks. */
+        void Close();
+
+        /** Returns true if the peaks are loaded. */
+        bool IsLoaded() const;
+
+        /** @brief Starts generating a peak file in a background thread.
+         *
+         *  The source is read from the beginning until its end; when done, the file is written and loaded.
+         *  @param source An initialized audio source. It's used only by the cache until the generation is
+         *         finished or cancelled.
+         *  @param filename The file to create.
+         *  @return false if the thread couldn't be started.
+         */
+        bool Generate(AVSource* source, const syString& filename);
+
+        /** Stops the generation, if running. Waits for the thread to finish; no file is written. */
+        void Cancel();
+
+        /** Returns true while the peaks are being generated. */
+        bool IsGenerating() const;
+
+        /** Gets the progress of the generation, from 0.0 to 1.0. */
+        float GetProgress() const;
+
+        /** Gets the sample frequency of the resource, in Hz; 0 if no peaks are loaded. */
+        unsigned int GetSampleFrequency() const;
+
+        /** Gets the number of channels of the resource; 0 if no peaks are loaded. */
+        unsigned int GetNumChannels() const;
+
+        /** Gets the number of samples of the resource; 0 if no peaks are loaded. */
+        unsigned long long GetNumSamples() const;
+
+        /** @brief Gets the peaks of a range of samples.
+         *
+         *  The range is split in numpeaks spans (e.g. one per pixel), and the levels of each span are
+         *  taken from the coarsest level whose buckets aren't bigger than the span.
+         *  @param channel The channel.
+         *  @param first The first sample of the range.
+         *  @param count The number of samples of the range.
+         *  @param dst The destination, with room for numpeaks peaks. The spans past the end of the resource are silent.
+         *  @param numpeaks The number of spans.
+         *  @return The number of spans that hold samples; 0 if no peaks are loaded or channel is out of range.
+         */
+        unsigned int GetPeaks(unsigned int channel, unsigned long long first, unsigned long long count, syPeak* dst, unsigned int numpeaks) const;
+
+    private:
+        class Data;
+        friend class Data;
+        friend class syPeakCacheThread;
+        Data* m_Data;
+
+        syPeakCache(const syPeakCache& copy);
+        syPeakCache& operator=(const syPeakCache& copy);
+};
+
+#endif
@@ -0,0 +1,372 @@
+/***************************************************************
+ * Name:      syresampler.cpp
+ * Purpose:   Implementation of the syResampler class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syResampler holds the fixed-point filter weights
+ *            used to resize images in two passes (horizontal,
+ *            then vertical). The weights are cached, so that
+ *            resizing a whole clip to the same size only
+ *            evaluates the filter once.
+ **************************************************************/
+
+#include "syresampler.h"
+#include "syrowconverter.h"
+#include "sythread.h"
+#include "sentryfuncs.h"
+#include "sysimd.h"
+#include <cmath>
+#include <cstring>
+
+// ------------------
+// Begin kernels
+// ------------------
+
+static inline unsigned char sy_clampweighted(int x) {
+    x >>= syResampleAxis::Shift;
+    return (x < 0) ? 0 : ((x > 255) ? 255 : x);
+}
+
+static void sy_resample_h(const syResampleAxis& axis, const unsigned char* src, unsigned char* dst) {
+    const short* weights = axis.m_Weights;
+    unsigned int taps = axis.m_Taps;
+    for(unsigned int i = 0; i < axis.m_DestLength; ++i, dst += 4, weights += taps) {
+        const unsigned char* p = src + (axis.m_Start[i] << 2);
+        int r = 1 << (syResampleAxis::Shift - 1), g = r, b = r, a = r;
+        for(unsigned int k = 0; k < taps; ++k, p += 4) {
+            r += weights[k]*p[0];
+            g += weights[k]*p[1];
+            b += weights[k]*p[2];
+            a += weights[k]*p[3];
+        }
+        dst[0] = sy_clampweighted(r);
+        dst[1] = sy_clampweighted(g);
+        dst[2] = sy_clampweighted(b);
+        dst[3] = sy_clampweighted(a);
+    }
+}
+
+/** Vertical pass for the bytes [first, last) of each row. */
+static void sy_resample_v(const syResampleAxis& axis, const unsigned char* buffer, unsigned int rowlength, unsigned int y, unsigned char* dst, unsigned int first, unsigned int last) {
+    const short* weights = axis.m_Weights + y*axis.m_Taps;
+    const unsigned char* src = buffer + axis.m_Start[y]*rowlength;
+    for(unsigned int i = first; i < last; ++i) {
+        int sum = 1 << (syResampleAxis::Shift - 1);
+        const unsigned char* p = src + i;
+        for(unsigned int k = 0; k < axis.m_Taps; ++k, p += rowlength) {
+            sum += weights[k]*(*p);
+        }
+        dst[i] = sy_clampweighted(sum);
+    }
+}
+
+#ifdef SY_X86_SIMD
+
+// The SSE2 kernels process two taps at a time: the components of both source pixels are interleaved,
+// so that a single _mm_madd_epi16 multiplies them by their weights and adds them together.
+
+SY_TARGET_SSE2 static void sy_resample_h_sse2(const syResampleAxis& axis, const unsigned char* src, unsigned char* dst) {
+    const short* weights = axis.m_Weights;
+    unsigned int taps = axis.m_Taps;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (syResampleAxis::Shift - 1));
+    for(unsigned int i = 0; i < axis.m_DestLength; ++i, dst += 4, weights += taps) {
+        const unsigned char* p = src + (axis.m_Start[i] << 2);
+        __m128i sum = round;
+        unsigned int k = 0;
+        int p0, p1;
+        for(; k + 2 <= taps; k += 2) {
+            memcpy(&p0, p + (k << 2), 4);
+            memcpy(&p1, p + (k << 2) + 4, 4);
+            __m128i x = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p0), _mm_cvtsi32_si128(p1)), zero);
+            __m128i w = _mm_set1_epi32((weights[k] & 0xffff) | (weights[k + 1] << 16));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(x, w));
+        }
+        if(k < taps) {
+            memcpy(&p0, p + (k << 2), 4);
+            __m128i x = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p0), zero), zero);
+            __m128i w = _mm_set1_epi32(weights[k] & 0xffff);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(x, w));
+        }
+        sum = _mm_srai_epi32(sum, syResampleAxis::Shift);
+        sum = _mm_packs_epi32(sum, sum);
+        int result = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+        memcpy(dst, &result, 4);
+    }
+}
+
+SY_TARGET_SSE2 static void sy_resample_v_sse2(const syResampleAxis& axis, const unsigned char* buffer, unsigned int rowlength, unsigned int y, unsigned char* dst) {
+    const short* weights = axis.m_Weights + y*axis.m_Taps;
+    const unsigned char* src = buffer + axis.m_Start[y]*rowlength;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (syResampleAxis::Shift - 1));
+    unsigned int taps = axis.m_Taps;
+    unsigned int i = 0;
+    for(; i + 16 <= rowlength; i += 16) {
+        __m128i s0 = round, s1 = round, s2 = round, s3 = round;
+        const unsigned char* p = src + i;
+        unsigned int k = 0;
+        for(; k < taps; k += 2, p += rowlength << 1) {
+            __m128i a = _mm_loadu_si128((const __m128i*)p);
+            __m128i b = zero;
+            __m128i w = _mm_set1_epi32(weights[k] & 0xffff);
+            if(k + 1 < taps) {
+                b = _mm_loadu_si128((const __m128i*)(p + rowlength));
+                w = _mm_set1_epi32((weights[k] & 0xffff) | (weights[k + 1] << 16));
+            }
+            __m128i lo = _mm_unpacklo_epi8(a, b);
+            __m128i hi = _mm_unpackhi_epi8(a, b);
+            s0 = _mm_add_epi32(s0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), w));
+            s1 = _mm_add_epi32(s1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), w));
+            s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), w));
+            s3 = _mm_add_epi32(s3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), w));
+        }
+        s0 = _mm_packs_epi32(_mm_srai_epi32(s0, syResampleAxis::Shift), _mm_srai_epi32(s1, syResampleAxis::Shift));
+        s2 = _mm_packs_epi32(_mm_srai_epi32(s2, syResampleAxis::Shift), _mm_srai_epi32(s3, syResampleAxis::Shift));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(s0, s2));
+    }
+    sy_resample_v(axis, buffer, rowlength, y, dst, i, rowlength);
+}
+
+#endif
+
+// ------------------
+// End kernels
+// ------------------
+
+syResampleAxis::syResampleAxis() :
+m_SourceLength(0),
+m_DestLength(0),
+m_Taps(0),
+m_Start(0),
+m_Weights(0)
+{
+}
+
+syResampleAxis::~syResampleAxis() {
+    delete[] m_Start;
+    delete[] m_Weights;
+}
+
+void syResampleAxis::Init(syImageFilter* filter, unsigned int srclength, unsigned int dstlength) {
+    delete[] m_Start;
+    delete[] m_Weights;
+    m_Start = 0;
+    m_Weights = 0;
+    m_SourceLength = srclength;
+    m_DestLength = dstlength;
+    m_Taps = 0;
+    if(!filter || !srclength || !dstlength) {
+        return;
+    }
+
+    // When shrinking, the filter must be stretched to cover all the source pixels.
+    double scale = ((double)dstlength) / srclength;
+    double filter_scale = (scale < 1.0) ? scale : 1.0;
+    double support = filter->GetWidth() / filter_scale;
+    unsigned int taps = (unsigned int)ceil(support)*2 + 1;
+    if(taps > srclength) {
+        taps = srclength;
+    }
+    m_Taps = taps;
+    m_Start = new int[dstlength];
+    m_Weights = new short[dstlength*taps];
+    double fweights[taps];
+    const int one = 1 << Shift;
+
+    for(unsigned int i = 0; i < dstlength; ++i) {
+        // Map the pixel centers, so that the images stay aligned.
+        double center = (i + 0.5) / scale - 0.5;
+        int left = (int)ceil(center - support);
+        if(left < 0) {
+            left = 0;
+        }
+        if(left > (int)(srclength - taps)) {
+            left = srclength - taps;
+        }
+        double weight_sum = 0; // For normalization
+        unsigned int k;
+        for(k = 0; k < taps; ++k) {
+            double delta = center - (left + (int)k);
+            double weight = (fabs(delta) <= support) ? filter->Filter(filter_scale * delta) : 0.0;
+            fweights[k] = weight;
+            weight_sum += weight;
+        }
+
+        short* weights = m_Weights + i*taps;
+        if(fabs(weight_sum) < 0.000000001) {
+            // No pixel is close enough; take the nearest one.
+            for(k = 0; k < taps; ++k) {
+                weights[k] = 0;
+            }
+            int nearest = (int)floor(center + 0.5) - left;
+            if(nearest < 0) {
+                nearest = 0;
+            } else if(nearest >= (int)taps) {
+                nearest = taps - 1;
+            }
+            weights[nearest] = one;
+        } else {
+            // Normalize the weights and give the rounding error to the largest one.
+            int total = 0;
+            unsigned int largest = 0;
+            for(k = 0; k < taps; ++k) {
+                double w = floor(fweights[k] / weight_sum * one + 0.5);
+                if(w > 32767) {
+                    w = 32767;
+                } else if(w < -32768) {
+                    w = -32768;
+                }
+                weights[k] = (short)w;
+                total += weights[k];
+                if(weights[k] > weights[largest]) {
+                    largest = k;
+                }
+            }
+            weights[largest] += one - total;
+        }
+        m_Start[i] = left;
+    }
+}
+
+// ------------------
+// Begin cache
+// ------------------
+
+/** @brief A small Most-Recently-Used list of resamplers. */
+class syResamplerCache {
+    public:
+        /** The number of resamplers kept when they're not in use */
+        static const unsigned int Capacity = 8;
+
+        syResamplerCache();
+        ~syResamplerCache();
+
+        static syResamplerCache& Get();
+
+        syMutex m_Mutex;
+        syResampler* m_Items[Capacity];
+
+        /** Decrements the reference count and deletes the resampler if unused. Must be called with m_Mutex locked. */
+        static void Unref(syResampler* resampler);
+};
+
+syResamplerCache::syResamplerCache() {
+    for(unsigned int i = 0; i < Capacity; ++i) {
+        m_Items[i] = 0;
+    }
+}
+
+syResamplerCache::~syResamplerCache() {
+    for(unsigned int i = 0; i < Capacity; ++i) {
+        if(m_Items[i]) {
+            Unref(m_Items[i]);
+        }
+    }
+}
+
+syResamplerCache& syResamplerCache::Get() {
+    static syResamplerCache cache;
+    return cache;
+}
+
+void syResamplerCache::Unref(syResampler* resampler) {
+    if(--resampler->m_RefCount == 0) {
+        delete resampler;
+    }
+}
+
+// ------------------
+// End cache
+// ------------------
+
+syResampler::syResampler(unsigned int srcwidth, unsigned int srcheight, unsigned int dstwidth, unsigned int dstheight, syFilterType filtertype) :
+m_FilterType(filtertype),
+m_RefCount(1)
+{
+    syImageFilter* filter = syImageFilter::Create(filtertype);
+    AutoDeleter<syImageFilter> deleter(filter);
+    m_X.Init(filter, srcwidth, dstwidth);
+    m_Y.Init(filter, srcheight, dstheight);
+}
+
+syResampler::~syResampler() {
+}
+
+bool syResampler::Matches(unsigned int srcwidth, unsigned int srcheight, unsigned int dstwidth, unsigned int dstheight, syFilterType filtertype) const {
+    return (m_X.m_SourceLength == srcwidth && m_Y.m_SourceLength == srcheight &&
+            m_X.m_DestLength == dstwidth && m_Y.m_DestLength == dstheight && m_FilterType == filtertype);
+}
+
+syResampler* syResampler::Get(unsigned int srcwidth, unsigned int srcheight, unsigned int dstwidth, unsigned int dstheight, syFilterType filtertype) {
+    if(filtertype == filter_none || !srcwidth || !srcheight || !dstwidth || !dstheight) {
+        return 0;
+    }
+    syResamplerCache& cache = syResamplerCache::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    syResampler* result = 0;
+    unsigned int i;
+    for(i = 0; i < syResamplerCache::Capacity; ++i) {
+        if(cache.m_Items[i] && cache.m_Items[i]->Matches(srcwidth, srcheight, dstwidth, dstheight, filtertype)) {
+            result = cache.m_Items[i];
+            break;
+        }
+    }
+    if(result) {
+        // Move it to the front of the list
+        for(; i > 0; --i) {
+            cache.m_Items[i] = cache.m_Items[i - 1];
+        }
+    } else {
+        result = new syResampler(srcwidth, srcheight, dstwidth, dstheight, filtertype);
+        if(cache.m_Items[syResamplerCache::Capacity - 1]) {
+            syResamplerCache::Unref(cache.m_Items[syResamplerCache::Capacity - 1]);
+        }
+        for(i = syResamplerCache::Capacity - 1; i > 0; --i) {
+            cache.m_Items[i] = cache.m_Items[i - 1];
+        }
+    }
+    cache.m_Items[0] = result;
+    ++result->m_RefCount;
+    return result;
+}
+
+void syResampler::Release() {
+    syResamplerCache& cache = syResamplerCache::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    syResamplerCache::Unref(this);
+}
+
+void syResampler::ClearCache() {
+    syResamplerCache& cache = syResamplerCache::Get();
+    syMutexLocker lock(cache.m_Mutex);
+    for(unsigned int i = 0; i < syResamplerCache::Capacity; ++i) {
+        if(cache.m_Items[i]) {
+            syResamplerCache::Unref(cache.m_Items[i]);
+            cache.m_Items[i] = 0;
+        }
+    }
+}
+
+void syResampler::ResampleRow(const unsigned char* src, unsigned char* dst) const {
+    #ifdef SY_X86_SIMD
+    if(syRowConverter::HasSSE2()) {
+        sy_resample_h_sse2(m_X, src, dst);
+        return;
+    }
+    #endif
+    sy_resample_h(m_X, src, dst);
+}
+
+void syResampler::ResampleCols(const unsigned char* buffer, unsigned int y, unsigned char* dst) const {
+    unsigned int rowlength = m_X.m_DestLength << 2;
+    #ifdef SY_X86_SIMD
+    if(syRowConverter::HasSSE2()) {
+        sy_resample_v_sse2(m_Y, buffer, rowlength, y, dst);
+        return;
+    }
+    #endif
+    sy_resample_v(m_Y, buffer, rowlength, y, dst, 0, rowlength);
+}
@@ -0,0 +1,120 @@
+/***************************************************************
+ * Name:      syresampler.h
+ * Purpose:   Declaration for the syResampler class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syResampler holds the fixed-point filter weights
+ *            used to resize images in two passes (horizontal,
+ *            then vertical). The weights are cached, so that
+ *            resizing a whole clip to the same size only
+ *            evaluates the filter once.
+ **************************************************************/
+
+#ifndef syresampler_h
+#define syresampler_h
+
+#include "imagefilters.h"
+
+/** @brief Filter weights for one axis of a resampling operation.
+ *
+ *  Each destination pixel takes m_Taps consecutive source pixels, beginning at m_Start[i].
+ *  The weights are stored as 16-bit fixed point numbers (1.0 = 1 << syResampleAxis::Shift),
+ *  and the weights of each destination pixel always add up to 1.0.
+ */
+class syResampleAxis {
+    public:
+        /** Number of fractional bits of the weights */
+        static const int Shift = 14;
+
+        /** Standard constructor */
+        syResampleAxis();
+
+        /** Standard destructor */
+        ~syResampleAxis();
+
+        /** @brief Calculates the weights.
+         *  @param filter The filter to evaluate.
+         *  @param srclength The number of source pixels.
+         *  @param dstlength The number of destination pixels.
+         */
+        void Init(syImageFilter* filter, unsigned int srclength, unsigned int dstlength);
+
+        /** Number of source pixels */
+        unsigned int m_SourceLength;
+
+        /** Number of destination pixels */
+        unsigned int m_DestLength;
+
+        /** Number of weights for each destination pixel */
+        unsigned int m_Taps;
+
+        /** First source pixel for each destination pixel */
+        int* m_Start;
+
+        /** m_DestLength * m_Taps weights */
+        short* m_Weights;
+};
+
+/** @brief Cached two-pass image resampler.
+ *
+ *  Works with vcfRGB32 rows. First, each source row is resampled horizontally into an intermediate
+ *  buffer (see ResampleRow); then each destination row is resampled vertically from the intermediate
+ *  rows (see ResampleCols). Both passes use integer arithmetic, with SSE2 kernels when available.
+ *
+ *  Resamplers are obtained with Get() and must be released with Release() after use.
+ */
+class syResampler {
+    public:
+        /** @brief Gets a resampler from the cache, creating it if necessary.
+         *  @param srcwidth The source width, in pixels.
+         *  @param srcheight The source height, in pixels.
+         *  @param dstwidth The destination width, in pixels.
+         *  @param dstheight The destination height, in pixels.
+         *  @param filtertype The filter to use.
+         *  @return The resampler, or NULL if filtertype is filter_none.
+         */
+        static syResampler* Get(unsigned int srcwidth, unsigned int srcheight, unsigned int dstwidth, unsigned int dstheight, syFilterType filtertype);
+
+        /** Releases a resampler obtained by Get(). */
+        void Release();
+
+        /** Removes all the unused resamplers from the cache. */
+        static void ClearCache();
+
+        /** @brief Resamples a row horizontally.
+         *  @param src The source row, with m_X.m_SourceLength vcfRGB32 pixels.
+         *  @param dst The destination row, with room for m_X.m_DestLength vcfRGB32 pixels.
+         */
+        void ResampleRow(const unsigned char* src, unsigned char* dst) const;
+
+        /** @brief Resamples a destination row vertically.
+         *  @param buffer The intermediate buffer: m_Y.m_SourceLength rows with m_X.m_DestLength pixels each.
+         *  @param y The destination row to calculate (zero-based).
+         *  @param dst The destination row, with room for m_X.m_DestLength vcfRGB32 pixels.
+         */
+        void ResampleCols(const unsigned char* buffer, unsigned int y, unsigned char* dst) const;
+
+        /** Horizontal weights */
+        syResampleAxis m_X;
+
+        /** Vertical weights */
+        syResampleAxis m_Y;
+
+    private:
+        syResampler(unsigned int srcwidth, unsigned int srcheight, unsigned int dstwidth, unsigned int dstheight, syFilterType filtertype);
+        ~syResampler();
+
+        /** Returns true if the resampler was created with the given parameters */
+        bool Matches(unsigned int srcwidth, unsigned int srcheight, unsigned int dstwidth, unsigned int dstheight, syFilterType filtertype) const;
+
+        syFilterType m_FilterType;
+
+        /** Number of users, counting the cache. Protected by the cache's mutex. */
+        unsigned int m_RefCount;
+
+        friend class syResamplerCache;
+};
+
+#endif
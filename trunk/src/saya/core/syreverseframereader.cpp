@@ -0,0 +1,216 @@
+/***************************************************************
+ * Name:      syreverseframereader.cpp
+ * Purpose:   Implementation of the syReverseFrameReader class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syReverseFrameReader reads a video source backwards,
+ *            a chunk of frames at a time, for reverse playback.
+ **************************************************************/
+
+#include "syreverseframereader.h"
+#include "aborter.h"
+#include "avsource.h"
+#include "sybitmap.h"
+#include "syframecache.h"
+#include "sythread.h"
+#include <cstddef>
+#include <vector>
+
+const unsigned int syReverseFrameReader::DefaultChunkSize = 16;
+const unsigned int syReverseFrameReader::MaxChunkSize = 256;
+
+// --------------------------------
+// Begin syReverseFrameReader::Data
+// --------------------------------
+
+class syReverseFrameReader::Data {
+    public:
+        Data();
+        ~Data();
+
+        /** Deletes the slots. */
+        void FreeSlots();
+
+        /** @brief Decodes the chunk that ends at m_NextFrame.
+         *  @return false if the decoding was aborted.
+         */
+        bool DecodeChunk();
+
+        /** The source being read. */
+        AVSource* m_Source;
+
+        /** Tells when to stop decoding. @see syReverseFrameReader::SetAborter */
+        syAborter* m_Aborter;
+
+        /** The decoded frames of the current chunk, in the source's order. */
+        std::vector<syBitmap*> m_Slots;
+
+        /** Stream position of each frame. */
+        std::vector<avtime_t> m_Positions;
+
+        /** Index of the first frame of the current chunk. */
+        unsigned long m_FirstFrame;
+
+        /** Number of frames in the current chunk. */
+        unsigned int m_Count;
+
+        /** Index of the frame that ReadFrame() returns next. */
+        unsigned long m_NextFrame;
+
+        /** Set when frame 0 has been read. */
+        bool m_Finished;
+
+        // Statistics
+
+        unsigned long m_ChunksDecoded;
+        unsigned long m_FramesDecoded;
+        unsigned long m_FramesRead;
+};
+
+syReverseFrameReader::Data::Data() :
+m_Source(NULL),
+m_Aborter(NULL),
+m_FirstFrame(0),
+m_Count(0),
+m_NextFrame(0),
+m_Finished(true),
+m_ChunksDecoded(0),
+m_FramesDecoded(0),
+m_FramesRead(0)
+{
+}
+
+syReverseFrameReader::Data::~Data() {
+    FreeSlots();
+}
+
+void syReverseFrameReader::Data::FreeSlots() {
+    for(unsigned int i = 0; i < m_Slots.size(); ++i) {
+        delete m_Slots[i];
+    }
+    m_Slots.clear();
+    m_Positions.clear();
+    m_Count = 0;
+}
+
+bool syReverseFrameReader::Data::DecodeChunk() {
+    unsigned int chunksize = m_Slots.size();
+    m_Count = 0;
+    m_FirstFrame = (m_NextFrame + 1 > chunksize) ? m_NextFrame + 1 - chunksize : 0;
+    // Go forward from the start of the chunk, so that the source doesn't have to seek backwards for every frame.
+    for(unsigned long frame = m_FirstFrame; frame <= m_NextFrame; ++frame) {
+        if(m_Aborter ? m_Aborter->MustAbort() : syThread::MustAbort()) {
+            m_Count = 0;
+            return false;
+        }
+        m_Positions[m_Count] = m_Source->SeekVideo(m_Source->GetTimeFromFrameIndex(frame, false));
+        syFrameCache::SendCurrentFrame(m_Source, m_Slots[m_Count]);
+        ++m_Count;
+    }
+    ++m_ChunksDecoded;
+    m_FramesDecoded += m_Count;
+    return true;
+}
+
+// ------------------------------
+// End syReverseFrameReader::Data
+// ------------------------------
+
+syReverseFrameReader::syReverseFrameReader() :
+m_Data(new Data)
+{
+    SetChunkSize(DefaultChunkSize);
+}
+
+syReverseFrameReader::~syReverseFrameReader() {
+    delete m_Data;
+}
+
+void syReverseFrameReader::SetChunkSize(unsigned int chunksize) {
+    if(chunksize < 1) { chunksize = 1; }
+    if(chunksize > MaxChunkSize) { chunksize = MaxChunkSize; }
+    if(chunksize == m_Data->m_Slots.size()) {
+        m_Data->m_Count = 0;
+        return;
+    }
+    m_Data->FreeSlots();
+    m_Data->m_Slots.resize(chunksize, NULL);
+    m_Data->m_Positions.resize(chunksize, 0);
+    for(unsigned int i = 0; i < chunksize; ++i) {
+        m_Data->m_Slots[i] = new syBitmap;
+    }
+}
+
+unsigned int syReverseFrameReader::GetChunkSize() const {
+    return m_Data->m_Slots.size();
+}
+
+void syReverseFrameReader::SetAborter(syAborter* aborter) {
+    m_Data->m_Aborter = aborter;
+}
+
+void syReverseFrameReader::Start(AVSource* source, unsigned long frame) {
+    // The source may have been sought or reopened since the current chunk was decoded.
+    m_Data->m_Count = 0;
+    m_Data->m_Source = source;
+    m_Data->m_NextFrame = frame;
+    m_Data->m_Finished = (source == NULL);
+}
+
+bool syReverseFrameReader::IsFinished() const {
+    return m_Data->m_Finished;
+}
+
+unsigned long syReverseFrameReader::GetNextFrame() const {
+    return m_Data->m_NextFrame;
+}
+
+void syReverseFrameReader::SkipTo(unsigned long frame) {
+    if(!m_Data->m_Finished && frame < m_Data->m_NextFrame) {
+        m_Data->m_NextFrame = frame;
+    }
+}
+
+const syBitmap* syReverseFrameReader::ReadFrame(avtime_t& pos) {
+    if(m_Data->m_Finished) {
+        return NULL;
+    }
+    unsigned long frame = m_Data->m_NextFrame;
+    if(!m_Data->m_Count || frame < m_Data->m_FirstFrame || frame >= m_Data->m_FirstFrame + m_Data->m_Count) {
+        if(!m_Data->DecodeChunk()) {
+            return NULL;
+        }
+    }
+    unsigned int i = frame - m_Data->m_FirstFrame;
+    pos = m_Data->m_Positions[i];
+    if(frame) {
+        m_Data->m_NextFrame = frame - 1;
+    } else {
+        m_Data->m_Finished = true;
+    }
+    ++m_Data->m_FramesRead;
+    return m_Data->m_Slots[i];
+}
+
+void syReverseFrameReader::Clear() {
+    for(unsigned int i = 0; i < m_Data->m_Slots.size(); ++i) {
+        m_Data->m_Slots[i]->ReleaseBuffer(true);
+    }
+    m_Data->m_Count = 0;
+}
+
+syReverseFrameStats syReverseFrameReader::GetStats() const {
+    syReverseFrameStats result;
+    result.m_ChunksDecoded = m_Data->m_ChunksDecoded;
+    result.m_FramesDecoded = m_Data->m_FramesDecoded;
+    result.m_FramesRead = m_Data->m_FramesRead;
+    return result;
+}
+
+void syReverseFrameReader::ResetStats() {
+    m_Data->m_ChunksDecoded = 0;
+    m_Data->m_FramesDecoded = 0;
+    m_Data->m_FramesRead = 0;
+}
@@ -0,0 +1,126 @@
+/***************************************************************
+ * Name:      syreverseframereader.h
+ * Purpose:   Declaration for the syReverseFrameReader class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syReverseFrameReader reads a video source backwards,
+ *            a chunk of frames at a time, for reverse playback.
+ **************************************************************/
+
+#ifndef syreverseframereader_h
+#define syreverseframereader_h
+
+#include "avtypes.h"
+
+class AVSource;
+class syAborter;
+class syBitmap;
+
+/** Statistics of a syReverseFrameReader. @see syReverseFrameReader::GetStats */
+struct syReverseFrameStats {
+    /** Number of chunks decoded */
+    unsigned long m_ChunksDecoded;
+
+    /** Number of frames decoded */
+    unsigned long m_FramesDecoded;
+
+    /** Number of frames returned by ReadFrame() */
+    unsigned long m_FramesRead;
+};
+
+/** @brief Reads the frames of a video source in reverse order.
+ *
+ *  Video sources decode forward from their seek points; seeking one frame back for every frame shown
+ *  would make reverse playback many times costlier than forward playback. Instead, syReverseFrameReader
+ *  decodes a chunk of frames into memory, from the first frame of the chunk to the last, and then returns
+ *  them from the last to the first. When the chunk is used up, the chunk that ends right before it is
+ *  decoded, and so on. Each frame is decoded once, as in forward playback.
+ *
+ *  AVSource has no call to read the next frame, so every frame of a chunk is still sought; but since they're
+ *  sought in the source's order, a source that decodes forward from its current position doesn't need to go
+ *  back to a key frame for each one.
+ *
+ *  The chunk's bitmaps are allocated once, and keep their buffers (which come from syBitmapPool) from chunk
+ *  to chunk.
+ *
+ *  @note The reader isn't thread-safe; it's meant to be used by the Video In thread only.
+ */
+class syReverseFrameReader {
+    public:
+        /** Default number of frames in a chunk */
+        static const unsigned int DefaultChunkSize;
+
+        /** Maximum number of frames in a chunk */
+        static const unsigned int MaxChunkSize;
+
+        /** Standard constructor. */
+        syReverseFrameReader();
+
+        /** Standard destructor. */
+        ~syReverseFrameReader();
+
+        /** @brief Sets the number of frames decoded at a time, and discards the current chunk.
+         *
+         *  Larger chunks mean fewer seeks, but more memory: one full bitmap per frame.
+         */
+        void SetChunkSize(unsigned int chunksize);
+
+        /** Gets the number of frames decoded at a time. */
+        unsigned int GetChunkSize() const;
+
+        /** @brief Sets the object that tells when to stop decoding a chunk (i.e. when playback is paused).
+         *
+         *  Decoding also stops when the current thread must be closed. An aborted chunk is decoded again
+         *  by the next call to ReadFrame().
+         */
+        void SetAborter(syAborter* aborter);
+
+        /** @brief Starts reading a source backwards, discarding the current chunk.
+         *  @param source The video source to read.
+         *  @param frame The index of the first frame to read (i.e. the last one, in the source's order).
+         */
+        void Start(AVSource* source, unsigned long frame);
+
+        /** Returns true if the first frame of the source has already been read. */
+        bool IsFinished() const;
+
+        /** Gets the index of the frame that the next call to ReadFrame() will return. */
+        unsigned long GetNextFrame() const;
+
+        /** @brief Skips frames backwards, so that the next frame read is the given one.
+         *
+         *  Does nothing if the frame isn't before the next one. If the frame is in the current chunk,
+         *  no decoding is done.
+         */
+        void SkipTo(unsigned long frame);
+
+        /** @brief Reads the next frame, going backwards.
+         *
+         *  If the frame isn't in the current chunk, a new chunk is decoded first.
+         *  @param pos Receives the stream position of the frame.
+         *  @return The frame, or NULL if there are no more frames to read. The frame stays valid until the
+         *  next call to any function of the reader.
+         */
+        const syBitmap* ReadFrame(avtime_t& pos);
+
+        /** Discards the current chunk, and gives its buffers back to the pool. */
+        void Clear();
+
+        /** Gets the statistics of the reader since the last ResetStats(). */
+        syReverseFrameStats GetStats() const;
+
+        /** Clears the statistics. */
+        void ResetStats();
+
+    private:
+        class Data;
+        friend class Data;
+        Data* m_Data;
+
+        syReverseFrameReader(const syReverseFrameReader& copy);
+        syReverseFrameReader& operator=(const syReverseFrameReader& copy);
+};
+
+#endif
@@ -0,0 +1,963 @@
+/***************************************************************
+ * Name:      syrowconverter.cpp
+ * Purpose:   Implementation of the syRowConverter class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syRowConverter converts whole rows of pixels between
+ *            color formats, using the fastest kernel available
+ *            for the current CPU (scalar, SSE2 or AVX2).
+ **************************************************************/
+
+#include "syrowconverter.h"
+#include "sybitmap.h"
+#include "sysimd.h"
+#include <cstring>
+
+/** The number of entries in the VideoColorFormat enum */
+static const unsigned int sy_numcolorformats = vcfBGRA32 + 1;
+
+// ------------------
+// Begin scalar kernels
+// ------------------
+
+// Straight copies
+
+static void sy_copy8(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    memcpy(dst, src, width);
+}
+
+static void sy_copy16(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    memcpy(dst, src, width << 1);
+}
+
+static void sy_copy24(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    memcpy(dst, src, width * 3);
+}
+
+static void sy_copy32(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    memcpy(dst, src, width << 2);
+}
+
+// 24 and 32-bit formats. SWAP means that the R and B components must be exchanged.
+
+static void sy_swap32(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, src += 4, dst += 4) {
+        unsigned char c0 = src[0];
+        dst[0] = src[2];
+        dst[1] = src[1];
+        dst[2] = c0;
+        dst[3] = src[3];
+    }
+}
+
+static void sy_swap24(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, src += 3, dst += 3) {
+        unsigned char c0 = src[0];
+        dst[0] = src[2];
+        dst[1] = src[1];
+        dst[2] = c0;
+    }
+}
+
+template<bool SWAP> static void sy_24to32(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, src += 3, dst += 4) {
+        dst[0] = SWAP ? src[2] : src[0];
+        dst[1] = src[1];
+        dst[2] = SWAP ? src[0] : src[2];
+        dst[3] = 0;
+    }
+}
+
+template<bool SWAP> static void sy_32to24(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, src += 4, dst += 3) {
+        dst[0] = SWAP ? src[2] : src[0];
+        dst[1] = src[1];
+        dst[2] = SWAP ? src[0] : src[2];
+    }
+}
+
+// Premultiplied alpha formats. Going from 32-bit RGB, the pixels become opaque; going back, dropping the
+// alpha is the same as compositing over black, so a copy (or swap) does it.
+
+template<bool SWAP> static void sy_opaque32(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, src += 4, dst += 4) {
+        unsigned char c0 = src[0];
+        dst[0] = SWAP ? src[2] : c0;
+        dst[1] = src[1];
+        dst[2] = SWAP ? c0 : src[2];
+        dst[3] = 255;
+    }
+}
+
+// 15 and 16-bit formats. RS, GS and BS are the bit positions of each component inside the 16-bit word;
+// GBITS is the number of bits for green (5 or 6). BGR tells whether the 32-bit side is vcfBGR32.
+
+template<int RS, int GS, int BS, int GBITS, bool BGR>
+static void sy_16to32(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, src += 2, dst += 4) {
+        unsigned int p = src[0] | (src[1] << 8);
+        unsigned int r = (p >> RS) & 0x1f;
+        unsigned int g = (p >> GS) & ((1 << GBITS) - 1);
+        unsigned int b = (p >> BS) & 0x1f;
+        r = (r << 3) | (r >> 2);
+        g = (g << (8 - GBITS)) | (g >> (2*GBITS - 8));
+        b = (b << 3) | (b >> 2);
+        dst[0] = BGR ? b : r;
+        dst[1] = g;
+        dst[2] = BGR ? r : b;
+        dst[3] = 0;
+    }
+}
+
+template<int RS, int GS, int BS, int GBITS, bool BGR>
+static void sy_32to16(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, src += 4, dst += 2) {
+        unsigned int r = BGR ? src[2] : src[0];
+        unsigned int g = src[1];
+        unsigned int b = BGR ? src[0] : src[2];
+        unsigned int p = ((r >> 3) << RS) | ((g >> (8 - GBITS)) << GS) | ((b >> 3) << BS);
+        dst[0] = p & 255;
+        dst[1] = p >> 8;
+    }
+}
+
+// 8-bit RGB (3 bits for red and green, 2 for blue).
+
+static void sy_rgb8torgb32(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, ++src, dst += 4) {
+        unsigned int p = *src;
+        unsigned int r = p & 7;
+        unsigned int g = (p >> 3) & 7;
+        unsigned int b = (p >> 6) & 3;
+        dst[0] = (r << 5) | (r << 2) | (r >> 1);
+        dst[1] = (g << 5) | (g << 2) | (g >> 1);
+        dst[2] = b * 0x55;
+        dst[3] = 0;
+    }
+}
+
+static void sy_rgb32torgb8(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, src += 4, ++dst) {
+        *dst = (src[0] >> 5) | ((src[1] >> 5) << 3) | ((src[2] >> 6) << 6);
+    }
+}
+
+// YUV formats. All the computations are done in fixed point, so that the SIMD kernels give exactly
+// the same results as the scalar ones. M is the color matrix (see syColorMatrix).
+
+/** YUV to RGB coefficients, scaled by 64: V->R, U->G, V->G, U->B. Y is scaled by 74.5 (1.164 * 64). */
+static const int sy_yuvtorgb[2][4] = {
+    { 102, -25, -52, 129 }, // BT.601
+    { 115, -14, -34, 135 }  // BT.709
+};
+
+/** RGB to YUV coefficients, scaled by 256: (R, G, B) -> Y, U, V. */
+static const int sy_rgbtoyuv[2][9] = {
+    { 66, 129, 25, -38, -74, 112, 112, -94, -18 }, // BT.601
+    { 47, 157, 16, -26, -87, 112, 112, -102, -10 } // BT.709
+};
+
+static inline unsigned char sy_clamp255(int x) {
+    return (x < 0) ? 0 : ((x > 255) ? 255 : x);
+}
+
+template<int M, bool BGR> static inline void sy_yuvtopixel(int y, int u, int v, unsigned char* dst) {
+    int yy = (y - 16)*74 + ((y - 16) >> 1) + 32;
+    u -= 128;
+    v -= 128;
+    unsigned char r = sy_clamp255((yy + sy_yuvtorgb[M][0]*v) >> 6);
+    unsigned char g = sy_clamp255((yy + sy_yuvtorgb[M][1]*u + sy_yuvtorgb[M][2]*v) >> 6);
+    unsigned char b = sy_clamp255((yy + sy_yuvtorgb[M][3]*u) >> 6);
+    dst[0] = BGR ? b : r;
+    dst[1] = g;
+    dst[2] = BGR ? r : b;
+    dst[3] = 0;
+}
+
+template<int M, bool BGR> static inline int sy_pixeltoy(const unsigned char* src) {
+    int r = BGR ? src[2] : src[0], g = src[1], b = BGR ? src[0] : src[2];
+    return ((sy_rgbtoyuv[M][0]*r + sy_rgbtoyuv[M][1]*g + sy_rgbtoyuv[M][2]*b + 128) >> 8) + 16;
+}
+
+template<int M, bool BGR> static inline int sy_pixeltou(const unsigned char* src) {
+    int r = BGR ? src[2] : src[0], g = src[1], b = BGR ? src[0] : src[2];
+    return ((sy_rgbtoyuv[M][3]*r + sy_rgbtoyuv[M][4]*g + sy_rgbtoyuv[M][5]*b + 128) >> 8) + 128;
+}
+
+template<int M, bool BGR> static inline int sy_pixeltov(const unsigned char* src) {
+    int r = BGR ? src[2] : src[0], g = src[1], b = BGR ? src[0] : src[2];
+    return ((sy_rgbtoyuv[M][6]*r + sy_rgbtoyuv[M][7]*g + sy_rgbtoyuv[M][8]*b + 128) >> 8) + 128;
+}
+
+// Packed 4:2:2 formats. Y0, U, Y1 and V are the byte positions of each component inside a pair of pixels.
+// If the width is odd, the last pair is only half used.
+
+template<int Y0, int U, int Y1, int V, int M, bool BGR>
+static void sy_yuv422to32(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width >= 2; width -= 2, src += 4, dst += 8) {
+        sy_yuvtopixel<M, BGR>(src[Y0], src[U], src[V], dst);
+        sy_yuvtopixel<M, BGR>(src[Y1], src[U], src[V], dst + 4);
+    }
+    if(width) {
+        sy_yuvtopixel<M, BGR>(src[Y0], src[U], src[V], dst);
+    }
+}
+
+template<int Y0, int U, int Y1, int V, int M, bool BGR>
+static void sy_32toyuv422(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width >= 2; width -= 2, src += 8, dst += 4) {
+        dst[Y0] = sy_pixeltoy<M, BGR>(src);
+        dst[Y1] = sy_pixeltoy<M, BGR>(src + 4);
+        dst[U] = (sy_pixeltou<M, BGR>(src) + sy_pixeltou<M, BGR>(src + 4) + 1) >> 1;
+        dst[V] = (sy_pixeltov<M, BGR>(src) + sy_pixeltov<M, BGR>(src + 4) + 1) >> 1;
+    }
+    if(width) {
+        dst[Y0] = dst[Y1] = sy_pixeltoy<M, BGR>(src);
+        dst[U] = sy_pixeltou<M, BGR>(src);
+        dst[V] = sy_pixeltov<M, BGR>(src);
+    }
+}
+
+// Planar 4:2:0 formats. Each U and V sample is shared by two pixels of the row.
+
+template<int M, bool BGR>
+static void sy_yuv420to32(const unsigned char* y, const unsigned char* u, const unsigned char* v, unsigned char* dst, unsigned int width) {
+    for(; width >= 2; width -= 2, y += 2, ++u, ++v, dst += 8) {
+        sy_yuvtopixel<M, BGR>(y[0], *u, *v, dst);
+        sy_yuvtopixel<M, BGR>(y[1], *u, *v, dst + 4);
+    }
+    if(width) {
+        sy_yuvtopixel<M, BGR>(y[0], *u, *v, dst);
+    }
+}
+
+template<int M, bool BGR>
+static void sy_32toyuv420(const unsigned char* src, unsigned char* y, unsigned char* u, unsigned char* v, unsigned int width) {
+    unsigned int i;
+    for(i = 0; i < width; ++i) {
+        y[i] = sy_pixeltoy<M, BGR>(src + (i << 2));
+    }
+    if(!u || !v) {
+        return;
+    }
+    for(; width >= 2; width -= 2, src += 8, ++u, ++v) {
+        *u = (sy_pixeltou<M, BGR>(src) + sy_pixeltou<M, BGR>(src + 4) + 1) >> 1;
+        *v = (sy_pixeltov<M, BGR>(src) + sy_pixeltov<M, BGR>(src + 4) + 1) >> 1;
+    }
+    if(width) {
+        *u = sy_pixeltou<M, BGR>(src);
+        *v = sy_pixeltov<M, BGR>(src);
+    }
+}
+
+// Y800 (luma only). The chroma is taken as neutral, so the color matrix only matters when packing.
+
+static void sy_y800to32(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, ++src, dst += 4) {
+        sy_yuvtopixel<sy_cmbt601, false>(*src, 128, 128, dst);
+    }
+}
+
+template<int M, bool BGR>
+static void sy_32toy800(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    for(; width; --width, src += 4, ++dst) {
+        *dst = sy_pixeltoy<M, BGR>(src);
+    }
+}
+
+// ------------------
+// End scalar kernels
+// ------------------
+
+#ifdef SY_X86_SIMD
+
+// ----------------
+// Begin SSE2 kernels
+// ----------------
+
+SY_TARGET_SSE2 static void sy_swap32_sse2(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    const __m128i maskag = _mm_set1_epi32(0xff00ff00);
+    const __m128i maskr = _mm_set1_epi32(0x00ff0000);
+    const __m128i maskb = _mm_set1_epi32(0x000000ff);
+    unsigned int i = 0;
+    for(; i + 4 <= width; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + (i << 2)));
+        __m128i y = _mm_and_si128(x, maskag);
+        y = _mm_or_si128(y, _mm_and_si128(_mm_slli_epi32(x, 16), maskr));
+        y = _mm_or_si128(y, _mm_and_si128(_mm_srli_epi32(x, 16), maskb));
+        _mm_storeu_si128((__m128i*)(dst + (i << 2)), y);
+    }
+    sy_swap32(src + (i << 2), dst + (i << 2), width - i);
+}
+
+template<bool SWAP> SY_TARGET_SSE2 static void sy_opaque32_sse2(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    const __m128i maskg = _mm_set1_epi32(0x0000ff00);
+    const __m128i maskr = _mm_set1_epi32(0x00ff0000);
+    const __m128i maskb = _mm_set1_epi32(0x000000ff);
+    const __m128i maska = _mm_set1_epi32(0xff000000);
+    unsigned int i = 0;
+    for(; i + 4 <= width; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + (i << 2)));
+        __m128i y;
+        if(SWAP) {
+            y = _mm_and_si128(x, maskg);
+            y = _mm_or_si128(y, _mm_and_si128(_mm_slli_epi32(x, 16), maskr));
+            y = _mm_or_si128(y, _mm_and_si128(_mm_srli_epi32(x, 16), maskb));
+        } else {
+            y = x;
+        }
+        _mm_storeu_si128((__m128i*)(dst + (i << 2)), _mm_or_si128(y, maska));
+    }
+    sy_opaque32<SWAP>(src + (i << 2), dst + (i << 2), width - i);
+}
+
+template<int RS, int GS, int BS, int GBITS, bool BGR>
+SY_TARGET_SSE2 static void sy_16to32_sse2(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    const __m128i mask5 = _mm_set1_epi16(0x1f);
+    const __m128i maskg = _mm_set1_epi16((1 << GBITS) - 1);
+    unsigned int i = 0;
+    for(; i + 8 <= width; i += 8) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(src + (i << 1)));
+        __m128i r = _mm_and_si128(_mm_srli_epi16(p, RS), mask5);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(p, GS), maskg);
+        __m128i b = _mm_and_si128(_mm_srli_epi16(p, BS), mask5);
+        r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        g = _mm_or_si128(_mm_slli_epi16(g, 8 - GBITS), _mm_srli_epi16(g, 2*GBITS - 8));
+        b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+        // Each 16-bit lane of lo holds the first two bytes of the pixel; hi holds the third one.
+        __m128i lo = _mm_or_si128(BGR ? b : r, _mm_slli_epi16(g, 8));
+        __m128i hi = BGR ? r : b;
+        _mm_storeu_si128((__m128i*)(dst + (i << 2)), _mm_unpacklo_epi16(lo, hi));
+        _mm_storeu_si128((__m128i*)(dst + (i << 2) + 16), _mm_unpackhi_epi16(lo, hi));
+    }
+    sy_16to32<RS, GS, BS, GBITS, BGR>(src + (i << 1), dst + (i << 2), width - i);
+}
+
+template<int RS, int GS, int BS, int GBITS, bool BGR>
+SY_TARGET_SSE2 static void sy_32to16_sse2(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    const __m128i mask8 = _mm_set1_epi32(0xff);
+    unsigned int i = 0;
+    for(; i + 8 <= width; i += 8) {
+        __m128i x0 = _mm_loadu_si128((const __m128i*)(src + (i << 2)));
+        __m128i x1 = _mm_loadu_si128((const __m128i*)(src + (i << 2) + 16));
+        __m128i c0 = _mm_packs_epi32(_mm_and_si128(x0, mask8), _mm_and_si128(x1, mask8));
+        __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(x0, 8), mask8), _mm_and_si128(_mm_srli_epi32(x1, 8), mask8));
+        __m128i c2 = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(x0, 16), mask8), _mm_and_si128(_mm_srli_epi32(x1, 16), mask8));
+        __m128i r = BGR ? c2 : c0;
+        __m128i b = BGR ? c0 : c2;
+        __m128i p = _mm_slli_epi16(_mm_srli_epi16(r, 3), RS);
+        p = _mm_or_si128(p, _mm_slli_epi16(_mm_srli_epi16(g, 8 - GBITS), GS));
+        p = _mm_or_si128(p, _mm_slli_epi16(_mm_srli_epi16(b, 3), BS));
+        _mm_storeu_si128((__m128i*)(dst + (i << 1)), p);
+    }
+    sy_32to16<RS, GS, BS, GBITS, BGR>(src + (i << 2), dst + (i << 1), width - i);
+}
+
+// YUV to RGB for 8 pixels, with Y, U and V in 16-bit lanes (U and V already duplicated for 4:2:x).
+// The sums may exceed the signed 16-bit range, but they always fit in 16 bits after adding a bias of
+// 384 * 64, so we can shift them as unsigned values and remove the bias afterwards.
+template<int M, bool BGR>
+SY_TARGET_SSE2 static inline void sy_yuvtopixels_sse2(__m128i y, __m128i u, __m128i v, unsigned char* dst) {
+    const __m128i c16 = _mm_set1_epi16(16);
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i c74 = _mm_set1_epi16(74);
+    const __m128i bias = _mm_set1_epi16(24576 + 32);
+    const __m128i unbias = _mm_set1_epi16(384);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c255 = _mm_set1_epi16(255);
+    y = _mm_sub_epi16(y, c16);
+    u = _mm_sub_epi16(u, c128);
+    v = _mm_sub_epi16(v, c128);
+    __m128i yy = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(y, c74), _mm_srai_epi16(y, 1)), bias);
+    __m128i r = _mm_add_epi16(yy, _mm_mullo_epi16(v, _mm_set1_epi16(sy_yuvtorgb[M][0])));
+    __m128i g = _mm_add_epi16(yy, _mm_add_epi16(
+        _mm_mullo_epi16(u, _mm_set1_epi16(sy_yuvtorgb[M][1])), _mm_mullo_epi16(v, _mm_set1_epi16(sy_yuvtorgb[M][2]))));
+    __m128i b = _mm_add_epi16(yy, _mm_mullo_epi16(u, _mm_set1_epi16(sy_yuvtorgb[M][3])));
+    r = _mm_min_epi16(_mm_max_epi16(_mm_sub_epi16(_mm_srli_epi16(r, 6), unbias), zero), c255);
+    g = _mm_min_epi16(_mm_max_epi16(_mm_sub_epi16(_mm_srli_epi16(g, 6), unbias), zero), c255);
+    b = _mm_min_epi16(_mm_max_epi16(_mm_sub_epi16(_mm_srli_epi16(b, 6), unbias), zero), c255);
+    __m128i lo = _mm_or_si128(BGR ? b : r, _mm_slli_epi16(g, 8));
+    __m128i hi = BGR ? r : b;
+    _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(lo, hi));
+    _mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi16(lo, hi));
+}
+
+// Splits 8 RGB32 pixels into R, G and B 16-bit lanes.
+template<bool BGR>
+SY_TARGET_SSE2 static inline void sy_splitpixels_sse2(const unsigned char* src, __m128i& r, __m128i& g, __m128i& b) {
+    const __m128i mask8 = _mm_set1_epi32(0xff);
+    __m128i x0 = _mm_loadu_si128((const __m128i*)src);
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(src + 16));
+    __m128i c0 = _mm_packs_epi32(_mm_and_si128(x0, mask8), _mm_and_si128(x1, mask8));
+    g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(x0, 8), mask8), _mm_and_si128(_mm_srli_epi32(x1, 8), mask8));
+    __m128i c2 = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(x0, 16), mask8), _mm_and_si128(_mm_srli_epi32(x1, 16), mask8));
+    r = BGR ? c2 : c0;
+    b = BGR ? c0 : c2;
+}
+
+// RGB to YUV for 8 pixels. Y can exceed 32767 before shifting, so it's shifted as unsigned.
+// U and V are averaged in pairs and returned in the 32-bit lanes.
+template<int M>
+SY_TARGET_SSE2 static inline void sy_pixelstoyuv_sse2(__m128i r, __m128i g, __m128i b, __m128i& y, __m128i& u, __m128i& v) {
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i one32 = _mm_set1_epi32(1);
+    y = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(sy_rgbtoyuv[M][0])),
+        _mm_mullo_epi16(g, _mm_set1_epi16(sy_rgbtoyuv[M][1]))),
+        _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(sy_rgbtoyuv[M][2])), c128));
+    y = _mm_add_epi16(_mm_srli_epi16(y, 8), _mm_set1_epi16(16));
+    u = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(sy_rgbtoyuv[M][3])),
+        _mm_mullo_epi16(g, _mm_set1_epi16(sy_rgbtoyuv[M][4]))),
+        _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(sy_rgbtoyuv[M][5])), c128));
+    u = _mm_add_epi16(_mm_srai_epi16(u, 8), c128);
+    v = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(sy_rgbtoyuv[M][6])),
+        _mm_mullo_epi16(g, _mm_set1_epi16(sy_rgbtoyuv[M][7]))),
+        _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(sy_rgbtoyuv[M][8])), c128));
+    v = _mm_add_epi16(_mm_srai_epi16(v, 8), c128);
+    u = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(u, one), one32), 1);
+    v = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(v, one), one32), 1);
+}
+
+template<int Y0, int U, int Y1, int V, int M, bool BGR>
+SY_TARGET_SSE2 static void sy_yuv422to32_sse2(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    const __m128i mask8 = _mm_set1_epi16(0xff);
+    unsigned int i = 0;
+    for(; i + 8 <= width; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + (i << 1)));
+        // Even positions hold the luma (YUY2, YVYU) or the chroma (UYVY).
+        __m128i lo = _mm_and_si128(x, mask8);
+        __m128i hi = _mm_srli_epi16(x, 8);
+        __m128i y = (Y0 == 0) ? lo : hi;
+        __m128i c = (Y0 == 0) ? hi : lo;
+        // c holds (U, V) pairs or (V, U) pairs; duplicate each of them for both pixels.
+        __m128i c0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+        __m128i c1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+        bool ufirst = (U < V);
+        sy_yuvtopixels_sse2<M, BGR>(y, ufirst ? c0 : c1, ufirst ? c1 : c0, dst + (i << 2));
+    }
+    sy_yuv422to32<Y0, U, Y1, V, M, BGR>(src + (i << 1), dst + (i << 2), width - i);
+}
+
+template<int Y0, int U, int Y1, int V, int M, bool BGR>
+SY_TARGET_SSE2 static void sy_32toyuv422_sse2(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    unsigned int i = 0;
+    for(; i + 8 <= width; i += 8) {
+        __m128i r, g, b, y, u, v;
+        sy_splitpixels_sse2<BGR>(src + (i << 2), r, g, b);
+        sy_pixelstoyuv_sse2<M>(r, g, b, y, u, v);
+        // Each 32-bit lane now holds the chroma pair in the right order.
+        __m128i c = (U < V) ? _mm_or_si128(u, _mm_slli_epi32(v, 16)) : _mm_or_si128(v, _mm_slli_epi32(u, 16));
+        __m128i x = (Y0 == 0) ? _mm_or_si128(y, _mm_slli_epi16(c, 8)) : _mm_or_si128(c, _mm_slli_epi16(y, 8));
+        _mm_storeu_si128((__m128i*)(dst + (i << 1)), x);
+    }
+    sy_32toyuv422<Y0, U, Y1, V, M, BGR>(src + (i << 2), dst + (i << 1), width - i);
+}
+
+template<int M, bool BGR>
+SY_TARGET_SSE2 static void sy_yuv420to32_sse2(const unsigned char* y, const unsigned char* u, const unsigned char* v, unsigned char* dst, unsigned int width) {
+    const __m128i zero = _mm_setzero_si128();
+    unsigned int i = 0;
+    for(; i + 8 <= width; i += 8) {
+        int u4, v4;
+        memcpy(&u4, u + (i >> 1), 4);
+        memcpy(&v4, v + (i >> 1), 4);
+        __m128i yv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(y + i)), zero);
+        __m128i uv = _mm_unpacklo_epi8(_mm_cvtsi32_si128(u4), zero);
+        __m128i vv = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v4), zero);
+        sy_yuvtopixels_sse2<M, BGR>(yv, _mm_unpacklo_epi16(uv, uv), _mm_unpacklo_epi16(vv, vv), dst + (i << 2));
+    }
+    sy_yuv420to32<M, BGR>(y + i, u + (i >> 1), v + (i >> 1), dst + (i << 2), width - i);
+}
+
+template<int M, bool BGR>
+SY_TARGET_SSE2 static void sy_32toyuv420_sse2(const unsigned char* src, unsigned char* y, unsigned char* u, unsigned char* v, unsigned int width) {
+    unsigned int i = 0;
+    for(; i + 8 <= width; i += 8) {
+        __m128i r, g, b, yv, uv, vv;
+        sy_splitpixels_sse2<BGR>(src + (i << 2), r, g, b);
+        sy_pixelstoyuv_sse2<M>(r, g, b, yv, uv, vv);
+        _mm_storel_epi64((__m128i*)(y + i), _mm_packus_epi16(yv, yv));
+        if(u && v) {
+            uv = _mm_packs_epi32(uv, uv);
+            vv = _mm_packs_epi32(vv, vv);
+            int u4 = _mm_cvtsi128_si32(_mm_packus_epi16(uv, uv));
+            int v4 = _mm_cvtsi128_si32(_mm_packus_epi16(vv, vv));
+            memcpy(u + (i >> 1), &u4, 4);
+            memcpy(v + (i >> 1), &v4, 4);
+        }
+    }
+    sy_32toyuv420<M, BGR>(src + (i << 2), y + i, u ? u + (i >> 1) : 0, v ? v + (i >> 1) : 0, width - i);
+}
+
+// --------------
+// End SSE2 kernels
+// --------------
+
+// ----------------
+// Begin AVX2 kernels
+// ----------------
+
+SY_TARGET_AVX2 static void sy_swap32_avx2(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    const __m256i shuf = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    unsigned int i = 0;
+    for(; i + 8 <= width; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + (i << 2)));
+        _mm256_storeu_si256((__m256i*)(dst + (i << 2)), _mm256_shuffle_epi8(x, shuf));
+    }
+    sy_swap32(src + (i << 2), dst + (i << 2), width - i);
+}
+
+// The 24-bit kernels process 8 pixels (24 bytes) at a time. The first 12 bytes go to the lower lane and
+// the next 12 bytes to the upper lane, so that the byte shuffles never need to cross lanes.
+
+template<bool SWAP> SY_TARGET_AVX2 static void sy_24to32_avx2(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    const __m256i perm = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+    const __m256i shuf = SWAP ?
+        _mm256_setr_epi8(
+            2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128,
+            2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128) :
+        _mm256_setr_epi8(
+            0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128,
+            0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128);
+    unsigned int i = 0;
+    // We load 32 bytes but only use 24, so we must stop before reading past the end of the row.
+    for(; i + 11 <= width; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i*3));
+        x = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(x, perm), shuf);
+        _mm256_storeu_si256((__m256i*)(dst + (i << 2)), x);
+    }
+    sy_24to32<SWAP>(src + i*3, dst + (i << 2), width - i);
+}
+
+template<bool SWAP> SY_TARGET_AVX2 static void sy_32to24_avx2(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    const __m256i perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    const __m256i shuf = SWAP ?
+        _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -128, -128, -128, -128,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -128, -128, -128, -128) :
+        _mm256_setr_epi8(
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -128, -128, -128, -128,
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -128, -128, -128, -128);
+    unsigned int i = 0;
+    for(; i + 8 <= width; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + (i << 2)));
+        x = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(x, shuf), perm);
+        _mm_storeu_si128((__m128i*)(dst + i*3), _mm256_castsi256_si128(x));
+        _mm_storel_epi64((__m128i*)(dst + i*3 + 16), _mm256_extracti128_si256(x, 1));
+    }
+    sy_32to24<SWAP>(src + (i << 2), dst + i*3, width - i);
+}
+
+SY_TARGET_AVX2 static void sy_swap24_avx2(const unsigned char* src, unsigned char* dst, unsigned int width) {
+    const __m256i permin = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+    const __m256i permout = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    const __m256i shuf = _mm256_setr_epi8(
+        2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -128, -128, -128, -128,
+        2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -128, -128, -128, -128);
+    unsigned int i = 0;
+    for(; i + 11 <= width; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i*3));
+        x = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(x, permin), shuf);
+        x = _mm256_permutevar8x32_epi32(x, permout);
+        _mm_storeu_si128((__m128i*)(dst + i*3), _mm256_castsi256_si128(x));
+        _mm_storel_epi64((__m128i*)(dst + i*3 + 16), _mm256_extracti128_si256(x, 1));
+    }
+    sy_swap24(src + i*3, dst + i*3, width - i);
+}
+
+// --------------
+// End AVX2 kernels
+// --------------
+
+#endif
+
+// ----------------------
+// Begin kernel table
+// ----------------------
+
+/** @brief Table with all the kernels, filled according to the CPU capabilities. */
+class syRowConverterTable {
+    public:
+        syRowConverterTable();
+
+        bool m_HasSSE2;
+        bool m_HasAVX2;
+
+        syRowConverterFunc m_Direct[sy_numcolorformats][sy_numcolorformats];
+        syRowConverterFunc m_Unpack[sy_numcolorformats];
+        syRowConverterFunc m_Pack[sy_numcolorformats];
+
+        /** YUV kernels, indexed by [color matrix][YUV format][RGB side is vcfBGR32] */
+        syRowConverterFunc m_YUVUnpack[2][sy_numcolorformats][2];
+        syRowConverterFunc m_YUVPack[2][sy_numcolorformats][2];
+
+        /** Planar 4:2:0 kernels, indexed by [color matrix][RGB side is vcfBGR32] */
+        syPlanarUnpackFunc m_PlanarUnpack[2][2];
+        syPlanarPackFunc m_PlanarPack[2][2];
+
+        static syRowConverterTable& Get();
+
+    private:
+        void Set(VideoColorFormat sourcefmt, VideoColorFormat destfmt, syRowConverterFunc func);
+        template<int RS, int GS, int BS, int GBITS> void Set16(VideoColorFormat format);
+        template<int M, bool BGR> void SetYUV();
+        template<int Y0, int U, int Y1, int V, int M, bool BGR> void SetYUV422(VideoColorFormat format);
+};
+
+syRowConverterTable& syRowConverterTable::Get() {
+    static syRowConverterTable table;
+    return table;
+}
+
+void syRowConverterTable::Set(VideoColorFormat sourcefmt, VideoColorFormat destfmt, syRowConverterFunc func) {
+    m_Direct[sourcefmt][destfmt] = func;
+    if(destfmt == vcfRGB32) {
+        m_Unpack[sourcefmt] = func;
+    }
+    if(sourcefmt == vcfRGB32) {
+        m_Pack[destfmt] = func;
+    }
+}
+
+template<int RS, int GS, int BS, int GBITS> void syRowConverterTable::Set16(VideoColorFormat format) {
+    Set(format, vcfRGB32, sy_16to32<RS, GS, BS, GBITS, false>);
+    Set(format, vcfBGR32, sy_16to32<RS, GS, BS, GBITS, true>);
+    Set(vcfRGB32, format, sy_32to16<RS, GS, BS, GBITS, false>);
+    Set(vcfBGR32, format, sy_32to16<RS, GS, BS, GBITS, true>);
+    #ifdef SY_X86_SIMD
+    if(m_HasSSE2) {
+        Set(format, vcfRGB32, sy_16to32_sse2<RS, GS, BS, GBITS, false>);
+        Set(format, vcfBGR32, sy_16to32_sse2<RS, GS, BS, GBITS, true>);
+        Set(vcfRGB32, format, sy_32to16_sse2<RS, GS, BS, GBITS, false>);
+        Set(vcfBGR32, format, sy_32to16_sse2<RS, GS, BS, GBITS, true>);
+    }
+    #endif
+}
+
+template<int Y0, int U, int Y1, int V, int M, bool BGR> void syRowConverterTable::SetYUV422(VideoColorFormat format) {
+    m_YUVUnpack[M][format][BGR] = sy_yuv422to32<Y0, U, Y1, V, M, BGR>;
+    m_YUVPack[M][format][BGR] = sy_32toyuv422<Y0, U, Y1, V, M, BGR>;
+    #ifdef SY_X86_SIMD
+    if(m_HasSSE2) {
+        m_YUVUnpack[M][format][BGR] = sy_yuv422to32_sse2<Y0, U, Y1, V, M, BGR>;
+        m_YUVPack[M][format][BGR] = sy_32toyuv422_sse2<Y0, U, Y1, V, M, BGR>;
+    }
+    #endif
+}
+
+template<int M, bool BGR> void syRowConverterTable::SetYUV() {
+    SetYUV422<0, 1, 2, 3, M, BGR>(vcfYUY2);
+    SetYUV422<1, 0, 3, 2, M, BGR>(vcfUYVY);
+    SetYUV422<0, 3, 2, 1, M, BGR>(vcfYVYU);
+    m_YUVUnpack[M][vcfY800][BGR] = sy_y800to32; // Gray, so the component order doesn't matter.
+    m_YUVPack[M][vcfY800][BGR] = sy_32toy800<M, BGR>;
+    m_PlanarUnpack[M][BGR] = sy_yuv420to32<M, BGR>;
+    m_PlanarPack[M][BGR] = sy_32toyuv420<M, BGR>;
+    #ifdef SY_X86_SIMD
+    if(m_HasSSE2) {
+        m_PlanarUnpack[M][BGR] = sy_yuv420to32_sse2<M, BGR>;
+        m_PlanarPack[M][BGR] = sy_32toyuv420_sse2<M, BGR>;
+    }
+    #endif
+}
+
+syRowConverterTable::syRowConverterTable() :
+m_HasSSE2(false),
+m_HasAVX2(false)
+{
+    unsigned int i, j;
+    for(i = 0; i < sy_numcolorformats; ++i) {
+        m_Unpack[i] = 0;
+        m_Pack[i] = 0;
+        for(j = 0; j < sy_numcolorformats; ++j) {
+            m_Direct[i][j] = 0;
+        }
+        for(j = 0; j < 4; ++j) {
+            m_YUVUnpack[j >> 1][i][j & 1] = 0;
+            m_YUVPack[j >> 1][i][j & 1] = 0;
+        }
+    }
+
+    #ifdef SY_X86_SIMD
+    __builtin_cpu_init();
+    m_HasSSE2 = __builtin_cpu_supports("sse2");
+    m_HasAVX2 = __builtin_cpu_supports("avx2");
+    #endif
+
+    // Trivial cases: Same color format
+    for(i = 0; i < sy_numcolorformats; ++i) {
+        VideoColorFormat format = (VideoColorFormat)i;
+        switch(syBitmap::CalculateBytesperPixel(format)) {
+            case 1: Set(format, format, sy_copy8); break;
+            case 2: Set(format, format, sy_copy16); break;
+            case 3: Set(format, format, sy_copy24); break;
+            default: Set(format, format, sy_copy32); break;
+        }
+    }
+
+    // 24 and 32-bit formats
+    Set(vcfRGB32, vcfBGR32, sy_swap32);
+    Set(vcfBGR32, vcfRGB32, sy_swap32);
+    Set(vcfRGB24, vcfBGR24, sy_swap24);
+    Set(vcfBGR24, vcfRGB24, sy_swap24);
+    Set(vcfRGB24, vcfRGB32, sy_24to32<false>);
+    Set(vcfBGR24, vcfBGR32, sy_24to32<false>);
+    Set(vcfRGB24, vcfBGR32, sy_24to32<true>);
+    Set(vcfBGR24, vcfRGB32, sy_24to32<true>);
+    Set(vcfRGB32, vcfRGB24, sy_32to24<false>);
+    Set(vcfBGR32, vcfBGR24, sy_32to24<false>);
+    Set(vcfRGB32, vcfBGR24, sy_32to24<true>);
+    Set(vcfBGR32, vcfRGB24, sy_32to24<true>);
+
+    // 8-bit RGB
+    Set(vcfRGB8, vcfRGB32, sy_rgb8torgb32);
+    Set(vcfRGB32, vcfRGB8, sy_rgb32torgb8);
+
+    // Premultiplied alpha formats
+    Set(vcfRGBA32, vcfBGRA32, sy_swap32);
+    Set(vcfBGRA32, vcfRGBA32, sy_swap32);
+    Set(vcfRGBA32, vcfRGB32, sy_copy32);
+    Set(vcfBGRA32, vcfBGR32, sy_copy32);
+    Set(vcfRGBA32, vcfBGR32, sy_swap32);
+    Set(vcfBGRA32, vcfRGB32, sy_swap32);
+    Set(vcfRGB32, vcfRGBA32, sy_opaque32<false>);
+    Set(vcfBGR32, vcfBGRA32, sy_opaque32<false>);
+    Set(vcfRGB32, vcfBGRA32, sy_opaque32<true>);
+    Set(vcfBGR32, vcfRGBA32, sy_opaque32<true>);
+
+    #ifdef SY_X86_SIMD
+    if(m_HasSSE2) {
+        Set(vcfRGB32, vcfBGR32, sy_swap32_sse2);
+        Set(vcfBGR32, vcfRGB32, sy_swap32_sse2);
+        Set(vcfRGBA32, vcfBGRA32, sy_swap32_sse2);
+        Set(vcfBGRA32, vcfRGBA32, sy_swap32_sse2);
+        Set(vcfRGBA32, vcfBGR32, sy_swap32_sse2);
+        Set(vcfBGRA32, vcfRGB32, sy_swap32_sse2);
+        Set(vcfRGB32, vcfRGBA32, sy_opaque32_sse2<false>);
+        Set(vcfBGR32, vcfBGRA32, sy_opaque32_sse2<false>);
+        Set(vcfRGB32, vcfBGRA32, sy_opaque32_sse2<true>);
+        Set(vcfBGR32, vcfRGBA32, sy_opaque32_sse2<true>);
+    }
+    if(m_HasAVX2) {
+        Set(vcfRGB32, vcfBGR32, sy_swap32_avx2);
+        Set(vcfBGR32, vcfRGB32, sy_swap32_avx2);
+        Set(vcfRGB24, vcfBGR24, sy_swap24_avx2);
+        Set(vcfBGR24, vcfRGB24, sy_swap24_avx2);
+        Set(vcfRGB24, vcfRGB32, sy_24to32_avx2<false>);
+        Set(vcfBGR24, vcfBGR32, sy_24to32_avx2<false>);
+        Set(vcfRGB24, vcfBGR32, sy_24to32_avx2<true>);
+        Set(vcfBGR24, vcfRGB32, sy_24to32_avx2<true>);
+        Set(vcfRGB32, vcfRGB24, sy_32to24_avx2<false>);
+        Set(vcfBGR32, vcfBGR24, sy_32to24_avx2<false>);
+        Set(vcfRGB32, vcfBGR24, sy_32to24_avx2<true>);
+        Set(vcfBGR32, vcfRGB24, sy_32to24_avx2<true>);
+    }
+    #endif
+
+    // 15 and 16-bit formats
+    Set16<0, 5, 11, 6>(vcfRGB16);
+    Set16<11, 5, 0, 6>(vcfBGR16);
+    Set16<0, 5, 10, 5>(vcfRGB15);
+    Set16<10, 5, 0, 5>(vcfBGR15);
+
+    // YUV formats. The plain table holds the BT.601 kernels; Init() picks the ones for other matrices.
+    SetYUV<sy_cmbt601, false>();
+    SetYUV<sy_cmbt601, true>();
+    SetYUV<sy_cmbt709, false>();
+    SetYUV<sy_cmbt709, true>();
+    static const VideoColorFormat yuvformats[] = { vcfYUY2, vcfUYVY, vcfYVYU, vcfY800 };
+    for(i = 0; i < sizeof(yuvformats) / sizeof(yuvformats[0]); ++i) {
+        VideoColorFormat format = yuvformats[i];
+        Set(format, vcfRGB32, m_YUVUnpack[sy_cmbt601][format][0]);
+        Set(format, vcfBGR32, m_YUVUnpack[sy_cmbt601][format][1]);
+        Set(vcfRGB32, format, m_YUVPack[sy_cmbt601][format][0]);
+        Set(vcfBGR32, format, m_YUVPack[sy_cmbt601][format][1]);
+    }
+
+    // The _Line32 formats only differ in their row padding.
+    for(i = 0; i < sy_numcolorformats; ++i) {
+        for(j = 0; j < sy_numcolorformats; ++j) {
+            VideoColorFormat srcfmt = syRowConverter::GetPixelFormat((VideoColorFormat)i);
+            VideoColorFormat dstfmt = syRowConverter::GetPixelFormat((VideoColorFormat)j);
+            m_Direct[i][j] = m_Direct[srcfmt][dstfmt];
+        }
+        m_Unpack[i] = m_Unpack[syRowConverter::GetPixelFormat((VideoColorFormat)i)];
+        m_Pack[i] = m_Pack[syRowConverter::GetPixelFormat((VideoColorFormat)i)];
+    }
+}
+
+// --------------------
+// End kernel table
+// --------------------
+
+syRowConverter::syRowConverter() :
+m_Ok(true),
+m_Trivial(true),
+m_SourcePlanar(false),
+m_DestPlanar(false),
+m_SourceBypp(4),
+m_DestBypp(4),
+m_Direct(sy_copy32),
+m_Unpack(0),
+m_Pack(0),
+m_PlanarUnpack(0),
+m_PlanarPack(0),
+m_PlanarDirect(false)
+{
+}
+
+void syRowConverter::Init(VideoColorFormat sourcefmt, VideoColorFormat destfmt, syColorMatrix sourcematrix, syColorMatrix destmatrix) {
+    syRowConverterTable& table = syRowConverterTable::Get();
+    m_SourceBypp = syBitmap::CalculateBytesperPixel(sourcefmt);
+    m_DestBypp = syBitmap::CalculateBytesperPixel(destfmt);
+    m_SourcePlanar = syBitmap::IsPlanarFormat(sourcefmt);
+    m_DestPlanar = syBitmap::IsPlanarFormat(destfmt);
+    m_Trivial = (GetPixelFormat(sourcefmt) == GetPixelFormat(destfmt));
+    m_Direct = table.m_Direct[sourcefmt][destfmt];
+    m_Unpack = table.m_Unpack[sourcefmt];
+    m_Pack = table.m_Pack[destfmt];
+    m_PlanarUnpack = 0;
+    m_PlanarPack = 0;
+    m_PlanarDirect = false;
+    m_Ok = true;
+    if(m_Trivial) {
+        return;
+    }
+
+    bool srcrgb = (sourcefmt == vcfRGB32 || sourcefmt == vcfBGR32);
+    bool dstrgb = (destfmt == vcfRGB32 || destfmt == vcfBGR32);
+    if(syBitmap::IsYUVFormat(sourcefmt)) {
+        m_Unpack = table.m_YUVUnpack[sourcematrix][sourcefmt][0];
+        if(dstrgb) {
+            m_Direct = table.m_YUVUnpack[sourcematrix][sourcefmt][destfmt == vcfBGR32];
+        }
+        if(m_SourcePlanar) {
+            m_PlanarDirect = dstrgb;
+            m_PlanarUnpack = table.m_PlanarUnpack[sourcematrix][destfmt == vcfBGR32];
+        }
+    }
+    if(syBitmap::IsYUVFormat(destfmt)) {
+        m_Pack = table.m_YUVPack[destmatrix][destfmt][0];
+        if(srcrgb) {
+            m_Direct = table.m_YUVPack[destmatrix][destfmt][sourcefmt == vcfBGR32];
+        }
+        if(m_DestPlanar) {
+            m_PlanarDirect = srcrgb;
+            m_PlanarPack = table.m_PlanarPack[destmatrix][sourcefmt == vcfBGR32];
+        }
+    }
+
+    // Two planar formats only differ in the order of their planes, which Convert() always gets as Y, U, V.
+    if(m_SourcePlanar && !m_DestPlanar) {
+        m_Ok = m_PlanarUnpack && (m_PlanarDirect || m_Pack);
+    } else if(m_DestPlanar && !m_SourcePlanar) {
+        m_Ok = m_PlanarPack && (m_PlanarDirect || m_Unpack);
+    } else {
+        m_Ok = m_SourcePlanar || m_Direct || (m_Unpack && m_Pack);
+    }
+}
+
+bool syRowConverter::CanConvert(VideoColorFormat sourcefmt, VideoColorFormat destfmt) {
+    syRowConverter converter;
+    converter.Init(sourcefmt, destfmt);
+    return converter.IsOk();
+}
+
+void syRowConverter::Convert(const unsigned char* src, unsigned char* dst, unsigned int width) const {
+    if(m_Direct) {
+        m_Direct(src, dst, width);
+    } else if(m_Unpack && m_Pack) {
+        // Convert through vcfRGB32 in chunks small enough to stay in the L1 cache.
+        unsigned int buffer[ChunkSize];
+        while(width) {
+            unsigned int chunk = (width < ChunkSize) ? width : ChunkSize;
+            m_Unpack(src, (unsigned char*)buffer, chunk);
+            m_Pack((const unsigned char*)buffer, dst, chunk);
+            src += chunk*m_SourceBypp;
+            dst += chunk*m_DestBypp;
+            width -= chunk;
+        }
+    }
+    // Otherwise, there's no kernel for these formats (see IsOk()); the destination is left untouched.
+}
+
+void syRowConverter::Convert(const unsigned char* const* src, unsigned char* const* dst, unsigned int width) const {
+    if(!m_SourcePlanar && !m_DestPlanar) {
+        Convert(src[0], dst[0], width);
+        return;
+    }
+    if(m_SourcePlanar && m_DestPlanar) {
+        // Since the planes are always given in Y, U, V order, this is a plain copy.
+        memcpy(dst[0], src[0], width);
+        if(dst[1] && dst[2]) {
+            memcpy(dst[1], src[1], (width + 1) >> 1);
+            memcpy(dst[2], src[2], (width + 1) >> 1);
+        }
+        return;
+    }
+
+    // ChunkSize is even, so each chunk starts at the beginning of a chroma sample.
+    unsigned int rgbbuffer[ChunkSize];
+    unsigned char* buffer = (unsigned char*)rgbbuffer;
+    unsigned int ofs = 0;
+    if(m_SourcePlanar) {
+        if(!m_PlanarUnpack || (!m_PlanarDirect && !m_Pack)) {
+            return;
+        } else if(m_PlanarDirect) {
+            m_PlanarUnpack(src[0], src[1], src[2], dst[0], width);
+        } else {
+            for(; ofs < width; ofs += ChunkSize) {
+                unsigned int chunk = (width - ofs < ChunkSize) ? width - ofs : ChunkSize;
+                m_PlanarUnpack(src[0] + ofs, src[1] + (ofs >> 1), src[2] + (ofs >> 1), buffer, chunk);
+                m_Pack(buffer, dst[0] + ofs*m_DestBypp, chunk);
+            }
+        }
+    } else {
+        if(!m_PlanarPack || (!m_PlanarDirect && !m_Unpack)) {
+            return;
+        } else if(m_PlanarDirect) {
+            m_PlanarPack(src[0], dst[0], dst[1], dst[2], width);
+        } else {
+            for(; ofs < width; ofs += ChunkSize) {
+                unsigned int chunk = (width - ofs < ChunkSize) ? width - ofs : ChunkSize;
+                m_Unpack(src[0] + ofs*m_SourceBypp, buffer, chunk);
+                m_PlanarPack(buffer, dst[0] + ofs,
+                    dst[1] ? dst[1] + (ofs >> 1) : 0,
+                    dst[2] ? dst[2] + (ofs >> 1) : 0, chunk);
+            }
+        }
+    }
+}
+
+syRowConverterFunc syRowConverter::GetConverter(VideoColorFormat sourcefmt, VideoColorFormat destfmt) {
+    return syRowConverterTable::Get().m_Direct[sourcefmt][destfmt];
+}
+
+syRowConverterFunc syRowConverter::GetUnpacker(VideoColorFormat format) {
+    return syRowConverterTable::Get().m_Unpack[format];
+}
+
+syRowConverterFunc syRowConverter::GetPacker(VideoColorFormat format) {
+    return syRowConverterTable::Get().m_Pack[format];
+}
+
+VideoColorFormat syRowConverter::GetPixelFormat(VideoColorFormat format) {
+    if(format == vcfRGB24_Line32) {
+        format = vcfRGB24;
+    } else if(format == vcfBGR24_Line32) {
+        format = vcfBGR24;
+    }
+    return format;
+}
+
+bool syRowConverter::HasSSE2() {
+    return syRowConverterTable::Get().m_HasSSE2;
+}
+
+bool syRowConverter::HasAVX2() {
+    return syRowConverterTable::Get().m_HasAVX2;
+}
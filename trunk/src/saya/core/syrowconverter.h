@@ -0,0 +1,131 @@
+/***************************************************************
+ * Name:      syrowconverter.h
+ * Purpose:   Declaration for the syRowConverter class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syRowConverter converts whole rows of pixels between
+ *            color formats, using the fastest kernel available
+ *            for the current CPU (scalar, SSE2 or AVX2).
+ **************************************************************/
+
+#ifndef syrowconverter_h
+#define syrowconverter_h
+
+#include "videocolorformat.h"
+
+/** @brief Row conversion kernel.
+ *  @param src The source pixels
+ *  @param dst The destination pixels
+ *  @param width The number of pixels to convert
+ */
+typedef void (*syRowConverterFunc)(const unsigned char* src, unsigned char* dst, unsigned int width);
+
+/** @brief Row conversion kernel for planar 4:2:0 sources. u and v hold (width + 1) / 2 samples. */
+typedef void (*syPlanarUnpackFunc)(const unsigned char* y, const unsigned char* u, const unsigned char* v, unsigned char* dst, unsigned int width);
+
+/** @brief Row conversion kernel for planar 4:2:0 destinations.
+ *  Since each chroma row is shared by two luma rows, u and v may be NULL to skip the chroma.
+ */
+typedef void (*syPlanarPackFunc)(const unsigned char* src, unsigned char* y, unsigned char* u, unsigned char* v, unsigned int width);
+
+/** @brief Converts rows of pixels between two color formats.
+  *
+  * The kernels are organized in a table indexed by (source format, destination format). The table is
+  * filled only once, according to the capabilities of the CPU, so that picking a kernel costs only a
+  * lookup. When there's no direct kernel for a pair of formats, the row is converted in chunks through
+  * an intermediate vcfRGB32 buffer on the stack.
+  *
+  * All the pixels are stored in little-endian order, following the masks given by syBitmap::Realloc:
+  * for vcfRGB32 the first byte is red; for vcfBGR32 the first byte is blue, and so on.
+  *
+  * YUV formats are converted with the BT.601 or BT.709 matrices. Packed 4:2:2 formats (vcfYUY2, vcfUYVY,
+  * vcfYVYU) work with pairs of pixels, so their rows must hold an even number of pixels. Planar formats
+  * (vcfYV12, vcfYUV12) must be converted with the Convert() version that takes the plane pointers.
+  *
+  * The formats vcfYUV and vcfYUY9 have no kernels yet. When converting from or into them,
+  * IsOk() returns false and Convert() leaves the destination untouched; callers should check IsOk()
+  * (or CanConvert()) and refuse the conversion.
+  */
+class syRowConverter {
+    public:
+        /** Standard constructor. */
+        syRowConverter();
+
+        /** @brief Picks the kernels needed to convert from sourcefmt into destfmt.
+         *  @param sourcefmt The color format of the source pixels.
+         *  @param destfmt The color format of the destination pixels.
+         *  @param sourcematrix The YUV to RGB matrix used when the source is a YUV format.
+         *  @param destmatrix The RGB to YUV matrix used when the destination is a YUV format.
+         */
+        void Init(VideoColorFormat sourcefmt, VideoColorFormat destfmt, syColorMatrix sourcematrix = sy_cmbt601, syColorMatrix destmatrix = sy_cmbt601);
+
+        /** @brief Converts a row of pixels.
+         *  @param src The source pixels, in the color format given to Init().
+         *  @param dst The destination pixels, in the color format given to Init().
+         *  @param width The number of pixels to convert.
+         *  @warning absolutely no memory checking is done. Use with care.
+         *  @note Convert() keeps no state, so several threads may share the same converter.
+         */
+        void Convert(const unsigned char* src, unsigned char* dst, unsigned int width) const;
+
+        /** @brief Converts a row of pixels from / to planar color formats.
+         *  @param src The source planes (Y, U, V). For packed formats, only src[0] is used.
+         *  @param dst The destination planes (Y, U, V). For packed formats, only dst[0] is used.
+         *  If the destination is planar, dst[1] and dst[2] may be NULL to skip writing the chroma.
+         *  @param width The number of pixels to convert.
+         */
+        void Convert(const unsigned char* const* src, unsigned char* const* dst, unsigned int width) const;
+
+        /** Returns false if there's no kernel to convert between the formats given to Init(). */
+        bool IsOk() const { return m_Ok; }
+
+        /** Returns true if source and destination formats share the same memory layout. */
+        bool IsTrivial() const { return m_Trivial; }
+
+        /** Returns true if rows can be converted from sourcefmt into destfmt. */
+        static bool CanConvert(VideoColorFormat sourcefmt, VideoColorFormat destfmt);
+
+        /** @brief Gets the kernel that converts directly between two formats.
+         *  @return The kernel, or NULL if the conversion must be done through vcfRGB32.
+         */
+        static syRowConverterFunc GetConverter(VideoColorFormat sourcefmt, VideoColorFormat destfmt);
+
+        /** Gets the kernel that converts from the given format into vcfRGB32; NULL if unsupported. */
+        static syRowConverterFunc GetUnpacker(VideoColorFormat format);
+
+        /** Gets the kernel that converts from vcfRGB32 into the given format; NULL if unsupported. */
+        static syRowConverterFunc GetPacker(VideoColorFormat format);
+
+        /** Returns the format with the same pixel layout, ignoring the row padding (i.e. vcfRGB24_Line32 -> vcfRGB24). */
+        static VideoColorFormat GetPixelFormat(VideoColorFormat format);
+
+        /** Returns true if the CPU supports SSE2 instructions. */
+        static bool HasSSE2();
+
+        /** Returns true if the CPU supports AVX2 instructions. */
+        static bool HasAVX2();
+
+    private:
+
+        /** The number of pixels converted at a time through the intermediate vcfRGB32 buffer */
+        static const unsigned int ChunkSize = 256;
+
+        bool m_Ok;
+        bool m_Trivial;
+        bool m_SourcePlanar;
+        bool m_DestPlanar;
+        unsigned int m_SourceBypp;
+        unsigned int m_DestBypp;
+        syRowConverterFunc m_Direct;
+        syRowConverterFunc m_Unpack;
+        syRowConverterFunc m_Pack;
+        syPlanarUnpackFunc m_PlanarUnpack;
+        syPlanarPackFunc m_PlanarPack;
+
+        /** Set when the planar kernel converts directly into (or from) the other format. */
+        bool m_PlanarDirect;
+};
+
+#endif
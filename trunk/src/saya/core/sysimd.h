@@ -0,0 +1,25 @@
+/***************************************************************
+ * Name:      sysimd.h
+ * Purpose:   Macros for compiling SIMD kernels
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  The SIMD kernels are compiled with GCC's per-function
+ *            target attributes, so that the rest of the program
+ *            can still be built for older CPUs (i.e. -march=i486).
+ *            They must only be called when the CPU reports that
+ *            it supports them (see syRowConverter::HasSSE2).
+ **************************************************************/
+
+#ifndef sysimd_h
+#define sysimd_h
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && ((__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+    #define SY_X86_SIMD
+    #include <immintrin.h>
+    #define SY_TARGET_SSE2 __attribute__((target("sse2")))
+    #define SY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#endif
@@ -754,6 +754,29 @@ syCondError syCondition::WaitTimeout(unsigned long msec) {
     return result;
 }
 
+syCondError syCondition::WaitUntil(unsigned long long deadline) {
+    #ifdef __WIN32__
+    unsigned long long now = syGetNanoTicks();
+    unsigned long msec = (deadline > now) ? (unsigned long)((deadline - now + 999999) / 1000000) : 0;
+    return WaitTimeout(msec);
+    #else
+    // syGetNanoTicks() counts from the time of day at program's start.
+    timespec tspec;
+    tspec.tv_sec = sySecondsAtInit + (time_t)(deadline / 1000000000ULL);
+    tspec.tv_nsec = (long)(deadline % 1000000000ULL);
+
+    int err = pthread_cond_timedwait( &m_Data->m_cond, m_Data->GetPMutex(), &tspec );
+    switch (err) {
+        case ETIMEDOUT:
+            return syCOND_TIMEOUT;
+        case 0:
+            return syCOND_NO_ERROR;
+        default:
+            return syCOND_MISC_ERROR;
+    }
+    #endif
+}
+
 syCondError syCondition::Signal() {
     #ifdef __WIN32__
     syMutexLocker lock(m_Data->m_csWaiters);
@@ -249,6 +249,12 @@ class syCondition {
 
         /** Same as Wait, but returns syCOND_TIMEOUT after the timeout has ellapsed. */
         syCondError WaitTimeout(unsigned long msec);
+
+        /** @brief Same as Wait, but returns syCOND_TIMEOUT when the system time reaches the deadline.
+         *  @param deadline The deadline, in nanoseconds, as returned by syGetNanoTicks().
+         *  @note Unlike WaitTimeout(), the deadline isn't rounded to milliseconds (except on Windows).
+         */
+        syCondError WaitUntil(unsigned long long deadline);
     private:
         syCondData* m_Data;
 };
@@ -0,0 +1,366 @@
+/***************************************************************
+ * Name:      sytimestretcher.cpp
+ * Purpose:   Implementation of the syTimeStretcher class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syTimeStretcher changes the speed of a stream of
+ *            audio without changing its pitch, so that audio
+ *            can be heard while shuttling.
+ **************************************************************/
+
+#include "sytimestretcher.h"
+#include "syaudioblock.h"
+#include <cmath>
+#include <vector>
+
+/** Length of a frame, in seconds */
+static const double sy_stretchframetime = 0.025;
+
+/** Maximum distance between a frame and its nominal position, in seconds */
+static const double sy_stretchsearchtime = 0.008;
+
+static const double sy_stretchminspeed = 0.25;
+static const double sy_stretchmaxspeed = 4.0;
+
+// ----------------------
+// Begin similarity score
+// ----------------------
+
+/** @brief Adds the correlation of a candidate with the target, and the candidate's energy.
+ *  Only every step-th sample is used.
+ */
+static void sy_stretchcorrelate(const float* target, const float* candidate, unsigned int count, unsigned int step,
+    double& correlation, double& energy) {
+    for(unsigned int i = 0; i < count; i += step) {
+        correlation += target[i] * candidate[i];
+        energy += candidate[i] * candidate[i];
+    }
+}
+
+// --------------------
+// End similarity score
+// --------------------
+
+class syTimeStretcher::Data {
+    public:
+        Data();
+
+        /** Sets up the frame sizes and the window for the current frequency. */
+        void Setup();
+
+        /** @brief Overlap-adds the next frame and makes half a frame of output ready.
+         *  @return false if there isn't enough input.
+         */
+        bool ProcessFrame();
+
+        /** Finds the position of the next frame, around nominal, that best continues the previous one. */
+        long FindFrame(long nominal) const;
+
+        /** @brief Scores how well the frame at pos continues the previous one, using every step-th sample.
+         *  The score is the correlation summed over all channels, divided by the candidate's norm.
+         */
+        double Score(long pos, unsigned int step) const;
+
+        /** Discards the input that won't be used anymore. */
+        void DiscardInput();
+
+        unsigned int m_Freq;
+        unsigned int m_NumChannels;
+        double m_Speed;
+
+        /** Frame length, in samples (an even number) */
+        unsigned int m_FrameSize;
+
+        /** Output hop: half a frame */
+        unsigned int m_Hop;
+
+        /** Maximum distance between a frame and its nominal position, in samples */
+        unsigned int m_SearchRange;
+
+        /** Hann window, m_FrameSize samples. Two halves of it add up to 1. */
+        std::vector<float> m_Window;
+
+        /** The input, per channel */
+        std::vector< std::vector<float> > m_Input;
+
+        /** Nominal position of the next frame in the input */
+        double m_NominalPos;
+
+        /** Position of the previous frame in the input. Before the first frame, it's -m_Hop. */
+        long m_PrevPos;
+
+        /** true once the stretcher has enough input to start */
+        bool m_Started;
+
+        /** The windowed second half of the previous frame, per channel */
+        std::vector< std::vector<float> > m_Overlap;
+
+        /** Output ready to be received, per channel; m_Hop samples. */
+        std::vector< std::vector<float> > m_Ready;
+
+        /** Number of samples of m_Ready already received */
+        unsigned int m_ReadyPos;
+};
+
+syTimeStretcher::Data::Data() :
+m_Freq(0),
+m_NumChannels(0),
+m_Speed(1.0),
+m_FrameSize(0),
+m_Hop(0),
+m_SearchRange(0),
+m_NominalPos(0.0),
+m_PrevPos(0),
+m_Started(false),
+m_ReadyPos(0)
+{
+}
+
+void syTimeStretcher::Data::Setup() {
+    m_FrameSize = ((unsigned int)(m_Freq * sy_stretchframetime) + 1) & ~1u;
+    if(m_FrameSize < 4) {
+        m_FrameSize = 4;
+    }
+    m_Hop = m_FrameSize / 2;
+    m_SearchRange = (unsigned int)(m_Freq * sy_stretchsearchtime);
+    m_Window.resize(m_FrameSize);
+    for(unsigned int i = 0; i < m_FrameSize; ++i) {
+        m_Window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / m_FrameSize));
+    }
+    m_Input.assign(m_NumChannels, std::vector<float>());
+    m_Overlap.assign(m_NumChannels, std::vector<float>(m_Hop, 0.0f));
+    m_Ready.assign(m_NumChannels, std::vector<float>(m_Hop, 0.0f));
+    m_NominalPos = 0.0;
+    m_PrevPos = -(long)m_Hop;
+    m_Started = false;
+    m_ReadyPos = m_Hop;
+}
+
+long syTimeStretcher::Data::FindFrame(long nominal) const {
+    long first = nominal - (long)m_SearchRange;
+    long last = nominal + (long)m_SearchRange;
+    if(first < 0) {
+        first = 0;
+    }
+
+    // First, a coarse search using every other sample and position; then we refine around the best one.
+    long best = first;
+    double bestscore = -HUGE_VAL;
+    long pos;
+    for(pos = first; pos <= last; pos += 2) {
+        double score = Score(pos, 2);
+        if(score > bestscore) {
+            bestscore = score;
+            best = pos;
+        }
+    }
+    long coarse = best;
+    bestscore = -HUGE_VAL;
+    for(pos = coarse - 1; pos <= coarse + 1; ++pos) {
+        if(pos < first || pos > last) {
+            continue;
+        }
+        double score = Score(pos, 1);
+        // On a tie, stay closer to the nominal position.
+        if(score > bestscore || (score == bestscore && labs(pos - nominal) < labs(best - nominal))) {
+            bestscore = score;
+            best = pos;
+        }
+    }
+    return best;
+}
+
+double syTimeStretcher::Data::Score(long pos, unsigned int step) const {
+    double correlation = 0.0;
+    double energy = 0.0;
+    for(unsigned int channel = 0; channel < m_NumChannels; ++channel) {
+        const float* input = &m_Input[channel][0];
+        sy_stretchcorrelate(input + m_PrevPos + m_Hop, input + pos, m_Hop, step, correlation, energy);
+    }
+    return correlation / sqrt(energy + 1e-9);
+}
+
+bool syTimeStretcher::Data::ProcessFrame() {
+    unsigned long length = m_Input[0].size();
+    unsigned int channel, i;
+    if(!m_Started) {
+        // Before the first frame, we make up a previous one whose second half is the start of the input,
+        // so that the output doesn't fade in.
+        if(length < m_Hop) {
+            return false;
+        }
+        for(channel = 0; channel < m_NumChannels; ++channel) {
+            const float* src = &m_Input[channel][0];
+            float* overlap = &m_Overlap[channel][0];
+            for(i = 0; i < m_Hop; ++i) {
+                overlap[i] = src[i] * m_Window[m_Hop + i];
+            }
+        }
+        m_Started = true;
+    }
+
+    long nominal = (long)m_NominalPos;
+    if((unsigned long)(nominal + m_SearchRange + m_FrameSize) > length ||
+        (unsigned long)(m_PrevPos + m_FrameSize) > length) {
+        return false;
+    }
+    long pos = FindFrame(nominal);
+
+    for(channel = 0; channel < m_NumChannels; ++channel) {
+        const float* src = &m_Input[channel][pos];
+        float* overlap = &m_Overlap[channel][0];
+        float* ready = &m_Ready[channel][0];
+        const float* window = &m_Window[0];
+        for(i = 0; i < m_Hop; ++i) {
+            ready[i] = overlap[i] + src[i] * window[i];
+            overlap[i] = src[m_Hop + i] * window[m_Hop + i];
+        }
+    }
+    m_ReadyPos = 0;
+    m_PrevPos = pos;
+    m_NominalPos += m_Hop * m_Speed;
+    DiscardInput();
+    return true;
+}
+
+void syTimeStretcher::Data::DiscardInput() {
+    long keep = m_PrevPos + m_Hop;
+    long nominal = (long)m_NominalPos - (long)m_SearchRange;
+    if(nominal < keep) {
+        keep = nominal;
+    }
+    // Moving the samples is cheap compared with the search, but we don't need to do it on every frame.
+    if(keep < (long)(4 * m_FrameSize)) {
+        return;
+    }
+    for(unsigned int channel = 0; channel < m_NumChannels; ++channel) {
+        m_Input[channel].erase(m_Input[channel].begin(), m_Input[channel].begin() + keep);
+    }
+    m_PrevPos -= keep;
+    m_NominalPos -= keep;
+}
+
+// ---------------------
+// Begin syTimeStretcher
+// ---------------------
+
+syTimeStretcher::syTimeStretcher() {
+    m_Data = new Data;
+}
+
+syTimeStretcher::~syTimeStretcher() {
+    delete m_Data;
+}
+
+bool syTimeStretcher::Init(unsigned int freq, unsigned int numchannels) {
+    if(!freq || !numchannels) {
+        m_Data->m_Freq = m_Data->m_NumChannels = 0;
+        return false;
+    }
+    m_Data->m_Freq = freq;
+    m_Data->m_NumChannels = numchannels;
+    m_Data->Setup();
+    return true;
+}
+
+bool syTimeStretcher::IsOk() const {
+    return m_Data->m_NumChannels != 0;
+}
+
+void syTimeStretcher::Reset() {
+    if(IsOk()) {
+        m_Data->Setup();
+    }
+}
+
+unsigned int syTimeStretcher::GetSampleFrequency() const {
+    return m_Data->m_Freq;
+}
+
+unsigned int syTimeStretcher::GetNumChannels() const {
+    return m_Data->m_NumChannels;
+}
+
+double syTimeStretcher::GetMinimumSpeed() {
+    return sy_stretchminspeed;
+}
+
+double syTimeStretcher::GetMaximumSpeed() {
+    return sy_stretchmaxspeed;
+}
+
+void syTimeStretcher::SetSpeed(double speed) {
+    if(speed < sy_stretchminspeed) { speed = sy_stretchminspeed; }
+    if(speed > sy_stretchmaxspeed) { speed = sy_stretchmaxspeed; }
+    m_Data->m_Speed = speed;
+}
+
+double syTimeStretcher::GetSpeed() const {
+    return m_Data->m_Speed;
+}
+
+bool syTimeStretcher::PutSamples(const syAudioBlock* src) {
+    if(!IsOk() || src->GetNumChannels() != m_Data->m_NumChannels) {
+        return false;
+    }
+    unsigned int count = src->GetLength();
+    unsigned int numchannels = m_Data->m_NumChannels;
+    for(unsigned int channel = 0; channel < numchannels; ++channel) {
+        const float* row = src->GetChannel(channel);
+        m_Data->m_Input[channel].insert(m_Data->m_Input[channel].end(), row, row + count);
+    }
+    return true;
+}
+
+unsigned int syTimeStretcher::ReceiveSamples(syAudioBlock* dst, unsigned int maxsamples) {
+    unsigned int numchannels = m_Data->m_NumChannels;
+    if(!IsOk() || !maxsamples) {
+        dst->SetLength(0);
+        return 0;
+    }
+    if(dst->GetNumChannels() != numchannels || dst->GetCapacity() < maxsamples) {
+        dst->Realloc(numchannels, maxsamples);
+    }
+    unsigned int received = 0;
+    while(received < maxsamples) {
+        if(m_Data->m_ReadyPos >= m_Data->m_Hop && !m_Data->ProcessFrame()) {
+            break;
+        }
+        unsigned int count = m_Data->m_Hop - m_Data->m_ReadyPos;
+        if(count > maxsamples - received) {
+            count = maxsamples - received;
+        }
+        for(unsigned int channel = 0; channel < numchannels; ++channel) {
+            const float* src = &m_Data->m_Ready[channel][m_Data->m_ReadyPos];
+            float* row = dst->GetChannel(channel) + received;
+            for(unsigned int i = 0; i < count; ++i) {
+                row[i] = src[i];
+            }
+        }
+        m_Data->m_ReadyPos += count;
+        received += count;
+    }
+    dst->SetLength(received);
+    return received;
+}
+
+unsigned int syTimeStretcher::GetInputNeeded(unsigned int count) const {
+    if(!IsOk()) {
+        return 0;
+    }
+    unsigned int ready = m_Data->m_Hop - m_Data->m_ReadyPos;
+    if(count <= ready) {
+        return 0;
+    }
+    unsigned int frames = (count - ready + m_Data->m_Hop - 1) / m_Data->m_Hop;
+    double lastframe = m_Data->m_NominalPos + (frames - 1) * m_Data->m_Hop * m_Data->m_Speed;
+    unsigned long needed = (unsigned long)lastframe + m_Data->m_SearchRange + m_Data->m_FrameSize;
+    unsigned long length = m_Data->m_Input[0].size();
+    return (needed > length) ? needed - length : 0;
+}
+
+// -------------------
+// End syTimeStretcher
+// -------------------
@@ -0,0 +1,98 @@
+/***************************************************************
+ * Name:      sytimestretcher.h
+ * Purpose:   Declaration for the syTimeStretcher class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syTimeStretcher changes the speed of a stream of
+ *            audio without changing its pitch, so that audio
+ *            can be heard while shuttling.
+ **************************************************************/
+
+#ifndef sytimestretcher_h
+#define sytimestretcher_h
+
+class syAudioBlock;
+
+/** @brief Real-time WSOLA (waveform similarity overlap-add) time stretcher.
+ *
+ *  The output is made of overlapping frames of about 25ms, cross-faded with a Hann window at a fixed hop of half
+ *  a frame. The frames are taken from the input at a hop of half a frame times the speed; each frame is moved
+ *  up to 8ms from its nominal position to the place where it best matches the natural continuation of the
+ *  previous frame, so that the periods of the waveform line up and the pitch is kept.
+ *
+ *  The stretcher is fed with PutSamples() and read with ReceiveSamples(), in blocks of any size. It holds back
+ *  about a frame and a half of input.
+ *
+ *  @note The search is done on all the channels at once, so every channel is moved by the same amount.
+ */
+class syTimeStretcher {
+    public:
+
+        /** Standard constructor. The stretcher must be set up with Init() before use. */
+        syTimeStretcher();
+
+        /** Standard destructor. */
+        ~syTimeStretcher();
+
+        /** @brief Sets up the stretcher and clears its input.
+         *  @param freq The sample frequency, in Hz.
+         *  @param numchannels The number of channels.
+         *  @return false if any of the parameters is 0.
+         */
+        bool Init(unsigned int freq, unsigned int numchannels);
+
+        /** Returns true if Init() succeeded. */
+        bool IsOk() const;
+
+        /** Clears the input and output, as if the stream started again. Call it after a seek. */
+        void Reset();
+
+        /** Gets the sample frequency, in Hz. */
+        unsigned int GetSampleFrequency() const;
+
+        /** Gets the number of channels. */
+        unsigned int GetNumChannels() const;
+
+        /** Gets the lowest speed supported. */
+        static double GetMinimumSpeed();
+
+        /** Gets the highest speed supported. */
+        static double GetMaximumSpeed();
+
+        /** @brief Sets the speed. It can be changed at any time; it's applied from the next frame.
+         *  @param speed The number of input samples per output sample. Clamped to GetMinimumSpeed()..GetMaximumSpeed().
+         */
+        void SetSpeed(double speed);
+
+        /** Gets the speed. */
+        double GetSpeed() const;
+
+        /** @brief Adds samples to the input.
+         *  @param src The samples. Must have GetNumChannels() channels; all its samples (up to its length) are added.
+         *  @return false if the number of channels doesn't match.
+         */
+        bool PutSamples(const syAudioBlock* src);
+
+        /** @brief Gets stretched samples.
+         *  @param dst The destination. It's reallocated if it doesn't have GetNumChannels() channels or room for
+         *         maxsamples samples. Its length is set to the number of samples received.
+         *  @param maxsamples The maximum number of samples to receive.
+         *  @return The number of samples received; less than maxsamples if more input is needed.
+         */
+        unsigned int ReceiveSamples(syAudioBlock* dst, unsigned int maxsamples);
+
+        /** Gets the number of input samples needed to produce count more output samples. */
+        unsigned int GetInputNeeded(unsigned int count) const;
+
+    private:
+        class Data;
+        friend class Data;
+        Data* m_Data;
+
+        syTimeStretcher(const syTimeStretcher& copy);
+        syTimeStretcher& operator=(const syTimeStretcher& copy);
+};
+
+#endif
@@ -0,0 +1,284 @@
+/***************************************************************
+ * Name:      syworkerpool.cpp
+ * Purpose:   Implementation of the syWorkerPool class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syWorkerPool keeps a set of worker threads (one
+ *            per extra CPU core) to split long image operations
+ *            into bands of rows processed in parallel.
+ **************************************************************/
+
+#include "syworkerpool.h"
+#include "sythread.h"
+#include <list>
+#include <vector>
+
+/** Protects the creation and destruction of the global pool */
+static syMutex gs_PoolMutex;
+
+/** The global pool */
+static syWorkerPool* gs_Pool = 0;
+
+/** @brief Shuts the global pool down when the program exits.
+ *
+ *  The idle workers don't poll syThread::MustAbort(), so they must be told to stop before the thread module
+ *  deletes the remaining threads. syWorkerPool::Get() creates it on first use; since it's constructed after
+ *  the thread module, it's destroyed before it.
+ */
+class syWorkerPoolCleanup {
+    public:
+        ~syWorkerPoolCleanup() { syWorkerPool::Shutdown(); }
+};
+
+// ------------------------
+// Begin syWorkerPool::Data
+// ------------------------
+
+/** A job passed to syWorkerPool::Run(). It lives in the stack of the calling thread. */
+class syWorkerJob {
+    public:
+        syWorkerJob(syBandTask* task, unsigned int rows, unsigned int bandcount) :
+            m_Task(task),
+            m_Rows(rows),
+            m_BandCount(bandcount),
+            m_NextBand(0),
+            m_ActiveBands(0),
+            m_Aborted(false) {}
+
+        syBandTask* m_Task;
+
+        /** Number of rows of the job */
+        unsigned int m_Rows;
+
+        /** Number of bands of the job */
+        unsigned int m_BandCount;
+
+        /** The next band to process */
+        unsigned int m_NextBand;
+
+        /** Number of bands being processed right now */
+        unsigned int m_ActiveBands;
+
+        /** Set when the calling thread was told to abort; the remaining bands are skipped. */
+        bool m_Aborted;
+};
+
+class syWorkerPool::Data {
+    public:
+        Data();
+
+        /** Starts the worker threads */
+        void StartWorkers(unsigned int count);
+
+        /** Stops and deletes the worker threads */
+        void StopWorkers();
+
+        /** @brief Waits for bands and processes them until StopWorkers() is called.
+         *  @param slot The worker's slot. @see syBandTask::ProcessBand
+         */
+        void WorkerLoop(unsigned int slot);
+
+        /** @brief Processes the next band of a job.
+         *  @param job A job with bands left to process.
+         *  @param slot The slot of the current thread; 0 if we're the thread that called syWorkerPool::Run().
+         *  @note m_Mutex must be locked before calling this function. It's unlocked while the band is processed.
+         *  Once the job's last band is handed out, the job is removed from m_Jobs.
+         */
+        void ProcessNextBand(syWorkerJob* job, unsigned int slot);
+
+        /** Protects the jobs and the variables below */
+        syMutex m_Mutex;
+
+        /** Signals the workers that a new job has begun */
+        syCondition m_WorkCondition;
+
+        /** Signals the calling threads that the last band of a job was finished */
+        syCondition m_DoneCondition;
+
+        /** The jobs with bands left to hand out, from the oldest to the newest */
+        std::list<syWorkerJob*> m_Jobs;
+
+        /** Set by StopWorkers() to tell the workers to exit */
+        bool m_Stopping;
+
+        /** The worker threads */
+        std::vector<syThread*> m_Workers;
+};
+
+class syWorkerThread : public syThread {
+    public:
+        syWorkerThread(syWorkerPool::Data* parent, unsigned int slot);
+        virtual int Entry();
+
+    private:
+        syWorkerPool::Data* m_Parent;
+        unsigned int m_Slot;
+};
+
+syWorkerThread::syWorkerThread(syWorkerPool::Data* parent, unsigned int slot) :
+syThread(syTHREAD_JOINABLE),
+m_Parent(parent),
+m_Slot(slot)
+{
+}
+
+int syWorkerThread::Entry() {
+    m_Parent->WorkerLoop(m_Slot);
+    return 0;
+}
+
+syWorkerPool::Data::Data() :
+m_WorkCondition(m_Mutex),
+m_DoneCondition(m_Mutex),
+m_Stopping(false)
+{
+}
+
+void syWorkerPool::Data::StartWorkers(unsigned int count) {
+    for(unsigned int i = 0; i < count; ++i) {
+        syThread* worker = new syWorkerThread(this, m_Workers.size() + 1);
+        if(worker->Create() != syTHREAD_NO_ERROR || worker->Run() != syTHREAD_NO_ERROR) {
+            delete worker;
+            break;
+        }
+        m_Workers.push_back(worker);
+    }
+}
+
+void syWorkerPool::Data::StopWorkers() {
+    {
+        syMutexLocker lock(m_Mutex);
+        m_Stopping = true;
+        m_WorkCondition.Broadcast();
+    }
+    for(unsigned int i = 0; i < m_Workers.size(); ++i) {
+        m_Workers[i]->Wait();
+        delete m_Workers[i];
+    }
+    m_Workers.clear();
+}
+
+void syWorkerPool::Data::WorkerLoop(unsigned int slot) {
+    syMutexLocker lock(m_Mutex);
+    while(!m_Stopping) {
+        if(m_Jobs.empty()) {
+            m_WorkCondition.Wait();
+            continue;
+        }
+        ProcessNextBand(m_Jobs.front(), slot);
+    }
+}
+
+void syWorkerPool::Data::ProcessNextBand(syWorkerJob* job, unsigned int slot) {
+    syBandTask* task = job->m_Task;
+    unsigned int first = (job->m_NextBand++)*syWorkerPool::BandHeight;
+    unsigned int last = first + syWorkerPool::BandHeight;
+    if(last > job->m_Rows) {
+        last = job->m_Rows;
+    }
+    if(job->m_NextBand >= job->m_BandCount) {
+        m_Jobs.remove(job);
+    }
+    bool aborted = job->m_Aborted;
+    ++job->m_ActiveBands;
+    m_Mutex.Unlock();
+
+    // Only the calling thread can tell if the job must be aborted. See syBandTask.
+    bool mustabort = !aborted && !slot && task->MustAbort();
+    if(!aborted && !mustabort) {
+        task->ProcessBand(first, last, slot);
+    }
+
+    m_Mutex.Lock();
+    if(mustabort) {
+        job->m_Aborted = true;
+        if(job->m_NextBand < job->m_BandCount) {
+            job->m_NextBand = job->m_BandCount;
+            m_Jobs.remove(job);
+        }
+    }
+    // Once this is done, the calling thread may return from Run(); don't touch the job afterwards.
+    --job->m_ActiveBands;
+    if(!job->m_ActiveBands && job->m_NextBand >= job->m_BandCount) {
+        m_DoneCondition.Broadcast();
+    }
+}
+
+// ----------------------
+// End syWorkerPool::Data
+// ----------------------
+
+// ------------------
+// Begin syWorkerPool
+// ------------------
+
+syWorkerPool::syWorkerPool() :
+m_Data(new Data)
+{
+    int cpucount = syThread::GetCPUCount();
+    if(cpucount > 1) {
+        m_Data->StartWorkers(cpucount - 1); // The calling thread does its share of the work, too.
+    }
+}
+
+syWorkerPool::~syWorkerPool() {
+    m_Data->StopWorkers();
+    delete m_Data;
+}
+
+syWorkerPool* syWorkerPool::Get() {
+    syMutexLocker lock(gs_PoolMutex);
+    static syWorkerPoolCleanup cleanup;
+    if(!gs_Pool) {
+        gs_Pool = new syWorkerPool;
+    }
+    return gs_Pool;
+}
+
+void syWorkerPool::Shutdown() {
+    syMutexLocker lock(gs_PoolMutex);
+    delete gs_Pool;
+    gs_Pool = 0;
+}
+
+unsigned int syWorkerPool::GetThreadCount() const {
+    return m_Data->m_Workers.size() + 1;
+}
+
+bool syWorkerPool::Run(syBandTask* task, unsigned int rows) {
+    if(!task || !rows) {
+        return true;
+    }
+    unsigned int bandcount = (rows + BandHeight - 1) / BandHeight;
+
+    if(bandcount < 2 || m_Data->m_Workers.empty()) {
+        // Too small or no workers: Do everything ourselves.
+        for(unsigned int first = 0; first < rows; first += BandHeight) {
+            if(task->MustAbort()) {
+                return false;
+            }
+            task->ProcessBand(first, (rows - first > BandHeight) ? first + BandHeight : rows, 0);
+        }
+        return true;
+    }
+
+    // We work on our own job only; the workers help with the oldest job first.
+    syWorkerJob job(task, rows, bandcount);
+    syMutexLocker lock(m_Data->m_Mutex);
+    m_Data->m_Jobs.push_back(&job);
+    m_Data->m_WorkCondition.Broadcast();
+
+    while(job.m_NextBand < job.m_BandCount) {
+        m_Data->ProcessNextBand(&job, 0);
+    }
+    while(job.m_ActiveBands) {
+        m_Data->m_DoneCondition.Wait();
+    }
+    return !job.m_Aborted;
+}
+
+// ----------------
+// End syWorkerPool
+// ----------------
@@ -0,0 +1,88 @@
+/***************************************************************
+ * Name:      syworkerpool.h
+ * Purpose:   Declaration for the syWorkerPool class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  syWorkerPool keeps a set of worker threads (one
+ *            per extra CPU core) to split long image operations
+ *            into bands of rows processed in parallel.
+ **************************************************************/
+
+#ifndef syworkerpool_h
+#define syworkerpool_h
+
+#include "aborter.h"
+
+/** @brief A job that can be split into bands of rows.
+ *
+ *  Derive from this class and implement ProcessBand(). Since ProcessBand() is called from several threads
+ *  at the same time, it must only write to its own rows. For temporary rows, allocate one set per slot
+ *  (see syWorkerPool::GetThreadCount()) before running the job, and pick it by the slot of each band.
+ *
+ *  To abort the job, override InternalMustAbort(). It's only called from the thread that called
+ *  syWorkerPool::Run(), so the workers stop when that thread is told to stop.
+ */
+class syBandTask : public syAborter {
+    public:
+        /** Standard constructor */
+        syBandTask() {}
+
+        /** Standard destructor */
+        virtual ~syBandTask() {}
+
+        /** @brief Processes a band of rows.
+         *  @param first The first row of the band.
+         *  @param last The row after the last one of the band.
+         *  @param slot The thread processing the band: 0 for the thread that called syWorkerPool::Run(), and
+         *  from 1 to syWorkerPool::GetThreadCount() - 1 for the workers. No two bands with the same slot are
+         *  processed at once.
+         */
+        virtual void ProcessBand(unsigned int first, unsigned int last, unsigned int slot) = 0;
+};
+
+/** @brief Pool of worker threads for band-parallel jobs.
+ *
+ *  The rows of a job are split into bands of BandHeight rows, which are handed to the workers (and the calling
+ *  thread) one at a time. Before starting each band, the calling thread checks syBandTask::MustAbort(); so
+ *  a job checks for abort every BandHeight rows, just like the single-threaded loops did.
+ *
+ *  Several threads can run jobs at once (i.e. the audio mixer and the compositor, or a job that calls Run()
+ *  from inside a band). Each calling thread works on its own job, and the workers help with the oldest job
+ *  first. Jobs of a single band, or any jobs if there are no workers, run entirely in the calling thread.
+ */
+class syWorkerPool {
+    public:
+        /** Number of rows in each band. Must be even, so that bands don't share 4:2:0 chroma rows. */
+        static const unsigned int BandHeight = 32;
+
+        /** Gets the global pool, creating it (and its threads) if necessary. */
+        static syWorkerPool* Get();
+
+        /** @brief Runs a job and waits for it to finish.
+         *  @param task The job to run. It must not be running already.
+         *  @param rows The number of rows to process.
+         *  @return false if the job was aborted; true otherwise.
+         */
+        bool Run(syBandTask* task, unsigned int rows);
+
+        /** Returns the number of threads working on each job, including the calling thread. */
+        unsigned int GetThreadCount() const;
+
+        /** @brief Stops and deletes the worker threads. Only call it when no jobs are running.
+         *  @note It's called when the program exits, too.
+         */
+        static void Shutdown();
+
+    private:
+        syWorkerPool();
+        ~syWorkerPool();
+
+        class Data;
+        friend class Data;
+        friend class syWorkerThread;
+        Data* m_Data;
+};
+
+#endif
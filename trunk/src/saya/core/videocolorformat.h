@@ -34,7 +34,18 @@ enum VideoColorFormat {
     vcfYUY9,
     vcfY800,
     vcfRGB24_Line32,
-    vcfBGR24_Line32
+    vcfBGR24_Line32,
+    vcfRGBA32, /** Like vcfRGB32, with premultiplied alpha in the fourth byte. */
+    vcfBGRA32 /** Like vcfBGR32, with premultiplied alpha in the fourth byte. */
+};
+
+/** @brief enumerates the color matrices used to convert between YUV and RGB.
+ *
+ *  Both assume studio range (Y from 16 to 235; U and V from 16 to 240).
+ */
+enum syColorMatrix {
+    sy_cmbt601, /** ITU-R BT.601, used for standard definition video. */
+    sy_cmbt709 /** ITU-R BT.709, used for high definition video. */
 };
 
 #endif
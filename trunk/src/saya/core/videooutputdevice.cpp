@@ -174,7 +174,8 @@ void VideoOutputDevice::LoadVideoData(const syBitmap* bitmap) {
     sySafeMutexLocker lock(*m_InputVideoMutex, this);
     if(lock.IsLocked()) {
         // Step one: Read data from bitmap into m_InputBitmap.
-        m_Data->m_InputBitmap->PasteFrom(bitmap,sy_stkeepaspectratio);
+        // Bilinear scaling looks much better than picking the nearest pixels, and it's still cheap enough for previews.
+        m_Data->m_InputBitmap->PasteFrom(bitmap,sy_stkeepaspectratio,filter_bilinear);
 
         // Step two: Swap m_InputBitmap and m_ExtraBitmap.
         m_Data->SwapInputAndExtraBitmaps();
@@ -25,6 +25,10 @@ class AVPlayer::Data : public syEvtHandler {
         Data(AVPlayer* parent);
         ~Data();
         AVPlayer* m_Parent;
+
+        /** The speed set with idSetSpeed; used by idPlay. */
+        float m_Speed;
+
         void OnStop(AVPlayerEvent& event);
         void OnPlay(AVPlayerEvent& event);
         void OnPause(AVPlayerEvent& event);
@@ -39,7 +43,9 @@ class AVPlayer::Data : public syEvtHandler {
         void OnSetSpeed(AVPlayerEvent& event);
 };
 
-AVPlayer::Data::Data(AVPlayer* parent) : m_Parent(parent)
+AVPlayer::Data::Data(AVPlayer* parent) :
+m_Parent(parent),
+m_Speed(1.0)
 {
     m_Parent->m_Delegate = this;
     syConnect(this, AVPlayerEvent::idStop, &AVPlayer::Data::OnStop);
@@ -65,7 +71,7 @@ void AVPlayer::Data::OnStop(AVPlayerEvent& event) {
 }
 
 void AVPlayer::Data::OnPlay(AVPlayerEvent& event) {
-    m_Parent->Play(1.0, 0, false); // Speed, duration, muted
+    m_Parent->Play(m_Speed, 0, false); // Speed, duration, muted
 }
 
 void AVPlayer::Data::OnPause(AVPlayerEvent& event) {
@@ -117,7 +123,11 @@ void AVPlayer::Data::OnGotoSpecificTime(AVPlayerEvent& event) {
 }
 
 void AVPlayer::Data::OnSetSpeed(AVPlayerEvent& event) {
-    // TODO: Implement AVPlayer::Data::OnSetSpeed()
+    m_Speed = event.ExtraParam / 1000.0;
+    if(m_Parent->IsPlaying()) {
+        // Change the speed on the fly; the audio is time-stretched to keep its pitch.
+        m_Parent->Play(m_Speed);
+    }
 }
 
 // ------------------
@@ -0,0 +1,511 @@
+/***************************************************************
+ * Name:      sequencemixer.cpp
+ * Purpose:   Implementation of the SequenceMixer class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  SequenceMixer renders the audio tracks of an
+ *            AVSequence into a single stream, block by block.
+ **************************************************************/
+
+#include "sequencemixer.h"
+#include "core/audiobuffer.h"
+#include "core/avsource.h"
+#include "core/syaudioblock.h"
+#include "core/syworkerpool.h"
+#include "timeline/avclip.h"
+#include "timeline/avclips.h"
+#include "timeline/avsequence.h"
+#include "timeline/avtrack.h"
+#include "timeline/avtracks.h"
+#include "timeline/smapxstr.h"
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <vector>
+
+// -------------------------
+// begin SequenceMixer::Data
+// -------------------------
+
+/** The state of a playing clip, kept between blocks. */
+class syMixerClip {
+    public:
+        syMixerClip();
+        ~syMixerClip();
+
+        /** The clip being played. Only valid during the current block. */
+        const AVClip* m_Clip;
+
+        /** The clip's source */
+        AVSource* m_Source;
+
+        /** Time of the clip's first sample in the source */
+        avtime_t m_SourceStart;
+
+        /** Clip sample (at the mixer's frequency) that the source will read next; ~0 to seek. */
+        unsigned long long m_NextSample;
+
+        /** Source sample (at the source's frequency, counted from m_SourceStart) that the clip reads next */
+        unsigned long long m_SourceSample;
+
+        /** Position of the source after the clip's last read; if it moved, another clip used the source. */
+        avtime_t m_SourcePos;
+
+        /** Clip sample at the beginning of the part played in the current block */
+        unsigned long long m_ClipSample;
+
+        /** First sample of the block covered by the clip */
+        unsigned int m_Offset;
+
+        /** Number of samples of the block covered by the clip */
+        unsigned int m_Count;
+
+        /** Set while the clip plays in the current block */
+        bool m_Active;
+
+        /** The samples read from the source */
+        syAudioBlock m_Input;
+
+        /** The resampled samples */
+        syAudioBlock m_Resampled;
+
+        /** The clip's contribution to the block, at the mixer's frequency. Silent outside of the clip. */
+        syAudioBlock m_Output;
+
+        /** Resamples the source when its frequency isn't the mixer's. */
+        syAudioBuffer* m_Converter;
+};
+
+syMixerClip::syMixerClip() :
+m_Clip(0),
+m_Source(0),
+m_SourceStart(0),
+m_NextSample(~0ULL),
+m_SourceSample(0),
+m_SourcePos(0),
+m_ClipSample(0),
+m_Offset(0),
+m_Count(0),
+m_Active(false),
+m_Converter(0)
+{
+}
+
+syMixerClip::~syMixerClip() {
+    delete m_Converter;
+}
+
+class SequenceMixer::Data : public syBandTask {
+    public:
+        /** Clips indexed by (track number << 32) | clip id */
+        typedef std::map<unsigned long long, syMixerClip*> ClipMap;
+
+        Data();
+        virtual ~Data();
+
+        /** Deletes the clip states, so that every source is sought again. */
+        void ClearClips();
+
+        /** Finds the clips that play in the current block and groups them by source. */
+        void FindClips();
+
+        /** Reads the samples of a clip for the current block. */
+        void ReadClip(syMixerClip* clip);
+
+        /** Reads the clips of the sources in a band (one source per band). */
+        virtual void ProcessBand(unsigned int first, unsigned int last, unsigned int slot);
+
+        /** Adds the rows of a clip, with their gains, to the output channels. */
+        void AddRoutes(const syMixerClip* clip);
+
+        /** Adds one row to an output channel */
+        void AddRoute(unsigned int channel, const float* row, float gain);
+
+        AVSequence* m_Sequence;
+        std::map<unsigned int, AVSource*> m_Sources;
+        unsigned int m_Freq;
+        unsigned int m_NumChannels;
+        unsigned int m_BlockSize;
+        unsigned int m_ParallelThreshold;
+
+        /** The position of the next block, in samples */
+        unsigned long long m_Position;
+
+        ClipMap m_Clips;
+
+        /** The playing clips, grouped by source. Only the first m_NumGroups are used. */
+        std::vector< std::vector<syMixerClip*> > m_Groups;
+        unsigned int m_NumGroups;
+
+        /** The rows mixed into each output channel, and their gains */
+        std::vector< std::vector<const float*> > m_Rows;
+        std::vector< std::vector<float> > m_Gains;
+
+        /** Block used by Render() */
+        syAudioBlock m_Mixed;
+};
+
+SequenceMixer::Data::Data() :
+m_Sequence(0),
+m_Freq(48000),
+m_NumChannels(2),
+m_BlockSize(SequenceMixer::DefaultBlockSize),
+m_ParallelThreshold(SequenceMixer::DefaultParallelThreshold),
+m_Position(0),
+m_NumGroups(0)
+{
+}
+
+SequenceMixer::Data::~Data() {
+    ClearClips();
+}
+
+void SequenceMixer::Data::ClearClips() {
+    for(ClipMap::iterator it = m_Clips.begin(); it != m_Clips.end(); ++it) {
+        delete it->second;
+    }
+    m_Clips.clear();
+}
+
+void SequenceMixer::Data::FindClips() {
+    for(ClipMap::iterator it = m_Clips.begin(); it != m_Clips.end(); ++it) {
+        it->second->m_Active = false;
+    }
+    m_NumGroups = 0;
+    std::map<AVSource*, unsigned int> groupindex;
+    unsigned long long blockend = m_Position + m_BlockSize;
+
+    AVTracks* tracks = m_Sequence->m_AudioTracks;
+    for(unsigned int i = 0; i < tracks->size(); ++i) {
+        AVTrack& track = (*tracks)[i];
+        if(track.m_Hidden) {
+            continue;
+        }
+        std::map<unsigned int, AVClip>& clips = track.m_Clips->data;
+        for(std::map<unsigned int, AVClip>::iterator it = clips.begin(); it != clips.end(); ++it) {
+            const AVClip& clip = it->second;
+            if(clip.m_Hide || clip.m_SourceEndTime < clip.m_SourceStartTime) {
+                continue;
+            }
+            std::map<unsigned int, AVSource*>::const_iterator src = m_Sources.find(clip.m_ResourceId);
+            if(src == m_Sources.end() || !src->second->IsAudio() || !src->second->GetNumAudioChannels()) {
+                continue;
+            }
+            // Don't use operator[]; it would add the clip to the index, which may be being edited.
+            const unsigned int* clipstart = track.m_TimeIndex->find(it->first);
+            if(!clipstart) {
+                continue;
+            }
+            AVSource* source = src->second;
+            unsigned long long start = (unsigned long long)(*clipstart) * m_Freq / 1000;
+            unsigned long long end = start + (unsigned long long)(clip.m_SourceEndTime - clip.m_SourceStartTime + 1) * m_Freq / 1000;
+            if(end <= m_Position || start >= blockend) {
+                continue;
+            }
+
+            syMixerClip*& state = m_Clips[((unsigned long long)i << 32) | it->first];
+            if(!state) {
+                state = new syMixerClip;
+            }
+            if(state->m_Source != source) {
+                state->m_NextSample = ~0ULL;
+                state->m_Source = source;
+            }
+            if(state->m_Output.GetNumChannels() != source->GetNumAudioChannels() || state->m_Output.GetCapacity() != m_BlockSize) {
+                state->m_Output.Realloc(source->GetNumAudioChannels(), m_BlockSize);
+            }
+            state->m_Output.SetLength(m_BlockSize);
+            state->m_Clip = &clip;
+            state->m_SourceStart = (avtime_t)clip.m_SourceStartTime * (AVTIME_T_SCALE / 1000);
+            state->m_Offset = (start > m_Position) ? (unsigned int)(start - m_Position) : 0;
+            state->m_ClipSample = m_Position + state->m_Offset - start;
+            state->m_Count = (unsigned int)(((end < blockend) ? end : blockend) - (m_Position + state->m_Offset));
+            state->m_Active = true;
+            if(state->m_NextSample != state->m_ClipSample) {
+                // The source will be sought; start the resampling again.
+                delete state->m_Converter;
+                state->m_Converter = 0;
+            }
+            if(source->GetAudioFrequency() != m_Freq && !state->m_Converter) {
+                state->m_Converter = new syAudioBuffer(4*m_BlockSize, source->GetNumAudioChannels(), syAudioBuffer::maxbitspersample, m_Freq);
+            }
+
+            // Group the clips by source, so that each source is only read by one thread.
+            std::map<AVSource*, unsigned int>::iterator group = groupindex.find(source);
+            unsigned int g;
+            if(group == groupindex.end()) {
+                g = m_NumGroups++;
+                groupindex[source] = g;
+                if(m_Groups.size() < m_NumGroups) {
+                    m_Groups.resize(m_NumGroups);
+                }
+                m_Groups[g].clear();
+            } else {
+                g = group->second;
+            }
+            m_Groups[g].push_back(state);
+        }
+    }
+
+    // Forget the clips that stopped playing.
+    for(ClipMap::iterator it = m_Clips.begin(); it != m_Clips.end();) {
+        if(!it->second->m_Active) {
+            delete it->second;
+            m_Clips.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void SequenceMixer::Data::ReadClip(syMixerClip* clip) {
+    AVSource* source = clip->m_Source;
+    unsigned int count = clip->m_Count;
+    unsigned int srcfreq = source->GetAudioFrequency();
+    if(clip->m_NextSample != clip->m_ClipSample) {
+        // The clip just started, or the playback jumped.
+        clip->m_SourceSample = clip->m_ClipSample * srcfreq / m_Freq;
+        source->SeekAudio(clip->m_SourceStart + (avtime_t)(clip->m_SourceSample * AVTIME_T_SCALE / srcfreq));
+    } else if(source->GetAudioPos() != clip->m_SourcePos) {
+        // Another clip of the same source read from it; go back to where this clip stopped reading.
+        source->SeekAudio(clip->m_SourceStart + (avtime_t)(clip->m_SourceSample * AVTIME_T_SCALE / srcfreq));
+    }
+    clip->m_NextSample = clip->m_ClipSample + count;
+
+    const syAudioBlock* samples = &clip->m_Input;
+    unsigned int got;
+    if(!clip->m_Converter) {
+        got = source->ReadAudioBlock(&clip->m_Input, count);
+        clip->m_SourceSample += got;
+    } else {
+        // Feed the resampler until it has a block's worth of samples, without overflowing it.
+        syAudioBuffer* converter = clip->m_Converter;
+        unsigned int length;
+        while((length = converter->GetLength()) < count) {
+            unsigned long long room = converter->GetSize() - length;
+            unsigned long long wanted = (unsigned long long)(count - length) * srcfreq / m_Freq + 1;
+            unsigned long long limit = room * srcfreq / m_Freq;
+            limit = (limit > 2) ? limit - 2 : 0;
+            if(wanted > limit) {
+                wanted = limit;
+            }
+            unsigned long read = wanted ? source->ReadAudioBlock(&clip->m_Input, (unsigned long)wanted) : 0;
+            if(!read) {
+                break; // End of the source
+            }
+            clip->m_SourceSample += read;
+            converter->WriteBlock(&clip->m_Input, srcfreq);
+        }
+        got = converter->ReadBlock(&clip->m_Resampled, count);
+        samples = &clip->m_Resampled;
+    }
+    clip->m_SourcePos = source->GetAudioPos();
+
+    syAudioBlock& output = clip->m_Output;
+    output.Silence();
+    for(unsigned int ch = 0; ch < output.GetNumChannels() && ch < samples->GetNumChannels(); ++ch) {
+        memcpy(output.GetChannel(ch) + clip->m_Offset, samples->GetChannel(ch), got*sizeof(float));
+    }
+}
+
+void SequenceMixer::Data::ProcessBand(unsigned int first, unsigned int last, unsigned int slot) {
+    for(unsigned int g = first / syWorkerPool::BandHeight; g*syWorkerPool::BandHeight < last; ++g) {
+        for(unsigned int i = 0; i < m_Groups[g].size(); ++i) {
+            ReadClip(m_Groups[g][i]);
+        }
+    }
+}
+
+void SequenceMixer::Data::AddRoute(unsigned int channel, const float* row, float gain) {
+    if(gain != 0.0f) {
+        m_Rows[channel].push_back(row);
+        m_Gains[channel].push_back(gain);
+    }
+}
+
+void SequenceMixer::Data::AddRoutes(const syMixerClip* clip) {
+    const AVClip* avclip = clip->m_Clip;
+    const syAudioBlock& output = clip->m_Output;
+    double gain = pow(10.0, avclip->m_AudioGain / 20.0);
+    double pan = avclip->m_AudioPan;
+    if(pan < -1.0) { pan = -1.0; }
+    if(pan > 1.0) { pan = 1.0; }
+
+    unsigned int first = 0;
+    unsigned int count = output.GetNumChannels();
+    if(avclip->m_SoloChannel && avclip->m_SoloChannel <= count) {
+        first = avclip->m_SoloChannel - 1;
+        count = 1;
+    }
+
+    if(count == 1) {
+        const float* row = output.GetChannel(first);
+        if(m_NumChannels == 1) {
+            AddRoute(0, row, (float)gain);
+        } else {
+            // Constant power: -3 dB on each side when centered.
+            double angle = (pan + 1.0) * atan(1.0);
+            AddRoute(0, row, (float)(gain * cos(angle)));
+            AddRoute(1, row, (float)(gain * sin(angle)));
+        }
+    } else if(m_NumChannels == 1) {
+        // Downmix to mono.
+        for(unsigned int ch = 0; ch < count; ++ch) {
+            AddRoute(0, output.GetChannel(ch), (float)(gain / count));
+        }
+    } else {
+        // Balance: Attenuate the opposite side.
+        double left = (pan > 0.0) ? 1.0 - pan : 1.0;
+        double right = (pan < 0.0) ? 1.0 + pan : 1.0;
+        for(unsigned int ch = 0; ch < count && ch < m_NumChannels; ++ch) {
+            double chgain = (ch == 0) ? left : ((ch == 1) ? right : 1.0);
+            AddRoute(ch, output.GetChannel(ch), (float)(gain * chgain));
+        }
+    }
+}
+
+// -----------------------
+// end SequenceMixer::Data
+// -----------------------
+
+SequenceMixer::SequenceMixer() {
+    m_Data = new Data;
+}
+
+SequenceMixer::~SequenceMixer() {
+    delete m_Data;
+}
+
+void SequenceMixer::SetSequence(AVSequence* sequence) {
+    m_Data->ClearClips();
+    m_Data->m_Sequence = sequence;
+}
+
+AVSequence* SequenceMixer::GetSequence() const {
+    return m_Data->m_Sequence;
+}
+
+void SequenceMixer::SetSource(unsigned int resourceid, AVSource* source) {
+    // The clips keep a pointer to their source, so a removed source must not be used again.
+    m_Data->ClearClips();
+    if(source) {
+        m_Data->m_Sources[resourceid] = source;
+    } else {
+        m_Data->m_Sources.erase(resourceid);
+    }
+}
+
+void SequenceMixer::SetOutputFormat(unsigned int freq, unsigned int numchannels) {
+    if(freq < 1) { freq = 1; }
+    if(freq > syAudioBuffer::maxsamplefreq) { freq = syAudioBuffer::maxsamplefreq; }
+    if(numchannels < 1) { numchannels = 1; }
+    if(numchannels > syAudioBuffer::maxaudiochannels) { numchannels = syAudioBuffer::maxaudiochannels; }
+    avtime_t position = GetPosition();
+    m_Data->ClearClips();
+    m_Data->m_Freq = freq;
+    m_Data->m_NumChannels = numchannels;
+    Seek(position);
+}
+
+unsigned int SequenceMixer::GetSampleFrequency() const {
+    return m_Data->m_Freq;
+}
+
+unsigned int SequenceMixer::GetNumChannels() const {
+    return m_Data->m_NumChannels;
+}
+
+void SequenceMixer::SetBlockSize(unsigned int blocksize) {
+    if(blocksize < 1) { blocksize = 1; }
+    if(blocksize > syAudioBuffer::maxsamplesperbuffer / 4) { blocksize = syAudioBuffer::maxsamplesperbuffer / 4; }
+    if(blocksize != m_Data->m_BlockSize) {
+        m_Data->ClearClips();
+        m_Data->m_BlockSize = blocksize;
+    }
+}
+
+unsigned int SequenceMixer::GetBlockSize() const {
+    return m_Data->m_BlockSize;
+}
+
+void SequenceMixer::SetParallelThreshold(unsigned int numsources) {
+    m_Data->m_ParallelThreshold = numsources;
+}
+
+unsigned int SequenceMixer::GetParallelThreshold() const {
+    return m_Data->m_ParallelThreshold;
+}
+
+void SequenceMixer::Seek(avtime_t time) {
+    m_Data->m_Position = (unsigned long long)((double)time * m_Data->m_Freq / AVTIME_T_SCALE);
+    // Make every clip seek its source on the next block.
+    for(Data::ClipMap::iterator it = m_Data->m_Clips.begin(); it != m_Data->m_Clips.end(); ++it) {
+        it->second->m_NextSample = ~0ULL;
+    }
+}
+
+avtime_t SequenceMixer::GetPosition() const {
+    return (avtime_t)((double)m_Data->m_Position * AVTIME_T_SCALE / m_Data->m_Freq);
+}
+
+unsigned long long SequenceMixer::GetSamplePosition() const {
+    return m_Data->m_Position;
+}
+
+bool SequenceMixer::MixBlock(syAudioBlock* dst) {
+    if(!m_Data->m_Sequence) {
+        return false;
+    }
+    unsigned int numchannels = m_Data->m_NumChannels;
+    unsigned int blocksize = m_Data->m_BlockSize;
+    if(dst->GetNumChannels() != numchannels || dst->GetCapacity() < blocksize) {
+        dst->Realloc(numchannels, blocksize);
+    }
+    dst->SetLength(blocksize);
+
+    m_Data->FindClips();
+    unsigned int numgroups = m_Data->m_NumGroups;
+    if(m_Data->m_ParallelThreshold && numgroups >= m_Data->m_ParallelThreshold) {
+        // One band per source
+        syWorkerPool::Get()->Run(m_Data, numgroups*syWorkerPool::BandHeight);
+    } else {
+        m_Data->ProcessBand(0, numgroups*syWorkerPool::BandHeight, 0);
+    }
+
+    m_Data->m_Rows.resize(numchannels);
+    m_Data->m_Gains.resize(numchannels);
+    for(unsigned int ch = 0; ch < numchannels; ++ch) {
+        m_Data->m_Rows[ch].clear();
+        m_Data->m_Gains[ch].clear();
+    }
+    for(Data::ClipMap::const_iterator it = m_Data->m_Clips.begin(); it != m_Data->m_Clips.end(); ++it) {
+        m_Data->AddRoutes(it->second);
+    }
+    for(unsigned int ch = 0; ch < numchannels; ++ch) {
+        std::vector<const float*>& rows = m_Data->m_Rows[ch];
+        unsigned int numrows = rows.size();
+        syAudioBlock::MixRow(dst->GetChannel(ch), numrows ? &rows[0] : 0, numrows ? &m_Data->m_Gains[ch][0] : 0, numrows, blocksize, false);
+    }
+
+    m_Data->m_Position += blocksize;
+    return true;
+}
+
+unsigned long SequenceMixer::Render(syAudioBuffer* output, unsigned long numsamples) {
+    if(!m_Data->m_Sequence || output->GetNumChannels() != m_Data->m_NumChannels) {
+        return 0;
+    }
+    // Room needed for a block, once it's resampled to the output's frequency.
+    unsigned long needed = (unsigned long)((unsigned long long)m_Data->m_BlockSize * output->GetSampleFrequency() / m_Data->m_Freq) + 2;
+    unsigned long mixed = 0;
+    while(!numsamples || mixed < numsamples) {
+        if(output->GetSize() - output->GetLength() < needed || !MixBlock(&m_Data->m_Mixed)) {
+            break;
+        }
+        output->WriteBlock(&m_Data->m_Mixed, m_Data->m_Freq);
+        mixed += m_Data->m_BlockSize;
+    }
+    return mixed;
+}
@@ -0,0 +1,128 @@
+/***************************************************************
+ * Name:      sequencemixer.h
+ * Purpose:   Declaration for the SequenceMixer class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  SequenceMixer renders the audio tracks of an
+ *            AVSequence into a single stream, block by block.
+ **************************************************************/
+
+#ifndef sequencemixer_h
+#define sequencemixer_h
+
+#include "core/avtypes.h"
+
+class AVSequence;
+class AVSource;
+class syAudioBlock;
+class syAudioBuffer;
+
+/** @brief Mixes the audio tracks of a sequence.
+ *
+ *  For each block of output samples, the mixer finds the clips of the audio tracks that overlap it, reads
+ *  their samples from the AVSource assigned to their resource (see SetSource()), and adds them up with
+ *  each clip's gain and pan (see AVClip::m_AudioGain and AVClip::m_AudioPan). Hidden tracks
+ *  (AVTrack::m_Hidden) and hidden clips (AVClip::m_Hide) are muted. Clips whose source has a different
+ *  sample frequency are resampled (see syAudioResampler).
+ *
+ *  The mix is done in floating point with syAudioBlock::MixRow(), so every output channel is written
+ *  in a single pass, whatever the number of clips. When many sources are playing at once, they're read
+ *  in parallel by the global syWorkerPool; the clips that share a source are always read by the same thread.
+ *
+ *  A clip starts at its position in the track's time index (AVTrack::m_TimeIndex) and plays its
+ *  source from AVClip::m_SourceStartTime to AVClip::m_SourceEndTime. The sources are only sought when
+ *  a clip starts, when playback jumps, or when another clip read from the same source in between.
+ *
+ *  @note Loops, speed changes and reversed clips aren't rendered yet; those clips play once, forwards.
+ *  @note Only one thread can use the mixer at a time.
+ */
+class SequenceMixer {
+    public:
+        /** Default number of samples mixed at a time */
+        static const unsigned int DefaultBlockSize = 1024;
+
+        /** Default number of playing sources needed to read them in parallel */
+        static const unsigned int DefaultParallelThreshold = 8;
+
+        /** Standard constructor. Mixes into 48 kHz stereo by default. */
+        SequenceMixer();
+
+        /** Standard destructor. */
+        ~SequenceMixer();
+
+        /** @brief Sets the sequence to mix.
+         *  @param sequence The sequence. NULL to mix silence. It's not owned by the mixer.
+         */
+        void SetSequence(AVSequence* sequence);
+
+        /** Gets the sequence being mixed. */
+        AVSequence* GetSequence() const;
+
+        /** @brief Assigns an audio source to a resource.
+         *  @param resourceid The resource id used by the clips (see AVClip::m_ResourceId).
+         *  @param source An initialized audio source; NULL to remove it. It's not owned by the mixer.
+         *  @note The source is sought and read by the mixer, so it shouldn't be used by another thread during playback.
+         */
+        void SetSource(unsigned int resourceid, AVSource* source);
+
+        /** @brief Sets the format of the mixed audio.
+         *  @param freq The sample frequency, in Hz.
+         *  @param numchannels The number of channels.
+         */
+        void SetOutputFormat(unsigned int freq, unsigned int numchannels);
+
+        /** Gets the sample frequency of the mixed audio, in Hz. */
+        unsigned int GetSampleFrequency() const;
+
+        /** Gets the number of channels of the mixed audio. */
+        unsigned int GetNumChannels() const;
+
+        /** @brief Sets the number of samples mixed at a time.
+         *  Smaller blocks lower the latency; bigger ones make the mixing more efficient.
+         */
+        void SetBlockSize(unsigned int blocksize);
+
+        /** Gets the number of samples mixed at a time. */
+        unsigned int GetBlockSize() const;
+
+        /** @brief Sets the number of playing sources needed to read them with the worker pool.
+         *  @param numsources The number of sources. 0 disables the worker pool.
+         */
+        void SetParallelThreshold(unsigned int numsources);
+
+        /** Gets the number of playing sources needed to read them with the worker pool. */
+        unsigned int GetParallelThreshold() const;
+
+        /** Sets the playback position. The clips' sources will be sought on the next block. */
+        void Seek(avtime_t time);
+
+        /** Gets the playback position: the time of the next block. */
+        avtime_t GetPosition() const;
+
+        /** Gets the playback position in samples. */
+        unsigned long long GetSamplePosition() const;
+
+        /** @brief Mixes the next block and advances the position.
+         *  @param dst The destination. It's reallocated if it doesn't have the mixer's number of channels,
+         *         or room for a block. Its length is set to GetBlockSize().
+         *  @return false if there's no sequence to mix (dst is left untouched).
+         */
+        bool MixBlock(syAudioBlock* dst);
+
+        /** @brief Mixes blocks into an audio buffer, for as long as it has room for them.
+         *  @param output The destination buffer. Must have the mixer's number of channels; if its frequency is
+         *         different, the mixed audio is resampled. The mixer is the buffer's writer.
+         *  @param numsamples Stop after mixing at least this number of samples. 0 to fill the buffer.
+         *  @return The number of samples mixed, at the mixer's frequency.
+         */
+        unsigned long Render(syAudioBuffer* output, unsigned long numsamples = 0);
+
+    private:
+        class Data;
+        friend class Data;
+        Data* m_Data;
+};
+
+#endif
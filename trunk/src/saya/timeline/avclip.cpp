@@ -19,6 +19,10 @@ AVClip::AVClip()
     m_Effects = new AVEffects;
     m_EndingTransition = new AVTransition;
     m_Markers = new SMapUintUint;
+    m_Hide = false;
+    m_SoloChannel = 0;
+    m_AudioGain = 0.0;
+    m_AudioPan = 0.0;
 }
 
 AVClip::~AVClip()
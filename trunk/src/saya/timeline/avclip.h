@@ -244,6 +244,13 @@ class AVClip: public serializable {
           */
         double m_AudioGain;
 
+        /** @brief Stereo panning; from -1.0 (left) to 1.0 (right). Default is 0.0 (center).
+          *
+          * Mono clips are panned with constant power; clips with more channels are balanced.
+          * Only the first two output channels are affected.
+          */
+        double m_AudioPan;
+
     protected:
     private:
 };
@@ -15,6 +15,9 @@
 AVTrack::AVTrack() {
     m_Clips = new AVClips;
     m_TimeIndex = new SMapUintUint;
+    m_Readonly = false;
+    m_Hidden = false;
+    m_Collapsed = false;
 }
 
 AVTrack::~AVTrack() {
@@ -8,6 +8,7 @@
  ***************************************************************/
 
 #include "smapxstr.h"
+#include <cstddef>
 #include <map>
 using namespace std;
 
@@ -175,6 +176,14 @@ unsigned int& SMapUintUint::operator[](unsigned int i) {
     return m_Data->m_Map[i];
 }
 
+const unsigned int* SMapUintUint::find(unsigned int i) const {
+    map<unsigned int,unsigned int>::const_iterator it = m_Data->m_Map.find(i);
+    if(it != m_Data->m_Map.end()) {
+        return &(it->second);
+    }
+    return NULL;
+}
+
 void SMapUintUint::clear() {
     m_Data->m_Map.clear();
 }
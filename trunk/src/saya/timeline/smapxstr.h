@@ -120,6 +120,9 @@ class SMapUintUint : public serializable {
 
         unsigned int& operator[](unsigned int i);
 
+        /** @return a pointer to the value corresponding to the key i, if found; NULL otherwise. */
+        const unsigned int* find(unsigned int i) const;
+
         void clear();
 
     private:
@@ -0,0 +1,171 @@
+/****************************************************************
+ * Name:      Test3.cpp
+ * Purpose:   Stress test for the syAudioBuffer class
+ * Author:    Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * Created:   2026-10-17
+ * Copyright: Ricardo Garcia (rick.g777 {at} gmail {dot} com)
+ * License:   GPL version 3 or later
+ * Comments:  A writer thread and a reader thread move a numbered
+ *            stream through a small syAudioBuffer, using both the
+ *            per-sample and the block methods, and the reader
+ *            checks that nothing gets lost, duplicated or torn.
+ ***************************************************************/
+#include <iostream>
+#include "../saya/core/sythread.h"
+#include "../saya/core/audiobuffer.h"
+
+using namespace std;
+
+const unsigned int NumChannels = 8;
+const unsigned int NumSamples = 4000000;
+const unsigned int MaxBlock = 700;
+
+/** Small pseudo-random generator, so each thread has its own sequence. */
+static unsigned int NextRandom(unsigned int& seed) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+class Test3 : public syThread
+{
+public:
+    Test3(syAudioBuffer* buffer);
+
+    // thread execution starts here
+    virtual int Entry();
+
+    syAudioBuffer* m_Buffer;
+    unsigned int m_Full;
+    volatile bool m_Done;
+};
+
+Test3::Test3(syAudioBuffer* buffer)
+             :syThread(syTHREAD_JOINABLE),
+             m_Buffer(buffer),
+             m_Full(0),
+             m_Done(false)
+{}
+
+int Test3::Entry()
+{
+    int block[MaxBlock * NumChannels];
+    unsigned int seed = 1;
+    unsigned int next = 0;
+    while(next < NumSamples) {
+        if ( TestDestroy() )
+            break;
+        unsigned int count = 1 + NextRandom(seed) % MaxBlock;
+        if(count > NumSamples - next) {
+            count = NumSamples - next;
+        }
+        // Every channel gets a different function of the sample number, so torn samples can be detected.
+        for(unsigned int i = 0; i < count; ++i) {
+            for(unsigned int ch = 0; ch < NumChannels; ++ch) {
+                block[i*NumChannels + ch] = (int)((next + i) * (ch + 1));
+            }
+        }
+        unsigned int written = 0;
+        if(NextRandom(seed) & 1) {
+            written = m_Buffer->WriteBlock(block, count);
+        } else {
+            while(written < count && m_Buffer->Write(&block[written*NumChannels])) {
+                ++written;
+            }
+        }
+        if(written < count) {
+            ++m_Full;
+            syThread::Yield();
+        }
+        next += written;
+    }
+    m_Done = true;
+    return 0;
+}
+
+/** Reads the whole stream. Returns the number of errors. */
+static unsigned int ReadStream(syAudioBuffer* buffer, bool clear)
+{
+    int block[MaxBlock * NumChannels];
+    unsigned int seed = 2;
+    unsigned int expected = 0;
+    unsigned int errors = 0;
+    unsigned int empty = 0;
+    unsigned int clears = 0;
+    Test3 *thread = new Test3(buffer);
+
+    if ( thread->Create() != syTHREAD_NO_ERROR || thread->Run() != syTHREAD_NO_ERROR )
+    {
+        cout << "Can't start the writer thread!" << endl;
+        delete thread;
+        return 1;
+    }
+
+    unsigned long ticks = syGetTicks();
+    bool done = false;
+    while(expected < NumSamples) {
+        unsigned int count = 1 + NextRandom(seed) % MaxBlock;
+        unsigned int read = 0;
+        if(NextRandom(seed) & 1) {
+            read = buffer->ReadBlock(block, count);
+        } else {
+            while(read < count && buffer->Read(&block[read*NumChannels])) {
+                ++read;
+            }
+        }
+        if(!read) {
+            // A Clear() may have discarded the end of the stream; stop when the writer is done
+            // and we have read everything.
+            if(done) {
+                break;
+            }
+            done = thread->m_Done;
+            ++empty;
+            syThread::Yield();
+            continue;
+        }
+        for(unsigned int i = 0; i < read; ++i) {
+            unsigned int value = (unsigned int)block[i*NumChannels];
+            // After a Clear(), samples may be skipped, but never repeated.
+            if(value != expected && !(clear && value > expected)) {
+                if(errors < 10) {
+                    cout << "Expected sample " << expected << ", got " << value << endl;
+                }
+                ++errors;
+            }
+            for(unsigned int ch = 1; ch < NumChannels; ++ch) {
+                if(block[i*NumChannels + ch] != (int)(value * (ch + 1))) {
+                    if(errors < 10) {
+                        cout << "Torn sample " << value << " at channel " << ch << endl;
+                    }
+                    ++errors;
+                }
+            }
+            expected = value + 1;
+        }
+        if(clear && NextRandom(seed) % 64 == 0) {
+            buffer->Clear();
+            ++clears;
+        }
+    }
+    ticks = syGetTicks() - ticks;
+    thread->Wait();
+    if(expected < NumSamples && !clear) {
+        cout << "The stream ended at sample " << expected << endl;
+        ++errors;
+    }
+
+    cout << (clear ? "With clears: " : "Sequential: ") << NumSamples << " samples in " << ticks << " ms; "
+         << empty << " empty reads, " << thread->m_Full << " full writes, " << clears << " clears, "
+         << errors << " errors." << endl;
+    delete thread;
+    return errors;
+}
+
+int main()
+{
+    syAudioBuffer buffer(1024, NumChannels, 32, 48000);
+    unsigned int errors = ReadStream(&buffer, false);
+    errors += ReadStream(&buffer, true);
+    cout << (errors ? "FAILED" : "OK") << endl;
+    return errors ? 1 : 0;
+}
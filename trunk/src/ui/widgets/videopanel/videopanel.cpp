@@ -242,7 +242,8 @@ bool VideoPanel::Data::UpdateX11Image(const syBitmap* bitmap) {
     m_XImage->height = bitmap->GetHeight();
     m_XImage->xoffset = 0;
     m_XImage->format = ZPixmap;
-    m_XImage->data = (char*)(const_cast<syBitmap*>(bitmap)->GetBuffer());
+    // XPutImage only reads the data, so we don't need to unshare the bitmap's buffer.
+    m_XImage->data = (char*)const_cast<unsigned char*>(bitmap->GetReadOnlyBuffer());
     m_XImage->byte_order = LSBFirst;
 
     // Not sure if this should be bitmap->GetRowPadding(), too. (I hate Xlib's poor documentation!)
@@ -354,7 +355,7 @@ void VideoPanel::paintEvent ( QPaintEvent * pe ) {
         if (m_Data->m_BufferChanged) {
             m_Data->m_BufferChanged = false;
         }
-        if (w > 0 && h > 0 && m_Data && m_Data->m_Video && m_Data->m_Video->IsOk() && currentbitmap->GetBuffer()) {
+        if (w > 0 && h > 0 && m_Data && m_Data->m_Video && m_Data->m_Video->IsOk() && currentbitmap->GetReadOnlyBuffer()) {
             // Video is created, active and available. Let's play our current bitmap.
             if(!m_Data->NativeRender(currentbitmap)) {
                 m_Data->QtRender(currentbitmap, painter);